@@ -1,3 +1,9 @@
 SUBDIRS += src
+mockigs {
+    SUBDIRS += tools/mockigs
+}
+stubengine {
+    SUBDIRS += tools/stubengine
+}
 TEMPLATE = subdirs 
 CONFIG += qt 
@@ -0,0 +1,138 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#include <QtWidgets>
+#include "archivesearchdialog.h"
+
+ArchiveSearchDialog::ArchiveSearchDialog(QWidget * parent) : QDialog(parent)
+{
+	QSettings settings;
+	folder = settings.value("SEARCH_FOLDER").toString();
+
+	folderLabel = new QLabel();
+	folderButton = new QPushButton(tr("Folder..."));
+	queryEdit = new QLineEdit();
+	queryEdit->setPlaceholderText(tr("Words in comments or node names"));
+	searchButton = new QPushButton(tr("Search"));
+	searchButton->setDefault(true);
+
+	resultList = new QTreeWidget();
+	resultList->setColumnCount(2);
+	resultList->setHeaderLabels(QStringList() << tr("File") << tr("Comment"));
+	resultList->setRootIsDecorated(false);
+	resultList->setUniformRowHeights(true);
+	resultList->setColumnWidth(0, 200);
+
+	countLabel = new QLabel();
+	closeButton = new QPushButton(tr("Close"));
+	connect(folderButton, SIGNAL(clicked()), this, SLOT(slot_chooseFolder()));
+	connect(queryEdit, SIGNAL(returnPressed()), this, SLOT(slot_search()));
+	connect(searchButton, SIGNAL(clicked()), this, SLOT(slot_search()));
+	connect(resultList, SIGNAL(itemActivated(QTreeWidgetItem *, int)), this, SLOT(slot_resultActivated(QTreeWidgetItem *)));
+	connect(closeButton, SIGNAL(clicked()), this, SLOT(hide()));
+
+	QHBoxLayout * folderLayout = new QHBoxLayout;
+	folderLayout->addWidget(folderLabel, 1);
+	folderLayout->addWidget(folderButton);
+
+	QHBoxLayout * queryLayout = new QHBoxLayout;
+	queryLayout->addWidget(queryEdit);
+	queryLayout->addWidget(searchButton);
+
+	QHBoxLayout * buttonLayout = new QHBoxLayout;
+	buttonLayout->addWidget(countLabel);
+	buttonLayout->addStretch();
+	buttonLayout->addWidget(closeButton);
+
+	QVBoxLayout * mainLayout = new QVBoxLayout;
+	mainLayout->addLayout(folderLayout);
+	mainLayout->addLayout(queryLayout);
+	mainLayout->addWidget(resultList);
+	mainLayout->addLayout(buttonLayout);
+	setLayout(mainLayout);
+
+	folderLabel->setText(folder.isEmpty() ? tr("No folder chosen") : folder);
+	setWindowTitle(tr("Search SGF Files"));
+	resize(600, 420);
+}
+
+void ArchiveSearchDialog::slot_chooseFolder(void)
+{
+	QString f = QFileDialog::getExistingDirectory(this, tr("Folder to search"), folder);
+	if(f.isEmpty())
+		return;
+	folder = f;
+	QSettings settings;
+	settings.setValue("SEARCH_FOLDER", folder);
+	folderLabel->setText(folder);
+	scan();
+	if(!queryEdit->text().trimmed().isEmpty())
+		slot_search();
+}
+
+void ArchiveSearchDialog::scan(void)
+{
+	archive.clear();
+	QStringList files = SGFArchive::listFiles(folder);
+	QProgressDialog progress(tr("Indexing SGF files..."), tr("Cancel"), 0, files.size(), this);
+	progress.setWindowModality(Qt::WindowModal);
+	progress.setMinimumDuration(500);
+	for(int i = 0; i < files.size(); i++)
+	{
+		progress.setValue(i);
+		if(progress.wasCanceled())
+			break;
+		if(!archive.addFile(files[i]))
+			qDebug() << "Could not index" << files[i];
+	}
+	progress.setValue(files.size());
+	folderLabel->setText(tr("%1 (%n file(s))", "", archive.fileCount()).arg(folder));
+}
+
+void ArchiveSearchDialog::slot_search(void)
+{
+	if(folder.isEmpty())
+	{
+		slot_chooseFolder();
+		return;
+	}
+	if(!archive.fileCount())
+		scan();
+	resultsQuery = queryEdit->text();
+	results = resultsQuery.trimmed().isEmpty() ? QList<SGFArchive::Match>() : archive.find(resultsQuery);
+
+	resultList->clear();
+	QDir dir(folder);
+	QList<QTreeWidgetItem *> items;
+	for(int i = 0; i < results.size(); i++)
+		items << new QTreeWidgetItem(QStringList() << dir.relativeFilePath(results[i].path) << results[i].text);
+	resultList->addTopLevelItems(items);
+	countLabel->setText(tr("%n match(es)", "", results.size()));
+}
+
+void ArchiveSearchDialog::slot_resultActivated(QTreeWidgetItem * item)
+{
+	int row = resultList->indexOfTopLevelItem(item);
+	if(row < 0 || row >= results.size())
+		return;
+	emit signal_open(results[row].path, resultsQuery, results[row].ordinal);
+}
@@ -0,0 +1,64 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#ifndef ARCHIVESEARCHDIALOG_H
+#define ARCHIVESEARCHDIALOG_H
+
+#include <QDialog>
+#include "sgfarchive.h"
+
+class QLabel;
+class QLineEdit;
+class QTreeWidget;
+class QTreeWidgetItem;
+class QPushButton;
+
+/* Search the comments of a folder of SGF files.  The folder is indexed
+ * once, when it's picked or on the first search. */
+class ArchiveSearchDialog : public QDialog
+{
+	Q_OBJECT
+	public:
+		ArchiveSearchDialog(QWidget * parent = 0);
+	signals:
+		void signal_open(const QString & path, const QString & query, int match);
+	private slots:
+		void slot_chooseFolder(void);
+		void slot_search(void);
+		void slot_resultActivated(QTreeWidgetItem * item);
+	private:
+		void scan(void);
+
+		SGFArchive archive;
+		QString folder;
+		QLabel * folderLabel;
+		QPushButton * folderButton;
+		QLineEdit * queryEdit;
+		QPushButton * searchButton;
+		QTreeWidget * resultList;
+		QLabel * countLabel;
+		QPushButton * closeButton;
+		QList<SGFArchive::Match> results;
+		QString resultsQuery;
+};
+
+#endif //ARCHIVESEARCHDIALOG_H
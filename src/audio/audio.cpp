@@ -21,24 +21,25 @@
 
 
 #include "audio/audio.h"
-#include <QDir>
-#include <defines.h>
-#include <QtMultimedia/QMediaPlayer>
+#include "audio/audioengine.h"
 
+/* A handle on one of the AudioEngine's samples, the file is only decoded
+ * by the first Sound using it */
 Sound::Sound(const QString &filename, QObject *parent)
     : QObject(parent)
 {
-    player = new QMediaPlayer;
-    if (QDir().exists(SOUND_PATH_PREFIX + filename))
-        player->setMedia(QMediaContent(QUrl::fromLocalFile(QDir().absoluteFilePath(SOUND_PATH_PREFIX + filename))));
+    sample = AudioEngine::engine()->load(filename);
 }
 
 Sound::~Sound()
 {
-    delete player;
 }
 
-void Sound::play(void)
+/*
+ * source is usually the board the sound is for, the same sound from the
+ * same source is dropped within SOUND_MIN_INTERVAL
+ */
+void Sound::play(const void *source)
 {
-    player->play();
+    AudioEngine::engine()->play(sample, source);
 }
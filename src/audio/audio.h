@@ -25,8 +25,6 @@
 
 #include<QObject>
 
-class QMediaPlayer;
-
 class Sound : public QObject
 {
 Q_OBJECT
@@ -35,9 +33,9 @@ public:
     Sound(const QString& filename, QObject* parent=0);
     ~Sound();
 
-    void play(void);
+    void play(const void *source = 0);
 private:
-    QMediaPlayer *player;
+    int sample;
 };
 
 #endif // _AUDIO_H_
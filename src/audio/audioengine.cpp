@@ -0,0 +1,327 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+
+
+#include "audioengine.h"
+#include "defines.h"
+#include <QAudioOutput>
+#include <QAudioDecoder>
+#include <QAudioDeviceInfo>
+
+/* Sounds needed by every board, decoded before the first one opens */
+static const char * preloaded[] = { "stone.wav", "timer.wav", 0 };
+
+/* Feeds the output from the engine's mix, silence when nothing plays */
+class SoundMixer : public QIODevice
+{
+public:
+	SoundMixer(QObject * parent) : QIODevice(parent) {}
+	qint64 readData(char * data, qint64 maxlen) { return AudioEngine::engine()->mix(data, maxlen); }
+	qint64 writeData(const char *, qint64) { return -1; }
+	bool isSequential(void) const { return true; }
+};
+
+AudioEngine * AudioEngine::instance = 0;
+
+AudioEngine * AudioEngine::engine(void)
+{
+	if(!instance)
+		instance = new AudioEngine();
+	return instance;
+}
+
+AudioEngine::AudioEngine() : QObject(QCoreApplication::instance())
+{
+	clock.start();
+	output = 0;
+	thread = 0;
+
+	QAudioFormat wanted;
+	wanted.setSampleRate(SOUND_RATE);
+	wanted.setChannelCount(1);
+	wanted.setSampleSize(16);
+	wanted.setCodec("audio/pcm");
+	wanted.setByteOrder(QAudioFormat::LittleEndian);
+	wanted.setSampleType(QAudioFormat::SignedInt);
+	QAudioDeviceInfo device = QAudioDeviceInfo::defaultOutputDevice();
+	if(device.isNull())
+		qDebug("No audio output device");
+	else
+	{
+		format = device.nearestFormat(wanted);
+		if(format.sampleSize() != 16 || format.sampleType() != QAudioFormat::SignedInt ||
+			format.byteOrder() != QAudioFormat::LittleEndian)
+		{
+			qDebug("Audio output has no 16 bit format, no sounds");
+			format = QAudioFormat();
+		}
+	}
+	if(!format.isValid())
+		format = wanted;		//still decode, play() does nothing
+	else
+	{
+		thread = new QThread(this);
+		output = new SoundOutput(format);
+		output->moveToThread(thread);
+		connect(thread, SIGNAL(started()), output, SLOT(slot_open()));
+		connect(thread, SIGNAL(finished()), output, SLOT(deleteLater()));
+		connect(QCoreApplication::instance(), SIGNAL(aboutToQuit()), SLOT(slot_shutdown()));
+		thread->start(QThread::TimeCriticalPriority);
+	}
+
+	for(int i = 0; preloaded[i]; i++)
+		load(preloaded[i]);
+}
+
+void AudioEngine::slot_shutdown(void)
+{
+	if(!thread)
+		return;
+	thread->quit();
+	thread->wait();
+	thread = 0;
+	output = 0;
+}
+
+/*
+ * Returns the index of the file's sample, decoding it the first time.
+ * -1 if it can't be read.
+ */
+int AudioEngine::load(const QString & filename)
+{
+	int sample = files.indexOf(filename);
+	if(sample != -1)
+		return sample;
+
+	QFile f(SOUND_PATH_PREFIX + filename);
+	if(!f.open(QIODevice::ReadOnly))
+	{
+		qDebug("Can't open sound %s", (SOUND_PATH_PREFIX + filename).toLatin1().constData());
+		return -1;
+	}
+	sample = files.size();
+	files.append(filename);
+	samples.append(QVector<qint16>());
+	QByteArray wav = f.readAll();
+	/* Plain PCM wavs are decoded here, anything else, like the mp3
+	 * in timer.wav, goes through the multimedia backend */
+	if(wav.size() > 12 && wav.startsWith("RIFF") && wav.mid(8, 4) == "WAVE")
+		decodeWav(sample, wav);
+	if(samples[sample].isEmpty())
+		decodeOther(sample, QFileInfo(f).absoluteFilePath());
+	return sample;
+}
+
+static quint16 le16(const char * p) { return (quint8)p[0] | ((quint8)p[1] << 8); }
+static quint32 le32(const char * p) { return le16(p) | ((quint32)le16(p + 2) << 16); }
+
+void AudioEngine::decodeWav(int sample, const QByteArray & wav)
+{
+	const char * p = wav.constData() + 12;
+	const char * end = wav.constData() + wav.size();
+	QAudioFormat f;
+	bool pcm = false;
+	while(p + 8 <= end)
+	{
+		quint32 length = le32(p + 4);
+		const char * chunk = p + 8;
+		if(length > (quint32)(end - chunk))
+			length = end - chunk;
+		if(!memcmp(p, "fmt ", 4) && length >= 16)
+		{
+			pcm = (le16(chunk) == 1);
+			f.setChannelCount(le16(chunk + 2));
+			f.setSampleRate(le32(chunk + 4));
+			f.setSampleSize(le16(chunk + 14));
+			f.setSampleType(f.sampleSize() == 8 ? QAudioFormat::UnSignedInt : QAudioFormat::SignedInt);
+			f.setByteOrder(QAudioFormat::LittleEndian);
+		}
+		else if(!memcmp(p, "data", 4))
+		{
+			if(pcm && (f.sampleSize() == 8 || f.sampleSize() == 16))
+				append(sample, chunk, length, f);
+			return;
+		}
+		p = chunk + length + (length & 1);
+	}
+}
+
+void AudioEngine::decodeOther(int sample, const QString & path)
+{
+	QAudioDecoder * decoder = new QAudioDecoder(this);
+	decoders.insert(decoder, sample);
+	connect(decoder, SIGNAL(bufferReady()), SLOT(slot_decoderBuffer()));
+	connect(decoder, SIGNAL(finished()), SLOT(slot_decoderFinished()));
+	connect(decoder, SIGNAL(error(QAudioDecoder::Error)), SLOT(slot_decoderFinished()));
+	decoder->setSourceFilename(path);
+	decoder->start();
+}
+
+void AudioEngine::slot_decoderBuffer(void)
+{
+	QAudioDecoder * decoder = qobject_cast<QAudioDecoder *>(sender());
+	if(!decoder || !decoders.contains(decoder))
+		return;
+	QAudioBuffer buffer = decoder->read();
+	if(buffer.isValid())
+		append(decoders[decoder], (const char *)buffer.constData(), buffer.byteCount(), buffer.format());
+}
+
+void AudioEngine::slot_decoderFinished(void)
+{
+	QAudioDecoder * decoder = qobject_cast<QAudioDecoder *>(sender());
+	if(!decoder || !decoders.contains(decoder))
+		return;
+	int sample = decoders.take(decoder);
+	if(decoder->error() != QAudioDecoder::NoError)
+		qDebug("Can't decode sound %s: %s", files[sample].toLatin1().constData(),
+			decoder->errorString().toLatin1().constData());
+	decoder->deleteLater();
+}
+
+/*
+ * Converts some decoded audio to mono 16 bit at the output rate and adds
+ * it to the end of the sample
+ */
+void AudioEngine::append(int sample, const char * data, int bytes, const QAudioFormat & f)
+{
+	int channels = f.channelCount();
+	int width = f.sampleSize() / 8;
+	if(channels < 1 || f.sampleRate() < 1 || (width != 1 && width != 2 && width != 4))
+		return;
+	int frames = bytes / (width * channels);
+	QVector<qint16> mono(frames);
+	for(int i = 0; i < frames; i++)
+	{
+		int sum = 0;
+		for(int c = 0; c < channels; c++)
+		{
+			const char * s = data + (i * channels + c) * width;
+			if(f.sampleType() == QAudioFormat::Float && width == 4)
+				sum += (int)(*(const float *)s * 32767);
+			else if(width == 1)
+				sum += (f.sampleType() == QAudioFormat::UnSignedInt ? (int)(quint8)*s - 128 : (int)(qint8)*s) << 8;
+			else if(width == 2)
+				sum += (qint16)le16(s);
+			else
+				sum += (qint32)le32(s) >> 16;
+		}
+		mono[i] = sum / channels;
+	}
+
+	/* linear resampling is good enough for clicks and beeps */
+	int rate = format.sampleRate();
+	int out = (qint64)frames * rate / f.sampleRate();
+	QVector<qint16> pcm(out);
+	for(int i = 0; i < out; i++)
+	{
+		qint64 pos = (qint64)i * f.sampleRate() * 256 / rate;
+		int j = pos >> 8, frac = pos & 0xff;
+		int next = (j + 1 < frames ? mono[j + 1] : mono[j]);
+		pcm[i] = (mono[j] * (256 - frac) + next * frac) >> 8;
+	}
+
+	samples[sample] += pcm;
+}
+
+void AudioEngine::play(int sample, const void * source)
+{
+	if(!output || sample < 0 || sample >= samples.size())
+		return;
+
+	qint64 now = clock.elapsed();
+	QPair<const void *, int> key(source, sample);
+	QHash<QPair<const void *, int>, qint64>::iterator last = lastPlayed.find(key);
+	if(last != lastPlayed.end() && now - *last < SOUND_MIN_INTERVAL)
+		return;
+	if(lastPlayed.size() > 256)
+	{
+		/* forget boards long closed */
+		QHash<QPair<const void *, int>, qint64>::iterator i = lastPlayed.begin();
+		while(i != lastPlayed.end())
+		{
+			if(now - *i >= SOUND_MIN_INTERVAL)
+				i = lastPlayed.erase(i);
+			else
+				++i;
+		}
+	}
+	lastPlayed[key] = now;
+
+	QMutexLocker locker(&mutex);
+	if(samples[sample].isEmpty())
+		return;		//still decoding
+	Voice v;
+	v.pcm = samples[sample];
+	v.pos = 0;
+	if(voices.size() >= SOUND_MAX_VOICES)
+		voices.removeFirst();
+	voices.append(v);
+}
+
+/*
+ * Called from the output thread for the next maxlen bytes
+ */
+qint64 AudioEngine::mix(char * data, qint64 maxlen)
+{
+	int channels = format.channelCount();
+	int frames = maxlen / (2 * channels);
+	qint16 * out = (qint16 *)data;
+
+	QMutexLocker locker(&mutex);
+	if(voices.isEmpty())
+	{
+		memset(data, 0, frames * 2 * channels);
+		return frames * 2 * channels;
+	}
+	for(int i = 0; i < frames; i++)
+	{
+		int sum = 0;
+		for(int v = 0; v < voices.size(); v++)
+		{
+			Voice & voice = voices[v];
+			if(voice.pos < voice.pcm.size())
+				sum += voice.pcm.at(voice.pos++);
+		}
+		qint16 s = qBound(-32768, sum, 32767);
+		for(int c = 0; c < channels; c++)
+			*out++ = s;
+	}
+	for(int v = voices.size() - 1; v >= 0; v--)
+	{
+		if(voices[v].pos >= voices[v].pcm.size())
+			voices.removeAt(v);
+	}
+	return frames * 2 * channels;
+}
+
+void SoundOutput::slot_open(void)
+{
+	mixer = new SoundMixer(this);
+	mixer->open(QIODevice::ReadOnly);
+	audio = new QAudioOutput(format, this);
+	audio->setBufferSize(format.bytesForDuration(SOUND_BUFFER_MS * 1000));
+	audio->start(mixer);
+	if(audio->error() != QAudio::NoError)
+		qDebug("Can't open audio output: %d", audio->error());
+}
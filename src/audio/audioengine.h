@@ -0,0 +1,96 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+
+
+#ifndef AUDIOENGINE_H
+#define AUDIOENGINE_H
+
+#include <QtCore>
+#include <QAudioFormat>
+
+class QAudioOutput;
+class QAudioDecoder;
+class SoundMixer;
+
+/* All sounds are decoded once to mono 16 bit PCM at the output rate and
+ * kept here.  A single output, running in its own thread with a short
+ * buffer, is always open and pulls the mix of whatever is playing, so a
+ * sound starts within a buffer of play() being called.  Sounds from one
+ * source, normally a board, are rate limited here as well so that a
+ * burst of moves doesn't turn into a burst of clicks. */
+class AudioEngine : public QObject
+{
+	Q_OBJECT
+
+public:
+	static AudioEngine * engine(void);
+	int load(const QString & filename);
+	void play(int sample, const void * source);
+	qint64 mix(char * data, qint64 maxlen);
+
+private slots:
+	void slot_decoderBuffer(void);
+	void slot_decoderFinished(void);
+	void slot_shutdown(void);
+
+private:
+	struct Voice {
+		QVector<qint16> pcm;
+		int pos;
+	};
+	AudioEngine();
+	void decodeWav(int sample, const QByteArray & wav);
+	void decodeOther(int sample, const QString & path);
+	void append(int sample, const char * data, int bytes, const QAudioFormat & f);
+
+	static AudioEngine * instance;
+	QThread * thread;
+	class SoundOutput * output;
+	QAudioFormat format;
+	QStringList files;
+	QVector<QVector<qint16> > samples;
+	QMap<QAudioDecoder *, int> decoders;
+	QHash<QPair<const void *, int>, qint64> lastPlayed;
+	QElapsedTimer clock;
+	QList<Voice> voices;
+	QMutex mutex;		//voices, shared with the output thread
+};
+
+/* Lives in the output thread */
+class SoundOutput : public QObject
+{
+	Q_OBJECT
+
+public:
+	SoundOutput(const QAudioFormat & f) : format(f), audio(0), mixer(0) {}
+
+public slots:
+	void slot_open(void);
+
+private:
+	QAudioFormat format;
+	QAudioOutput * audio;
+	SoundMixer * mixer;
+};
+
+#endif //AUDIOENGINE_H
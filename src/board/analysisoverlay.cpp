@@ -0,0 +1,97 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+
+
+#include "analysisoverlay.h"
+
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+/* Candidates shown, best first */
+#define ANALYSIS_SHOWN 10
+
+AnalysisOverlay::AnalysisOverlay()
+	: board_size(0), offsetX(0), offsetY(0), square_size(0)
+{
+	setZValue(5);
+	// Clicks go to the board underneath
+	setAcceptedMouseButtons(0);
+}
+
+void AnalysisOverlay::setGeometry(int size, int oX, int oY, int sq)
+{
+	prepareGeometryChange();
+	board_size = size;
+	offsetX = oX;
+	offsetY = oY;
+	square_size = sq;
+	bounds = QRectF(offsetX - square_size, offsetY - square_size,
+			square_size * (board_size + 1), square_size * (board_size + 1));
+}
+
+void AnalysisOverlay::setCandidates(const QVector<AnalysisCandidate> &c)
+{
+	candidates = c;
+	update();
+}
+
+void AnalysisOverlay::paint(QPainter *p, const QStyleOptionGraphicsItem *option, QWidget *)
+{
+	if (candidates.isEmpty() || square_size < 8)
+		return;
+
+	int maxVisits = 1;
+	for (int i = 0; i < candidates.size(); i++)
+		maxVisits = qMax(maxVisits, candidates[i].visits);
+
+	p->setRenderHint(QPainter::Antialiasing);
+	QFont f = p->font();
+	f.setPixelSize(qMax(6, square_size / 4));
+	p->setFont(f);
+
+	for (int i = 0; i < candidates.size(); i++)
+	{
+		const AnalysisCandidate &c = candidates[i];
+		if (c.order >= ANALYSIS_SHOWN || c.x < 1 || c.y < 1 || c.x > board_size || c.y > board_size)
+			continue;
+		QPointF centre(offsetX + square_size * (c.x - 1), offsetY + square_size * (c.y - 1));
+		QRectF r(centre.x() - square_size * 0.45, centre.y() - square_size * 0.45,
+			square_size * 0.9, square_size * 0.9);
+		if (!option->exposedRect.intersects(r))
+			continue;
+
+		// From red for few visits to blue for the most searched move
+		float share = float(c.visits) / maxVisits;
+		QColor col = QColor::fromHsvF(share * 0.6, 0.7, 0.95, 0.8);
+		p->setPen(c.order == 0 ? QPen(Qt::black, qMax(1, square_size / 16)) : Qt::NoPen);
+		p->setBrush(col);
+		p->drawEllipse(r);
+
+		QString visits = (c.visits >= 1000 ? QString::number(c.visits / 1000) + "k" : QString::number(c.visits));
+		p->setPen(Qt::black);
+		p->drawText(QRectF(r.left(), r.top(), r.width(), r.height() / 2), Qt::AlignHCenter | Qt::AlignBottom,
+			QString::number(c.winrate * 100, 'f', 1));
+		p->drawText(QRectF(r.left(), centre.y(), r.width(), r.height() / 2), Qt::AlignHCenter | Qt::AlignTop,
+			visits);
+	}
+}
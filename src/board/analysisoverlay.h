@@ -0,0 +1,54 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+
+
+#ifndef ANALYSISOVERLAY_H
+#define ANALYSISOVERLAY_H
+
+#include "defines.h"
+#include "graphicsitemstypes.h"
+#include "qgtp.h"
+
+#include <QGraphicsItem>
+
+/* Shows the candidate moves of a live engine analysis on the board:
+ * a disc on each point, bluer for better moves, with the winrate and
+ * the number of visits. */
+class AnalysisOverlay : public QGraphicsItem
+{
+public:
+	AnalysisOverlay();
+	int type() const { return RTTI_ANALYSIS; }
+	QRectF boundingRect() const { return bounds; }
+	void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget = 0);
+
+	void setGeometry(int board_size, int offsetX, int offsetY, int square_size);
+	void setCandidates(const QVector<AnalysisCandidate> &c);
+
+private:
+	QRectF bounds;
+	QVector<AnalysisCandidate> candidates;
+	int board_size, offsetX, offsetY, square_size;
+};
+
+#endif
@@ -31,6 +31,8 @@
 #include "board.h"
 #include "stone.h"
 #include "gatter.h"
+#include "boarditem.h"
+#include "analysisoverlay.h"
 #include "mark.h"
 #include "imagehandler.h"
 #include "move.h"		//for updateLastMove, cleaner and yet not FIXME
@@ -57,6 +59,7 @@ Board::Board(QWidget *parent, QGraphicsScene *c)
     setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
     isDisplayBoard = false;
     lockResize =  false;
+    square_size = 0;
     showCoords = true;//TODO setting->readBoolEntry("BOARD_COORDS");
     showSGFCoords = false;//TODO setting->readBoolEntry("SGF_BOARD_COORDS");
     //antiClicko = setting->readBoolEntry("ANTICLICKO");
@@ -83,15 +86,39 @@ Board::Board(QWidget *parent, QGraphicsScene *c)
     canvas = new QGraphicsScene(0,0, BOARD_X, BOARD_Y,this);
     Q_CHECK_PTR(canvas);
     // Set background texture
-    canvas->setBackgroundBrush(QBrush(*(ImageHandler::getTablePixmap(  settings.value("SKIN_TABLE").toString()))));
+    canvas->setBackgroundBrush(QBrush(ImageHandler::getTablePixmap(settings.value("SKIN_TABLE").toString())));
     table = canvas->addRect(QRectF(),
                 QPen(Qt::NoPen),
-                QBrush(* (ImageHandler::getBoardPixmap(settings.value("SKIN").toString()))));
+                QBrush(ImageHandler::getBoardPixmap(settings.value("SKIN").toString())));
+
+    // Optionally draw everything as one item, see boarditem.h
+    boardItem = NULL;
+    if (settings.value("BOARD_SINGLE_ITEM").toBool())
+    {
+        boardItem = new BoardItem(imageHandler, ImageHandler::getBoardPixmap(settings.value("SKIN").toString()));
+        canvas->addItem(boardItem);
+        table->hide();
+    }
 
     //setRenderHints(QPainter::SmoothPixmapTransform);
     setScene(canvas);
     viewport()->setMouseTracking(true);
 
+    // Window drags only rebuild the board once the size settles
+    resizeTimer = new QTimer(this);
+    resizeTimer->setSingleShot(true);
+    resizeTimer->setInterval(BOARD_RESIZE_DELAY);
+    connect(resizeTimer, SIGNAL(timeout()), SLOT(slot_resizeSettled()));
+    spriteWatcher = new QFutureWatcher<void>(this);
+    connect(spriteWatcher, SIGNAL(finished()), SLOT(slot_spritesReady()));
+
+    // Engines stream analysis much faster than it's worth redrawing
+    analysisOverlay = NULL;
+    analysisTimer = new QTimer(this);
+    analysisTimer->setSingleShot(true);
+    analysisTimer->setInterval(ANALYSIS_FRAME_INTERVAL);
+    connect(analysisTimer, SIGNAL(timeout()), SLOT(slot_analysisFrame()));
+
     init(DEFAULT_BOARD_SIZE);
 
     // Init the ghost cursor stone
@@ -107,6 +134,7 @@ Board::Board(QWidget *parent, QGraphicsScene *c)
 Board::~Board()
 {
     setUpdatesEnabled(false);
+    spriteWatcher->waitForFinished();
 
     delete stones;
     delete ghosts;
@@ -125,9 +153,14 @@ Board::~Board()
 void Board::init(int size)
 {
     board_size = size;
-    if (gatter != NULL)
-        delete gatter;
-    gatter = new Gatter(canvas, board_size);
+    if (boardItem)
+        boardItem->setBoardSize(board_size);
+    else
+    {
+        if (gatter != NULL)
+            delete gatter;
+        gatter = new Gatter(canvas, board_size);
+    }
     setupCoords();
     resizeBoard();
 }
@@ -143,6 +176,7 @@ void Board::setupCoords(void)
     vCoords1->clear();
     vCoords2->clear();
 	QString hTxt,vTxt;
+	QStringList vTxts, hTxts;
 
 	// Init the coordinates
     QGraphicsSimpleTextItem *tmp;
@@ -165,6 +199,12 @@ void Board::setupCoords(void)
 				break;
 		}
 
+		if (boardItem)
+		{
+			vTxts << vTxt;
+			hTxts << hTxt;
+			continue;
+		}
         tmp = new QGraphicsSimpleTextItem(vTxt, 0);
         vCoords1->append(tmp);
         canvas->addItem(tmp);
@@ -178,6 +218,8 @@ void Board::setupCoords(void)
         hCoords2->append(tmp);
         canvas->addItem(tmp);
 	}
+	if (boardItem)
+		boardItem->setCoordinates(vTxts, hTxts);
 }
 
 /*
@@ -191,6 +233,8 @@ void Board::clearData()
 	ghosts->clear();
     qDeleteAll(*marks);
     marks->clear();
+    if (boardItem)
+        boardItem->clear();
 
     update();
 }
@@ -209,29 +253,7 @@ void Board::calculateSize()
 		
 	int table_size = (w < h ? w : h );
 
-	// distance from edge of wooden board to playing area (grids + space for stones on 1st & last line)
-	offset = table_size * 2/100 ;  
-
-
-    QGraphicsSimpleTextItem *coordV = new QGraphicsSimpleTextItem(QString::number(board_size),0);
-    QGraphicsSimpleTextItem *coordH = new QGraphicsSimpleTextItem("A",0);
-    canvas->addItem(coordV);
-    canvas->addItem(coordH);
-	int coord_width = (int)coordV->boundingRect().width();
-	int coord_height = (int)coordH->boundingRect().height();
-
-	// space for coodinates if shown
-	int coord_offset =  (coord_width < coord_height ? coord_height : coord_width);
-
-	if (showCoords)
-		offset = coord_offset + 2 ;
-
-	//we need 1 more virtual 'square' for the stones on 1st and last line getting off the grid
-	square_size = (table_size - 2*offset) / (board_size);  
-
-	// Should not happen, but safe is safe.
-	if (square_size == 0)
-		  square_size = 1;
+	square_size = squareSizeFor(w, h);
 
 	// grid size
 	board_pixel_size = square_size * (board_size-1) + 1 ;    
@@ -241,10 +263,37 @@ void Board::calculateSize()
 
 	offsetX = margin + (w - board_pixel_size) / 2;
 	offsetY = margin + (h - board_pixel_size) / 2;
+}
+
+/*
+* The square size for a table of w x h, without touching the board
+*/
+int Board::squareSizeFor(int w, int h)
+{
+	int table_size = (w < h ? w : h );
 
-	//deletes the samples
-	delete coordV;
-	delete coordH;
+	// distance from edge of wooden board to playing area (grids + space for stones on 1st & last line)
+	int offset = table_size * 2/100 ;  
+
+	if (showCoords)
+	{
+		QGraphicsSimpleTextItem coordV(QString::number(board_size), 0);
+		QGraphicsSimpleTextItem coordH("A", 0);
+		int coord_width = (int)coordV.boundingRect().width();
+		int coord_height = (int)coordH.boundingRect().height();
+
+		// space for coodinates if shown
+		int coord_offset =  (coord_width < coord_height ? coord_height : coord_width);
+		offset = coord_offset + 2 ;
+	}
+
+	//we need 1 more virtual 'square' for the stones on 1st and last line getting off the grid
+	int size = (table_size - 2*offset) / (board_size);  
+
+	// Should not happen, but safe is safe.
+	if (size <= 0)
+		  size = 1;
+	return size;
 }
 
 /*
@@ -317,17 +366,70 @@ void Board::setShowCoords(bool b)
 */
 void Board::resizeEvent(QResizeEvent*)
 {
-#ifdef _WS_WIN_x
-    if (!resizeDelayFlag)
-    {
-		resizeDelayFlag = true;
-		// not necessary?
-        QTimer::singleShot(50, this, SLOT(resizeBoard()));
-    }
-#else
-	if (!lockResize)
-        resizeBoard();
-#endif
+	if (lockResize)
+		return;
+
+	// Nothing to scale yet
+	if (square_size <= 0 || !isVisible())
+	{
+		resizeBoard();
+		return;
+	}
+
+	/* Stretch what's there until slot_resizeSettled rebuilds it, the
+	 * view does the scaling */
+	qreal scale = qMin(width() / canvas->width(), height() / canvas->height());
+	setTransform(QTransform::fromScale(scale, scale));
+	resizeTimer->start();
+}
+
+/*
+* the size hasn't changed for a while, paint the stones for it off the
+* GUI thread and rebuild when they're done
+*/
+void Board::slot_resizeSettled()
+{
+	if (width() < 30 || height() < 30)
+		return;
+
+	QFuture<void> f = imageHandler->prepareSquareSize(squareSizeFor(width() - 2, height() - 2));
+	if (f.isFinished())
+		slot_spritesReady();
+	else
+		spriteWatcher->setFuture(f);
+}
+
+void Board::slot_spritesReady()
+{
+	// a newer drag may have come in meanwhile
+	if (resizeTimer->isActive())
+		return;
+
+	resizeBoard();
+}
+
+/*
+* Shows the candidates of a live analysis, an empty list hides them.
+* The overlay is redrawn at most every ANALYSIS_FRAME_INTERVAL.
+*/
+void Board::setAnalysis(const QVector<AnalysisCandidate> &a)
+{
+	pendingAnalysis = a;
+	if (!analysisTimer->isActive())
+		analysisTimer->start();
+}
+
+void Board::slot_analysisFrame()
+{
+	if (!analysisOverlay)
+	{
+		if (pendingAnalysis.isEmpty())
+			return;
+		analysisOverlay = new AnalysisOverlay();
+		analysisOverlay->setGeometry(board_size, offsetX, offsetY, square_size);
+		canvas->addItem(analysisOverlay);
+	}
+	analysisOverlay->setCandidates(pendingAnalysis);
 }
 
 /*
@@ -338,6 +440,9 @@ void Board::resizeBoard()
     if (width() < 30 || height() < 30)
 		return;
 
+	// Drop any stretching done while the size was settling
+	resetTransform();
+
 	// Resize canvas
     canvas->setSceneRect(0,0,width(),height());
 
@@ -347,6 +452,15 @@ void Board::resizeBoard()
 	// Rescale the pixmaps in the ImageHandler
     imageHandler->setSquareSize(square_size);
 
+	if (analysisOverlay)
+		analysisOverlay->setGeometry(board_size, offsetX, offsetY, square_size);
+
+	if (boardItem)
+	{
+		boardItem->setGeometry(canvas->sceneRect(), offsetX, offsetY, offset, square_size, showCoords);
+		return;
+	}
+
 	// Delete gatter lines and update stones positions
 	QList<QGraphicsItem *> list = canvas->items();
 	QGraphicsItem *item;
@@ -439,7 +553,7 @@ void Board::setCursorType(CursorType cur)
 				setCursor(Qt::ArrowCursor);
 			
 			showCursor = false;
-			curStone->hide();
+			hideCursor();
 			break;
 		}
 
@@ -467,7 +581,7 @@ void Board::setCursorType(CursorType cur)
 		{
 			setCursor(Qt::PointingHandCursor);		
 			showCursor = false;
-			curStone->hide();
+			hideCursor();
 			break;
 		}
 
@@ -475,7 +589,7 @@ void Board::setCursorType(CursorType cur)
 		{
 			setCursor(Qt::WaitCursor);
 			showCursor = false;
-			curStone->hide();
+			hideCursor();
 			break;
 		}			
 	}
@@ -490,6 +604,9 @@ void Board::setCursorType(CursorType cur)
   */
 int Board::hasStone(int x, int y)
 {
+	if (boardItem)
+		return boardItem->stoneAt(x, y) != stoneNone ? 1 : 0;
+
 	if (!stones->contains(coordsToKey(x, y)))
 		return 0;
 
@@ -522,6 +639,12 @@ bool Board::hasVarGhost(StoneColor c, int x, int y)
  */
 void Board::updateStone(StoneColor c, int x, int y, bool dead)
 {
+	if (boardItem)
+	{
+		boardItem->setStone(c, x, y, dead);
+		return;
+	}
+
     Stone *stone = stones->value(coordsToKey(x, y),NULL);
     //if ((stone == NULL) & ((c == stoneBlack) || (c == stoneWhite)))
 
@@ -580,6 +703,12 @@ void Board::updateStone(StoneColor c, int x, int y, bool dead)
 void Board::setVarGhost(StoneColor c, int x, int y)
 {
 	Stone *s = NULL;
+
+	if (boardItem)
+	{
+		boardItem->setVarGhost(c, x, y);
+		return;
+	}
 	
 //	if (setting->readIntEntry("VAR_GHOSTS") == vardisplayGhost) TODO
 //		s = new Stone(imageHandler->getGhostPixmaps(), canvas, c, x, y);
@@ -612,6 +741,8 @@ void Board::removeGhosts()
 {
     qDeleteAll(*ghosts);
     ghosts->clear();
+    if (boardItem)
+        boardItem->clearVarGhosts();
 }
 
 /*
@@ -624,6 +755,19 @@ void Board::setMark(int x, int y, MarkType t, bool /*update*/, QString txt, bool
 	
 	Mark *m;
 
+	// The item picks the mark colour itself when painting
+	if (boardItem)
+	{
+		if (boardItem->markAt(x, y) == t && t != markText)
+			return;
+		boardItem->setMark(x, y, t, txt);
+		if (t == markTerrBlack && hasStone(x, y) == 1)
+			updateStone(stoneWhite, x, y, true);
+		else if (t == markTerrWhite && hasStone(x, y) == 1)
+			updateStone(stoneBlack, x, y, true);
+		return;
+	}
+
 	// We already have a mark on this spot? If it is of the same type,
 	// do nothing, else overwrite with the new mark.
 	if ((m = hasMark(x, y)) != NULL)
@@ -768,6 +912,13 @@ void Board::setMark(int x, int y, MarkType t, bool /*update*/, QString txt, bool
 void Board::setMarkText(int x, int y, const QString &txt)
 {
 	Mark *m;
+
+	if (boardItem)
+	{
+		if (!txt.isEmpty() && boardItem->markAt(x, y) == markText)
+			boardItem->setMark(x, y, markText, txt);
+		return;
+	}
     
 	// Oops, no mark here, or no text mark
 	if (txt.isNull() || txt.isEmpty() ||
@@ -804,6 +955,12 @@ Mark* Board::hasMark(int x, int y)
 void Board::removeMark(int x, int y, bool /*update*/)
 {
 	Mark *m = NULL;
+
+	if (boardItem)
+	{
+		boardItem->removeMark(x, y);
+		return;
+	}
 	
 	if (lastMoveMark != NULL &&
 		lastMoveMark->posX() == x &&
@@ -857,6 +1014,15 @@ void Board::removeLastMoveMark()
 	delete lastMoveMark;
 	lastMoveMark = NULL;
 
+	if (boardItem)
+	{
+		if (x == PASS_XY || move->isHandicapMove() || c == stoneNone || x > board_size || y > board_size)
+			boardItem->setLastMove(stoneNone, -1, -1);
+		else
+			boardItem->setLastMove(c, x, y, preferences.number_current_move ? move->getMoveNumber() : -1);
+		return;
+	}
+
     if (x == PASS_XY && y == PASS_XY)  // Passing	(FIXME don't think we use this anymore)
 		removeLastMoveMark();
 	else if(move->isHandicapMove()) {}	// no last move marks on handicaps
@@ -885,6 +1051,16 @@ void Board::removeLastMoveMark()
 //	setCurStoneColor();
 }
 
+/*
+ * Hides the ghost cursor stone, wherever it is drawn
+ */
+void Board::hideCursor()
+{
+	curStone->hide();
+	if (boardItem)
+		boardItem->hideCursorStone();
+}
+
 /*
  * Used to know where the mouse is over the goban
  */
@@ -902,7 +1078,7 @@ int Board::convertCoordsToPoint(int c, int o)
  */
 void Board::leaveEvent(QEvent*)
 {
-	curStone->hide();
+	hideCursor();
 }
 
 /*
@@ -914,20 +1090,21 @@ void Board::mouseMoveEvent ( QMouseEvent * e )
 	if (!showCursor)
 		return;
 
-	int x = convertCoordsToPoint(e->x(), offsetX),
-		y = convertCoordsToPoint(e->y(), offsetY);
+	QPointF p = mapToScene(e->pos());
+	int x = convertCoordsToPoint((int)p.x(), offsetX),
+		y = convertCoordsToPoint((int)p.y(), offsetY);
 
 	/* FIXME, maybe don't draw cursor if x/y changes from downX downY?? */
 	if(downX > 0 && (downX != x || downY != y))
 	{
-        curStone->hide();
+        hideCursor();
 		curX = curY = -1;
 		return;
 	}
 	// Outside the valid board?
 	if ((x < 1) || x > board_size || y < 1 || y > board_size)
 	{
-        curStone->hide();
+        hideCursor();
 		curX = curY = -1;
 		return;
 	}
@@ -946,6 +1123,12 @@ void Board::mouseMoveEvent ( QMouseEvent * e )
 	curX = (short)x;
 	curY = (short)y;
 
+	if (boardItem)
+	{
+		boardItem->setCursorStone(curStone->getColor(), x, y);
+		return;
+	}
+
 //	if (// !showCursor || setting->readBoolEntry("CURSOR") ||
 //		(gamePhase == phaseEdit /*&& boardHandler->getMarkType() != markNone*/) ||
 //		gamePhase == phaseScore ||
@@ -985,8 +1168,10 @@ void Board::wheelEvent(QWheelEvent *e)
  */
 void Board::mousePressEvent(QMouseEvent * e)
 {
-	downX = convertCoordsToPoint(e->x(), offsetX),
-	downY = convertCoordsToPoint(e->y(), offsetY);
+	// scene and view only differ while a resize is pending
+	QPointF p = mapToScene(e->pos());
+	downX = convertCoordsToPoint((int)p.x(), offsetX),
+	downY = convertCoordsToPoint((int)p.y(), offsetY);
 
 	// Button gesture outside the board?
 	if ((downX < 1) || downX > board_size || downY < 1 || downY > board_size)
@@ -1002,8 +1187,9 @@ void Board::mouseReleaseEvent(QMouseEvent* e)
 {
 	mouseState = e->button();
 
-	int 	x = convertCoordsToPoint(e->x(), offsetX),
-		y = convertCoordsToPoint(e->y(), offsetY);
+	QPointF p = mapToScene(e->pos());
+	int 	x = convertCoordsToPoint((int)p.x(), offsetX),
+		y = convertCoordsToPoint((int)p.y(), offsetY);
 
 	/* FIXME click protection... if we don't like, we should change it */
 	if(downX != x || downY != y)
@@ -1051,7 +1237,8 @@ void Board::mouseReleaseEvent(QMouseEvent* e)
 void Board::exportPicture(const QString &fileName,  QString *filter, bool toClipboard)
 {
 
-    QPixmap pix = this->grab(table->boundingRect().toAlignedRect());
+    QRectF r = (boardItem ? boardItem->woodRect() : table->boundingRect());
+    QPixmap pix = this->grab(r.toAlignedRect());
 
 	if (toClipboard)
 	{
@@ -1145,7 +1332,7 @@ bool Board::updateAll(Move * move)
 
             case markNone:
             case markTerrDame:
-                if (hasMark(x, y))
+                if (boardItem ? boardItem->markAt(x, y) != markNone : hasMark(x, y) != NULL)
                 {
                     modified = true;
                     removeMark(x, y, false);
@@ -26,6 +26,7 @@
 #include "defines.h"
 
 #include <QGraphicsView>
+#include <QFutureWatcher>
 
 enum CursorType { cursorIdle, cursorGhostBlack , cursorGhostWhite , cursorWait , cursorNavTo };
 enum CoordType { uninit, sgf, numbertopnoi, numberbottomi };
@@ -35,6 +36,9 @@ class Move;
 class Mark;
 class Stone;
 class Gatter;
+class BoardItem;
+class AnalysisOverlay;
+struct AnalysisCandidate;
 
 class Board : public QGraphicsView
 {
@@ -64,14 +68,21 @@ public:
 	void exportPicture(const QString &fileName,  QString *filter, bool toClipboard);
     bool updateAll(Move *move);
     void updateVariationGhosts(Move *m);
+	void setAnalysis(const QVector<AnalysisCandidate> &a);
 		
 signals:
 	void signalClicked(bool , int, int, Qt::MouseButton );
 	void signalWheelEvent(QWheelEvent *);
 
+private slots:
+	void slot_resizeSettled();
+	void slot_spritesReady();
+	void slot_analysisFrame();
+
 
 protected:
 	void calculateSize();
+	int squareSizeFor(int w, int h);
     void drawBack(); // old drawBackground
 	void initGatter();
 	void drawGatter();
@@ -94,6 +105,12 @@ private:
 	QGraphicsScene *canvas;
 	QGraphicsRectItem *table;
 	Gatter *gatter;
+	QTimer *resizeTimer;
+	QFutureWatcher<void> *spriteWatcher;
+	BoardItem *boardItem;		//NULL unless BOARD_SINGLE_ITEM is set
+	AnalysisOverlay *analysisOverlay;	//NULL until an engine analyses
+	QTimer *analysisTimer;
+	QVector<AnalysisCandidate> pendingAnalysis;
 //	GamePhase gamePhase;
 
 	int board_size, offset, offsetX, offsetY, square_size, board_pixel_size;
@@ -124,6 +141,7 @@ private:
 	bool hasVarGhost(StoneColor c, int x, int y);
 
 	void removeLastMoveMark();
+	void hideCursor();
 	void setMarkText(int x, int y, const QString &txt);
 
 	void mousePressEvent(QMouseEvent *e);
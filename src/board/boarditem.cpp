@@ -0,0 +1,520 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+
+
+/*
+ * boarditem.cpp
+ * Paints the goban, stones, ghosts and marks as a single graphics item,
+ * see boarditem.h.  Sizes and offsets follow the Stone, Mark and Gatter
+ * items so both renderers look the same.
+ */
+#include "boarditem.h"
+#include "imagehandler.h"
+
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+BoardItem::BoardItem(ImageHandler *ih, const QPixmap &wood)
+: QGraphicsItem(0), imageHandler(ih), woodBrush(wood),
+board_size(0), offsetX(0), offsetY(0), offset(0), square_size(0),
+showCoords(true), labelLength(1), passGhost(stoneNone),
+lastColor(stoneNone), lastX(-1), lastY(-1), lastNumber(-1),
+cursorColor(stoneNone), cursorX(-1), cursorY(-1)
+{
+	setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+	setZValue(1);
+}
+
+BoardItem::~BoardItem()
+{
+}
+
+void BoardItem::setBoardSize(int size)
+{
+	board_size = size;
+	points.fill(0, board_size * board_size);
+	labels.clear();
+	labelLength = 1;
+	passGhost = stoneNone;
+	lastX = lastY = cursorX = cursorY = -1;
+}
+
+void BoardItem::setCoordinates(const QStringList &vertical, const QStringList &horizontal)
+{
+	vCoords = vertical;
+	hCoords = horizontal;
+}
+
+/*
+ * Called by Board::resizeBoard with the values from calculateSize
+ */
+void BoardItem::setGeometry(const QRectF &scene, int oX, int oY, int o, int sq, bool coords)
+{
+	prepareGeometryChange();
+	bounds = scene;
+	offsetX = oX;
+	offsetY = oY;
+	offset = o;
+	square_size = sq;
+	showCoords = coords;
+
+	int board_pixel_size = square_size * (board_size-1) + 1;
+	wood_rect = QRectF(offsetX - offset, offsetY - offset,
+			board_pixel_size + offset*2, board_pixel_size + offset*2);
+
+	renderBackground();
+	update();
+}
+
+void BoardItem::clear()
+{
+	points.fill(0);
+	labels.clear();
+	passGhost = stoneNone;
+	lastX = lastY = -1;
+	update();
+}
+
+/*
+ * Wood, grid lines, hoshis and coordinates only change with the size
+ */
+void BoardItem::renderBackground()
+{
+	if (board_size < 1 || wood_rect.isEmpty())
+	{
+		background = QPixmap();
+		return;
+	}
+	background = QPixmap(wood_rect.size().toSize());
+
+	QPainter p(&background);
+	// paint in scene coordinates so the wood lines up with the text mark patches
+	p.translate(-wood_rect.topLeft());
+	p.fillRect(wood_rect, woodBrush);
+
+	paintGrid(&p, board_size, offsetX, offsetY, square_size);
+
+	if (!showCoords || vCoords.size() < board_size || hCoords.size() < board_size)
+		return;
+
+	// as Board::drawCoordinates
+	const int coord_centre = (offset - square_size/2 )/2;
+	const int board_pixel_size = square_size * (board_size-1) + 1;
+	QFontMetricsF fm(p.font());
+	p.setPen(Qt::black);
+	for (int i=0; i<board_size; i++)
+	{
+		qreal w = fm.width(vCoords[i]), h = fm.height();
+		p.drawText(QPointF(offsetX - offset + coord_centre - w/2, offsetY + square_size * i - h/2 + fm.ascent()), vCoords[i]);
+		p.drawText(QPointF(offsetX + board_pixel_size + offset - coord_centre - w/2, offsetY + square_size * i - h/2 + fm.ascent()), vCoords[i]);
+
+		w = fm.width(hCoords[i]);
+		p.drawText(QPointF(offsetX + square_size * i - w/2, offsetY - offset + coord_centre - h/2 + fm.ascent()), hCoords[i]);
+		p.drawText(QPointF(offsetX + square_size * i - w/2, offsetY + offset + board_pixel_size - coord_centre - h/2 + fm.ascent()), hCoords[i]);
+	}
+}
+
+/*
+ * Grid lines and hoshis, sized as in Gatter::resize
+ */
+void BoardItem::paintGrid(QPainter *p, int board_size, int offsetX, int offsetY, int square_size)
+{
+	int length = square_size * (board_size-1);
+	p->setPen(QPen());
+	for (int i=0; i<board_size; i++)
+	{
+		p->drawLine(offsetX + square_size * i, offsetY, offsetX + square_size * i, offsetY + length);
+		p->drawLine(offsetX, offsetY + square_size * i, offsetX + length, offsetY + square_size * i);
+	}
+
+	int size = square_size / 5;
+	if (size % 2 == 0)
+		size--;
+	if ((size < 7) && (size>2))
+		size = 7;
+	else if (size <= 2)
+		size = 3;
+
+	int edge_dist = (board_size > 12 ? 4 : 3);
+	int low = edge_dist - 1;
+	int middle = (board_size + 1) / 2 - 1;
+	int high = board_size - edge_dist;
+	QList<QPoint> hoshis;
+	if (board_size % 2 && board_size >= 9)
+		hoshis << QPoint(middle, middle);
+	if (board_size % 2 && board_size > 13)
+		hoshis << QPoint(middle, low) << QPoint(middle, high) << QPoint(low, middle) << QPoint(high, middle);
+	hoshis << QPoint(low, low) << QPoint(high, low) << QPoint(high, high) << QPoint(low, high);
+
+	p->save();
+	p->setRenderHint(QPainter::Antialiasing);
+	p->setPen(Qt::NoPen);
+	p->setBrush(Qt::black);
+	for (int i=0; i<hoshis.size(); i++)
+		p->drawEllipse(offsetX + square_size * hoshis[i].x() - size/2,
+				offsetY + square_size * hoshis[i].y() - size/2, size, size);
+	p->restore();
+}
+
+/*
+ * The area a point may paint into, shadow included
+ */
+QRectF BoardItem::pointRect(int x, int y) const
+{
+	return QRectF(offsetX + square_size * (x - 2), offsetY + square_size * (y - 2),
+			square_size * 2, square_size * 2);
+}
+
+void BoardItem::updatePoint(int x, int y)
+{
+	if (square_size)
+		update(pointRect(x, y));
+}
+
+void BoardItem::setStone(StoneColor c, int x, int y, bool dead)
+{
+	if (!onBoard(x, y))
+		return;
+
+	quint32 &w = points[indexOf(x, y)];
+	quint32 old = w;
+
+	w &= ~(colorMask | deadBit);
+	if (c == stoneBlack || c == stoneWhite)
+	{
+		// Stones pick a random white when they're placed
+		if ((old & colorMask) != (quint32)c)
+			w = (w & ~variantMask) | ((rand() % WHITE_STONES_NB) << variantShift);
+		w |= c;
+		if (dead)
+			w |= deadBit;
+	}
+	if (w != old)
+		updatePoint(x, y);
+}
+
+StoneColor BoardItem::stoneAt(int x, int y) const
+{
+	if (!onBoard(x, y))
+		return stoneNone;
+	return (StoneColor)(points[indexOf(x, y)] & colorMask);
+}
+
+bool BoardItem::isDead(int x, int y) const
+{
+	return onBoard(x, y) && (points[indexOf(x, y)] & deadBit);
+}
+
+void BoardItem::setVarGhost(StoneColor c, int x, int y)
+{
+	if (x == PASS_XY && y == PASS_XY)
+		passGhost = c;
+	else if (onBoard(x, y))
+	{
+		quint32 &w = points[indexOf(x, y)];
+		w = (w & ~ghostMask) | (c << ghostShift);
+	}
+	else
+		return;
+	update();
+}
+
+bool BoardItem::hasVarGhost(StoneColor c, int x, int y) const
+{
+	return onBoard(x, y) && ((points[indexOf(x, y)] & ghostMask) >> ghostShift) == (quint32)c;
+}
+
+void BoardItem::clearVarGhosts()
+{
+	for (int i=0; i<points.size(); i++)
+		points[i] &= ~ghostMask;
+	passGhost = stoneNone;
+	update();
+}
+
+void BoardItem::setMark(int x, int y, MarkType t, const QString &txt)
+{
+	if (!onBoard(x, y))
+		return;
+
+	if (x == lastX && y == lastY)
+		setLastMove(stoneNone, -1, -1);
+
+	quint32 &w = points[indexOf(x, y)];
+	w = (w & ~markMask) | (t << markShift);
+	if (t == markText || t == markNumber)
+	{
+		labels.insert(indexOf(x, y), txt);
+		if (txt.length() > labelLength)
+		{
+			labelLength = txt.length();
+			update();
+		}
+	}
+	else
+		labels.remove(indexOf(x, y));
+	updatePoint(x, y);
+}
+
+MarkType BoardItem::markAt(int x, int y) const
+{
+	if (!onBoard(x, y))
+		return markNone;
+	return (MarkType)((points[indexOf(x, y)] & markMask) >> markShift);
+}
+
+void BoardItem::removeMark(int x, int y)
+{
+	if (!onBoard(x, y))
+		return;
+
+	if (x == lastX && y == lastY)
+		setLastMove(stoneNone, -1, -1);
+
+	points[indexOf(x, y)] &= ~markMask;
+	labels.remove(indexOf(x, y));
+	updatePoint(x, y);
+}
+
+/*
+ * A number >= 0 draws the move number instead of the cross
+ */
+void BoardItem::setLastMove(StoneColor c, int x, int y, int number)
+{
+	if (onBoard(lastX, lastY))
+		updatePoint(lastX, lastY);
+
+	lastColor = c;
+	lastX = x;
+	lastY = y;
+	lastNumber = number;
+	if (onBoard(lastX, lastY))
+		updatePoint(lastX, lastY);
+}
+
+void BoardItem::setCursorStone(StoneColor c, int x, int y)
+{
+	if (c == cursorColor && x == cursorX && y == cursorY)
+		return;
+	if (onBoard(cursorX, cursorY))
+		updatePoint(cursorX, cursorY);
+
+	cursorColor = c;
+	cursorX = x;
+	cursorY = y;
+	if (onBoard(cursorX, cursorY))
+		updatePoint(cursorX, cursorY);
+}
+
+void BoardItem::hideCursorStone()
+{
+	setCursorStone(cursorColor, -1, -1);
+}
+
+void BoardItem::paintPixmapAt(QPainter *p, const QPixmap &pix, int x, int y)
+{
+	p->drawPixmap(offsetX + square_size * (x - 1) - pix.width()/2,
+			offsetY + square_size * (y - 1) - pix.height()/2, pix);
+}
+
+void BoardItem::paintMark(QPainter *p, const QPointF &centre, int square_size, MarkType t,
+			const QColor &col, const QString &txt, int labelLength, bool plus)
+{
+	const qreal cx = centre.x();
+	const qreal cy = centre.y();
+	qreal s;
+
+	p->setBrush(Qt::NoBrush);
+	p->setPen(QPen(col, 2));
+	switch (t)
+	{
+	case markSquare:
+		s = square_size * 0.5;
+		p->drawRect(QRectF(cx - s/2, cy - s/2, s, s));
+		break;
+
+	case markCircle:
+		s = square_size * 0.5;
+		p->setRenderHint(QPainter::Antialiasing);
+		p->drawEllipse(QRectF(cx - s/2, cy - s/2, s, s));
+		p->setRenderHint(QPainter::Antialiasing, false);
+		break;
+
+	case markTriangle:
+	{
+		s = square_size * 0.55;
+		QPolygonF pa;
+		pa << QPointF(cx, cy - s/2) << QPointF(cx - s/2, cy + s/2) << QPointF(cx + s/2, cy + s/2);
+		p->setRenderHint(QPainter::Antialiasing);
+		p->drawPolygon(pa);
+		p->setRenderHint(QPainter::Antialiasing, false);
+		break;
+	}
+
+	case markCross:
+	case markTerrBlack:
+	case markTerrWhite:
+		s = square_size * 0.45;
+		if (plus)
+		{
+			p->drawLine(QPointF(cx, cy - s/2), QPointF(cx, cy + s/2));
+			p->drawLine(QPointF(cx - s/2, cy), QPointF(cx + s/2, cy));
+		}
+		else
+		{
+			p->drawLine(QPointF(cx - s/2, cy - s/2), QPointF(cx + s/2, cy + s/2));
+			p->drawLine(QPointF(cx - s/2, cy + s/2), QPointF(cx + s/2, cy - s/2));
+		}
+		break;
+
+	case markText:
+	case markNumber:
+	{
+		QFont f("", qMax(1, (int)(square_size * 0.5 / labelLength)));
+		f.setBold(false);
+		f.setStyleStrategy(QFont::NoAntialias);
+		p->setFont(f);
+		p->setPen(col);
+		p->drawText(QRectF(cx - square_size/2.0, cy - square_size/2.0, square_size, square_size),
+				Qt::AlignCenter, txt);
+		break;
+	}
+
+	default:
+		break;
+	}
+}
+
+/*
+ * Draws, in order, what the separate items were stacked as:
+ * territory stones, variation and cursor ghosts, shadows, stones, marks
+ */
+void BoardItem::paint(QPainter *p, const QStyleOptionGraphicsItem *option, QWidget *)
+{
+	if (board_size < 1 || square_size < 1)
+		return;
+
+	const QRectF exposed = option->exposedRect;
+	const QRectF target = exposed & wood_rect;
+	if (!target.isEmpty() && !background.isNull())
+		p->drawPixmap(target, background, target.translated(-wood_rect.topLeft()));
+
+	// Points that may paint into the exposed rect, one more for shadows
+	const int x1 = qMax(1, (int)((exposed.left() - offsetX) / square_size));
+	const int x2 = qMin(board_size, (int)((exposed.right() - offsetX) / square_size) + 2);
+	const int y1 = qMax(1, (int)((exposed.top() - offsetY) / square_size));
+	const int y2 = qMin(board_size, (int)((exposed.bottom() - offsetY) / square_size) + 2);
+
+	const QList<QPixmap> *stones = imageHandler->getStonePixmaps();
+	const QList<QPixmap> *ghosts = imageHandler->getGhostPixmaps();
+	const QList<QPixmap> *smallStones = imageHandler->getSmallStonePixmaps();
+	const QList<QPixmap> *altGhosts = ImageHandler::getAlternateGhostPixmaps();
+	const bool smallStoneTerr = preferences.terr_stone_mark && smallStones && smallStones->size() > 1;
+	int x, y;
+
+	// Labels hide the grid under them, territory stones sit on it
+	for (y = y1; y <= y2; y++)
+		for (x = x1; x <= x2; x++)
+		{
+			const quint32 w = points[indexOf(x, y)];
+			const int mark = (w & markMask) >> markShift;
+			if (mark == markText || mark == markNumber)
+				p->fillRect(QRectF(offsetX + square_size * (x - 1.5), offsetY + square_size * (y - 1.5),
+						square_size, square_size), woodBrush);
+			else if (smallStoneTerr && (mark == markTerrBlack || mark == markTerrWhite))
+				paintPixmapAt(p, smallStones->at(mark == markTerrBlack ? 0 : 1), x, y);
+		}
+
+	if (altGhosts && altGhosts->size() >= 2)
+	{
+		for (y = y1; y <= y2; y++)
+			for (x = x1; x <= x2; x++)
+			{
+				const quint32 g = (points[indexOf(x, y)] & ghostMask) >> ghostShift;
+				if (g == stoneBlack || g == stoneWhite)
+					paintPixmapAt(p, altGhosts->at(g == stoneBlack ? 0 : 1), x, y);
+			}
+		if (passGhost == stoneBlack || passGhost == stoneWhite)
+			p->drawPixmap(offsetX + square_size * (board_size+1), offsetY + square_size * board_size,
+					altGhosts->at(passGhost == stoneBlack ? 0 : 1));
+	}
+
+	if (onBoard(cursorX, cursorY) && ghosts->size() >= 2)
+		paintPixmapAt(p, ghosts->at(cursorColor == stoneBlack ? 0 : 1), cursorX, cursorY);
+
+	if (stones->size() < WHITE_STONES_NB + 2)
+		return;
+	const QPixmap &shadow = stones->last();
+	const qreal shadowOffset = shadow.height() / 8.0;
+	for (y = y1; y <= y2; y++)
+		for (x = x1; x <= x2; x++)
+		{
+			const quint32 w = points[indexOf(x, y)];
+			if (!(w & colorMask) || (w & deadBit))
+				continue;
+			p->drawPixmap(QPointF(offsetX + square_size * (x - 1) - stones->at(0).width()/2 - shadowOffset,
+					offsetY + square_size * (y - 1) - stones->at(0).height()/2 + shadowOffset), shadow);
+		}
+
+	for (y = y1; y <= y2; y++)
+		for (x = x1; x <= x2; x++)
+		{
+			const quint32 w = points[indexOf(x, y)];
+			const StoneColor c = (StoneColor)(w & colorMask);
+			if (c != stoneBlack && c != stoneWhite)
+				continue;
+			const QList<QPixmap> *list = (w & deadBit) ? ghosts : stones;
+			int i = (c == stoneBlack ? 0 : ((w & variantMask) >> variantShift) + 1);
+			paintPixmapAt(p, list->at(qMin(i, list->size() - 1)), x, y);
+		}
+
+	for (y = y1; y <= y2; y++)
+		for (x = x1; x <= x2; x++)
+		{
+			const quint32 w = points[indexOf(x, y)];
+			const MarkType mark = (MarkType)((w & markMask) >> markShift);
+			if (mark == markNone)
+				continue;
+			QColor col;
+			if (mark == markTerrBlack || mark == markTerrWhite)
+			{
+				if (smallStoneTerr)
+					continue;
+				col = (mark == markTerrBlack ? Qt::black : Qt::white);
+			}
+			else if ((w & colorMask) == stoneBlack || ((w & ghostMask) >> ghostShift) == stoneBlack)
+				col = Qt::white;
+			else
+				col = Qt::black;
+			paintMark(p, centreOf(x, y), square_size, mark, col, labels.value(indexOf(x, y)), labelLength);
+		}
+
+	if (onBoard(lastX, lastY) && lastX >= x1 && lastX <= x2 && lastY >= y1 && lastY <= y2)
+	{
+		QColor col = (lastColor == stoneBlack ? Qt::white : Qt::black);
+		if (lastNumber >= 0)
+			paintMark(p, centreOf(lastX, lastY), square_size, markNumber, col, QString::number(lastNumber), labelLength);
+		else
+			paintMark(p, centreOf(lastX, lastY), square_size, markCross, col, QString(), labelLength, true);
+	}
+}
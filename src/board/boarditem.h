@@ -0,0 +1,114 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+
+
+#ifndef BOARDITEM_H
+#define BOARDITEM_H
+
+#include "defines.h"
+#include "graphicsitemstypes.h"
+
+#include <QGraphicsItem>
+#include <QtCore>
+
+class ImageHandler;
+
+/* Draws a whole goban as one scene item.  Instead of an item for every
+ * stone, shadow, mark, grid line and coordinate, the state of each
+ * point is packed into one word and paint() draws whatever intersects
+ * the exposed rect on top of a cached pixmap of the wood, grid, hoshis
+ * and coordinates.  Board uses it in place of its Stone, Mark and Gatter
+ * items when the BOARD_SINGLE_ITEM setting is on. */
+class BoardItem : public QGraphicsItem
+{
+public:
+	BoardItem(ImageHandler *ih, const QPixmap &wood);
+	~BoardItem();
+	int type() const { return RTTI_BOARD; }
+	QRectF boundingRect() const { return bounds; }
+	QRectF woodRect() const { return wood_rect; }
+	void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget = 0);
+
+	void setBoardSize(int size);
+	void setCoordinates(const QStringList &vertical, const QStringList &horizontal);
+	void setGeometry(const QRectF &scene, int offsetX, int offsetY, int offset,
+				int square_size, bool showCoords);
+	void clear();
+
+	void setStone(StoneColor c, int x, int y, bool dead);
+	StoneColor stoneAt(int x, int y) const;
+	bool isDead(int x, int y) const;
+	void setVarGhost(StoneColor c, int x, int y);
+	bool hasVarGhost(StoneColor c, int x, int y) const;
+	void clearVarGhosts();
+	void setMark(int x, int y, MarkType t, const QString &txt = QString());
+	MarkType markAt(int x, int y) const;
+	void removeMark(int x, int y);
+	void setLastMove(StoneColor c, int x, int y, int number = -1);
+	void setCursorStone(StoneColor c, int x, int y);
+	void hideCursorStone();
+
+	/* Also used by DiagramExporter */
+	static void paintGrid(QPainter *p, int board_size, int offsetX, int offsetY, int square_size);
+	static void paintMark(QPainter *p, const QPointF &centre, int square_size, MarkType t,
+				const QColor &col, const QString &txt, int labelLength = 1, bool plus = false);
+
+private:
+	/* Layout of a point word */
+	enum {
+		colorMask = 0x3,		//StoneColor
+		deadBit = 0x4,
+		variantShift = 3,		//which of the white stones
+		variantMask = 0x38,
+		ghostShift = 6,			//variation ghost StoneColor
+		ghostMask = 0xc0,
+		markShift = 8,			//MarkType
+		markMask = 0xff00
+	};
+
+	inline int indexOf(int x, int y) const { return (y-1)*board_size + x-1; }
+	inline bool onBoard(int x, int y) const { return x >= 1 && x <= board_size && y >= 1 && y <= board_size; }
+	QRectF pointRect(int x, int y) const;
+	void updatePoint(int x, int y);
+	void renderBackground();
+	QPointF centreOf(int x, int y) const { return QPointF(offsetX + square_size * (x - 1), offsetY + square_size * (y - 1)); }
+	void paintPixmapAt(QPainter *p, const QPixmap &pix, int x, int y);
+
+	ImageHandler *imageHandler;
+	QBrush woodBrush;
+	QPixmap background;
+	QVector<quint32> points;
+	QHash<int, QString> labels;
+	QStringList vCoords, hCoords;
+	QRectF bounds, wood_rect;
+	int board_size, offsetX, offsetY, offset, square_size;
+	bool showCoords;
+	int labelLength;		//longest label, all are drawn at the same size
+	StoneColor passGhost;
+	StoneColor lastColor;
+	int lastX, lastY, lastNumber;
+	StoneColor cursorColor;
+	int cursorX, cursorY;
+};
+
+#endif
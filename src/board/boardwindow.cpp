@@ -29,6 +29,8 @@
 #include "../network/boarddispatch.h"
 #include "gameinfo.h"
 #include "matrix.h"
+#include "engineanalysis.h"
+#include "searchdialog.h"
 #include "ui_boardwindow.h"
 #include <QtWidgets>
 
@@ -64,6 +66,8 @@ BoardWindow::BoardWindow(GameData *gd, bool iAmBlack , bool iAmWhite, class Boar
 
 	//Creates the game tree
     tree = new Tree(boardSize, gameData->komi);
+    analysis = NULL;
+    searchDialog = NULL;
 	
 	//Loads the sgf file if any
 	if (! gameData->fileName.isEmpty())
@@ -161,6 +165,8 @@ BoardWindow::BoardWindow(GameData *gd, bool iAmBlack , bool iAmWhite, class Boar
     connect(ui->actionExportPic, SIGNAL(triggered(bool)), SLOT(slotExportPic()));
     connect(ui->actionDuplicate, SIGNAL(triggered(bool)), SLOT(slotDuplicate()));
     connect(ui->actionGameInfo, SIGNAL(triggered(bool)), SLOT(slotGameInfo(bool)));
+    connect(ui->actionAnalyse, SIGNAL(toggled(bool)), SLOT(slotAnalyse(bool)));
+    connect(ui->actionFind, SIGNAL(triggered(bool)), SLOT(slotFind()));
 
     connect(tree, SIGNAL(currentMoveChanged(Move*)), this, SLOT(updateMove(Move*)));
     connect(tree, SIGNAL(scoreChanged(int,int,int,int,int,int)), this, SLOT(slotGetScore(int,int,int,int,int,int)));
@@ -257,6 +263,9 @@ BoardWindow::BoardWindow(GameData *gd, bool iAmBlack , bool iAmWhite, class Boar
 	}
     if (gameData->gameMode == modeLocal)
         connect(ui->insertMoveButton, SIGNAL(toggled(bool)), static_cast<qGoBoardLocalInterface*>(qgoboard), SLOT(slotToggleInsertStones(bool)));
+    // Edit boards may be switched to local mode later
+    if (dynamic_cast<qGoBoardLocalInterface*>(qgoboard) != NULL)
+        connect(ui->computerAnalysis, SIGNAL(toggled(bool)), qgoboard, SLOT(slotToggleLiveAnalysis(bool)));
     //make sure to set the sound button to the proper state before anything
     ui->actionSound->setChecked(qgoboard->getPlaySound());
 
@@ -315,6 +324,8 @@ BoardWindow::~BoardWindow()
 	settings.setValue("BOARD_WINDOW_SIZE_Y", height());
 //	settings.setValue("BOARD_SIZES", ui->boardSplitter->saveState());
 	
+	// The engines may still answer about nodes of the tree
+	delete analysis;
 	delete tree;	//okay?
 	
 	delete gameData;
@@ -570,6 +581,77 @@ void BoardWindow::slotExportPicClipB()
     ui->board->exportPicture(0, 0 , true);
 }
 
+/*
+ * button 'analyse' toggled : runs the engines over the game, the answers
+ * are added to the comments of the moves
+ */
+void BoardWindow::slotAnalyse(bool toggle)
+{
+    if (!toggle)
+    {
+        if (analysis)
+            analysis->stop();
+        return;
+    }
+
+    if (!analysis)
+    {
+        analysis = new EngineAnalysis(tree, boardSize, gameData->komi, this);
+        connect(analysis, SIGNAL(signal_analysed(Move*)), SLOT(slotAnalysed(Move*)));
+        connect(analysis, SIGNAL(signal_progress(int,int)), SLOT(slotAnalysisProgress(int,int)));
+        connect(analysis, SIGNAL(signal_finished()), SLOT(slotAnalysisFinished()));
+    }
+
+    QSettings settings;
+    if (!analysis->start(settings.value("ANALYSIS_VARIATIONS").toBool()))
+    {
+        ui->actionAnalyse->setChecked(false);
+        QMessageBox::warning(this, tr("Analysis"), tr("Could not start the analysis: %1").arg(analysis->getLastMessage()));
+    }
+}
+
+void BoardWindow::slotAnalysed(Move *m)
+{
+    qgoboard->setModified(true);
+    if (m == tree->getCurrent() && getGameMode() == modeEdit)
+        ui->commentEdit->setPlainText(m->getComment());
+}
+
+void BoardWindow::slotAnalysisProgress(int done, int total)
+{
+    ui->statusbar->showMessage(tr("Analysed %1 of %2 positions").arg(done).arg(total));
+}
+
+void BoardWindow::slotAnalysisFinished()
+{
+    ui->actionAnalyse->setChecked(false);
+    // Engines failed after start(), some positions were left out
+    if (!analysis->getLastMessage().isEmpty())
+        QMessageBox::warning(this, tr("Analysis"), tr("The analysis stopped: %1").arg(analysis->getLastMessage()));
+    else
+        ui->statusbar->showMessage(tr("Analysis done"), 5000);
+}
+
+/*
+ * button 'find' activated
+ */
+void BoardWindow::slotFind()
+{
+    showSearch(QString());
+}
+
+/* The dialog stays around once made, so the last search is still there */
+void BoardWindow::showSearch(const QString &query, int match)
+{
+    if (!searchDialog)
+        searchDialog = new SearchDialog(tree, this);
+    if (!query.isEmpty())
+        searchDialog->setQuery(query, match);
+    searchDialog->show();
+    searchDialog->raise();
+    searchDialog->activateWindow();
+}
+
 /*
  * button 'duplicate board' activated
  */
@@ -971,6 +1053,7 @@ void BoardWindow::switchToEditMode()
     gameData->gameMode = modeEdit;
     setMode(modeEdit);
     ui->computerControlsWidget->setVisible(gameData->gameMode == modeLocal);
+    ui->computerAnalysis->setChecked(false);
     myColorIsBlack = true;
     myColorIsWhite = true;
 }
@@ -1315,6 +1398,11 @@ void BoardWindow::setMode(GameMode mode)
     }
 
 
+    // Only an edited game can be analysed
+    ui->actionAnalyse->setEnabled(mode == modeEdit);
+    if (mode != modeEdit)
+        ui->actionAnalyse->setChecked(false);
+
     switch (mode)
     {
 
@@ -1624,6 +1712,11 @@ void BoardWindow::warnTimeWhite(TimeWarnState state)
     }
 }
 
+void BoardWindow::setAnalysis(const QVector<AnalysisCandidate> &a)
+{
+    ui->board->setAnalysis(a);
+}
+
 void BoardWindow::displayComment(QString comment)
 {
     // add comments to SGF/tree FIXME
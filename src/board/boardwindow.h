@@ -34,6 +34,9 @@ class QLabel;
 class QButtonGroup;
 class Board;
 class Move;
+class EngineAnalysis;
+class SearchDialog;
+struct AnalysisCandidate;
 namespace Ui {
 class BoardWindow;
 }
@@ -92,6 +95,8 @@ public:
     void warnTimeBlack(TimeWarnState state);
     void warnTimeWhite(TimeWarnState state);
     void displayComment(QString comment);
+    void setAnalysis(const QVector<AnalysisCandidate> &a);
+    void showSearch(const QString &query, int match = -1);
 
 protected:
 	void closeEvent(QCloseEvent *e);
@@ -114,6 +119,11 @@ public slots:
 	void slotExportPicClipB();
 	void slotExportPic();
 	void slotDuplicate();
+	void slotFind();
+	void slotAnalyse(bool toggle);
+	void slotAnalysed(Move *m);
+	void slotAnalysisProgress(int done, int total);
+	void slotAnalysisFinished();
     void slot_addtime_menu(QAction *);
     void setComputerBlack(bool val);
     void setComputerWhite(bool val);
@@ -154,6 +164,8 @@ private:
 	QButtonGroup *editButtons;
 	MarkType editMark;
 	ClockDisplay *clockDisplay;
+	EngineAnalysis *analysis;
+	SearchDialog *searchDialog;
     QTime wheelTime;
 };
 
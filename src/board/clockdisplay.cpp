@@ -29,6 +29,7 @@
 
 
 #include "clockdisplay.h"
+#include "clockservice.h"
 #include "boardwindow.h"
 #include "audio.h"
 #include "network/messages.h" 		//for the TimeRecord FIXME
@@ -57,6 +58,7 @@ ClockDisplay::ClockDisplay(BoardWindow *bw, TimeSystem s, int _maintime, int _pe
 	warningSecs = settings.value("BYO_SEC_WARNING").toInt();
 
     warningSound = 	new Sound("timer.wav");
+	hold(true);
 }
 
 void ClockDisplay::setTimeSettings(TimeSystem s, int m, int p, int o)
@@ -71,8 +73,9 @@ void ClockDisplay::setTimeSettings(TimeSystem s, int m, int p, int o)
  * This takes alls values coming from the time information and updates the clocks
  */
  /* FIXME, change to take TimeRecords ?? or not*/
-void ClockDisplay::setTimeInfo(int btime, int bstones_periods, int wtime, int wstones_periods)
+void ClockDisplay::setTimeInfo(int btime, int bstones_periods, int wtime, int wstones_periods, int lag)
 {
+	bool running = false;
 	/* FIXME DOUBLECHECK if this is allowed.  We want to be able
 	 * to pass empty records but, this may not be the way to
 	 * do it */
@@ -80,20 +83,65 @@ void ClockDisplay::setTimeInfo(int btime, int bstones_periods, int wtime, int ws
 	{
 		w_time = wtime;
 		w_stones_periods = wstones_periods; 
+		running = running || !last_black;
 	}
 	if(btime != 0 || bstones_periods != -1)
 	{ 
 		b_time = btime;
 		b_stones_periods = bstones_periods;
+		running = running || last_black;
+	}
+	/* The server read its clock about lag ms ago, that much has
+	 * already gone from whoever is on turn.  Updates for the player
+	 * waiting leave the running count alone. */
+	if(running)
+	{
+		turnStart = ClockService::now();
+		turnConsumed = -lag;
 	}
 	//printf("wb %d %d %d %d\n", w_time, b_time, w_stones_periods, b_stones_periods);
 	updateTimers();
 }
 
 /*
- * decrease the timer info according to the step, and updates the clocks
+ * counts down the running clock by the whole seconds that have gone by
+ * since the turn started or the server last told us the time.  Only
+ * updates the clocks and returns true if at least one did.
+ */
+bool ClockDisplay::setTimeStep(bool black)
+{
+	if(black != last_black)
+	{
+		hold(black);
+		return false;
+	}
+	qint64 due = ClockService::now() - turnStart - turnConsumed;
+	if(due < 1000)
+		return false;
+	int secs = due / 1000;
+	turnConsumed += (qint64)secs * 1000;
+	while(secs--)
+		stepSecond(black);
+	
+	updateTimers();
+	return true;
+}
+
+/*
+ * restarts the monotonic count for the player on turn, for a new turn
+ * or while the clock is paused
  */
-void ClockDisplay::setTimeStep(bool black)
+void ClockDisplay::hold(bool black)
+{
+	last_black = black;
+	turnStart = ClockService::now();
+	turnConsumed = 0;
+}
+
+/*
+ * decrease the timer info by one second, rolling over into the next period
+ */
+void ClockDisplay::stepSecond(bool black)
 {
 	if (black)
 	{
@@ -169,8 +217,6 @@ void ClockDisplay::setTimeStep(bool black)
 				printf("other timesystem\n");
 		}
 	}
-	
-	updateTimers();
 }
 
 void ClockDisplay::makeMove(bool black)
@@ -195,6 +241,7 @@ void ClockDisplay::makeMove(bool black)
 
 void ClockDisplay::rerackTime(bool black)
 {
+	hold(black);
 	if (black)
 	{
 		if(timeSystem == canadian && b_stones_periods == 0)
@@ -307,7 +354,7 @@ bool ClockDisplay::warning(bool black)
 		{
             boardwindow->warnTimeBlack(TimeLow);
             if (playWarningSound)
-                warningSound->play();
+                warningSound->play(boardwindow);
         }
 		else if(b_time == 0 && b_stones_periods == 0)	//FIXME for tvasia
 		{
@@ -323,7 +370,7 @@ bool ClockDisplay::warning(bool black)
 		{
             boardwindow->warnTimeWhite(TimeLow);
 			if (playWarningSound)
-				warningSound->play();
+				warningSound->play(boardwindow);
         }
 		else if(w_time == 0 && w_stones_periods == 0)
 		{
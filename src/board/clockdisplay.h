@@ -37,15 +37,17 @@ public:
 	ClockDisplay(BoardWindow *bw, TimeSystem s, int _maintime, int _period, int _periodtime);
 	~ClockDisplay() {}
 	void setTime( bool black, int secs);
-	void setTimeStep(bool black);
+	bool setTimeStep(bool black);
+	void hold(bool black);
 	void rerackTime(bool black);
 	void makeMove(bool black);
 	class TimeRecord getTimeRecord(bool black);
 	void setTimeSettings(TimeSystem s, int m, int p, int o);
-	void setTimeInfo(int btime, int bstones_periods, int wtime, int wstones_periods);
+	void setTimeInfo(int btime, int bstones_periods, int wtime, int wstones_periods, int lag = 0);
 	void updateTimers();
 	bool warning(bool black);
 private :
+	void stepSecond(bool black);
 	BoardWindow *boardwindow;
 	TimeSystem timeSystem;
 	int w_time, b_time;
@@ -56,6 +58,7 @@ private :
 	bool playWarningSound;
 	bool outOfMainTime;
 	bool last_black;
+	qint64 turnStart, turnConsumed;	//ms, ClockService::now()
 };
 
 #endif
@@ -0,0 +1,81 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+
+
+#include "clockservice.h"
+#include "qgoboard.h"
+#include "defines.h"
+
+ClockService * ClockService::instance = 0;
+QElapsedTimer ClockService::monotonic;
+
+ClockService::ClockService() : QObject(QCoreApplication::instance())
+{
+	timer.setInterval(CLOCK_TICK_INTERVAL);
+	connect(&timer, SIGNAL(timeout()), SLOT(slot_tick()));
+}
+
+ClockService * ClockService::service(void)
+{
+	if(!instance)
+		instance = new ClockService();
+	return instance;
+}
+
+qint64 ClockService::now(void)
+{
+	if(!monotonic.isValid())
+		monotonic.start();
+	return monotonic.elapsed();
+}
+
+void ClockService::addBoard(qGoBoard * board)
+{
+	ClockService * s = service();
+	if(s->boards.contains(board))
+		return;
+	s->boards.append(board);
+	if(!s->timer.isActive())
+		s->timer.start();
+}
+
+void ClockService::removeBoard(qGoBoard * board)
+{
+	if(!instance)
+		return;
+	instance->boards.removeAll(board);
+	if(instance->boards.isEmpty())
+		instance->timer.stop();
+}
+
+void ClockService::slot_tick(void)
+{
+	/* A tick can end a game on time and take its board out of the
+	 * list, so walk a copy */
+	QList<qGoBoard *> ticking = boards;
+	for(int i = 0; i < ticking.size(); i++)
+	{
+		if(boards.contains(ticking[i]))
+			ticking[i]->clockTick();
+	}
+}
@@ -0,0 +1,59 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+
+
+#ifndef CLOCKSERVICE_H
+#define CLOCKSERVICE_H
+
+#include <QtCore>
+
+class qGoBoard;
+
+/* Every board with a running game clock registers here instead of
+ * starting its own one second timer.  A single timer ticks all of them
+ * a few times a second and the ClockDisplays work out from monotonic
+ * time how many whole seconds have gone by, so a late tick never loses
+ * a second and a board only does anything when one has passed. */
+class ClockService : public QObject
+{
+	Q_OBJECT
+
+public:
+	static void addBoard(qGoBoard * board);
+	static void removeBoard(qGoBoard * board);
+	static qint64 now(void);	//monotonic ms
+
+private slots:
+	void slot_tick(void);
+
+private:
+	ClockService();
+	static ClockService * service(void);
+
+	QTimer timer;
+	QList<qGoBoard *> boards;
+	static ClockService * instance;
+	static QElapsedTimer monotonic;
+};
+
+#endif //CLOCKSERVICE_H
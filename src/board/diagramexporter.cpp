@@ -0,0 +1,370 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+
+
+#include "diagramexporter.h"
+#include "boarditem.h"
+#include "imagehandler.h"
+#include "sgfparser.h"
+#include "gamedata.h"
+#include "tree.h"
+#include "move.h"
+#include "matrix.h"
+
+#include <QPainter>
+#include <QSvgGenerator>
+#include <QtConcurrent>
+
+DiagramExporter::DiagramExporter(const QString &d, const Options &o)
+: dir(d), options(o)
+{
+	QSettings settings;
+
+	if (options.svg)
+		return;
+	// no ImageHandler has loaded the default wood when we run headless
+	QPixmap skin = ImageHandler::getBoardPixmap(settings.value("SKIN").toString());
+	if (!skin.isNull())
+		wood = skin.toImage();
+	else
+		wood = QImage(":/boardicons/resources/pics/wood.png");
+}
+
+/*
+ * Returns the number of diagrams written
+ */
+int DiagramExporter::exportFiles(const QStringList &files)
+{
+	if (!dir.exists() && !dir.mkpath("."))
+	{
+		qWarning("Can't create diagram directory %s", dir.path().toLatin1().constData());
+		return 0;
+	}
+	SGFParser::setInteractive(false);
+
+	for (int i = 0; i < files.size(); i++)
+	{
+		SGFParser parser(NULL);
+		QString sgf = parser.loadFile(files[i]);
+		if (sgf.isEmpty())
+			continue;
+
+		QStringList games = splitCollection(sgf);
+		QString baseName = QFileInfo(files[i]).completeBaseName();
+		for (int j = 0; j < games.size(); j++)
+		{
+			GameData * gameData = parser.initGame(games[j], files[i]);
+			if (!gameData)
+			{
+				qWarning("Can't read game %d of %s", j + 1, files[i].toLatin1().constData());
+				continue;
+			}
+			Tree tree(gameData->board_size, gameData->komi);
+			SGFParser gameParser(&tree);
+			if (gameParser.doParse(games[j]))
+				collect(games.size() > 1 ? baseName + "-" + QString::number(j + 1) : baseName,
+					&tree, gameData->board_size);
+			delete gameData;
+		}
+	}
+
+	// Stones are painted once per size, before the diagrams share them
+	if (!options.svg)
+		for (int i = 0; i < diagrams.size(); i++)
+			prepareStones(squareSize(diagrams[i].board_size));
+
+	QtConcurrent::blockingMap(diagrams, &DiagramExporter::render);
+
+	int written = 0;
+	for (int i = 0; i < diagrams.size(); i++)
+		if (diagrams[i].written)
+			written++;
+	qDebug("Wrote %d of %d diagrams to %s", written, diagrams.size(), dir.path().toLatin1().constData());
+	return written;
+}
+
+/*
+ * Splits a collection into its game trees, a single game comes back whole
+ */
+QStringList DiagramExporter::splitCollection(const QString &sgf)
+{
+	QStringList games;
+	int depth = 0, start = -1;
+	bool inValue = false;
+
+	for (int i = 0; i < sgf.length(); i++)
+	{
+		QChar c = sgf[i];
+		if (inValue)
+		{
+			if (c == '\\')
+				i++;
+			else if (c == ']')
+				inValue = false;
+		}
+		else if (c == '[')
+			inValue = true;
+		else if (c == '(')
+		{
+			if (depth++ == 0)
+				start = i;
+		}
+		else if (c == ')' && depth > 0)
+		{
+			if (--depth == 0)
+				games.append(sgf.mid(start, i - start + 1));
+		}
+	}
+	if (games.isEmpty())
+		games.append(sgf);
+	return games;
+}
+
+/*
+ * Picks the positions to draw from the main line
+ */
+void DiagramExporter::collect(const QString &baseName, Tree *tree, int board_size)
+{
+	const bool finalOnly = options.moves.isEmpty() && !options.every && !options.comments;
+	const QString extension = options.svg ? "svg" : "png";
+	QList<Move *> played;		//since the previous diagram
+
+	for (Move *m = tree->getRoot(); m != NULL; m = m->son)
+	{
+		int number = m->getMoveNumber();
+		bool onBoard = m->getX() >= 1 && m->getX() <= board_size && m->getY() >= 1 && m->getY() <= board_size;
+		if (onBoard && (m->getColor() == stoneBlack || m->getColor() == stoneWhite) && !m->isHandicapMove())
+			played.append(m);
+
+		bool wanted;
+		if (finalOnly)
+			wanted = (m->son == NULL);
+		else
+			wanted = options.moves.contains(number) ||
+				(options.every > 0 && number > 0 && number % options.every == 0) ||
+				(options.comments && !m->getComment().isEmpty());
+		if (!wanted)
+			continue;
+
+		Matrix *matrix = m->getMatrix();
+		Diagram d;
+		d.exporter = this;
+		d.fileName = dir.filePath(QString("%1-%2.%3").arg(baseName).arg(number, 3, 10, QChar('0')).arg(extension));
+		d.board_size = board_size;
+		d.stones.resize(board_size * board_size);
+		d.marks.resize(board_size * board_size);
+		d.lastX = d.lastY = -1;
+		d.lastColor = stoneNone;
+		d.written = false;
+		for (int y = 1; y <= board_size; y++)
+			for (int x = 1; x <= board_size; x++)
+			{
+				int i = (y-1)*board_size + x-1;
+				StoneColor c = matrix->getStoneAt(x, y);
+				d.stones[i] = (c == stoneBlack || c == stoneWhite) ? c : stoneNone;
+				d.marks[i] = markNone;
+				if (!options.marks)
+					continue;
+				MarkType t = matrix->getMarkAt(x, y);
+				d.marks[i] = (t == markKoMarker ? markSquare : t);
+				if (t == markText || t == markNumber)
+					d.labels.insert(i, matrix->getMarkText(x, y));
+			}
+
+		if (options.numbers)
+		{
+			// The first stone played on a point keeps its number
+			for (int j = 0; j < played.size(); j++)
+			{
+				int i = (played[j]->getY()-1)*board_size + played[j]->getX()-1;
+				if (d.stones[i] == played[j]->getColor() && !d.numbers.contains(i))
+					d.numbers.insert(i, played[j]->getMoveNumber());
+			}
+		}
+		else if (options.marks && !played.isEmpty() && played.last() == m)
+		{
+			d.lastX = m->getX();
+			d.lastY = m->getY();
+			d.lastColor = m->getColor();
+		}
+		played.clear();
+		diagrams.append(d);
+	}
+}
+
+/*
+ * Room for the coordinates or a stone's radius around the grid
+ */
+int DiagramExporter::squareSize(int board_size) const
+{
+	return qMax(4, (int)(options.size / (board_size - 1 + (options.coords ? 3.0 : 1.2))));
+}
+
+void DiagramExporter::prepareStones(int square_size)
+{
+	if (stoneImages.contains(square_size))
+		return;
+
+	QSettings settings;
+	int stone_look = settings.value("STONES_LOOK").toInt();
+	QVector<StoneJob> jobs;
+	jobs.append(StoneJob(StoneJob::Black, square_size, stone_look));
+	jobs.append(StoneJob(StoneJob::White, square_size, stone_look));
+	jobs.append(StoneJob(StoneJob::Shadow, square_size, stone_look));
+
+	QVector<QImage> images;
+	for (int i = 0; i < jobs.size(); i++)
+	{
+		// the same white stone in every diagram
+		jobs[i].seed[0] = jobs[i].seed[1] = jobs[i].seed[2] = 0x330e + i;
+		ImageHandler::paintStone(jobs[i]);
+		images.append(jobs[i].image);
+	}
+	stoneImages.insert(square_size, images);
+}
+
+/* Runs on the global thread pool, see exportFiles */
+void DiagramExporter::render(Diagram &d)
+{
+	const int size = d.exporter->options.size;
+
+	if (d.exporter->options.svg)
+	{
+		QSvgGenerator svg;
+		svg.setFileName(d.fileName);
+		svg.setSize(QSize(size, size));
+		svg.setViewBox(QRect(0, 0, size, size));
+		svg.setTitle(QFileInfo(d.fileName).completeBaseName());
+		QPainter p;
+		if (!p.begin(&svg))
+		{
+			qWarning("Can't write %s", d.fileName.toLatin1().constData());
+			return;
+		}
+		d.exporter->paint(&p, d);
+		d.written = p.end();
+		return;
+	}
+
+	QImage image(size, size, QImage::Format_ARGB32_Premultiplied);
+	QPainter p(&image);
+	d.exporter->paint(&p, d);
+	p.end();
+	d.written = image.save(d.fileName, "PNG");
+	if (!d.written)
+		qWarning("Can't write %s", d.fileName.toLatin1().constData());
+}
+
+void DiagramExporter::paint(QPainter *p, const Diagram &d) const
+{
+	const int n = d.board_size;
+	const int square_size = squareSize(n);
+	const int offset = (options.size - square_size * (n-1)) / 2;
+	const QBrush background = (options.svg ? QBrush(Qt::white) : QBrush(wood));
+
+	p->fillRect(0, 0, options.size, options.size, background);
+	BoardItem::paintGrid(p, n, offset, offset, square_size);
+
+	if (options.coords)
+	{
+		// as numbertopnoi on the boards
+		QFont f("", qMax(1, square_size * 2 / 5));
+		p->setFont(f);
+		p->setPen(Qt::black);
+		const int low = offset - square_size, high = offset + square_size * n;
+		for (int i = 0; i < n; i++)
+		{
+			QString v = QString::number(n - i);
+			QString h = QString(QChar(static_cast<const char>('A' + (i<8?i:i+1))));
+			const int pos = offset + square_size * i;
+			p->drawText(QRectF(low - square_size/2, pos - square_size/2, square_size, square_size), Qt::AlignCenter, v);
+			p->drawText(QRectF(high - square_size/2, pos - square_size/2, square_size, square_size), Qt::AlignCenter, v);
+			p->drawText(QRectF(pos - square_size/2, low - square_size/2, square_size, square_size), Qt::AlignCenter, h);
+			p->drawText(QRectF(pos - square_size/2, high - square_size/2, square_size, square_size), Qt::AlignCenter, h);
+		}
+	}
+
+	int labelLength = 1;
+	QHashIterator<int, QString> l(d.labels);
+	while (l.hasNext())
+		labelLength = qMax(labelLength, l.next().value().length());
+	QHashIterator<int, int> num(d.numbers);
+	while (num.hasNext())
+		labelLength = qMax(labelLength, QString::number(num.next().value()).length());
+
+	const QVector<QImage> images = stoneImages.value(square_size);
+	const qreal radius = square_size * 0.48;
+	p->setRenderHint(QPainter::Antialiasing);
+	for (int y = 1; y <= n; y++)
+		for (int x = 1; x <= n; x++)
+		{
+			const int i = (y-1)*n + x-1;
+			const QPointF centre(offset + square_size * (x-1), offset + square_size * (y-1));
+			const StoneColor c = (StoneColor)d.stones[i];
+			if (c == stoneNone)
+			{
+				// labels on empty points hide the grid
+				if (d.marks[i] == markText || d.marks[i] == markNumber)
+					p->fillRect(QRectF(centre.x() - square_size/2.0, centre.y() - square_size/2.0,
+							square_size, square_size), background);
+				continue;
+			}
+			if (images.size() == 3)
+			{
+				const QImage &stone = images.at(c == stoneBlack ? 0 : 1);
+				const QImage &shadow = images.at(2);
+				p->drawImage(QPointF(centre.x() - stone.width()/2 - shadow.height()/8.0,
+						centre.y() - stone.height()/2 + shadow.height()/8.0), shadow);
+				p->drawImage(QPointF(centre.x() - stone.width()/2, centre.y() - stone.height()/2), stone);
+			}
+			else
+			{
+				p->setPen(QPen(Qt::black, qMax(1.0, square_size / 20.0)));
+				p->setBrush(c == stoneBlack ? Qt::black : Qt::white);
+				p->drawEllipse(centre, radius, radius);
+			}
+		}
+	p->setRenderHint(QPainter::Antialiasing, false);
+
+	for (int y = 1; y <= n; y++)
+		for (int x = 1; x <= n; x++)
+		{
+			const int i = (y-1)*n + x-1;
+			const QPointF centre(offset + square_size * (x-1), offset + square_size * (y-1));
+			const MarkType t = (MarkType)d.marks[i];
+			const QColor col = (d.stones[i] == stoneBlack ? Qt::white : Qt::black);
+			if (t == markTerrBlack || t == markTerrWhite)
+				BoardItem::paintMark(p, centre, square_size, t,
+						t == markTerrBlack ? Qt::black : Qt::white, QString(), labelLength);
+			else if (t != markNone)
+				BoardItem::paintMark(p, centre, square_size, t, col, d.labels.value(i), labelLength);
+			else if (d.numbers.contains(i))
+				BoardItem::paintMark(p, centre, square_size, markNumber, col,
+						QString::number(d.numbers.value(i)), labelLength);
+		}
+
+	if (d.lastX > 0)
+		BoardItem::paintMark(p, QPointF(offset + square_size * (d.lastX-1), offset + square_size * (d.lastY-1)),
+				square_size, markCross, d.lastColor == stoneBlack ? Qt::white : Qt::black,
+				QString(), labelLength, true);
+}
@@ -0,0 +1,88 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+
+
+#ifndef DIAGRAMEXPORTER_H
+#define DIAGRAMEXPORTER_H
+
+#include "defines.h"
+
+#include <QtCore>
+#include <QImage>
+
+class QPainter;
+class Tree;
+
+/* Renders board diagrams from SGF files without opening any window,
+ * for qgo --export-diagrams.  Positions are taken from the main line
+ * of each game on the main thread, then painted and written in
+ * parallel: PNG with the same stones and wood as the boards, SVG as
+ * flat black and white diagrams. */
+class DiagramExporter
+{
+public:
+	struct Options {
+		Options() : every(0), comments(false), svg(false), numbers(false),
+			marks(true), coords(true), size(600) {}
+		QList<int> moves;	//move numbers to draw
+		int every;		//and every n moves
+		bool comments;		//and every commented move
+		bool svg;
+		bool numbers;		//number the stones played since the previous diagram
+		bool marks;		//SGF marks and the last move mark
+		bool coords;
+		int size;		//width and height in pixels
+	};
+
+	DiagramExporter(const QString &dir, const Options &o);
+	int exportFiles(const QStringList &files);
+
+private:
+	struct Diagram {
+		const DiagramExporter *exporter;
+		QString fileName;
+		int board_size;
+		QVector<quint8> stones;		//StoneColor, by (y-1)*board_size + x-1
+		QVector<quint8> marks;		//MarkType
+		QHash<int, QString> labels;	//text and number marks
+		QHash<int, int> numbers;	//move numbers on stones
+		int lastX, lastY;
+		StoneColor lastColor;
+		bool written;
+	};
+
+	static QStringList splitCollection(const QString &sgf);
+	void collect(const QString &baseName, Tree *tree, int board_size);
+	int squareSize(int board_size) const;
+	void prepareStones(int square_size);
+	static void render(Diagram &d);
+	void paint(QPainter *p, const Diagram &d) const;
+
+	QDir dir;
+	Options options;
+	QList<Diagram> diagrams;
+	QImage wood;
+	QMap<int, QVector<QImage> > stoneImages;	//black, white, shadow by square size
+};
+
+#endif
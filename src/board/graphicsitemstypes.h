@@ -31,3 +31,5 @@
 #define RTTI_MARK_NUMBER 1007
 #define RTTI_MARK_TERR 1008
 #define RTTI_MARK_OTHERLINE 1009
+#define RTTI_BOARD 1010
+#define RTTI_ANALYSIS 1011
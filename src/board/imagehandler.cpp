@@ -29,9 +29,11 @@
 */
 
 #include <cmath>
+#include <QtConcurrent>
 
 #include "defines.h"
 #include "imagehandler.h"
+#include "logging.h"
 
 
 #ifdef Q_OS_WIN
@@ -39,6 +41,16 @@
   #define M_PI 3.141592653
  #endif //M_PI
  double drand48() { return rand()*1.0/RAND_MAX; }
+ /* same generator as POSIX, each stone carries its own state */
+ double erand48(unsigned short xsubi[3])
+ {
+	quint64 x = ((quint64)xsubi[2] << 32) | ((quint64)xsubi[1] << 16) | xsubi[0];
+	x = (x * 0x5DEECE66DULL + 0xB) & 0xFFFFFFFFFFFFULL;
+	xsubi[0] = x & 0xffff;
+	xsubi[1] = (x >> 16) & 0xffff;
+	xsubi[2] = (x >> 32) & 0xffff;
+	return x / 281474976710656.0;
+ }
 #endif
 
 
@@ -62,10 +74,10 @@ int ImageHandler::classCounter = 0;
 
 ImageHandler::ImageHandler()
 {
-	// Load the pixmaps
-//	if (tablePixmap == NULL)
+	// Load the pixmaps, shared by all handlers
+	if (tablePixmap == NULL)
 		tablePixmap =  new QPixmap(":/boardicons/resources/pics/table.png");
-//	if (woodPixmap1 == NULL)
+	if (woodPixmap1 == NULL)
 		woodPixmap1 =  new QPixmap(":/boardicons/resources/pics/wood.png");
 		/* I wanted to make it look like an old style go manual, but apparently
 		 * this is possible by changing the stone type to "Ugly 2d" and I 
@@ -85,9 +97,6 @@ ImageHandler::ImageHandler()
 	ghostPixmapsScaled = NULL;
 	smallStonePixmapsScaled = NULL;
 #endif //DONTREDRAWSTONES
-#define STONEIMAGE_MAXSIZE	400
-	painting_buffer = new int[STONEIMAGE_MAXSIZE*STONEIMAGE_MAXSIZE];
-	
     // Init the alternate ghost pixmaps
 	if (altGhostPixmaps == NULL)
 	{
@@ -126,6 +135,8 @@ ImageHandler::ImageHandler()
 
 ImageHandler::~ImageHandler()
 {
+	pending.cancel();
+	pending.waitForFinished();
 
 	classCounter --;
 	if (classCounter == 0)
@@ -141,6 +152,8 @@ ImageHandler::~ImageHandler()
 		altGhostPixmaps = NULL;
 	}
 	
+	if (atlasKey.size)
+		StoneAtlas::release(atlasKey);
 	delete stonePixmaps;
 	delete ghostPixmaps;
 	delete smallStonePixmaps;
@@ -149,24 +162,30 @@ ImageHandler::~ImageHandler()
 	delete ghostPixmapsScaled;
 	delete smallStonePixmapsScaled;
 #endif //DONTREDRAWSTONES
-	
-	delete[] painting_buffer;
 }
 
-void ImageHandler::icopy(int *im, QImage &qim, int w, int h) 
+/* Only the pixels within r of the center can be on the stone, so the
+ * painters clear the rest of the scanline and loop over [jmin, jmax] */
+static void clearOutsideStone(uint * line, int d, double d2, double r, double di, int & jmin, int & jmax)
 {
-	
-	for (int y = 0; y < h; y++) 
+	if (di*di > r*r)
 	{
-		uint *p = (uint *)qim.scanLine(y);
-		for(int x = 0; x < w; x++) 
-		{
-			p[x] = im[y*h + x];
-		}
+		jmin = d;
+		jmax = d - 1;
 	}
+	else
+	{
+		double span = sqrt(r*r - di*di);
+		jmin = qMax(0, (int)floor(d2 - span));
+		jmax = qMin(d - 1, (int)ceil(d2 + span));
+	}
+	for (int j = 0; j < jmin && j < d; j++)
+		line[j] = 0;
+	for (int j = jmax + 1; j < d; j++)
+		line[j] = 0;
 }
 
-void ImageHandler::decideAppearance(WhiteDesc *desc, int size)  
+void ImageHandler::decideAppearance(WhiteDesc *desc, int size, unsigned short * seed)
 {
 	double  minStripeW, maxStripeW, theta;
 	
@@ -177,17 +196,17 @@ void ImageHandler::decideAppearance(WhiteDesc *desc, int size)
 	if (maxStripeW < 2.5)
 		maxStripeW = 2.5;
 
-	theta = drand48() * 2.0 * M_PI;
+	theta = erand48(seed) * 2.0 * M_PI;
 	desc->cosTheta = cos(theta);
 	desc->sinTheta = sin(theta);
 	desc->stripeWidth = 1.5*minStripeW +
-		(drand48() * (maxStripeW - minStripeW));
+		(erand48(seed) * (maxStripeW - minStripeW));
 	
 	desc->xAdd = 3*desc->stripeWidth +
 		(double)size * 3.0;
 	
 	desc->stripeMul = 3.0;
-	desc->zMul = drand48() * 650.0 + 70.0;
+	desc->zMul = erand48(seed) * 650.0 + 70.0;
 
 }
 
@@ -221,7 +240,7 @@ double ImageHandler::getStripe(WhiteDesc &white, double bright, double z, int x,
 
 }
 
-void ImageHandler::paintBlackStone (QImage &bi, int d, int stone_render) 
+void ImageHandler::paintBlackStone (QImage &bi, int d, int stone_render, unsigned short * seed)
 {	
 	const double pixel=0.8;//,shadow=0.99;
 
@@ -229,18 +248,20 @@ void ImageHandler::paintBlackStone (QImage &bi, int d, int stone_render)
 	bool Alias=true;
 	
 	// these are the images
-	int i, j, g,g1,g2, k;
+	int i, j, g,g1,g2, jmin, jmax;
 	double di, dj, d2=(double)d/2.0-5e-1, r=d2-2e-1, f=sqrt(3.0);
 	double x, y, z, xr,xr1, xr2, xg1,xg2,hh;
 		
-	k=0;
-	
 	bool smallerstones = false;
 	if (smallerstones) r-=1;
 	
 	for (i=0; i<d; i++)
-		for (j=0; j<d; j++) {
-			di=i-d2; dj=j-d2;
+	{
+		uint *line = (uint *)bi.scanLine(i);
+		di=i-d2;
+		clearOutsideStone(line, d, d2, r, di, jmin, jmax);
+		for (j=jmin; j<=jmax; j++) {
+			dj=j-d2;
 			hh=r-sqrt(di*di+dj*dj);
 			if (hh>=0) 
 			{
@@ -261,34 +282,28 @@ void ImageHandler::paintBlackStone (QImage &bi, int d, int stone_render)
 					if (xr2>0.96) xg2=(xr2-0.96)*10;
 					else xg2=0;
 				
-					//random = drand48();
-				
-					g1=(int)(5+10*drand48() + 10*xr1 + xg1*140);
+					g1=(int)(5+10*erand48(seed) + 10*xr1 + xg1*140);
 					g2=(int)(10+10* xr2+xg2*160);
 					g=(g1 > g2 ? g1 : g2);
 					//g=(int)1/ (1/g1 + 1/g2);
 				
 					if (hh>pixel || !Alias) {
-						painting_buffer[k]=(255<<24)|(g<<16)|(g<<8)|g;
+						line[j]=(255<<24)|(g<<16)|(g<<8)|g;
 					}
 					else {			
-						painting_buffer[k]=((int)(hh/pixel*255)<<24)|(g<<16)|(g<<8)|g;
+						line[j]=((int)(hh/pixel*255)<<24)|(g<<16)|(g<<8)|g;
 					}
 
 				}
 				else //code for flat stones
 				{
 					g=0;
-					painting_buffer[k]=((int)(255)<<24)|(g<<16)|(g<<8)|g;	
+					line[j]=((int)(255)<<24)|(g<<16)|(g<<8)|g;	
 				}
 			}
-			else painting_buffer[k]=0;
-			k++;
-			
+			else line[j]=0;
 		}
-		
-		// now copy the result in QImages
-		icopy(painting_buffer, bi, d, d);
+	}
 }
 
 // shadow under stones
@@ -297,39 +312,37 @@ void ImageHandler::paintShadowStone (QImage &si, int d) {
 	//const double pixel=0.8,shadow=0.99;
 
 	// these are the images
-	int i, j,  k;
+	int i, j, jmin, jmax;
 	double di, dj, d2=(double)d/2.0-5e-1, r=d2-2e-1;
 	double hh;
 	
-	k=0;
-	
 	bool smallerstones = false;
 	if (smallerstones) r-=1;
 	
 	for (i=0; i<d; i++)
-		for (j=0; j<d; j++) {
-			di=i-d2; dj=j-d2;
+	{
+		uint *line = (uint *)si.scanLine(i);
+		di=i-d2;
+		clearOutsideStone(line, d, d2, r, di, jmin, jmax);
+		for (j=jmin; j<=jmax; j++) {
+			dj=j-d2;
 			hh=r-sqrt(di*di+dj*dj);
 			if (hh>=0) {
 				hh=2*hh/r ;
 				if (hh> 1)  hh=1;
 				
-				painting_buffer[k]=((int)(255*hh)<<24)|(1<<16)|(1<<8)|(1);
+				line[j]=((int)(255*hh)<<24)|(1<<16)|(1<<8)|(1);
 			}
-			else painting_buffer[k]=0;
-			k++;
-			
+			else line[j]=0;
 		}
-		
-		// now copy the result in QImages
-		icopy(painting_buffer, si, d, d);
+	}
 }
 
 // shaded white stones
-void ImageHandler::paintWhiteStone (QImage &wi, int d, int stone_render)//bool stripes ) {
+void ImageHandler::paintWhiteStone (QImage &wi, int d, int stone_render, unsigned short * seed)//bool stripes ) {
 {
 	WhiteDesc desc;
-	decideAppearance(&desc, d);
+	decideAppearance(&desc, d, seed);
 
 	// the angle from which the dim starts (measured to the light direction = pi/4)
 	// alpha should be in (0, pi)
@@ -343,18 +356,20 @@ void ImageHandler::paintWhiteStone (QImage &wi, int d, int stone_render)//bool s
 	bool Alias=true;
 	
 	// these are the images
-	int i, j, g, g1,g2,k;
+	int i, j, g, g1,g2, jmin, jmax;
 	double di, dj, d2=(double)d/2.0-5e-1, r=d2-2e-1, f=sqrt(3.0);
 	double x, y, z, xr, xr1, xr2, xg1,xg2, hh;
 	
-	k=0;
-	
 	bool smallerstones = false;
 	if (smallerstones) r-=1;
 
 	for (i=0; i<d; i++)
-		for (j=0; j<d; j++) {
-			di=i-d2; dj=j-d2;
+	{
+		uint *line = (uint *)wi.scanLine(i);
+		di=i-d2;
+		clearOutsideStone(line, d, d2, r, di, jmin, jmax);
+		for (j=jmin; j<=jmax; j++) {
+			dj=j-d2;
 			hh=r-sqrt(di*di+dj*dj);
 			if (hh>=0) 
 			{
@@ -411,7 +426,7 @@ void ImageHandler::paintWhiteStone (QImage &wi, int d, int stone_render)//bool s
 					
 						if (stone_render == 0) //stripes)
 							g = (int)getStripe(desc, g, xr1/7.0, i, j);
-						painting_buffer[k]=(255<<24)|(g<<16)|((g)<<8)|(g);
+						line[j]=(255<<24)|(g<<16)|((g)<<8)|(g);
 					}
 					else if (( hh > pixel ) || (!Alias) )
 					{
@@ -421,7 +436,7 @@ void ImageHandler::paintWhiteStone (QImage &wi, int d, int stone_render)//bool s
 					
 						if (stone_render == 0)//stripes)
 							g = (int)getStripe(desc, g, xr1/7.0, i, j);
-						painting_buffer[k]=(255<<24)|(g<<16)|((g)<<8)|(g);
+						line[j]=(255<<24)|(g<<16)|((g)<<8)|(g);
 					}
 					else {
 					
@@ -433,7 +448,7 @@ void ImageHandler::paintWhiteStone (QImage &wi, int d, int stone_render)//bool s
 						if (stone_render == 0)//stripes)
 							g = (int)getStripe(desc, g, xr1/7.0, i, j);
 				
-						painting_buffer[k]=((int)(hh/pixel*255)<<24)|(g<<16)|(g<<8)|g;				
+						line[j]=((int)(hh/pixel*255)<<24)|(g<<16)|(g<<8)|g;				
 					}
 				}
 				else // Code for flat stones
@@ -442,56 +457,53 @@ void ImageHandler::paintWhiteStone (QImage &wi, int d, int stone_render)//bool s
 					if ((hh>=-1)&&(hh<=1))
 					{
 						g=0;
-						painting_buffer[k]=((int)(255)<<24)|(g<<16)|(g<<8)|g;
+						line[j]=((int)(255)<<24)|(g<<16)|(g<<8)|g;
 					}	
 					else if (hh>0)
 					{
 						g=255;
-						painting_buffer[k]=((int)(255)<<24)|(g<<16)|(g<<8)|g;
+						line[j]=((int)(255)<<24)|(g<<16)|(g<<8)|g;
 					}
 				}	
 				
 			}
-			else painting_buffer[k]=0;
-			k++;
+			else line[j]=0;
 		}
-
-	// now copy the result in QImages
-	icopy(painting_buffer, wi, d, d);
+	}
 }
 
 
-QPixmap *ImageHandler::getBoardPixmap(QString filename)
+QPixmap ImageHandler::getBoardPixmap(QString filename)
 {
 	if (! QFile::exists (QString(filename)))
 	{
 		if(filename != QString())
-			qDebug("Can't open board picture: \"%s\"", filename.toLatin1().constData());
-		return woodPixmap1;
+			qCWarning(logRender, "Can't open board picture: \"%s\"", filename.toLatin1().constData());
+		return woodPixmap1 ? *woodPixmap1 : QPixmap();
 	}
 
-	QPixmap *p =  new QPixmap(filename) ;
+	QPixmap p(filename);
 
-	if (p->isNull())
-		return woodPixmap1;
+	if (p.isNull())
+		return woodPixmap1 ? *woodPixmap1 : QPixmap();
 	else 
 		return p;
 
 }
 
-QPixmap *ImageHandler::getTablePixmap(QString filename) 
+QPixmap ImageHandler::getTablePixmap(QString filename) 
 {
 	if (! QFile::exists (QString(filename)))
 	{
 		if(filename != QString())
-			qDebug("Can't open table picture: \"%s\"", filename.toLatin1().constData());
-		return tablePixmap;
+			qCWarning(logRender, "Can't open table picture: \"%s\"", filename.toLatin1().constData());
+		return tablePixmap ? *tablePixmap : QPixmap();
 	}
 	
-	QPixmap *p =  new QPixmap(filename) ;
+	QPixmap p(filename);
 
-	if (p->isNull())
-		return tablePixmap;
+	if (p.isNull())
+		return tablePixmap ? *tablePixmap : QPixmap();
 	else 
 		return p;
 
@@ -502,99 +514,148 @@ void ImageHandler::setDisplay(bool isDisplay)
     isDisplayBoard = isDisplay;
 }
 
+/*
+ * The atlas entry a board of this square size uses
+ */
+StoneAtlas::Key ImageHandler::keyFor(int size) const
+{
+	QSettings settings;
+
+	int stone_look =  ( isDisplayBoard ? 1 : settings.value("STONES_LOOK").toInt());
+	return StoneAtlas::Key(size, stone_look, preferences.terr_stone_mark);
+}
+
+/*
+ * Every stone is independent, so they're painted in parallel and only
+ * turned into pixmaps back on the GUI thread.  The painters each get
+ * their own random state rather than sharing drand48's
+ */
+QVector<StoneJob> ImageHandler::stoneJobs(const StoneAtlas::Key & key)
+{
+	int smallstones_size = (int)(key.size / SMALL_STONE_TERR_DIVISOR);
+	QVector<StoneJob> jobs;
+
+	jobs.append(StoneJob(StoneJob::Black, key.size, key.look, true));
+	if(key.terr)
+		jobs.append(StoneJob(StoneJob::Black, smallstones_size, key.look, false, true));
+	for (int i=1 ;	i<=WHITE_STONES_NB;	i++)
+	{
+		jobs.append(StoneJob(StoneJob::White, key.size, key.look, true));
+		if(key.terr)
+			jobs.append(StoneJob(StoneJob::White, smallstones_size, key.look, false, true));
+	}
+	// shadow
+	jobs.append(StoneJob(StoneJob::Shadow, key.size, key.look));
+	for (int i = 0; i < jobs.size(); i++)
+	{
+		for (int k = 0; k < 3; k++)
+			jobs[i].seed[k] = (unsigned short)(drand48() * 65536);
+	}
+	return jobs;
+}
+
+/*
+ * Starts painting the stones for a coming setSquareSize(size) on the
+ * thread pool.  The returned future is already finished if there's
+ * nothing to paint.
+ */
+QFuture<void> ImageHandler::prepareSquareSize(int size)
+{
+	StoneAtlas::Key key = keyFor(size);
+
+	if (pendingKey == key)
+		return pending;
+	if (StoneAtlas::contains(key))
+		return QFuture<void>();
+
+	// a size we've dragged past
+	pending.cancel();
+	pending.waitForFinished();
+
+	pendingKey = key;
+	pendingJobs = stoneJobs(key);
+	pending = QtConcurrent::map(pendingJobs, &ImageHandler::paintStone);
+	return pending;
+}
+
 #ifdef DONTREDRAWSTONES
 void ImageHandler::generateStonePixmaps(int size)//, bool smallerStones)
 #else
 void ImageHandler::setSquareSize(int size)
 #endif //DONTREDRAWSTONES
 {
-	QSettings settings;
-
 	Q_CHECK_PTR(stonePixmaps);
 	Q_CHECK_PTR(ghostPixmaps);
-	
-	int stone_look =  ( isDisplayBoard ? 1 : settings.value("STONES_LOOK").toInt());
-	int smallstones_size;	
-	
-	stonePixmaps->clear();
-	ghostPixmaps->clear();
-	if(preferences.terr_stone_mark)
-	{
-		smallstones_size = (int)(size / SMALL_STONE_TERR_DIVISOR);
-		smallStonePixmaps->clear();
-	}
 
-	//repaint black stones
-	QImage ib = QImage(size, size, QImage::Format_ARGB32);
-	QImage iws;
-//	ib.setAlphaBuffer(true);
-	paintBlackStone(ib, size, stone_look);
-	//stonePixmaps->append(QPixmap::fromImage(ib));//, 
-//		Qt::PreferDither | 
-//		Qt::DiffuseAlphaDither | 
-//		Qt::DiffuseDither) );
-//	stonePixmaps->image(0)->setOffset(size/2, size/2);
-	stonePixmaps->append(QPixmap::fromImage(ib, 
-			Qt::PreferDither | 
-			Qt::DiffuseAlphaDither | 
-			Qt::DiffuseDither) );
-	
-	QImage gb(ib);
-	ghostImage(&gb);
-	ghostPixmaps->append(QPixmap::fromImage(gb));
-
-	//small black stone
-	if(preferences.terr_stone_mark)
+	/* Another board may already have painted this set */
+	StoneAtlas::Key key = keyFor(size);
+	const StoneAtlas::Sprites * sprites = StoneAtlas::acquire(key);
+	QVector<StoneJob> jobs;
+	if (pendingKey == key)
 	{
-		QImage ibs = QImage(smallstones_size, smallstones_size, QImage::Format_ARGB32);
-		paintBlackStone(ibs, smallstones_size, stone_look);
-		smallStonePixmaps->append(QPixmap::fromImage(ibs));
-
-		// small white stones
-		iws = QImage(smallstones_size, smallstones_size, QImage::Format_ARGB32);
+		pending.waitForFinished();
+		jobs = pendingJobs;
+		pendingKey = StoneAtlas::Key();
+		pendingJobs.clear();
 	}
-	// white stones	
-	QImage iw1 = QImage(size, size, QImage::Format_ARGB32);
-
-	
-	
-	for (int i=1 ;	i<=WHITE_STONES_NB;	i++)
+	if (!sprites)
 	{
-		paintWhiteStone(iw1, size, stone_look);
-		//stonePixmaps->append(QPixmap::fromImage(iw1));
-		stonePixmaps->append(QPixmap::fromImage(iw1, 
-			Qt::PreferDither | 
-			Qt::DiffuseAlphaDither | 
-			Qt::DiffuseDither)   );
-		QImage gw1(iw1);
-		ghostImage(&gw1);
-		ghostPixmaps->append(QPixmap::fromImage(gw1));
-		
-		if(preferences.terr_stone_mark)
+		if (jobs.isEmpty())
 		{
-			paintWhiteStone(iws, smallstones_size, stone_look);
-			smallStonePixmaps->append(QPixmap::fromImage(iws));
-			
-			/*smallStonePixmaps->append(QPixmap::fromImage(iws, 
-					     	Qt::PreferDither | 
-						Qt::DiffuseAlphaDither | 
-				  		Qt::DiffuseDither)   );*/
+			jobs = stoneJobs(key);
+			QtConcurrent::blockingMap(jobs, &ImageHandler::paintStone);
 		}
-	}
-	
-	// shadow
-	QImage is = QImage(size, size, QImage::Format_ARGB32);
 
-	if (stone_look == 0)
-		paintShadowStone(is, size);
-	else
-		is.fill(0);
+		QList<QImage> stones, ghosts, smallStones;
+		for (int i = 0; i < jobs.size(); i++)
+		{
+			if (jobs[i].terr)
+			{
+				smallStones.append(jobs[i].image);
+				continue;
+			}
+			stones.append(jobs[i].image);
+			if (jobs[i].ghost)
+				ghosts.append(jobs[i].ghostImage);
+		}
+		sprites = StoneAtlas::insert(key, stones, ghosts, smallStones);
+	}
+	if (atlasKey.size)
+		StoneAtlas::release(atlasKey);
+	atlasKey = key;
+
+	/* Stones keep pointers to our lists, so we copy into them.  The
+	 * pixmaps themselves are shared */
+	*stonePixmaps = sprites->stones;
+	*ghostPixmaps = sprites->ghosts;
+	if(preferences.terr_stone_mark)
+		*smallStonePixmaps = sprites->smallStones;
+}
 
-	//stonePixmaps->append(QPixmap::fromImage(is));
-	stonePixmaps->append(QPixmap::fromImage(is, 
-			Qt::PreferDither | 
-			Qt::DiffuseAlphaDither | 
-			Qt::DiffuseDither)  );
+/* Runs on the global thread pool, see setSquareSize */
+void ImageHandler::paintStone(StoneJob & job)
+{
+	job.image = QImage(job.size, job.size, QImage::Format_ARGB32);
+	switch (job.kind)
+	{
+		case StoneJob::Black:
+			paintBlackStone(job.image, job.size, job.stone_render, job.seed);
+			break;
+		case StoneJob::White:
+			paintWhiteStone(job.image, job.size, job.stone_render, job.seed);
+			break;
+		case StoneJob::Shadow:
+			if (job.stone_render == 0)
+				paintShadowStone(job.image, job.size);
+			else
+				job.image.fill(0);
+			break;
+	}
+	if (job.ghost)
+	{
+		job.ghostImage = job.image.copy();
+		ghostImage(&job.ghostImage);
+	}
 }
 
 #ifdef DONTREDRAWSTONES
@@ -25,6 +25,9 @@
 
 #include <QtCore>
 #include <QPixmap>
+#include <QImage>
+#include <QFuture>
+#include "stoneatlas.h"
 
 /* DONTREDRAWSTONES lets Qt do the scaling rather than redrawing them
  * to scale.  I'm not convinced it improves the speed all that much
@@ -39,6 +42,21 @@ struct WhiteDesc {
 	double stripeMul, zMul;
 };
 
+/* One pixmap's worth of painting for ImageHandler::setSquareSize */
+struct StoneJob {
+	enum Kind { Black, White, Shadow };
+	StoneJob() {}
+	StoneJob(enum Kind k, int s, int r, bool g = false, bool t = false) :
+		kind(k), size(s), stone_render(r), ghost(g), terr(t) {}
+	enum Kind kind;
+	int size;
+	int stone_render;
+	bool ghost;		//also paint the ghost image
+	bool terr;		//small territory mark stone
+	unsigned short seed[3];	//erand48 state
+	QImage image, ghostImage;
+};
+
 class ImageHandler
 {
 public:
@@ -47,8 +65,9 @@ public:
 	
     void setDisplay(bool isDisplay = false);
     void setSquareSize(int size);
-	static QPixmap *getBoardPixmap(QString ) ;
-	static QPixmap *getTablePixmap(QString ) ;
+	QFuture<void> prepareSquareSize(int size);
+	static QPixmap getBoardPixmap(QString ) ;
+	static QPixmap getTablePixmap(QString ) ;
 #ifdef DONTREDRAWSTONES
 	QList<QPixmap> *getStonePixmaps() const { return stonePixmapsScaled; }
 	QList<QPixmap> *getSmallStonePixmaps() const { return smallStonePixmapsScaled; }
@@ -59,11 +78,11 @@ public:
 	QList<QPixmap> *getGhostPixmaps() const { return ghostPixmaps; }
 #endif //DONTREDRAWSTONES
 	static QList<QPixmap> * getAlternateGhostPixmaps() { return altGhostPixmaps; }
-	void ghostImage(QImage *img);
+	static void ghostImage(QImage *img);
 
-	void icopy(int *im, QImage &qim, int w, int h);
-	void decideAppearance(WhiteDesc *desc, int size);
-	double getStripe(WhiteDesc &white, double bright, double z, int x, int y);
+	static void paintStone(StoneJob & job);
+	static void decideAppearance(WhiteDesc *desc, int size, unsigned short * seed);
+	static double getStripe(WhiteDesc &white, double bright, double z, int x, int y);
 	
 
 protected:
@@ -75,12 +94,17 @@ private:
 	void generateStonePixmaps(int size);
 	QList<QPixmap> *stonePixmapsScaled, *ghostPixmapsScaled, *smallStonePixmapsScaled;
 #endif //DONTREDRAWSTONES
-	void paintBlackStone (QImage &bi, int d, int stone_render);
-	void paintShadowStone (QImage &si, int d);
-	void paintWhiteStone (QImage &wi, int d, int stone_render);
-	int * painting_buffer;	
+	StoneAtlas::Key keyFor(int size) const;
+	static QVector<StoneJob> stoneJobs(const StoneAtlas::Key & key);
+	static void paintBlackStone (QImage &bi, int d, int stone_render, unsigned short * seed);
+	static void paintShadowStone (QImage &si, int d);
+	static void paintWhiteStone (QImage &wi, int d, int stone_render, unsigned short * seed);
 
 	bool isDisplayBoard;
+	StoneAtlas::Key atlasKey;	//set we hold in the atlas, size 0 for none
+	StoneAtlas::Key pendingKey;	//set being painted by prepareSquareSize
+	QVector<StoneJob> pendingJobs;
+	QFuture<void> pending;
 	QList<QPixmap> *stonePixmaps, *ghostPixmaps, *smallStonePixmaps;
 	static QList<QPixmap> *altGhostPixmaps;
 	static QPixmap *tablePixmap;
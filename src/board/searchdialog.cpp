@@ -0,0 +1,150 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#include <QtWidgets>
+#include "searchdialog.h"
+#include "tree.h"
+#include "treeindex.h"
+
+#include <algorithm>
+
+SearchDialog::SearchDialog(Tree * t, QWidget * parent) : QDialog(parent), tree(t), resultsRevision(0)
+{
+	queryEdit = new QLineEdit();
+	queryEdit->setPlaceholderText(tr("Words in comments or node names"));
+	countLabel = new QLabel();
+
+	resultList = new QTreeWidget();
+	resultList->setColumnCount(2);
+	resultList->setHeaderLabels(QStringList() << tr("Move") << tr("Comment"));
+	resultList->setRootIsDecorated(false);
+	resultList->setUniformRowHeights(true);
+	resultList->setColumnWidth(0, 80);
+
+	previousButton = new QPushButton(tr("Previous"));
+	nextButton = new QPushButton(tr("Next"));
+	nextButton->setDefault(true);
+	closeButton = new QPushButton(tr("Close"));
+	connect(queryEdit, SIGNAL(textChanged(const QString &)), this, SLOT(slot_search()));
+	connect(resultList, SIGNAL(itemActivated(QTreeWidgetItem *, int)), this, SLOT(slot_resultActivated(QTreeWidgetItem *)));
+	connect(previousButton, SIGNAL(clicked()), this, SLOT(slot_previous()));
+	connect(nextButton, SIGNAL(clicked()), this, SLOT(slot_next()));
+	connect(closeButton, SIGNAL(clicked()), this, SLOT(hide()));
+
+	QHBoxLayout * buttonLayout = new QHBoxLayout;
+	buttonLayout->addWidget(countLabel);
+	buttonLayout->addStretch();
+	buttonLayout->addWidget(previousButton);
+	buttonLayout->addWidget(nextButton);
+	buttonLayout->addWidget(closeButton);
+
+	QVBoxLayout * mainLayout = new QVBoxLayout;
+	mainLayout->addWidget(queryEdit);
+	mainLayout->addWidget(resultList);
+	mainLayout->addLayout(buttonLayout);
+	setLayout(mainLayout);
+
+	setWindowTitle(tr("Find in Comments"));
+	resize(420, 360);
+	slot_search();
+}
+
+/* match is which result to go to, for a search started somewhere else */
+void SearchDialog::setQuery(const QString & query, int match)
+{
+	queryEdit->setText(query);
+	slot_search();
+	if(match >= 0 && match < results.size())
+		goTo(match);
+}
+
+void SearchDialog::slot_search(void)
+{
+	const TreeIndex & index = tree->getIndex();
+	QString query = queryEdit->text();
+	results = query.trimmed().isEmpty() ? QVector<int>() : index.find(query);
+	resultsRevision = tree->getRevision();
+
+	resultList->clear();
+	QList<QTreeWidgetItem *> items;
+	for(int i = 0; i < results.size(); i++)
+	{
+		Move * m = index.node(results[i]);
+		QString move = QString::number(m->getMoveNumber());
+		if(!tree->isInMainBranch(m))
+			move += tr(" (var)");
+		QTreeWidgetItem * item = new QTreeWidgetItem(QStringList() << move << SearchIndex::snippet(TreeIndex::text(m), query));
+		item->setData(0, Qt::UserRole, QVariant::fromValue((void *)m));
+		items << item;
+	}
+	resultList->addTopLevelItems(items);
+	countLabel->setText(query.trimmed().isEmpty() ? QString() : tr("%n match(es)", "", results.size()));
+	previousButton->setEnabled(!results.isEmpty());
+	nextButton->setEnabled(!results.isEmpty());
+}
+
+/* Comments change under us in live games, kibitz goes into them */
+void SearchDialog::refreshIfStale(void)
+{
+	if(resultsRevision != tree->getRevision())
+		slot_search();
+}
+
+void SearchDialog::goTo(int row)
+{
+	refreshIfStale();
+	if(row < 0 || row >= results.size())
+		return;
+	resultList->setCurrentItem(resultList->topLevelItem(row));
+	tree->setCurrent(tree->getIndex().node(results[row]));
+}
+
+/* The row may be from before the comments changed, so go by its node.
+ * The pointer is only a key into the fresh index, if the move is gone
+ * it won't be found there. */
+void SearchDialog::slot_resultActivated(QTreeWidgetItem * item)
+{
+	const Move * m = (const Move *)item->data(0, Qt::UserRole).value<void *>();
+	refreshIfStale();	//item is deleted if it was
+	goTo(results.indexOf(tree->getIndex().number(m)));
+}
+
+/* Both wrap around at the ends */
+void SearchDialog::slot_next(void)
+{
+	refreshIfStale();
+	if(results.isEmpty())
+		return;
+	int n = tree->getIndex().number(tree->getCurrent());
+	QVector<int>::const_iterator i = std::upper_bound(results.constBegin(), results.constEnd(), n);
+	goTo(i == results.constEnd() ? 0 : i - results.constBegin());
+}
+
+void SearchDialog::slot_previous(void)
+{
+	refreshIfStale();
+	if(results.isEmpty())
+		return;
+	int n = tree->getIndex().number(tree->getCurrent());
+	QVector<int>::const_iterator i = std::lower_bound(results.constBegin(), results.constEnd(), n);
+	goTo(i == results.constBegin() ? results.size() - 1 : i - results.constBegin() - 1);
+}
@@ -0,0 +1,66 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#ifndef SEARCHDIALOG_H
+#define SEARCHDIALOG_H
+
+#include <QDialog>
+#include <QVector>
+
+class Tree;
+class Move;
+class QLineEdit;
+class QLabel;
+class QTreeWidget;
+class QTreeWidgetItem;
+class QPushButton;
+
+/* Find in the comments and node names of a board's tree.  Results are in
+ * tree order, Next and Previous go to the nearest one after or before
+ * the current move. */
+class SearchDialog : public QDialog
+{
+	Q_OBJECT
+	public:
+		SearchDialog(Tree * t, QWidget * parent = 0);
+		void setQuery(const QString & query, int match = -1);
+	private slots:
+		void slot_search(void);
+		void slot_next(void);
+		void slot_previous(void);
+		void slot_resultActivated(QTreeWidgetItem * item);
+	private:
+		void goTo(int row);
+		void refreshIfStale(void);
+
+		Tree * tree;
+		QLineEdit * queryEdit;
+		QLabel * countLabel;
+		QTreeWidget * resultList;
+		QPushButton * previousButton;
+		QPushButton * nextButton;
+		QPushButton * closeButton;
+		QVector<int> results;
+		unsigned int resultsRevision;
+};
+
+#endif //SEARCHDIALOG_H
@@ -0,0 +1,219 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#include <QtConcurrent>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include "defines.h"
+#include "stoneatlas.h"
+#include "logging.h"
+
+/* Unused sets kept for reuse */
+#define STONEATLAS_SPARE_ENTRIES	8
+/* Bump when the stone painting changes so old strips aren't picked up */
+#define STONEATLAS_CACHE_VERSION	1
+/* Sets kept on disk, one per look, size and terr, so a few boards'
+ * worth of window sizes */
+#define STONEATLAS_DISK_ENTRIES		48
+
+QHash<StoneAtlas::Key, StoneAtlas::Sprites *> StoneAtlas::entries;
+quint64 StoneAtlas::clock = 0;
+
+static const Qt::ImageConversionFlags stoneDither = Qt::PreferDither | Qt::DiffuseAlphaDither | Qt::DiffuseDither;
+
+const StoneAtlas::Sprites * StoneAtlas::acquire(const Key & k)
+{
+	Sprites * s = entries.value(k);
+	if(!s)
+	{
+		s = load(k);
+		if(!s)
+			return NULL;
+		entries.insert(k, s);
+	}
+	s->refs++;
+	s->lastUsed = ++clock;
+	return s;
+}
+
+/* Takes a freshly painted set, already acquired once for the caller */
+const StoneAtlas::Sprites * StoneAtlas::insert(const Key & k, const QList<QImage> & stones,
+				const QList<QImage> & ghosts, const QList<QImage> & smallStones)
+{
+	Sprites * s = entries.value(k);
+	if(!s)
+	{
+		s = new Sprites();
+		s->refs = 0;
+		for(int i = 0; i < stones.size(); i++)
+			s->stones.append(QPixmap::fromImage(stones[i], stoneDither));
+		for(int i = 0; i < ghosts.size(); i++)
+			s->ghosts.append(QPixmap::fromImage(ghosts[i]));
+		for(int i = 0; i < smallStones.size(); i++)
+			s->smallStones.append(QPixmap::fromImage(smallStones[i]));
+		entries.insert(k, s);
+		if(diskCacheEnabled())
+			QtConcurrent::run(&StoneAtlas::save, k, stones, ghosts, smallStones);
+	}
+	s->refs++;
+	s->lastUsed = ++clock;
+	return s;
+}
+
+void StoneAtlas::release(const Key & k)
+{
+	Sprites * s = entries.value(k);
+	if(!s)
+		return;
+	s->refs--;
+	if(s->refs <= 0)
+		evict();
+}
+
+/* Whether acquire would find the set without painting it */
+bool StoneAtlas::contains(const Key & k)
+{
+	return entries.contains(k) || (diskCacheEnabled() && QFile::exists(cacheFileName(k, "stones")));
+}
+
+/* Drops the least recently used sets nobody holds beyond the spares */
+void StoneAtlas::evict(void)
+{
+	QList<Key> unused;
+	QHash<Key, Sprites *>::const_iterator i;
+	for(i = entries.constBegin(); i != entries.constEnd(); ++i)
+	{
+		if(i.value()->refs <= 0)
+			unused.append(i.key());
+	}
+	while(unused.size() > STONEATLAS_SPARE_ENTRIES)
+	{
+		int oldest = 0;
+		for(int j = 1; j < unused.size(); j++)
+		{
+			if(entries.value(unused[j])->lastUsed < entries.value(unused[oldest])->lastUsed)
+				oldest = j;
+		}
+		delete entries.take(unused.takeAt(oldest));
+	}
+}
+
+bool StoneAtlas::diskCacheEnabled(void)
+{
+	QSettings settings;
+	return settings.value("STONES_DISK_CACHE", true).toBool();
+}
+
+QString StoneAtlas::cacheFileName(const Key & k, const char * list)
+{
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+		QString("/stones-%1/%2-%3-%4-%5.png").arg(STONEATLAS_CACHE_VERSION)
+		.arg(k.look).arg(k.size).arg(k.terr ? "terr" : "noterr").arg(list);
+}
+
+/* The sets are stored as one strip of square tiles per list */
+static bool loadStrip(const QString & fileName, int tiles, QList<QPixmap> & list, Qt::ImageConversionFlags flags)
+{
+	QImage strip;
+	if(!strip.load(fileName, "PNG"))
+		return false;
+	int size = strip.height();
+	if(size <= 0 || strip.width() != size * tiles)
+		return false;
+	strip = strip.convertToFormat(QImage::Format_ARGB32);
+	for(int i = 0; i < tiles; i++)
+		list.append(QPixmap::fromImage(strip.copy(i * size, 0, size, size), flags));
+	return true;
+}
+
+static bool saveStrip(const QString & fileName, const QList<QImage> & list)
+{
+	if(list.isEmpty() || list[0].height() <= 0)
+		return false;
+	int size = list[0].height();
+	QImage strip(size * list.size(), size, QImage::Format_ARGB32);
+	strip.fill(0);
+	for(int i = 0; i < list.size(); i++)
+	{
+		for(int y = 0; y < size; y++)
+			memcpy(strip.scanLine(y) + i * size * 4, list[i].constScanLine(y), size * 4);
+	}
+	QSaveFile file(fileName);
+	if(!file.open(QIODevice::WriteOnly) || !strip.save(&file, "PNG"))
+		return false;
+	return file.commit();
+}
+
+StoneAtlas::Sprites * StoneAtlas::load(const Key & k)
+{
+	if(!diskCacheEnabled())
+		return NULL;
+	Sprites * s = new Sprites();
+	s->refs = 0;
+	if(!loadStrip(cacheFileName(k, "stones"), WHITE_STONES_NB + 2, s->stones, stoneDither) ||
+	   !loadStrip(cacheFileName(k, "ghosts"), WHITE_STONES_NB + 1, s->ghosts, Qt::AutoColor) ||
+	   (k.terr && !loadStrip(cacheFileName(k, "small"), WHITE_STONES_NB + 1, s->smallStones, Qt::AutoColor)))
+	{
+		delete s;
+		return NULL;
+	}
+	return s;
+}
+
+/* Runs on the global thread pool */
+void StoneAtlas::save(Key k, QList<QImage> stones, QList<QImage> ghosts, QList<QImage> smallStones)
+{
+	QDir().mkpath(QFileInfo(cacheFileName(k, "stones")).path());
+	if(!saveStrip(cacheFileName(k, "stones"), stones) ||
+	   !saveStrip(cacheFileName(k, "ghosts"), ghosts) ||
+	   (k.terr && !saveStrip(cacheFileName(k, "small"), smallStones)))
+		qCWarning(logRender, "Could not cache %d pixel stones", k.size);
+	prune(QFileInfo(cacheFileName(k, "stones")).dir());
+}
+
+/* Every window size paints another set, so the oldest written ones go
+ * once there's more than STONEATLAS_DISK_ENTRIES, as do the directories
+ * of older cache versions.  Files for one set go together. */
+void StoneAtlas::prune(QDir dir)
+{
+	QDir parent(dir);
+	if(parent.cdUp())
+	{
+		QFileInfoList versions = parent.entryInfoList(QStringList() << "stones-*", QDir::Dirs | QDir::NoDotAndDotDot);
+		for(int i = 0; i < versions.size(); i++)
+		{
+			if(versions[i].fileName() != dir.dirName())
+				QDir(versions[i].filePath()).removeRecursively();
+		}
+	}
+
+	QFileInfoList sets = dir.entryInfoList(QStringList() << "*-stones.png", QDir::Files, QDir::Time);
+	for(int i = STONEATLAS_DISK_ENTRIES; i < sets.size(); i++)
+	{
+		QString prefix = sets[i].fileName();
+		prefix.chop(QString("stones.png").length());
+		QFileInfoList files = dir.entryInfoList(QStringList() << prefix + "*.png", QDir::Files);
+		for(int j = 0; j < files.size(); j++)
+			QFile::remove(files[j].filePath());
+	}
+}
@@ -0,0 +1,74 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#ifndef STONEATLAS_H
+#define STONEATLAS_H
+
+#include <QtCore>
+#include <QPixmap>
+#include <QImage>
+
+/* Stone, ghost and territory stone pixmaps are the same for every board
+ * with the same square size and look, so the ImageHandlers share them
+ * through here instead of each painting its own.  Entries are counted
+ * by the handlers using them and a few unused ones are kept around for
+ * windows being resized back and forth.  Unless the STONES_DISK_CACHE
+ * setting is turned off, painted sets are also written out as strips
+ * under the cache location and read back by later windows and runs. */
+class StoneAtlas
+{
+public:
+	struct Key {
+		Key() : size(0), look(0), terr(false) {}
+		Key(int s, int l, bool t) : size(s), look(l), terr(t) {}
+		bool operator==(const Key & k) const { return size == k.size && look == k.look && terr == k.terr; }
+		int size;
+		int look;	//STONES_LOOK, 1 for display boards
+		bool terr;	//includes small territory stones
+	};
+	struct Sprites {
+		QList<QPixmap> stones, ghosts, smallStones;
+		int refs;
+		quint64 lastUsed;
+	};
+
+	static const Sprites * acquire(const Key & k);
+	static const Sprites * insert(const Key & k, const QList<QImage> & stones,
+				const QList<QImage> & ghosts, const QList<QImage> & smallStones);
+	static void release(const Key & k);
+	static bool contains(const Key & k);
+
+private:
+	static Sprites * load(const Key & k);
+	static void save(Key k, QList<QImage> stones, QList<QImage> ghosts, QList<QImage> smallStones);
+	static void prune(QDir dir);
+	static QString cacheFileName(const Key & k, const char * list);
+	static bool diskCacheEnabled(void);
+	static void evict(void);
+
+	static QHash<Key, Sprites *> entries;
+	static quint64 clock;
+};
+
+inline uint qHash(const StoneAtlas::Key & k) { return (k.size << 8) ^ (k.look << 1) ^ k.terr; }
+
+#endif //STONEATLAS_H
@@ -31,6 +31,7 @@
 #include "messages.h"
 #include "room.h"
 #include "friendslistdialog.h"
+#include "diagnosticsdialog.h"
 
 ConnectionWidget::ConnectionWidget(QWidget *parent) :
     QWidget(parent),
@@ -93,6 +94,7 @@ ConnectionWidget::ConnectionWidget(QWidget *parent) :
     connect( ui->openCheckBox, SIGNAL( clicked(bool) ), this, SLOT( slot_cbopen() ) );
     connect( ui->lookingCheckBox, SIGNAL( clicked(bool) ), this, SLOT( setLooking(bool) ) );
     connect( ui->editFriendsWatchesButton, SIGNAL(pressed()), SLOT(slot_editFriendsWatchesList()));
+    connect( ui->diagnosticsButton, SIGNAL(clicked()), SLOT(slot_diagnostics()));
 
     bool ok;
     int sort_column, sort_order_int;
@@ -1093,3 +1095,12 @@ void ConnectionWidget::slot_editFriendsWatchesList(void)
     fld->exec();
     fld->deleteLater();
 }
+
+void ConnectionWidget::slot_diagnostics(void)
+{
+    if (connection == NULL)
+        return;
+    DiagnosticsDialog * dd = new DiagnosticsDialog(connection, this);
+    dd->setAttribute(Qt::WA_DeleteOnClose);
+    dd->show();
+}
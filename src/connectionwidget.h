@@ -103,6 +103,7 @@ public slots:
 private slots:
     void setRankSpreadView(void);
     void slot_editFriendsWatchesList(void);
+    void slot_diagnostics(void);
     
 private:
     Ui::ConnectionWidget *ui;
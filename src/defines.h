@@ -35,6 +35,8 @@
 #define DEFAULT_BOARD_SIZE 19
 #define BOARD_X 500
 #define BOARD_Y 500
+#define BOARD_RESIZE_DELAY 150	//ms without resize events before the board is rebuilt
+#define ANALYSIS_FRAME_INTERVAL 250	//ms between two redraws of the live analysis
 #define PASS_XY -1
 
 #define WHITE_STONES_NB 8
@@ -50,6 +52,20 @@
 #define DEFAULT_ENGINE "gnugo"
 #define DEFAULT_ENGINE_PATH "/usr/games/"
 #define DEFAULT_ENGINE_OPTIONS "--mode gtp --quiet --level 10"
+#define ANALYSIS_RUN_LENGTH 8	//consecutive positions given to an analysing engine at once
+#define ANALYSIS_INTERVAL 10	//centiseconds between two lz/kata-analyze info lines
+#define GTP_TIMEOUT 30000	//ms to wait for an engine's answer before giving up on it
+#define CLOCK_TICK_INTERVAL 200	//ms between two checks of the running game clocks
+#define SOUND_RATE 22050	//Hz all sounds are decoded to and mixed at
+#define SOUND_BUFFER_MS 30	//audio output buffer, the latency of a sound
+#define SOUND_MIN_INTERVAL 250	//ms before a board plays the same sound again
+#define SOUND_MAX_VOICES 16	//sounds mixed at once, older ones are cut
+#define STRINGPOOL_MAX 50000	//interned or decoded strings kept before starting over
+#define DIAGNOSTICS_REFRESH 1000	//ms between diagnostics panel updates
+#define LOG_RING_SIZE 2000	//log lines kept in memory for saving
+#define LISTINGCACHE_MAX_AGE 24	//hours before a cached player/game list is ignored
+#define LISTINGCACHE_GRACE 20000	//ms to wait for the server lists before cached or pre-reconnect leftovers are dropped
+#define SEARCH_SNIPPET 60	//characters of comment shown per search result
 
 
 /*
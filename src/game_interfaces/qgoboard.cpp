@@ -30,12 +30,14 @@
 #include "messages.h"
 #include "resultdialog.h"
 #include "clockdisplay.h"
+#include "clockservice.h"
 #include "gamedata.h"
 #include "matrix.h"
 
 qGoBoard::qGoBoard(BoardWindow *bw, Tree * t, GameData *gd) : QObject(bw)
 {
 	isModified = false;	
+	clockStarted = false;
 	tree = t;
 	boardwindow = bw;
 	
@@ -48,7 +50,6 @@ qGoBoard::qGoBoard(BoardWindow *bw, Tree * t, GameData *gd) : QObject(bw)
     clickSound = new Sound("stone.wav");
 
 	dontCheckValidity = false;
-	lastSound = QTime(0,0,0);
 }
 
 /* FIXME: Make sure this isn't called from places it shouldn't be. Like
@@ -346,15 +347,11 @@ Move *qGoBoardNetworkInterface::doMove(StoneColor c, int x, int y)
     /* Non trivial here.  We don't want to play a sound as we get all
      * the moves from an observed game.  But there's no clean way
      * to tell when the board has stopped loading, particularly for IGS.
-     * so we only play a sound every 250 msecs...
+     * so the audio engine only plays this board's click every
+     * SOUND_MIN_INTERVAL, and none at all while a move list is batched in.
      * Also, maybe it should play even if we aren't looking at last move, yeah not sure on that FIXME */
-    if(boardwindow->getGamePhase() == phaseOngoing && QTime::currentTime() > lastSound)
-    {
-        if (playSound)
-            clickSound->play();
-        lastSound = QTime::currentTime();
-        lastSound = lastSound.addMSecs(250);
-    }
+    if(boardwindow->getGamePhase() == phaseOngoing && playSound && !moveBatch)
+        clickSound->play(this);
 
     return result;
 }
@@ -522,13 +519,30 @@ void qGoBoard::kibitzReceived(const QString& text)
     boardwindow->displayComment(k);
 }
 
+qGoBoard::~qGoBoard()
+{
+	ClockService::removeBoard(this);
+}
+
+/* Hands the board to the ClockService, which calls clockTick() from then
+ * on until stopTime().  Time before this isn't counted. */
+void qGoBoard::startClock(void)
+{
+	boardwindow->getClockDisplay()->hold(getBlackTurn(true));
+	ClockService::addBoard(this);
+	clockStarted = true;
+}
+
 // send regular time Info
-void qGoBoard::timerEvent(QTimerEvent*)
+void qGoBoard::clockTick(void)
 {
 	// wait until first move
 //	if (mv_counter < 0 || id < 0 || game_paused)
 	if (boardwindow->getGamePhase() != phaseOngoing)
+	{
+		boardwindow->getClockDisplay()->hold(getBlackTurn(true));
 		return;
+	}
 
 	boardwindow->getClockDisplay()->setTimeStep(getBlackTurn(true));
 /*
@@ -53,7 +53,7 @@ class qGoBoard : public QObject //, public Misc<QString>
 public:
 	qGoBoard(BoardWindow *bw, Tree * t, GameData *gd);
 //	qGoBoard(qGoBoard &qgoboard );
-    virtual ~qGoBoard() {}
+    virtual ~qGoBoard();
 	virtual void setHandicap(int handicap);
 	virtual void addStone(StoneColor c, int x, int y);
 
@@ -65,6 +65,8 @@ public:
     virtual void startGame() {}
     virtual void stopTime() {}
     virtual void handleMove(class MoveRecord *) {}
+    virtual void beginMoveBatch(void) {}
+    virtual void endMoveBatch(void) {}
     virtual void moveControl(QString &) {}
 	int getMoveNumber(void);
 	//virtual void set_havegd(bool b) 		{ have_gameData = b; }
@@ -76,7 +78,7 @@ public:
 	virtual void setResult(class GameResult & );
 	virtual void kibitzReceived(const QString& txt);
 	virtual void setTimerInfo(const QString&, const QString&, const QString&, const QString&) {}
-	virtual void timerEvent(QTimerEvent*);
+	virtual void clockTick(void);
 	class TimeRecord getOurTimeRecord(void);		//awkward
 	class TimeRecord getTheirTimeRecord(void);
 	virtual void enterScoreMode();
@@ -179,7 +181,8 @@ protected:
 	Tree *tree;
 	GameData *gameData;
 	Sound *clickSound;
-	int boardTimerId;
+	void startClock(void);
+	bool clockStarted;
 
 //	bool        timer_running;
 //	bool        game_paused;
@@ -226,7 +229,6 @@ protected:
     virtual void doPass(StoneColor c = stoneNone); // By default the player who is on turn will pass
 protected:
 	bool dontCheckValidity;
-	QTime lastSound;
 };
 
 /* We can override the virtuals above with nulls below if the option
@@ -248,6 +250,8 @@ protected:
 	virtual void sendMoveToInterface(StoneColor c,int x, int y);
 	virtual void sendPassToInterface(StoneColor c);
 	virtual void handleMove(MoveRecord * m);
+	virtual void beginMoveBatch(void);
+	virtual void endMoveBatch(void);
     virtual void moveControl(QString & player) { controlling_player = player; }
 	virtual void adjournGame(void);
     virtual void startGame(void) {}
@@ -256,6 +260,7 @@ protected:
 	
 	QString game_Id;
 	bool dontsend;
+	bool moveBatch;		//tree signals, sounds and clock held until endMoveBatch
 	QString controlling_player;
     Move * reviewCurrent;
     virtual Move *doMove(StoneColor c, int x, int y);
@@ -301,7 +306,7 @@ public:
 	void setTimerInfo(const QString&, const QString&, const QString&, const QString&);
 	void enterScoreMode();
 	void leaveScoreMode();
-	void timerEvent(QTimerEvent*);
+	void clockTick(void);
 	virtual void requestAdjournDialog(void);
 	virtual void requestCountDialog(void);
 	virtual void requestMatchModeDialog(void);
@@ -36,7 +36,7 @@ qGoBoardMatchInterface::qGoBoardMatchInterface(BoardWindow *bw, Tree * t, GameDa
 	
 	if(bw->getBoardDispatch()->startTimerOnOpen() && 
 		  (bw->getBoardDispatch()->clientCountsTime() || bw->getBoardDispatch()->clientSendsTime()))
-		boardTimerId = startTimer(1000);
+		startClock();
 	
     tree->slotNavLast();
 }
@@ -46,7 +46,7 @@ void qGoBoardMatchInterface::startGame(void)
 {
 	if(!boardwindow->getBoardDispatch()->startTimerOnOpen() && 
 		   (boardwindow->getBoardDispatch()->clientCountsTime() || boardwindow->getBoardDispatch()->clientSendsTime()))
-		boardTimerId = startTimer(1000);
+		startClock();
 }
 
 void qGoBoardMatchInterface::onFirstMove(void)
@@ -54,7 +54,7 @@ void qGoBoardMatchInterface::onFirstMove(void)
 	//we can now start the timer
 	if(!boardwindow->getBoardDispatch()->startTimerOnOpen() && 
 		   (boardwindow->getBoardDispatch()->clientCountsTime() || boardwindow->getBoardDispatch()->clientSendsTime()))
-		boardTimerId = startTimer(1000);				
+		startClock();				
 }
 
 /*
@@ -76,10 +76,14 @@ void qGoBoardMatchInterface::localMarkDeadRequest(int x,  int y)
 	sendMoveToInterface(stoneBlack,x,y);
 }
 
-void qGoBoardMatchInterface::timerEvent(QTimerEvent*)
+void qGoBoardMatchInterface::clockTick(void)
 {
+	ClockDisplay * clock = boardwindow->getClockDisplay();
 	if (boardwindow->getGamePhase() != phaseOngoing)
+	{
+		clock->hold(getBlackTurn());
 		return;
+	}
 	BoardDispatch * boarddispatch = boardwindow->getBoardDispatch();
 	if(!boarddispatch)
 	{
@@ -90,20 +94,26 @@ void qGoBoardMatchInterface::timerEvent(QTimerEvent*)
 	 * we could leave it in just in case, actually
 	 * might still somehow be necessary for clientSendsTime()*/
 	if(boarddispatch->isClockStopped())
+	{
+		clock->hold(getBlackTurn());
+		return;
+	}
+	bool ourTurn = ((getBlackTurn() && boardwindow->getMyColorIsBlack()) ||
+	   ((!getBlackTurn()) && boardwindow->getMyColorIsWhite()));
+	if(!boarddispatch->clientCountsTime() && !(ourTurn && boarddispatch->clientSendsTime()))
+	{
+		clock->hold(getBlackTurn());
+		return;
+	}
+	/* Nothing to warn about or send until a whole second has gone */
+	if(!clock->setTimeStep(getBlackTurn()))
 		return;
-	if(boarddispatch->clientCountsTime())
-		boardwindow->getClockDisplay()->setTimeStep(getBlackTurn());
-	
 	
-	if ((getBlackTurn() && boardwindow->getMyColorIsBlack()) ||
-	   ((!getBlackTurn()) && boardwindow->getMyColorIsWhite()))
+	if (ourTurn)
 	{
-		if(!boarddispatch->clientCountsTime() && boarddispatch->clientSendsTime())
-			boardwindow->getClockDisplay()->setTimeStep(getBlackTurn());
-		
 		/* FIXME, probably don't want to send time and time loss... even if
 		 * network protocols are exclusive with these... */
-		if(!boardwindow->getClockDisplay()->warning(getBlackTurn()))
+		if(!clock->warning(getBlackTurn()))
 			boarddispatch->sendTimeLoss();
 		
 		if(boarddispatch->clientSendsTime())
@@ -176,7 +186,7 @@ void qGoBoardMatchInterface::leaveScoreMode()
 	/* Make sure this doesn't conflict with game result stuff */
 	if(!boardwindow->getBoardDispatch()->startTimerOnOpen() && 
 		   (boardwindow->getBoardDispatch()->clientCountsTime() || boardwindow->getBoardDispatch()->clientSendsTime()))
-		boardTimerId = startTimer(1000);
+		startClock();
 
 	//boardwindow->getUi().doneButton->setEnabled(true);
 
@@ -27,6 +27,7 @@
 #include "../network/messages.h"
 #include "undoprompt.h"
 #include "clockdisplay.h"
+#include "clockservice.h"
 #include "gamedata.h"
 #include "boardwindow.h"
 #include "matrix.h"
@@ -48,7 +49,7 @@ qGoBoardNetworkInterface::qGoBoardNetworkInterface(BoardWindow *bw, Tree * t, Ga
         tree->slotNavLast();
 	}
 	dontsend = false;
-	boardTimerId = 0;
+	moveBatch = false;
 	controlling_player = QString();
 	reviewCurrent = 0;
 	// what about review games?  games without timers ??
@@ -436,7 +437,7 @@ void qGoBoardNetworkInterface::handleMove(MoveRecord * m)
 					m->color = (getBlackTurn() ? stoneBlack : stoneWhite);
                 if (doMove(m->color, m->x, m->y) == NULL)
 					QMessageBox::warning(boardwindow, tr("Invalid Move"), tr("The incoming move %1 %2 seems to be invalid").arg(QString::number(m->x), QString::number(m->y)));
-				else if(m->color == stoneWhite && !boardTimerId)  //awkward ?  FIXME for always move 1?
+				else if(m->color == stoneWhite && !clockStarted)  //awkward ?  FIXME for always move 1?
 				{
 					onFirstMove();
 				}
@@ -458,7 +459,8 @@ void qGoBoardNetworkInterface::handleMove(MoveRecord * m)
 			 * but with getBlackTurn() negated.  Otherwise, its like our move
 			 * gets decremented possibly when they play.  It looks weird... double
 			 * check with other time style though. */
-			boardwindow->getClockDisplay()->rerackTime(getBlackTurn());
+			if(!moveBatch)
+				boardwindow->getClockDisplay()->rerackTime(getBlackTurn());
 			break;
 	}
 	
@@ -473,6 +475,27 @@ void qGoBoardNetworkInterface::handleMove(MoveRecord * m)
     }
 }
 
+/* A whole move list, on observing or resuming a game, goes into the tree
+ * with its signals blocked so the board is drawn once at the end rather
+ * than for every move. */
+void qGoBoardNetworkInterface::beginMoveBatch(void)
+{
+	if(moveBatch)
+		return;
+	moveBatch = true;
+	tree->blockSignals(true);
+}
+
+void qGoBoardNetworkInterface::endMoveBatch(void)
+{
+	if(!moveBatch)
+		return;
+	moveBatch = false;
+	tree->blockSignals(false);
+	tree->setCurrent(tree->getCurrent());
+	boardwindow->getClockDisplay()->rerackTime(getBlackTurn());
+}
+
 void qGoBoardNetworkInterface::sendPassToInterface(StoneColor /*c*/)
 {
 	/* doPass is called when we receive the move from the server, 
@@ -587,6 +610,5 @@ void qGoBoardNetworkInterface::adjournGame(void)
  * something, I'll though we might just have lost connection so... */
 void qGoBoardNetworkInterface::stopTime(void)
 {
-	if(boardTimerId)
-		killTimer(boardTimerId);
+	ClockService::removeBoard(this);
 }
@@ -32,7 +32,7 @@
 qGoBoardObserveInterface::qGoBoardObserveInterface(BoardWindow *bw, Tree * t, GameData *gd) : qGoBoardNetworkInterface(bw,  t, gd) //, QObject(bw)
 {
 	if(bw->getBoardDispatch()->startTimerOnOpen() && bw->getBoardDispatch()->clientCountsTime())
-		boardTimerId = startTimer(1000);
+		startClock();
 	boardwindow->getBoardDispatch()->requestGameInfo();
 }
 
@@ -40,5 +40,5 @@ void qGoBoardObserveInterface::onFirstMove(void)
 {
 	//we can now start the timer
 	if(!boardwindow->getBoardDispatch()->startTimerOnOpen() && boardwindow->getBoardDispatch()->clientCountsTime())
-		boardTimerId = startTimer(1000);
+		startClock();
 }
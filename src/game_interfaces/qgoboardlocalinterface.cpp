@@ -33,6 +33,7 @@
 #include "audio.h"
 
 #include <QMessageBox>
+#include <QSet>
 
 qGoBoardLocalInterface::qGoBoardLocalInterface(BoardWindow *bw, Tree * t, GameData *gd)
     : qGoBoard(bw, t, gd)
@@ -51,10 +52,12 @@ qGoBoardLocalInterface::qGoBoardLocalInterface(BoardWindow *bw, Tree * t, GameDa
     // Set up computer interface.
     gtp = new QGtp();
     currentEngine = NULL;
+    replayReported = false;
 
     connect (gtp, SIGNAL(signal_computerPlayed(int, int)), SLOT(slot_playComputer(int, int)));
     connect (gtp, SIGNAL(computerResigned()), SLOT(slot_resignComputer()));
     connect (gtp, SIGNAL(computerPassed()), SLOT(slot_passComputer()));
+    connect (gtp, SIGNAL(signal_analysisUpdated()), SLOT(slot_analysisUpdated()));
 
 
     settings.beginReadArray("ENGINES");
@@ -75,10 +78,13 @@ qGoBoardLocalInterface::qGoBoardLocalInterface(BoardWindow *bw, Tree * t, GameDa
         delete gtp;
         gtp = NULL;
     }
+    engineUndo = (gtp && gtp->supportsUndo());
 
     tree->setCurrent(tree->findLastMoveInMainBranch());
 
     insertStoneFlag = false;
+    liveAnalysis = false;
+    analysedNode = NULL;
     feedPositionThroughGtp();
 }
 
@@ -109,15 +115,11 @@ void qGoBoardLocalInterface::localMoveRequest(StoneColor c, int x, int y)
     /* Non trivial here.  We don't want to play a sound as we get all
      * the moves from an observed game.  But there's no clean way
      * to tell when the board has stopped loading, particularly for IGS.
-     * so we only play a sound every 250 msecs...
+     * so the audio engine only plays this board's click every
+     * SOUND_MIN_INTERVAL...
      * Also, maybe it should play even if we aren't looking at last move, yeah not sure on that FIXME */
-    if(boardwindow->getGamePhase() == phaseOngoing && QTime::currentTime() > lastSound)
-    {
-        if (playSound)
-            clickSound->play();
-        lastSound = QTime::currentTime();
-        lastSound = lastSound.addMSecs(250);
-    }
+    if(boardwindow->getGamePhase() == phaseOngoing && playSound)
+        clickSound->play(this);
 
     if (engineUpToDate)
     {
@@ -150,9 +152,25 @@ void qGoBoardLocalInterface::slotUndoPressed()
         leaveScoreMode();
     else
     {
-        if (gtp)
-            gtp->undo(0);
+        // The engine must not be left on a node that is about to be deleted
+        Move *deleted = tree->getCurrent();
+        Move *m = currentEngine;
+        while (m != NULL && m != deleted)
+            m = m->parent;
+        if (gtp && m != NULL)
+        {
+            if (!deleted->parent || !walkEngineTo(deleted->parent))
+            {
+                // Replayed on the next move, any answer in flight is for the undone node
+                if (gtp->isBusy())
+                    gtp->discardMoves();
+                currentEngine = NULL;
+            }
+        }
+        analysedNode = NULL;
+        analysisResults.clear();
         qGoBoard::slotUndoPressed();
+        restartAnalysis();
     }
 }
 
@@ -163,37 +181,45 @@ void qGoBoardLocalInterface::sendMoveToInterface(StoneColor c,int x, int y)
 {
     if (!gtp)
         return;
-    switch (c)
-    {
-        case stoneWhite :
-        if (gtp->playwhite(x ,y))
-            {
-            QMessageBox::warning(boardwindow, PACKAGE, tr("Failed to play the stone within program \n") + 	gtp->getLastMessage());
-            return;
-            }
-        break;
-
-        case stoneBlack :
-        if (gtp->playblack(x ,y))
-        {
-            QMessageBox::warning(boardwindow, PACKAGE, tr("Failed to play the stone within program \n") + gtp->getLastMessage());
-            return;
-        }
-        break;
+    if (c != stoneWhite && c != stoneBlack)
+        return;
 
-        default :
-        ;
-    }
+    // The genmove, if any, is queued right behind the play
+    gtp->play(c, x, y, this, "slot_gtpPlayAnswered");
 
     // Check whether the computer should reply
     checkComputersTurn();
 }
 
+/*
+ * Answer to a play sent through GTP
+ */
+void qGoBoardLocalInterface::slot_gtpPlayAnswered(int, bool ok, QString response)
+{
+    if (!ok)
+        QMessageBox::warning(boardwindow, PACKAGE, tr("Failed to play the stone within program \n") + response);
+}
+
+/*
+ * Answer to a play sent while replaying the game.  Once one has failed
+ * the rest of the replay likely fails too : this is told only once.
+ */
+void qGoBoardLocalInterface::slot_gtpReplayAnswered(int, bool ok, QString response)
+{
+    if (ok || replayReported)
+        return;
+    replayReported = true;
+    QMessageBox::warning(boardwindow, PACKAGE, tr("Failed to replay the game within program \n") + response);
+}
+
 /*
  * This slot is triggered by the signal emitted by 'gtp' when getting a move
  */
 void qGoBoardLocalInterface::slot_playComputer(int x, int y)
 {
+    // The engine's node was undone while it was thinking
+    if (!currentEngine)
+        return;
     bool atCurrent = (tree->getCurrent() == currentEngine);
     Move *result = currentEngine->makeMove(currentEngine->whoIsOnTurn(), x, y);
     if (!result)
@@ -210,6 +236,9 @@ void qGoBoardLocalInterface::slot_playComputer(int x, int y)
 
 void qGoBoardLocalInterface::slot_resignComputer()
 {
+    // The engine's node was undone while it was thinking
+    if (!currentEngine)
+        return;
     // This hack should be removed by making doMove() and related functions relative to a move
     Move *remember = tree->getCurrent();
     bool atCurrent = (remember == currentEngine);
@@ -226,6 +255,9 @@ void qGoBoardLocalInterface::slot_resignComputer()
 
 void qGoBoardLocalInterface::slot_passComputer()
 {
+    // The engine's node was undone while it was thinking
+    if (!currentEngine)
+        return;
     bool atCurrent = (tree->getCurrent() == currentEngine);
     Move *result = currentEngine->makePass();
     if (!result)
@@ -250,47 +282,87 @@ void qGoBoardLocalInterface::sendPassToInterface(StoneColor c)
 {
     doPass(c);
 
-    if (gtp)
-    {
     // if simple pass, tell computer and move on
-    switch (c)
-    {
-        case stoneWhite :
-        if (gtp->playwhitePass())
-        {
-            QMessageBox::warning(boardwindow, PACKAGE, tr("Failed to pass within program \n") + gtp->getLastMessage());
-            return;
-        }
-        else
-            qDebug("comp notified of white pass");
-        break;
-
-        case stoneBlack :
-        if (gtp->playblackPass())
-        {
-            QMessageBox::warning(boardwindow, PACKAGE, tr("Failed to pass within program \n") + gtp->getLastMessage());
-            return;
-        }
-        break;
-
-        default :
-        ;
-    }
-    }
+    if (gtp && (c == stoneWhite || c == stoneBlack))
+        gtp->play(c, PASS_XY, PASS_XY, this, "slot_gtpPlayAnswered");
     if (tree->getCurrent()->parent->isPassMove())
         enterScoreMode();
     else
         checkComputersTurn();
 }
 
+/*
+ * Brings the engine to the current node.  When the engine knows "undo",
+ * it is walked back to the common ancestor of its node and the current
+ * one, then forward again.  Otherwise the whole game is replayed.
+ */
 void qGoBoardLocalInterface::feedPositionThroughGtp()
 {
     if (!gtp)
         return;
-    gtp->clearBoard();
+
+    if (!walkEngineTo(tree->getCurrent()))
+        replayThroughGtp(tree->getCurrent());
+
+    // Request a move if the computer is on turn
+    checkComputersTurn();
+}
+
+/*
+ * Sends the undo's and play's leading from 'currentEngine' to 'target'.
+ * Returns false when this can't be done and the board must be replayed.
+ */
+bool qGoBoardLocalInterface::walkEngineTo(Move *target)
+{
+    if (!gtp || !engineUndo || !currentEngine)
+        return false;
+    // A genmove in flight will have played a stone we can't count on
+    if (gtp->isBusy())
+        return false;
+
+    QSet<Move*> engineLine;
+    for (Move *m = currentEngine; m != NULL; m = m->parent)
+        engineLine.insert(m);
+
+    QStack<Move*> forward;
+    Move *ancestor = target;
+    while (ancestor != NULL && !engineLine.contains(ancestor))
+    {
+        forward.push(ancestor);
+        ancestor = ancestor->parent;
+    }
+    // Not in the same tree
+    if (ancestor == NULL)
+        return false;
+
+    // Everything is sent without waiting for the answers
+    for (Move *m = currentEngine; m != ancestor; m = m->parent)
+    {
+        if (m->getColor() == stoneWhite || m->getColor() == stoneBlack)
+            gtp->command("undo", this, "slot_gtpSyncAnswered");
+    }
+    while (!forward.isEmpty())
+        gtpPlay(forward.pop(), "slot_gtpSyncAnswered");
+
+    currentEngine = target;
+    return true;
+}
+
+/*
+ * Clears the engine board and plays every move from the root to 'target'.
+ */
+void qGoBoardLocalInterface::replayThroughGtp(Move *target)
+{
+    // A move being thought about is for the old position
+    if (gtp->isBusy())
+        gtp->discardMoves();
+
+    // Everything is sent without waiting for the answers
+    gtp->command("clear_board");
+    replayReported = false;
 
     QStack<Move*> stack;
-    Move *m = tree->getCurrent();
+    Move *m = target;
     currentEngine = m;
     while (m->parent != NULL)
     {
@@ -310,31 +382,48 @@ void qGoBoardLocalInterface::feedPositionThroughGtp()
                 if (m->getStoneAt(x,y) == stoneBlack)
                     handicap_stones.append(Point(x,y));
             }
-        gtp->set_free_handicap(handicap_stones);
+        gtp->set_free_handicap(handicap_stones, this, "slot_gtpReplayAnswered");
     }
 
     while (!stack.isEmpty())
-    {
-        m = stack.pop();
-        if (m->isPassMove())
-        {
-            if (m->getColor() == stoneBlack)
-                gtp->playblackPass();
-            else if (m->getColor() == stoneWhite)
-                gtp->playwhitePass();
-        } else {
-            if (m->getColor() == stoneWhite)
-                gtp->playwhite(m->getX(), m->getY());
-            else if (m->getColor() == stoneBlack)
-                gtp->playblack(m->getX(), m->getY());
-        }
-    }
-    // Request a move if the computer is on turn
-    checkComputersTurn();
+        gtpPlay(stack.pop(), "slot_gtpReplayAnswered");
+}
+
+/*
+ * Sends the stone (or pass) of 'm', if it has one
+ */
+void qGoBoardLocalInterface::gtpPlay(Move *m, const char *member)
+{
+    if (m->getColor() != stoneWhite && m->getColor() != stoneBlack)
+        return;
+    if (m->isPassMove())
+        gtp->play(m->getColor(), PASS_XY, PASS_XY, this, member);
+    else
+        gtp->play(m->getColor(), m->getX(), m->getY(), this, member);
+}
+
+/*
+ * Answer to an undo or play sent while walking the engine through the tree.
+ * If one fails the engine board can't be trusted any more : it is replayed
+ * from scratch, and so will it be from now on.
+ */
+void qGoBoardLocalInterface::slot_gtpSyncAnswered(int, bool ok, QString response)
+{
+    if (ok)
+        return;
+    qWarning("Engine failed to follow the tree: %s", response.toLatin1().constData());
+    if (!engineUndo || !gtp || !currentEngine)
+        return;
+    engineUndo = false;
+    replayThroughGtp(currentEngine);
 }
 
 void qGoBoardLocalInterface::checkComputersTurn(bool force)
 {
+    // The board may have moved on without the engine
+    if (liveAnalysis)
+        showAnalysis();
+
     if ((!gtp) || (gtp->isBusy()) || (!currentEngine))
         return;
 
@@ -347,9 +436,69 @@ void qGoBoardLocalInterface::checkComputersTurn(bool force)
 
     if (result == FAIL)
         QMessageBox::warning(boardwindow, PACKAGE, tr("Move request from engine failed\n") + gtp->getLastMessage());
+
+    // Thinking about its own move stops the analysis anyway
+    if (!gtp->isBusy())
+        restartAnalysis();
 }
 
 void qGoBoardLocalInterface::slotToggleInsertStones(bool val)
 {
     insertStoneFlag = val;
 }
+
+void qGoBoardLocalInterface::slotToggleLiveAnalysis(bool val)
+{
+    liveAnalysis = val;
+    if (liveAnalysis)
+        restartAnalysis();
+    else
+    {
+        // Any command ends the analysis
+        if (gtp && analysedNode)
+            gtp->command("name");
+        analysedNode = NULL;
+        analysisResults.clear();
+        showAnalysis();
+    }
+}
+
+/*
+ * Has the engine analyse its position until the next command
+ */
+void qGoBoardLocalInterface::restartAnalysis()
+{
+    if (!liveAnalysis || !gtp)
+        return;
+    // A genmove in the way : restarted once the engine has played
+    if (!currentEngine || gtp->isBusy())
+    {
+        showAnalysis();
+        return;
+    }
+
+    if (gtp->analyze(currentEngine->whoIsOnTurn(), ANALYSIS_INTERVAL) == FAIL)
+    {
+        QMessageBox::warning(boardwindow, PACKAGE, tr("Live analysis failed\n") + gtp->getLastMessage());
+        liveAnalysis = false;
+        return;
+    }
+    analysedNode = currentEngine;
+    showAnalysis();
+}
+
+void qGoBoardLocalInterface::slot_analysisUpdated()
+{
+    if (!liveAnalysis || !analysedNode)
+        return;
+    analysisResults.insert(analysedNode, gtp->getAnalysis());
+    showAnalysis();
+}
+
+/*
+ * Shows the latest analysis of the current node, if there is one
+ */
+void qGoBoardLocalInterface::showAnalysis()
+{
+    boardwindow->setAnalysis(analysisResults.value(tree->getCurrent()));
+}
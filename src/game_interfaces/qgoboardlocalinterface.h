@@ -24,12 +24,12 @@
 
 #include "defines.h"
 #include "qgoboard.h"
+#include "qgtp.h"
 
 class BoardWindow;
 class Tree;
 class GameData;
 class Move;
-class QGtp;
 class Sound;
 
 class qGoBoardLocalInterface : public qGoBoard
@@ -49,9 +49,14 @@ public slots:
     void slot_playComputer(int x, int y);
     void slot_resignComputer();
     void slot_passComputer();
+    void slot_gtpPlayAnswered(int, bool ok, QString response);
+    void slot_gtpSyncAnswered(int, bool ok, QString response);
+    void slot_gtpReplayAnswered(int, bool ok, QString response);
     virtual void slotDonePressed();
     virtual void slotUndoPressed();
     void slotToggleInsertStones(bool val);
+    void slotToggleLiveAnalysis(bool val);
+    void slot_analysisUpdated();
 
 private:
     virtual void sendMoveToInterface(StoneColor c,int x, int y);
@@ -61,8 +66,19 @@ private:
 //	void enterScoreMode() {}
     void leaveScoreMode() {}
 
+    bool walkEngineTo(Move *target);
+    void replayThroughGtp(Move *target);
+    void gtpPlay(Move *m, const char *member);
+    void restartAnalysis();
+    void showAnalysis();
+
     QGtp *gtp;
     Move *currentEngine;
+    bool engineUndo;
+    bool replayReported;	//a failure of the last replay was shown already
+    bool liveAnalysis;
+    Move *analysedNode;
+    QHash<Move*, QVector<AnalysisCandidate> > analysisResults;	//keys are only compared
     bool insertStoneFlag;
 };
 
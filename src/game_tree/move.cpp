@@ -44,6 +44,7 @@ Move::Move(int board_size)
 	timeinfo = false;
 	handicapMove = false;
 	matrix = new Matrix(board_size);
+	revision = 0;
 }
 
 Move::Move(StoneColor c, int mx, int my, int n, GamePhase phase, const Matrix &mat, bool clearAllMarks, const QString &s)
@@ -62,6 +63,7 @@ Move::Move(StoneColor c, int mx, int my, int n, GamePhase phase, const Matrix &m
 	timeinfo = false;
 	handicapMove = false;
     matrix = new Matrix(mat, clearAllMarks);
+	revision = 0;
 }
 
 Move::Move(StoneColor c, int mx, int my, int n, GamePhase phase, const QString &s)
@@ -80,6 +82,7 @@ Move::Move(StoneColor c, int mx, int my, int n, GamePhase phase, const QString &
 	PLinfo = false;
 	timeinfo = false;
     handicapMove = false;
+	revision = 0;
 }
 
 Move::Move(Move *_parent, StoneColor _c, int _x, int _y)
@@ -99,10 +102,12 @@ Move::Move(Move *_parent, StoneColor _c, int _x, int _y)
     PLinfo = false;
     timeinfo = false;
     handicapMove = false;
+    revision = 0;
     // current node has no son?
     if (parent->son == NULL)
     {
         parent->son = this;
+        touch();
     }
     // A son found. Add the new node as farest right brother of that son
     else
@@ -127,6 +132,17 @@ Move::~Move()
     delete matrix;
 }
 
+/*
+ * Counts a change to the tree 'this' is in, on its root
+ */
+void Move::touch()
+{
+	Move *m = this;
+	while (m->parent != NULL)
+		m = m->parent;
+	m->revision++;
+}
+
 /*
  * returns a string representing the move in SGF format
  */
@@ -284,6 +300,7 @@ void Move::addBrother(Move * b)
 		
 	tmp->brother = b;
 	b->parent = tmp->parent;
+	b->touch();
 	b->setTimeinfo(false);			//whats this for FIXME?
 }
 
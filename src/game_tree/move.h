@@ -52,11 +52,12 @@ public:
 	GamePhase getGamePhase() const 	{ return gamePhase; }
 	void setGamePhase(GamePhase p) 	{ gamePhase = p; }
 	QString &getNodeName() 		{ return nodeName; }
-	void setNodeName(const QString &s) { nodeName = s; }
+	void setNodeName(const QString &s) { nodeName = s; touch(); }
 	QString &getComment() 		{ return comment; }
 	void setComment(const QString &s) {
 		comment = s;
 		comment.squeeze();
+		touch();
 	}
 	QString &getUnknownProperty() 	{ return unknownProperty; }
 	void setUnknownProperty(const QString &s) { unknownProperty = s; }
@@ -104,7 +105,15 @@ public:
 
     StoneColor whoIsOnTurn();
 
+	/* The root counts every node made, linked or deleted in its tree,
+	 * and every comment or name set, so a TreeIndex can tell when it's
+	 * out of date.  Only the root's count means anything. */
+	void touch();
+	unsigned int getRevision() const	{ return revision; }
+	void setRevision(unsigned int r)	{ revision = r; }
+
 private:
+	unsigned int revision;
 	StoneColor stoneColor, PLnextMove;
 	int x, y, moveNum, capturesBlack, capturesWhite, openMoves , nodeIndex;
 	float scoreBlack, scoreWhite;
@@ -0,0 +1,121 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#include "searchindex.h"
+#include "defines.h"
+
+#include <algorithm>
+#include <iterator>
+
+SearchIndex::SearchIndex() : entries(0)
+{
+}
+
+void SearchIndex::clear(void)
+{
+	postings.clear();
+	entries = 0;
+}
+
+int SearchIndex::addEntry(const QString & text)
+{
+	QStringList words = tokenize(text);
+	for(int i = 0; i < words.size(); i++)
+	{
+		QVector<int> & p = postings[words[i]];
+		if(p.isEmpty() || p.last() != entries)
+			p.append(entries);
+	}
+	return entries++;
+}
+
+/* Sorted entry numbers */
+QVector<int> SearchIndex::find(const QString & query) const
+{
+	QVector<int> result;
+	QStringList words = tokenize(query);
+	for(int i = 0; i < words.size(); i++)
+	{
+		QVector<int> matches;
+		QMap<QString, QVector<int> >::const_iterator p = postings.lowerBound(words[i]);
+		for(; p != postings.constEnd() && p.key().startsWith(words[i]); ++p)
+			matches += p.value();
+		std::sort(matches.begin(), matches.end());
+		matches.erase(std::unique(matches.begin(), matches.end()), matches.end());
+		if(i == 0)
+			result = matches;
+		else
+		{
+			QVector<int> both;
+			std::set_intersection(result.constBegin(), result.constEnd(),
+					matches.constBegin(), matches.constEnd(), std::back_inserter(both));
+			result = both;
+		}
+		if(result.isEmpty())
+			break;
+	}
+	return result;
+}
+
+QStringList SearchIndex::tokenize(const QString & text)
+{
+	QStringList words;
+	QString word;
+	for(int i = 0; i < text.size(); i++)
+	{
+		QChar c = text.at(i);
+		if(!c.isLetterOrNumber())
+		{
+			if(!word.isEmpty())
+				words << word.toCaseFolded();
+			word.clear();
+			continue;
+		}
+		QChar::Script script = c.script();
+		if(script == QChar::Script_Han || script == QChar::Script_Hiragana || script == QChar::Script_Katakana)
+		{
+			if(!word.isEmpty())
+				words << word.toCaseFolded();
+			word.clear();
+			words << QString(c);
+			continue;
+		}
+		word += c;
+	}
+	if(!word.isEmpty())
+		words << word.toCaseFolded();
+	return words;
+}
+
+/* A line's worth of text around the first word of the query */
+QString SearchIndex::snippet(const QString & text, const QString & query)
+{
+	QStringList words = tokenize(query);
+	int at = words.isEmpty() ? -1 : text.indexOf(words.first(), 0, Qt::CaseInsensitive);
+	int from = qMax(0, at - SEARCH_SNIPPET / 3);
+	QString s = text.mid(from, SEARCH_SNIPPET).simplified();
+	if(from > 0)
+		s.prepend("...");
+	if(from + SEARCH_SNIPPET < text.size())
+		s.append("...");
+	return s;
+}
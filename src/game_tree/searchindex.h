@@ -0,0 +1,51 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <QMap>
+#include <QVector>
+#include <QStringList>
+
+/* Inverted index from words to the entries they appear in.  Entries are
+ * numbered in the order they're added, so postings stay sorted without
+ * any work.  Every word of a query has to appear, each as a prefix of
+ * some word in the entry.  Han and kana aren't split into words by
+ * spaces, so each of those characters is a word on its own. */
+class SearchIndex
+{
+	public:
+		SearchIndex();
+		void clear(void);
+		int addEntry(const QString & text);
+		int size(void) const { return entries; }
+		QVector<int> find(const QString & query) const;
+
+		static QStringList tokenize(const QString & text);
+		static QString snippet(const QString & text, const QString & query);
+	private:
+		QMap<QString, QVector<int> > postings;
+		int entries;
+};
+
+#endif //SEARCHINDEX_H
@@ -27,6 +27,8 @@
 #include "messages.h"
 #include "sgfparser.h"
 #include "gamedata.h"
+#include "logging.h"
+#include "treeindex.h"
 
 #include <vector>
 
@@ -36,15 +38,19 @@ Tree::Tree(int board_size, float komi)
     : boardSize(board_size), root(NULL), komi(komi)
 {
     checkPositionTags = NULL;
+    index = new TreeIndex();
     init();
     loadingSGF = false;
 }
 
 void Tree::init()
 {
+	// The count goes on over the new root, for those comparing with it
+	unsigned int revision = getRevision();
 	if(root)
 		clear();
     root = new Move(boardSize);
+    root->setRevision(revision + 1);
 	// node index used for IGS review
 	root->setNodeIndex(1);
 	lastMoveInMainBranch = current = root;
@@ -58,6 +64,7 @@ Tree::~Tree()
 {
 	delete checkPositionTags;
     clear();
+    delete index;
 }
 
 /*
@@ -108,12 +115,13 @@ bool Tree::addSon(Move *node)
     {
         if(current == node)
         {
-            qDebug("Attempting to add move as its own son!");
+            qCWarning(logTree, "Attempting to add move as its own son!");
             return false;
         }
         current->son = node;
 
         node->parent = current;
+        node->touch();
         node->setTimeinfo(false);
         current = node;
         if(isInMainBranch(current->parent))
@@ -265,9 +273,7 @@ bool Tree::hasSon(Move *m)
 
 void Tree::clear()
 {
-#ifndef NO_DEBUG
-	qDebug("Tree had %d nodes.", count());
-#endif
+	qCDebug(logTree, "Tree had %d nodes.", count());
 	
 	if (root == NULL)
 		return;
@@ -508,7 +514,7 @@ void Tree::addEmptyMove( bool /*brother*/)
 		 * "brother", so it just always does addSon.
 		 * Then addSon will add a brother if it should be a brother.
 		 * Obviously this needs clarification */
-		qDebug("*** HAVE THIS SON ALREADY! ***");
+		qCDebug(logTree, "*** HAVE THIS SON ALREADY! ***");
 		delete m;
 		return;
 	}
@@ -601,12 +607,13 @@ bool Tree::insertStone(Move *node)
 		{
 			if(current == node)
 			{
-				qDebug("Attempting to add move as its own son!");
+				qCWarning(logTree, "Attempting to add move as its own son!");
 				return false;
 			}
 
 			current->son = node;
 			node->parent = current;
+			node->touch();
 			node->setTimeinfo(false);
             current = node;
 			node->getMatrix()->insertStone(node->getX(), node->getY(), node->getColor());
@@ -632,6 +639,7 @@ bool Tree::insertStone(Move *node)
 			}
 			current->parent->marker = current;
 			node->marker = NULL;
+			node->touch();
 
 			node->setTimeinfo(false);
             current = node;
@@ -757,6 +765,7 @@ void Tree::deleteNode()
 		traverseClear(m->son);  // Traverse the tree after our move (to avoid brothers)
 	delete m;                         // Delete our move
     remember->son = remSon;           // Reset son pointer, NULL
+	root->touch();
 	remember->marker = NULL;          // Forget marker
     setCurrent(remember);       // Set current move to previous move
 }
@@ -799,42 +808,38 @@ void Tree::slotNavLast()
     setCurrent(findLastMoveInCurrentBranch());
 }
 
-void Tree::slotNavPrevComment()
+const TreeIndex & Tree::getIndex()
 {
-    Move  *m = current->parent;
+    if (!index->isCurrent(getRevision()))
+        index->build(root);
+    return *index;
+}
 
-    while (m != NULL)
-    {
-        if (m->getComment() != "")
-            break;
-        if (m->parent == NULL)
-            break;
-        m = m->parent;
-    }
+unsigned int Tree::getRevision() const
+{
+    return (root ? root->getRevision() : 0);
+}
 
+/* A brother of the old root takes over, and its count */
+void Tree::setRoot(Move *m)
+{
+    m->setRevision(getRevision() + 1);
+    root = m;
+}
+
+void Tree::slotNavPrevComment()
+{
+    Move *m = getIndex().previous(current);
     if (m != NULL)
-    {
         setCurrent(m);
-    }
 }
 
+/* Carries on into the variations once the current line has no more */
 void Tree::slotNavNextComment()
 {
-    Move  *m = current->son;
-
-    while (m != NULL)
-    {
-        if (m->getComment() != "")
-            break;
-        if (m->son == NULL)
-            break;
-        m = m->son;
-    }
-
+    Move *m = getIndex().next(current);
     if (m != NULL)
-    {
         setCurrent(m);
-    }
 }
 
 void Tree::slotNthMove(int n)
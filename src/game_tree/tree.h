@@ -32,6 +32,7 @@ class Group;
 class Matrix;
 class GameResult;
 class GameData;
+class TreeIndex;
 
 class Tree : public QObject
 {
@@ -53,6 +54,9 @@ public:
 	Move * findLastMoveInCurrentBranch();
 	Move * findNode(Move *m, int node);
     bool isInMainBranch(Move * m) const;
+    // Built again on demand after the tree or its comments change
+    const TreeIndex & getIndex();
+    unsigned int getRevision() const;
 /*
  * Former Boardhandler functions called by SGF parser
  */
@@ -119,7 +123,7 @@ private:
     void clear();
     void traverseClear(Move *m);
     int count();
-    void setRoot(Move *m) { root = m; }
+    void setRoot(Move *m);
     int mainBranchSize();
     void traverseFind(Move *m, int x, int y, QStack<Move*> &result);
 
@@ -130,6 +134,7 @@ private:
 
     Move *root, *current;
 	Matrix * checkPositionTags;
+	TreeIndex * index;
 
     bool loadingSGF;
     int deadWhite, deadBlack;
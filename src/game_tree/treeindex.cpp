@@ -0,0 +1,114 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#include "treeindex.h"
+
+#include <QStack>
+#include <algorithm>
+
+TreeIndex::TreeIndex() : revision(0), built(false)
+{
+}
+
+void TreeIndex::build(Move * root)
+{
+	index.clear();
+	nodes.clear();
+	ends.clear();
+	numbers.clear();
+	commented.clear();
+
+	/* root's brothers, if any, are other games, not variations */
+	QStack<Move *> stack;
+	QVector<Move *> sons;
+	if(root)
+		stack.push(root);
+	while(!stack.isEmpty())
+	{
+		Move * m = stack.pop();
+		int n = index.addEntry(text(m));
+		numbers.insert(m, n);
+		nodes.append(m);
+		ends.append(n + 1);
+		if(!m->getComment().isEmpty())
+			commented.append(n);
+		sons.clear();
+		for(Move * s = m->son; s; s = s->brother)
+			sons.append(s);
+		while(!sons.isEmpty())
+			stack.push(sons.takeLast());
+	}
+	/* Every node comes after its parent, so going backwards each
+	 * subtree is done before it's passed up */
+	for(int i = nodes.size() - 1; i > 0; i--)
+	{
+		int p = numbers.value(nodes[i]->parent, -1);
+		if(p >= 0 && ends[i] > ends[p])
+			ends[p] = ends[i];
+	}
+	revision = (root ? root->getRevision() : 0);
+	built = true;
+}
+
+QString TreeIndex::text(Move * m)
+{
+	if(m->getNodeName().isEmpty())
+		return m->getComment();
+	return m->getNodeName() + "\n" + m->getComment();
+}
+
+QVector<int> TreeIndex::find(const QString & query) const
+{
+	return index.find(query);
+}
+
+/* An empty query matches every node with a comment */
+QVector<int> TreeIndex::matches(const QString & query) const
+{
+	if(query.isEmpty())
+		return commented;
+	return index.find(query);
+}
+
+Move * TreeIndex::next(const Move * from, const QString & query) const
+{
+	QVector<int> m = matches(query);
+	QVector<int>::const_iterator i = std::upper_bound(m.constBegin(), m.constEnd(), number(from));
+	if(i == m.constEnd())
+		return NULL;
+	return nodes[*i];
+}
+
+/* Back up the line toward the root, like stepping backward does */
+Move * TreeIndex::previous(const Move * from, const QString & query) const
+{
+	int n = number(from);
+	QVector<int> m = matches(query);
+	QVector<int>::const_iterator i = std::lower_bound(m.constBegin(), m.constEnd(), n);
+	while(i != m.constBegin())
+	{
+		--i;
+		if(ends[*i] > n)
+			return nodes[*i];
+	}
+	return NULL;
+}
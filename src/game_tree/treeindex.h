@@ -0,0 +1,61 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#ifndef TREEINDEX_H
+#define TREEINDEX_H
+
+#include "searchindex.h"
+#include "move.h"
+
+#include <QHash>
+
+/* Search over the comments and node names of one tree.  Nodes are
+ * numbered in preorder with sons before brothers, which is also the
+ * order they come in an SGF file.  From a node on some line, that puts
+ * the rest of the line first and the variations after it.  Tree::getIndex()
+ * builds it again whenever the revision kept on the root has moved on. */
+class TreeIndex
+{
+	public:
+		TreeIndex();
+		void build(Move * root);
+		bool isCurrent(unsigned int r) const { return built && revision == r; }
+		QVector<int> find(const QString & query) const;
+		Move * next(const Move * from, const QString & query = QString()) const;
+		Move * previous(const Move * from, const QString & query = QString()) const;
+		Move * node(int number) const { return nodes.value(number); }
+		int number(const Move * m) const { return numbers.value(m, -1); }
+
+		static QString text(Move * m);
+	private:
+		QVector<int> matches(const QString & query) const;
+
+		SearchIndex index;
+		QVector<Move *> nodes;
+		QVector<int> ends;		//one past the last node under each node
+		QHash<const Move *, int> numbers;
+		QVector<int> commented;
+		unsigned int revision;
+		bool built;
+};
+
+#endif //TREEINDEX_H
@@ -0,0 +1,393 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+
+
+#include "engineanalysis.h"
+#include "qgtp.h"
+#include "tree.h"
+#include "move.h"
+#include "matrix.h"
+
+#include <QSettings>
+#include <QStack>
+#include <QStringList>
+#include <QThread>
+
+EngineAnalysis::EngineAnalysis(Tree *t, int size, float k, QObject *parent)
+	: QObject(parent), tree(t), board_size(size), komi(k), done(0)
+{
+}
+
+EngineAnalysis::~EngineAnalysis()
+{
+	for (int i = 0; i < workers.size(); i++)
+		delete workers[i].gtp;
+}
+
+/*
+ * Starts the engines of the pool.  Their number is the ANALYSIS_ENGINES
+ * setting, by default one per core, and they all run the default engine.
+ * Each one is fed as soon as its setup is answered, nothing waits here.
+ */
+bool EngineAnalysis::start(bool variations)
+{
+	stop();
+	lastMessage.clear();
+	collect(variations);
+	for (int i = 0; i < positions.size(); i += ANALYSIS_RUN_LENGTH)
+		runs.append(qMakePair(i, qMin(i + ANALYSIS_RUN_LENGTH, positions.size())));
+
+	QSettings settings;
+	settings.beginReadArray("ENGINES");
+	settings.setArrayIndex(settings.value("DEFAULT_ENGINE").toInt());
+	QString path = settings.value("path").toString();
+	QString args = settings.value("args").toString();
+	settings.endArray();
+	if (path.isEmpty())
+	{
+		path = QString(DEFAULT_ENGINE_PATH)+QString(DEFAULT_ENGINE);
+		args = DEFAULT_ENGINE_OPTIONS;
+	}
+	int pool = settings.value("ANALYSIS_ENGINES", QThread::idealThreadCount()).toInt();
+	pool = qBound(1, pool, qMax(1, runs.size()));
+
+	for (int i = 0; i < pool; i++)
+	{
+		Worker w;
+		w.gtp = new QGtp();
+		w.board = NULL;
+		w.regGenmove = w.estimateScore = false;
+		if (w.gtp->startGtpSession(path, args, board_size, komi) == FAIL)
+		{
+			lastMessage = w.gtp->getLastMessage();
+			qWarning("Analysis engine failed to start: %s", lastMessage.toLatin1().constData());
+			delete w.gtp;
+			// Won't do better with the next ones
+			break;
+		}
+		connect(w.gtp, SIGNAL(signal_sessionReady(bool)), SLOT(slot_engineReady(bool)));
+		connect(w.gtp, SIGNAL(signal_response(int,bool,QString)), SLOT(slot_answer(int,bool,QString)));
+		// Answered after the session setup : the engine is fed on the last one
+		Request r;
+		r.position = -1;
+		r.score = false;
+		w.requests.insert(w.gtp->command("known_command reg_genmove"), r);
+		r.score = true;
+		w.requests.insert(w.gtp->command("known_command estimate_score"), r);
+		workers.append(w);
+	}
+
+	done = 0;
+	if (workers.isEmpty() || positions.isEmpty())
+	{
+		stop();
+		return false;
+	}
+	emit signal_progress(0, positions.size());
+	return true;
+}
+
+void EngineAnalysis::stop()
+{
+	// Answers already on their way are dropped by slot_answer()
+	for (int i = 0; i < workers.size(); i++)
+		workers[i].gtp->deleteLater();
+	workers.clear();
+	runs.clear();
+	positions.clear();
+}
+
+/*
+ * Lists the positions in the order the engines will go through them:
+ * the main line, or all the nodes, each variation right after its parent.
+ */
+void EngineAnalysis::collect(bool variations)
+{
+	positions.clear();
+	Position p;
+	p.move = tree->getRoot();
+
+	if (!variations)
+	{
+		while (p.move != NULL)
+		{
+			positions.append(p);
+			p.move = p.move->son;
+			p.path.append(0);
+		}
+		return;
+	}
+
+	QStack<Position> stack;
+	stack.push(p);
+	while (!stack.isEmpty())
+	{
+		p = stack.pop();
+		positions.append(p);
+
+		QList<Position> sons;
+		int n = 0;
+		for (Move *s = p.move->son; s != NULL; s = s->brother, n++)
+		{
+			Position q;
+			q.move = s;
+			q.path = p.path;
+			q.path.append(n);
+			sons.prepend(q);
+		}
+		// The first son goes on top of the stack
+		for (int i = 0; i < sons.size(); i++)
+			stack.push(sons[i]);
+	}
+}
+
+/*
+ * Finds the node of a position again, or NULL if it was deleted since.
+ * The pointer kept in the position is only compared, never followed.
+ */
+Move *EngineAnalysis::resolve(const Position &p) const
+{
+	Move *m = tree->getRoot();
+	for (int i = 0; i < p.path.size() && m != NULL; i++)
+	{
+		m = m->son;
+		for (int n = 0; n < p.path[i] && m != NULL; n++)
+			m = m->brother;
+	}
+	return (m == p.move ? m : NULL);
+}
+
+/*
+ * Gives the next run of positions to an engine.  Returns false when
+ * there is none left.
+ */
+bool EngineAnalysis::feed(Worker &w)
+{
+	while (w.requests.isEmpty() && !runs.isEmpty())
+	{
+		QPair<int,int> run = runs.takeFirst();
+		for (int i = run.first; i < run.second; i++)
+		{
+			Move *m = resolve(positions[i]);
+			if (m == NULL)
+			{
+				w.board = NULL;
+				emit signal_progress(++done, positions.size());
+				continue;
+			}
+
+			if (w.board != NULL && m->parent == w.board)
+				sendMove(w, m);
+			else if (m != w.board)
+				replay(w, m);
+			w.board = m;
+
+			QByteArray color = (m->whoIsOnTurn() == stoneBlack ? "black" : "white");
+			Request r;
+			r.position = i;
+			r.score = false;
+			if (w.regGenmove)
+				w.requests.insert(w.gtp->command("reg_genmove " + color), r);
+			else
+			{
+				// See slot_answer() for a genmove that plays nothing
+				w.requests.insert(w.gtp->command("genmove " + color), r);
+				w.gtp->command("undo");
+			}
+			if (w.estimateScore)
+			{
+				r.score = true;
+				w.requests.insert(w.gtp->command("estimate_score"), r);
+			}
+		}
+	}
+	return !w.requests.isEmpty();
+}
+
+/*
+ * Sets up the position of 'target' on an empty board
+ */
+void EngineAnalysis::replay(Worker &w, Move *target)
+{
+	w.gtp->command("clear_board");
+
+	QStack<Move*> stack;
+	for (Move *m = target; m->parent != NULL; m = m->parent)
+		stack.push(m);
+
+	if (tree->getRoot()->isHandicapMove())
+	{
+		Matrix *matrix = tree->getRoot()->getMatrix();
+		QList<Point> handicap_stones;
+		for (int x = 1; x <= board_size; x++)
+			for (int y = 1; y <= board_size; y++)
+			{
+				if (matrix->getStoneAt(x,y) == stoneBlack)
+					handicap_stones.append(Point(x,y));
+			}
+		w.gtp->set_free_handicap(handicap_stones);
+	}
+
+	while (!stack.isEmpty())
+		sendMove(w, stack.pop());
+}
+
+void EngineAnalysis::sendMove(Worker &w, Move *m)
+{
+	if (m->getColor() != stoneWhite && m->getColor() != stoneBlack)
+		return;
+	if (m->isPassMove())
+		w.gtp->play(m->getColor(), PASS_XY, PASS_XY);
+	else
+		w.gtp->play(m->getColor(), m->getX(), m->getY());
+}
+
+/*
+ * The answers of all the commands of an engine come here, those we are
+ * not waiting for are dropped.
+ */
+void EngineAnalysis::slot_answer(int id, bool ok, QString response)
+{
+	int i = 0;
+	while (i < workers.size() && workers[i].gtp != sender())
+		i++;
+	if (i == workers.size() || !workers[i].requests.contains(id))
+		return;
+
+	Worker &w = workers[i];
+	Request r = w.requests.take(id);
+	if (r.position < 0)
+	{
+		bool known = (ok && response.trimmed() == "true");
+		if (r.score)
+			w.estimateScore = known;
+		else
+			w.regGenmove = known;
+		if (!w.requests.isEmpty())
+			return;
+		if (!w.regGenmove && !w.gtp->supportsUndo())
+		{
+			lastMessage = tr("The engine knows neither reg_genmove nor undo");
+			qWarning("Analysis engine dropped: %s", lastMessage.toLatin1().constData());
+			retire(i);
+			return;
+		}
+	}
+	else
+	{
+		Move *m = resolve(positions[r.position]);
+		bool played = (ok && response.trimmed().toLower() != "resign");
+		if (!ok)
+			qWarning("Analysis of position %d failed: %s", r.position, response.toLatin1().constData());
+		else if (m != NULL)
+			annotate(m, r.score ? tr("Analysis: score estimate %1") : tr("Analysis: best move %1"), response.trimmed());
+		if (!r.score)
+			emit signal_progress(++done, positions.size());
+
+		// The undo queued behind a genmove that played nothing takes back
+		// a stone of the position itself
+		if (!r.score && !w.regGenmove && !played)
+			restartRun(w, r.position);
+	}
+
+	if (w.requests.isEmpty() && !feed(w))
+		retire(i);
+}
+
+/*
+ * The session of an engine could not be set up
+ */
+void EngineAnalysis::slot_engineReady(bool ok)
+{
+	if (ok)
+		return;
+	int i = 0;
+	while (i < workers.size() && workers[i].gtp != sender())
+		i++;
+	if (i == workers.size())
+		return;
+	lastMessage = workers[i].gtp->getLastMessage();
+	qWarning("Analysis engine failed to start: %s", lastMessage.toLatin1().constData());
+	retire(i);
+}
+
+/*
+ * The engine's board is wrong from 'position' on.  What is left of its
+ * run is given out again one position at a time, and the engine itself
+ * starts over from an empty board.  The answers to the commands already
+ * sent are dropped.
+ */
+void EngineAnalysis::restartRun(Worker &w, int position)
+{
+	QList<int> left;
+	QHash<int, Request>::const_iterator it;
+	for (it = w.requests.constBegin(); it != w.requests.constEnd(); ++it)
+	{
+		if (!it.value().score && it.value().position > position)
+			left.append(it.value().position);
+	}
+	w.requests.clear();
+	w.board = NULL;
+
+	qSort(left);
+	for (int j = left.size() - 1; j >= 0; j--)
+		runs.prepend(qMakePair(left[j], left[j] + 1));
+}
+
+/*
+ * An engine is done, or of no use.  We are called from its own
+ * dispatching, so it is deleted later.
+ */
+void EngineAnalysis::retire(int i)
+{
+	workers[i].gtp->deleteLater();
+	workers.removeAt(i);
+	if (!workers.isEmpty())
+		return;
+	// The message only tells why positions were left out
+	if (runs.isEmpty())
+		lastMessage.clear();
+	runs.clear();
+	positions.clear();
+	emit signal_finished();
+}
+
+/*
+ * Writes a line of the analysis in the comment of the node.  The line of
+ * an earlier analysis, if any, is replaced.
+ */
+void EngineAnalysis::annotate(Move *m, const QString &line, const QString &value)
+{
+	QString prefix = line.left(line.indexOf("%1"));
+	QStringList lines = m->getComment().split('\n');
+	for (int j = lines.size() - 1; j >= 0; j--)
+	{
+		if (lines[j].startsWith(prefix))
+			lines.removeAt(j);
+	}
+	while (!lines.isEmpty() && lines.last().isEmpty())
+		lines.removeLast();
+	lines.append(line.arg(value));
+	m->setComment(lines.join("\n"));
+	emit signal_analysed(m);
+}
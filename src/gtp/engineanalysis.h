@@ -0,0 +1,102 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+
+
+#ifndef ENGINEANALYSIS_H
+#define ENGINEANALYSIS_H
+
+#include <QObject>
+#include <QList>
+#include <QHash>
+#include <QPair>
+
+#include "defines.h"
+
+class QGtp;
+class Tree;
+class Move;
+
+/* Analyses the positions of a game tree with a pool of engine processes.
+ * The positions (the main line, or every node) are cut into short runs
+ * of consecutive moves that the engines take in turn, so an engine only
+ * has to play one move between two positions of its run.  All commands
+ * of a run are sent at once; each answer is written to the comment of
+ * its node as it comes back. */
+class EngineAnalysis : public QObject
+{
+	Q_OBJECT
+
+public:
+	EngineAnalysis(Tree *tree, int board_size, float komi, QObject *parent = 0);
+	~EngineAnalysis();
+
+	bool start(bool variations = false);
+	void stop();
+	bool isRunning() const { return !workers.isEmpty(); }
+	QString getLastMessage() const { return lastMessage; }
+
+signals:
+	void signal_analysed(Move *m);
+	void signal_progress(int done, int total);
+	void signal_finished();
+
+private slots:
+	void slot_answer(int id, bool ok, QString response);
+	void slot_engineReady(bool ok);
+
+private:
+	struct Position {
+		Move *move;
+		QList<int> path;	//brother index at each depth from the root
+	};
+	struct Request {
+		int position;		//-1 for the known_command's of the setup
+		bool score;
+	};
+	struct Worker {
+		QGtp *gtp;
+		Move *board;		//node the engine is at once its commands are done
+		bool regGenmove, estimateScore;
+		QHash<int, Request> requests;
+	};
+
+	void collect(bool variations);
+	Move *resolve(const Position &p) const;
+	bool feed(Worker &w);
+	void replay(Worker &w, Move *target);
+	void sendMove(Worker &w, Move *m);
+	void restartRun(Worker &w, int position);
+	void retire(int i);
+	void annotate(Move *m, const QString &line, const QString &value);
+
+	Tree *tree;
+	int board_size;
+	float komi;
+	QList<Position> positions;
+	QList<QPair<int,int> > runs;	//[first, last) positions, not yet given out
+	QList<Worker> workers;
+	int done;
+	QString lastMessage;
+};
+
+#endif
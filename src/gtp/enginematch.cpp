@@ -0,0 +1,488 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+
+
+#include "enginematch.h"
+#include "qgtp.h"
+#include "tree.h"
+#include "move.h"
+#include "matrix.h"
+#include "gamedata.h"
+
+#include <QSettings>
+#include <QTimer>
+#include <QTextStream>
+
+/* Slack given to an engine over its time per move, for starting up
+ * and for engines that overrun a little */
+#define MATCH_TIME_SLACK_MSECS	5000
+
+EngineMatch::EngineMatch(const QString &d, const Options &o)
+	: dir(d), options(o), nextGame(1), failed(0)
+{
+	if (!QDir().mkpath(d))
+		qWarning("Can't create match directory %s", d.toLatin1().constData());
+	if (options.max_moves <= 0)
+		options.max_moves = 3 * options.board_size * options.board_size;
+
+	clockTimer = new QTimer(this);
+	connect(clockTimer, SIGNAL(timeout()), SLOT(slot_checkClocks()));
+}
+
+EngineMatch::~EngineMatch()
+{
+	QList<Game*> games = running + starting;
+	for (int i = 0; i < games.size(); i++)
+	{
+		delete games[i]->gtp[0];
+		delete games[i]->gtp[1];
+		delete games[i]->tree;
+		delete games[i];
+	}
+}
+
+/*
+ * An engine given on the command line : its number in the engine table
+ * of the settings, or its command line.  Empty for the default engine.
+ */
+bool EngineMatch::engineFromSpec(const QString &spec, QString &path, QString &args)
+{
+	QSettings settings;
+	bool isIndex = spec.isEmpty();
+	int index = (isIndex ? settings.value("DEFAULT_ENGINE").toInt() : spec.toInt(&isIndex));
+
+	if (!isIndex)
+	{
+		QStringList words = spec.split(' ', QString::SkipEmptyParts);
+		path = words.takeFirst();
+		args = words.join(" ");
+		return true;
+	}
+
+	int size = settings.beginReadArray("ENGINES");
+	if (index >= 0 && index < size)
+	{
+		settings.setArrayIndex(index);
+		path = settings.value("path").toString();
+		args = settings.value("args").toString();
+	}
+	settings.endArray();
+	if (size == 0 && spec.isEmpty())
+	{
+		path = QString(DEFAULT_ENGINE_PATH)+QString(DEFAULT_ENGINE);
+		args = DEFAULT_ENGINE_OPTIONS;
+	}
+	else if (index < 0 || index >= size)
+		return false;
+	return true;
+}
+
+void EngineMatch::start()
+{
+	clockTimer->start(250);
+	fillSlots();
+}
+
+/*
+ * Starts games until as many as asked for run at once, and ends the match
+ * when there is none left.  Nothing here waits on the engines, so we are
+ * never called again from inside ourselves.
+ */
+void EngineMatch::fillSlots()
+{
+	while (running.size() + starting.size() < options.parallel && nextGame <= options.games)
+		startGame(nextGame++);
+	if (running.isEmpty() && starting.isEmpty())
+	{
+		clockTimer->stop();
+		writeResults();
+		// We may not be in the event loop yet
+		QMetaObject::invokeMethod(this, "signal_finished", Qt::QueuedConnection);
+	}
+}
+
+QString EngineMatch::engineName(int engine) const
+{
+	QString name = QFileInfo(options.path[engine]).baseName();
+	if (options.path[0] == options.path[1])
+		name += " " + QString::number(engine + 1);
+	return name;
+}
+
+bool EngineMatch::startGame(int number)
+{
+	Game *g = new Game;
+	g->number = number;
+	g->black = (options.swap && number % 2 == 0 ? 1 : 0);
+	g->tree = new Tree(options.board_size, options.komi);
+	g->current = g->tree->getRoot();
+	g->moveId = 0;
+	g->scoring = false;
+	g->passes = 0;
+	g->moves = 0;
+	g->ready = 0;
+	g->gtp[0] = g->gtp[1] = NULL;
+
+	// Same handicap stones as a local game, sent to both engines
+	QList<Point> handicap_stones;
+	if (options.handicap >= 2 && g->current->getMatrix()->addHandicapStones(options.handicap))
+	{
+		Move *root = g->current;
+		root->setHandicapMove(true);
+		root->setX(-1);
+		root->setY(-1);
+		root->setColor(stoneBlack);
+		for (int x = 1; x <= options.board_size; x++)
+			for (int y = 1; y <= options.board_size; y++)
+			{
+				if (root->getMatrix()->getStoneAt(x,y) == stoneBlack)
+					handicap_stones.append(Point(x,y));
+			}
+	}
+
+	for (int e = 0; e < 2; e++)
+	{
+		g->gtp[e] = new QGtp();
+		if (g->gtp[e]->startGtpSession(options.path[e], options.args[e],
+				options.board_size, options.komi) == FAIL)
+		{
+			qWarning("Game %d: can't start %s: %s", number, options.path[e].toLatin1().constData(),
+				g->gtp[e]->getLastMessage().toLatin1().constData());
+			delete g->gtp[0];
+			delete g->gtp[1];
+			delete g->tree;
+			delete g;
+			failed++;
+			return false;
+		}
+		connect(g->gtp[e], SIGNAL(signal_sessionReady(bool)), SLOT(slot_sessionReady(bool)));
+		connect(g->gtp[e], SIGNAL(signal_response(int,bool,QString)), SLOT(slot_answered(int,bool,QString)));
+		g->gtp[e]->command("time_settings 0 " + QByteArray::number(options.move_secs) + " 1");
+		if (!handicap_stones.isEmpty())
+			g->gtp[e]->set_free_handicap(handicap_stones);
+	}
+
+	// The game runs once both engines have answered their setup
+	starting.append(g);
+	g->clock.start();
+	return true;
+}
+
+void EngineMatch::slot_sessionReady(bool ok)
+{
+	Game *g = NULL;
+	int e = 0;
+	for (int i = 0; i < starting.size() && !g; i++)
+	{
+		for (e = 0; e < 2; e++)
+		{
+			if (starting[i]->gtp[e] == sender())
+			{
+				g = starting[i];
+				break;
+			}
+		}
+	}
+	if (g == NULL)
+		return;
+
+	if (!ok)
+	{
+		qWarning("Game %d: can't set up %s: %s", g->number, options.path[e].toLatin1().constData(),
+			g->gtp[e]->getLastMessage().toLatin1().constData());
+		dropGame(g);
+		fillSlots();
+		return;
+	}
+	if (++g->ready < 2)
+		return;
+	starting.removeOne(g);
+	running.append(g);
+	requestMove(g);
+}
+
+/* A game that never got going, it isn't recorded */
+void EngineMatch::dropGame(Game *g)
+{
+	starting.removeOne(g);
+	failed++;
+	// We may be called from the engine's own dispatching
+	g->gtp[0]->deleteLater();
+	g->gtp[1]->deleteLater();
+	delete g->tree;
+	delete g;
+}
+
+void EngineMatch::requestMove(Game *g)
+{
+	StoneColor c = g->current->whoIsOnTurn();
+	int e = (c == stoneBlack ? g->black : 1 - g->black);
+	g->moveId = g->gtp[e]->command(c == stoneBlack ? "genmove black" : "genmove white");
+	g->clock.start();
+}
+
+EngineMatch::Game *EngineMatch::gameOf(QObject *gtp, int id)
+{
+	// Ids are counted by each engine : only the one asked is checked
+	for (int i = 0; i < running.size(); i++)
+	{
+		Game *g = running[i];
+		int e = (g->scoring ? 0 : g->current->whoIsOnTurn() == stoneBlack ? g->black : 1 - g->black);
+		if (g->gtp[e] == gtp && g->moveId == id)
+			return g;
+	}
+	return NULL;
+}
+
+/*
+ * Every answer of the engines comes here, and is matched with the game
+ * that waits for it.  Going through the signal lets us know the engine.
+ */
+void EngineMatch::slot_answered(int id, bool ok, QString response)
+{
+	Game *g = gameOf(sender(), id);
+	if (g == NULL)
+		return;
+	g->moveId = 0;
+	if (g->scoring)
+		count(g, ok ? response : QString());
+	else
+		moveAnswered(g, ok, response);
+}
+
+/*
+ * A move came in : it's checked, added to the game and sent to the
+ * other engine, which is asked for its answer right away.
+ */
+void EngineMatch::moveAnswered(Game *g, bool ok, const QString &response)
+{
+	StoneColor c = g->current->whoIsOnTurn();
+	StoneColor other = (c == stoneBlack ? stoneWhite : stoneBlack);
+	QString move = response.trimmed().toLower();
+	if (!ok)
+	{
+		qWarning("Game %d: genmove failed: %s", g->number, response.toLatin1().constData());
+		endGame(g, GameResult(other, GameResult::FORFEIT));
+		return;
+	}
+	if (move == "resign")
+	{
+		endGame(g, GameResult(other, GameResult::RESIGN));
+		return;
+	}
+
+	int x = PASS_XY, y = PASS_XY;
+	Move *m;
+	if (move == "pass")
+	{
+		m = g->current->makeMove(c, PASS_XY, PASS_XY, true);
+		g->passes++;
+	}
+	else
+	{
+		if (!QGtp::decodeCoors(move, x, y) || (m = g->current->makeMove(c, x, y)) == NULL)
+		{
+			qWarning("Game %d: illegal move %s", g->number, move.toLatin1().constData());
+			endGame(g, GameResult(other, GameResult::FORFEIT));
+			return;
+		}
+		g->passes = 0;
+	}
+	g->current = m;
+	g->moves++;
+
+	g->gtp[c == stoneBlack ? 1 - g->black : g->black]->play(c, x, y);
+	if (g->passes >= 2 || g->moves >= options.max_moves)
+		score(g);
+	else
+		requestMove(g);
+}
+
+/*
+ * The game is over : the first engine is asked which stones are dead
+ * before qGo counts
+ */
+void EngineMatch::score(Game *g)
+{
+	g->scoring = true;
+	g->moveId = g->gtp[0]->command("final_status_list dead");
+	g->clock.start();
+}
+
+void EngineMatch::count(Game *g, const QString &dead)
+{
+	Matrix *matrix = g->current->getMatrix();
+	QStringList vertices = dead.split(QRegExp("\\s+"), QString::SkipEmptyParts);
+	for (int i = 0; i < vertices.size(); i++)
+	{
+		int x, y;
+		if (QGtp::decodeCoors(vertices[i], x, y) && x >= 1 && y >= 1 &&
+		    x <= options.board_size && y <= options.board_size &&
+		    matrix->getStoneAt(x, y) != stoneNone)
+			matrix->markStoneDead(x, y);
+	}
+	g->tree->setCurrent(g->current);
+	g->tree->countScore();
+	endGame(g, g->tree->retrieveScore());
+}
+
+/*
+ * Games are looked for again by number after every one that is ended or
+ * dropped, since that starts the next ones and the lists change
+ */
+void EngineMatch::slot_checkClocks()
+{
+	int limit = options.move_secs * 1000 + MATCH_TIME_SLACK_MSECS;
+	QList<int> late;
+	for (int i = 0; i < running.size(); i++)
+	{
+		if (running[i]->moveId && running[i]->clock.elapsed() > limit)
+			late.append(running[i]->number);
+	}
+	for (int i = 0; i < starting.size(); i++)
+	{
+		if (starting[i]->clock.elapsed() > limit)
+			late.append(starting[i]->number);
+	}
+	for (int i = 0; i < late.size(); i++)
+	{
+		Game *g = NULL;
+		for (int j = 0; j < starting.size() && !g; j++)
+		{
+			if (starting[j]->number == late[i])
+				g = starting[j];
+		}
+		if (g)
+		{
+			qWarning("Game %d: engines not set up after %d ms", g->number, limit);
+			dropGame(g);
+			fillSlots();
+			continue;
+		}
+		for (int j = 0; j < running.size() && !g; j++)
+		{
+			if (running[j]->number == late[i])
+				g = running[j];
+		}
+		if (g == NULL)
+			continue;
+		g->moveId = 0;
+		if (g->scoring)
+		{
+			// Counted without dead stones then
+			count(g, QString());
+			continue;
+		}
+		qWarning("Game %d: no move after %d ms", g->number, limit);
+		endGame(g, GameResult(g->current->whoIsOnTurn() == stoneBlack ? stoneWhite : stoneBlack, GameResult::TIME));
+	}
+}
+
+void EngineMatch::endGame(Game *g, const GameResult &r)
+{
+	running.removeOne(g);
+
+	GameResult result = r;
+	GameData gameData;
+	gameData.board_size = options.board_size;
+	gameData.komi = options.komi;
+	gameData.handicap = (options.handicap >= 2 ? options.handicap : 0);
+	gameData.black_name = engineName(g->black);
+	gameData.white_name = engineName(1 - g->black);
+	gameData.result = result.shortMessage();
+	gameData.date = QDate::currentDate().toString("yyyy-MM-dd");
+	gameData.gameName = tr("Match game %1").arg(g->number);
+	gameData.fileName = dir.filePath(QString("game-%1.sgf").arg(g->number, 3, 10, QChar('0')));
+
+	QFile file(gameData.fileName);
+	if (file.open(QIODevice::WriteOnly))
+		file.write(g->tree->exportSGFString(&gameData).toLatin1());
+	else
+	{
+		qWarning("Could not open file: %s", gameData.fileName.toLatin1().constData());
+		failed++;
+	}
+
+	Record rec;
+	rec.number = g->number;
+	rec.black = g->black;
+	rec.moves = g->moves;
+	rec.winner = result.winner_color;
+	rec.result = gameData.result;
+	rec.file = QFileInfo(gameData.fileName).fileName();
+	records.append(rec);
+	QTextStream(stdout) << tr("Game %1: %2 (B) - %3 (W) %4, %5 moves\n")
+			.arg(g->number).arg(gameData.black_name).arg(gameData.white_name)
+			.arg(rec.result).arg(rec.moves);
+
+	// We may be called from the engine's own dispatching
+	g->gtp[0]->deleteLater();
+	g->gtp[1]->deleteLater();
+	delete g->tree;
+	delete g;
+
+	fillSlots();
+}
+
+/*
+ * results.txt : one line per game, then the wins of each engine
+ */
+void EngineMatch::writeResults()
+{
+	QString table;
+	QTextStream out(&table);
+	out << qSetFieldWidth(6) << "game" << qSetFieldWidth(0) << "  ";
+	out << left << qSetFieldWidth(16) << "black" << "white" << qSetFieldWidth(8) << "result"
+		<< right << qSetFieldWidth(6) << "moves" << qSetFieldWidth(0) << "  file\n";
+
+	int wins[2] = { 0, 0 }, winsBlack[2] = { 0, 0 };
+	for (int i = 0; i < records.size(); i++)
+	{
+		const Record &r = records[i];
+		out << qSetFieldWidth(6) << r.number << qSetFieldWidth(0) << "  ";
+		out << left << qSetFieldWidth(16) << engineName(r.black) << engineName(1 - r.black)
+			<< qSetFieldWidth(8) << r.result
+			<< right << qSetFieldWidth(6) << r.moves << qSetFieldWidth(0) << "  " << r.file << "\n";
+		if (r.winner == stoneBlack)
+		{
+			wins[r.black]++;
+			winsBlack[r.black]++;
+		}
+		else if (r.winner == stoneWhite)
+			wins[1 - r.black]++;
+	}
+	out << "\n";
+	for (int e = 0; e < 2; e++)
+		out << tr("%1: %2 wins (%3 as black, %4 as white)\n")
+			.arg(engineName(e)).arg(wins[e]).arg(winsBlack[e]).arg(wins[e] - winsBlack[e]);
+	if (failed)
+		out << tr("%1 games could not be played or saved\n").arg(failed);
+	out.flush();
+
+	QFile file(dir.filePath("results.txt"));
+	if (file.open(QIODevice::WriteOnly | QIODevice::Text))
+		file.write(table.toUtf8());
+	else
+		qWarning("Could not open file: %s", file.fileName().toLatin1().constData());
+	QTextStream(stdout) << "\n" << table;
+}
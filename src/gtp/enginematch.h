@@ -0,0 +1,125 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+
+
+#ifndef ENGINEMATCH_H
+#define ENGINEMATCH_H
+
+#include <QObject>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QDir>
+
+#include "defines.h"
+#include "../network/messages.h"
+
+class QGtp;
+class QTimer;
+class Tree;
+class Move;
+
+/* Plays two GTP engines against each other without opening any window,
+ * for qgo --match.  Several games run at once; moves are checked with
+ * qGo's own rules and the final position is counted by qGo as well,
+ * with the dead stones given by the first engine when it knows
+ * final_status_list.  Each game is saved as SGF and the results are
+ * written to results.txt. */
+class EngineMatch : public QObject
+{
+	Q_OBJECT
+
+public:
+	struct Options {
+		Options() : games(10), board_size(19), komi(6.5), handicap(0),
+			move_secs(5), parallel(1), max_moves(0), swap(true) {}
+		QString path[2], args[2];	//the two engines
+		int games;
+		int board_size;
+		float komi;
+		int handicap;
+		int move_secs;		//time per move given to the engines
+		int parallel;		//games played at once
+		int max_moves;		//counted after that many moves, 0 for 3 per point
+		bool swap;		//engines change colour every game
+	};
+
+	EngineMatch(const QString &dir, const Options &o);
+	~EngineMatch();
+	void start();
+	int failures() const { return failed; }
+
+	static bool engineFromSpec(const QString &spec, QString &path, QString &args);
+
+signals:
+	void signal_finished();
+
+private slots:
+	void slot_answered(int id, bool ok, QString response);
+	void slot_sessionReady(bool ok);
+	void slot_checkClocks();
+
+private:
+	struct Record {
+		int number;
+		int black;
+		int moves;
+		StoneColor winner;	//stoneNone for no result
+		QString result, file;
+	};
+	struct Game {
+		int number;
+		QGtp *gtp[2];		//by engine
+		int black;		//engine playing black
+		Tree *tree;
+		Move *current;
+		int moveId;		//genmove or dead stones waited for, 0 if none
+		bool scoring;
+		int passes;
+		int moves;
+		int ready;		//engines whose setup is answered
+		QElapsedTimer clock;
+	};
+
+	void fillSlots();
+	bool startGame(int number);
+	void dropGame(Game *g);
+	void requestMove(Game *g);
+	void moveAnswered(Game *g, bool ok, const QString &response);
+	void score(Game *g);
+	void count(Game *g, const QString &dead);
+	void endGame(Game *g, const GameResult &r);
+	void writeResults();
+	Game *gameOf(QObject *gtp, int id);
+	QString engineName(int engine) const;
+
+	QDir dir;
+	Options options;
+	QList<Game*> running;
+	QList<Game*> starting;		//engines not set up yet
+	QList<Record> records;
+	QTimer *clockTimer;
+	int nextGame;
+	int failed;
+};
+
+#endif
@@ -19,10 +19,15 @@ email                :
 #include <stdio.h>
 //#include <unistd.h>
 #include <stdlib.h>
+#include <ctype.h>
 #include <QApplication>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTimer>
 enum CommandType {PROTOCOL, BOARDSIZE, KNOWN_COMMAND, LEVEL, KOMI, PLAY_BLACK, PLAY_WHITE, GENMOVE};
 #include "qgtp.h"
+#include "logging.h"
 
 #ifdef Q_OS_WIN
 #include <Windows.h>
@@ -37,9 +42,17 @@ QGtp::QGtp()
 {
 	/*openGtpSession(filename);*/
 	programProcess = NULL; // This to permit proper ending
-	responseReceived = false;
-	answer = "";
+	inResponse = false;
+	responseOk = false;
+	dispatchPending = false;
+	undoSupported = false;
+	analysisChanged = false;
+	analyzeId = 0;
+	waitingId = 0;
+	sessionOk = false;
+	readBuffer.resize(IGTP_BUFSIZE);
     busy = false;
+	_cpt = 1000;
 }
 
 QGtp::~QGtp()
@@ -62,10 +75,9 @@ QString QGtp::getLastMessage()
 	return _response;
 }
 
-int QGtp::openGtpSession(QString path, QString args, int size, float komi, int handicap)
+/* Starts the program, the part both ways of opening a session share */
+int QGtp::launchProgram(QString path, QString args)
 {
-	_cpt = 1000;
-	
 	programProcess = new QProcess();
     programProcess->setReadChannel(QProcess::StandardOutput);
     QStringList arguments = args.split(' ',QString::SkipEmptyParts);
@@ -79,7 +91,7 @@ int QGtp::openGtpSession(QString path, QString args, int size, float komi, int h
 	connect(programProcess, SIGNAL(finished(int,QProcess::ExitStatus)),
 		this, SLOT(slot_processExited(int , QProcess::ExitStatus )) );
 	
-    qDebug() << "QGtp::openGtpSession(" << path << "," << args << ")";
+    qDebug() << "QGtp::launchProgram(" << path << "," << args << ")";
 
     programProcess->start(path, arguments);
 	
@@ -95,51 +107,45 @@ int QGtp::openGtpSession(QString path, QString args, int size, float komi, int h
 	{
 		  _response="Yuck ! Could not allocate 100 bytes !!!"  ;
 		  return FAIL ;
-	}   
-	
-	if (protocolVersion()==OK)
+	}
+	return OK;
+}
+
+int QGtp::openGtpSession(QString path, QString args, int size, float komi, int handicap)
+{
+	if (launchProgram(path, args) == FAIL)
+		return FAIL;
+
+	// All of it goes out at once, the answers are checked in order
+	int protocol = command("protocol_version");
+	int boardsize = command("boardsize "+intToQByteArray(size));
+	command("clear_board");		// failure ignored, removed by frosla -> protocol changes...
+	int komiSet = command(QString("komi %1").arg(komi,0,'f',2).toLatin1());
+	int handicapSet = (handicap < 2 ? 0 : command("fixed_handicap "+intToQByteArray(handicap)));
+	int undoKnown = command("known_command undo");
+	int kataKnown = command("known_command kata-analyze");
+	int lzKnown = command("known_command lz-analyze");
+
+	if (waitResponse(protocol)==OK)
 	{
 		if(getLastMessage().toInt() !=2)
 		{
 			qDebug("Protocol version problem???");
-			//				quit();
 			_response="Protocol version not supported";
-			//				return FAIL;
 		}
-		if(setBoardsize(size)==FAIL)
-		{
+		if(waitResponse(boardsize)==FAIL)
 			return FAIL;
-		}
-		if(clearBoard()==FAIL)
-		{
-			// removed by frosla -> protocol changes...
-			// return FAIL;
-		}
-
-/*
-		if(knownCommand("level")==FAIL)
-		{
-			  return FAIL;
-		}
-	
-		else if (getLastMessage().contains("true"))
-        	{
-        		if (setLevel(level)==FAIL)
-			{
-				return FAIL;
-			}
-        	}
-*/ 
-      
-		if(setKomi(komi)==FAIL)
-		{
+		if(waitResponse(komiSet)==FAIL)
 			return FAIL;
-		}
-
-		if(fixedHandicap(handicap)==FAIL)
-		{
+		if(handicapSet && waitResponse(handicapSet)==FAIL)
 			return FAIL;
-		}
+		// Without undo, the board has to be replayed from scratch on every jump
+		undoSupported = (waitResponse(undoKnown)==OK && getLastMessage().trimmed() == "true");
+		analyzeCommand.clear();
+		if (waitResponse(kataKnown)==OK && getLastMessage().trimmed() == "true")
+			analyzeCommand = "kata-analyze";
+		else if (waitResponse(lzKnown)==OK && getLastMessage().trimmed() == "true")
+			analyzeCommand = "lz-analyze";
 	}
 	else
 	{
@@ -152,95 +158,436 @@ int QGtp::openGtpSession(QString path, QString args, int size, float komi, int h
 	return OK;
 }
 
+/* Like openGtpSession(), but returns as soon as the program runs.  The
+ * setup answers are checked as they come in, and signal_sessionReady()
+ * tells whether it went through.  Commands given meanwhile queue up
+ * behind it. */
+int QGtp::startGtpSession(QString path, QString args, int size, float komi)
+{
+	if (launchProgram(path, args) == FAIL)
+		return FAIL;
+
+	const char *m = "slot_setupAnswered";
+	sessionOk = true;
+	undoSupported = false;
+	analyzeCommand.clear();
+	// In the order slot_setupAnswered() expects them
+	setupIds.clear();
+	setupIds << command("protocol_version", this, m);
+	setupIds << command("boardsize "+intToQByteArray(size), this, m);
+	command("clear_board");
+	setupIds << command(QString("komi %1").arg(komi,0,'f',2).toLatin1(), this, m);
+	setupIds << command("known_command undo", this, m);
+	setupIds << command("known_command kata-analyze", this, m);
+	setupIds << command("known_command lz-analyze", this, m);
+
+	busy = false;
+	return OK;
+}
+
+void QGtp::slot_setupAnswered(int id, bool ok, QString response)
+{
+	int step = setupIds.indexOf(id);
+	if (step < 0)
+		return;
+	bool known = (ok && response.trimmed() == "true");
+	switch (step)
+	{
+	case 0:
+		if (!ok)
+		{
+			sessionOk = false;
+			_response = "Protocol version error";
+		}
+		else if (response.toInt() != 2)
+			qDebug("Protocol version problem???");
+		break;
+	case 1:
+	case 2:
+		if (!ok && sessionOk)
+		{
+			sessionOk = false;
+			_response = response;
+		}
+		break;
+	case 3:
+		undoSupported = known;
+		break;
+	case 4:
+		if (known)
+			analyzeCommand = "kata-analyze";
+		break;
+	case 5:
+		if (known && analyzeCommand.isEmpty())
+			analyzeCommand = "lz-analyze";
+		setupIds.clear();
+		emit signal_sessionReady(sessionOk);
+		break;
+	}
+}
+
 // Read from stdout
 void QGtp::slot_readFromStdout()
 {
-	int number;
-	int pos;
-
+    // Lines go through one buffer : analysis lines come many times a second
     while (programProcess->canReadLine())
     {
-        answer = programProcess->readLine();
-        answer.chop(1); // remove the trailing '\n'
-        responseReceived = ((! answer.isEmpty()) &&
-                            ((answer.at(0) == '=') || (answer.at(0) == '?')));
-        if (responseReceived)
+        int len = 0;
+        forever
+        {
+            qint64 n = programProcess->readLine(readBuffer.data() + len, readBuffer.size() - len);
+            if (n <= 0)
+                break;
+            len += n;
+            if (readBuffer[len - 1] == '\n')
+                break;
+            readBuffer.resize(readBuffer.size() * 2);
+        }
+        if (len + 1 > readBuffer.size())
+            readBuffer.resize(len + 1);
+        readBuffer[len] = '\0';
+
+        if (inResponse && analyzeId && !inFlight.isEmpty() && inFlight.first().id == analyzeId
+            && qstrncmp(readBuffer.constData(), "info ", 5) == 0)
+            parseAnalysis(readBuffer.data(), len);
+        else
+            parseLine(QByteArray(readBuffer.constData(), len));
+    }
+}
+
+/*
+ * An info line holds every candidate move of the engine, each one
+ * starting with "info" and followed by "key value" pairs.  It is parsed
+ * in place, into a vector whose memory is kept from line to line.
+ */
+void QGtp::parseAnalysis(char *s, int len)
+{
+    char *end = s + len;
+    bool kata = analyzeCommand.startsWith("kata");
+    AnalysisCandidate *c = NULL;
+    bool skip = false;
+
+    analysisScratch.resize(0);
+    while (s < end)
+    {
+        while (s < end && isspace((unsigned char)*s))
+            s++;
+        char *key = s;
+        while (s < end && !isspace((unsigned char)*s))
+            s++;
+        int keyLen = s - key;
+        if (keyLen == 0)
             break;
+
+        if (keyLen == 4 && qstrncmp(key, "info", 4) == 0)
+        {
+            analysisScratch.resize(analysisScratch.size() + 1);
+            c = &analysisScratch.last();
+            c->x = c->y = PASS_XY;
+            c->visits = c->order = 0;
+            c->winrate = c->scoreLead = 0;
+            skip = false;
+            continue;
+        }
+        // pv, ownership and the like run until the next "info"
+        if (c == NULL || skip)
+            continue;
+
+        while (s < end && isspace((unsigned char)*s))
+            s++;
+        char *value = s;
+        while (s < end && !isspace((unsigned char)*s))
+            s++;
+
+        if (keyLen == 4 && qstrncmp(key, "move", 4) == 0)
+        {
+            if (qstrnicmp(value, "pass", 4) != 0)
+            {
+                int x = toupper((unsigned char)*value) - 'A' + 1;
+                // skip 'J'
+                if (x > 8)
+                    x--;
+                c->x = x;
+                c->y = strtol(value + 1, NULL, 10);
+            }
+        }
+        else if (keyLen == 6 && qstrncmp(key, "visits", 6) == 0)
+            c->visits = strtol(value, NULL, 10);
+        else if (keyLen == 5 && qstrncmp(key, "order", 5) == 0)
+            c->order = strtol(value, NULL, 10);
+        else if (keyLen == 7 && qstrncmp(key, "winrate", 7) == 0)
+            // Leela Zero gives hundredths of a percent
+            c->winrate = (kata ? strtod(value, NULL) : strtod(value, NULL) / 10000.);
+        else if (keyLen == 9 && qstrncmp(key, "scoreLead", 9) == 0)
+            c->scoreLead = strtod(value, NULL);
+        else if ((keyLen == 2 && qstrncmp(key, "pv", 2) == 0) ||
+                 (keyLen > 2 && qstrncmp(key, "pv", 2) == 0 && isupper((unsigned char)key[2])) ||
+                 (keyLen >= 9 && qstrncmp(key, "ownership", 9) == 0) ||
+                 (keyLen >= 14 && qstrncmp(key, "movesOwnership", 14) == 0))
+            skip = true;
     }
-    if (!responseReceived)
-        return;
 
-    _response = answer;
-    qDebug("** QGtp::slot_readFromStdout():  %s" , _response.toLatin1().constData());
+    analysis.swap(analysisScratch);
+    analysisChanged = true;
+    if (!dispatchPending)
+    {
+        dispatchPending = true;
+        QMetaObject::invokeMethod(this, "slot_dispatchResponses", Qt::QueuedConnection);
+    }
+}
 
-	// do we have any answer after the command number ?
-	pos = _response.indexOf(" ");
-	number = _response.mid(1,pos).toInt();
+/*
+ * Responses are "=[id] text" or "?[id] error", possibly over several
+ * lines, and end with an empty line.  They come back in the order the
+ * commands were sent.
+ */
+void QGtp::parseLine(QByteArray line)
+{
+    line.replace('\r', "");
+    line.replace('\t', ' ');
+    while (line.endsWith('\n'))
+        line.chop(1);
+
+    if (!inResponse)
+    {
+        if (line.isEmpty())
+            return;
+        if (line[0] != '=' && line[0] != '?')
+        {
+            qCDebug(logGtp, "** QGtp::parseLine(): ignoring %s", line.constData());
+            return;
+        }
+        inResponse = true;
+        responseOk = (line[0] == '=');
+        // skip the command number, if any
+        int pos = line.indexOf(' ');
+        responseLines.clear();
+        responseLines.append(pos < 1 ? QString() : QString::fromLatin1(line.mid(pos + 1)));
+        return;
+    }
 
-	if (pos < 1)
-		_response = "";
-	else
-		_response = _response.right(_response.length() - pos - 1);
+    if (!line.isEmpty())
+    {
+        responseLines.append(QString::fromLatin1(line));
+        return;
+    }
 
-    int i = moveRequests.indexOf(number);
-    if (i == -1)
+    inResponse = false;
+    if (inFlight.isEmpty())
+    {
+        qDebug("** QGtp::parseLine(): response to no command");
         return;
-    // Otherwise we have an answer to a move request.
-    // This is the one case in which we currently do not busy-wait.
-    busy=false;
-    moveRequests.removeAt(i);
+    }
+    GtpCommand c = inFlight.takeFirst();
+    if (c.id == analyzeId)
+        analyzeId = 0;
+    c.ok = responseOk;
+    c.response = responseLines.join("\n").trimmed();
+    qCDebug(logGtp, "** QGtp::parseLine(): %d %s -> %s", c.id, c.text.constData(), c.response.toLatin1().constData());
+    answered.append(c);
+
+    // Callbacks always run from the event loop, never inside waitResponse
+    if (!dispatchPending)
+    {
+        dispatchPending = true;
+        QMetaObject::invokeMethod(this, "slot_dispatchResponses", Qt::QueuedConnection);
+    }
+}
+
+void QGtp::slot_dispatchResponses()
+{
+    dispatchPending = false;
+    // waitResponse() posts us again once it has its answer
+    if (waitingId)
+        return;
+    if (analysisChanged)
+    {
+        analysisChanged = false;
+        emit signal_analysisUpdated();
+    }
+    while (!answered.isEmpty())
+    {
+        GtpCommand c = answered.takeFirst();
+        if (moveRequests.removeOne(c.id))
+        {
+            busy = !moveRequests.isEmpty();
+            if (c.ok)
+                moveReceived(c.response);
+        }
+        else
+            discardedMoves.removeOne(c.id);
+        if (c.receiver)
+            QMetaObject::invokeMethod(c.receiver, c.member.constData(),
+                          Q_ARG(int, c.id), Q_ARG(bool, c.ok), Q_ARG(QString, c.response));
+        emit signal_response(c.id, c.ok, c.response);
+    }
+}
+
+/* The genmoves in flight were asked for a position that is gone.  Their
+ * answers are dropped, and new ones can be asked for right away, they
+ * queue up behind whatever puts the engine's board right again. */
+void QGtp::discardMoves()
+{
+    discardedMoves += moveRequests;
+    moveRequests.clear();
+    busy = false;
+}
 
-    if (_response == "resign")
+/* Answer to one of our genmoves */
+void QGtp::moveReceived(QString move)
+{
+    move = move.toUpper();
+    if (move == "RESIGN")
     {
         emit computerResigned();
         return;
-    } else if (_response.contains("Pass",Qt::CaseInsensitive))
+    } else if (move.contains("PASS"))
     {
         emit computerPassed();
         return;
     }
+    int x, y;
+    if (!decodeCoors(move, x, y))
+    {
+        qDebug("** QGtp::moveReceived(): bad move %s", move.toLatin1().constData());
+        return;
+    }
+    emit signal_computerPlayed( x, y );
+}
+
+/* A vertex such as "Q16" to board coordinates, the reverse of encodeCoors() */
+bool QGtp::decodeCoors(const QString &vertex, int &x, int &y)
+{
+    QString move = vertex.trimmed().toUpper();
+    if (move.length() < 2 || move[0] < 'A' || move[0] > 'Z')
+        return false;
 
-    int x = _response[0].unicode() - QChar::fromLatin1('A').unicode() + 1;
+    x = move[0].unicode() - QChar::fromLatin1('A').unicode() + 1;
     // skip 'J'
     if (x > 8)
         x--;
 
-    int y;
-    if (_response[2] >= '0' && _response[2] <= '9')
-        y = _response.mid(1,2).toInt();
-    else
-        y = _response[1].digitValue();
-    emit signal_computerPlayed( x, y );
+    bool ok;
+    y = move.mid(1).toInt(&ok);
+    return ok;
 }
 
 // exit
 void QGtp::slot_processExited(int exitCode, QProcess::ExitStatus exitStatus)
 {
     qDebug("Process Exited with exit code %i and status  %d", exitCode, exitStatus);
-//	fflush ("quit");
-    //	return waitResponse();
 }
 
-/* Function:  wait for a go response
-* Arguments: none
+/* Function:  queue a command
+* Arguments: command, and optionally an object and the name of its
+*            slot(int id, bool ok, QString response) to call with the answer
 * Fails:     never
-* Returns:   nothing
+* Returns:   the command's id
 */
 int
-QGtp::waitResponse()
+QGtp::command(const QByteArray &cmd, QObject *receiver, const char *member)
 {
-    busy=true;
-    do //FIXME : use the readyRead signal of the process
-	{
-        programProcess->waitForReadyRead(10);
-        qApp->processEvents();
-    } while (!responseReceived);
+    GtpCommand c;
+    c.id = _cpt++;
+    c.text = cmd;
+    c.receiver = receiver;
+    c.member = member;
+    c.ok = false;
+    inFlight.append(c);
+    fflush(cmd, c.id);
+    return c.id;
+}
 
-	qDebug("** QGtp::waitResponse():  \'%s\'" , _response.toLatin1().constData());
-	responseReceived = false;
-    busy=false;
+/* Function:  play a stone or pass, asynchronously
+* Arguments: color, vertex or PASS_XY, see command()
+* Fails:     never
+* Returns:   the command's id
+*/
+int
+QGtp::play(StoneColor c, int x, int y, QObject *receiver, const char *member)
+{
+    QByteArray cmd = (c == stoneBlack ? "play black " : "play white ");
+    if (x == PASS_XY && y == PASS_XY)
+        cmd += "pass";
+    else
+        cmd += encodeCoors(x,y);
+    return command(cmd, receiver, member);
+}
+
+/* Function:  start streaming analysis of the position
+* Arguments: color to play, centiseconds between two info lines
+* Fails:     the program knows neither kata-analyze nor lz-analyze
+* Returns:   the command's id, it runs until the next command is sent
+*/
+int
+QGtp::analyze(StoneColor c, int interval)
+{
+    if (analyzeCommand.isEmpty())
+    {
+        _response = "The program can't analyze";
+        return FAIL;
+    }
+    analysis.resize(0);
+    analyzeId = command(analyzeCommand + (c == stoneBlack ? " b " : " w ") + intToQByteArray(interval));
+    return analyzeId;
+}
 
-    return ((answer.at(0) == '=') ? OK : FAIL );
+/* Function:  wait for the answer to a command
+* Arguments: command id
+* Fails:     the command failed, or no answer came within GTP_TIMEOUT
+* Returns:   OK or FAIL, the response is in getLastMessage()
+*/
+int
+QGtp::waitResponse(int id)
+{
+    // Events other than user input go on meanwhile, the board still
+    // repaints, but no answer is dispatched before we have ours
+    int outer = waitingId;
+    waitingId = id;
+    int result = FAIL;
+    QElapsedTimer elapsed;
+    elapsed.start();
+    slot_readFromStdout();
+    forever
+    {
+        int i = 0;
+        while (i < answered.size() && answered[i].id != id)
+            i++;
+        if (i < answered.size())
+        {
+            _response = answered[i].response;
+            result = (answered[i].ok ? OK : FAIL);
+            break;
+        }
+        bool waiting = false;
+        for (i = 0; i < inFlight.size() && !waiting; i++)
+            waiting = (inFlight[i].id == id);
+        if (!waiting)
+        {
+            // answered and dispatched already
+            _response = "";
+            break;
+        }
+        qint64 left = GTP_TIMEOUT - elapsed.elapsed();
+        if (programProcess->state() != QProcess::Running || left <= 0)
+        {
+            _response = "No answer from program";
+            break;
+        }
+        // slot_readFromStdout() is connected first, it has read the line
+        QEventLoop loop;
+        QTimer::singleShot((int)left, &loop, SLOT(quit()));
+        connect(programProcess, SIGNAL(readyRead()), &loop, SLOT(quit()));
+        connect(programProcess, SIGNAL(finished(int,QProcess::ExitStatus)), &loop, SLOT(quit()));
+        loop.exec(QEventLoop::ExcludeUserInputEvents);
+    }
+    waitingId = outer;
+    if (!waitingId && !answered.isEmpty() && !dispatchPending)
+    {
+        dispatchPending = true;
+        QMetaObject::invokeMethod(this, "slot_dispatchResponses", Qt::QueuedConnection);
+    }
+    return result;
 }
 
 /****************************
@@ -255,8 +602,7 @@ QGtp::waitResponse()
 int
 QGtp::name ()
 {
-    fflush("name");
-	return waitResponse();
+    return waitResponse(command("name"));
 }
 
 /* Function:  Report protocol version.
@@ -267,17 +613,16 @@ QGtp::name ()
 int
 QGtp::protocolVersion ()
 {
-    fflush("protocol_version");
-	return waitResponse();
+    return waitResponse(command("protocol_version"));
 }
 
-void QGtp::fflush(QByteArray s)
+void QGtp::fflush(QByteArray s, int id)
 {
     if (issueCmdNb)
     {
-        s = QString().setNum(_cpt++).toLatin1() + " " + s;
+        s = QString().setNum(id).toLatin1() + " " + s;
     }
-    qDebug("flush -> %s",s.constData());
+    qCDebug(logGtp, "flush -> %s",s.constData());
     s += '\n';
     int i= programProcess->write(s);
 
@@ -297,8 +642,7 @@ void QGtp::fflush(QByteArray s)
 int
 QGtp::quit ()
 {
-    fflush("quit");
-	return waitResponse();
+    return waitResponse(command("quit"));
 }
 
 /* Function:  Report the version number of the program.
@@ -309,8 +653,7 @@ QGtp::quit ()
 int
 QGtp::version ()
 {
-    fflush("version");
-	return waitResponse();
+    return waitResponse(command("version"));
 }
 
 
@@ -326,8 +669,7 @@ QGtp::version ()
 int
 QGtp::setBoardsize (int size)
 {
-    fflush("boardsize "+intToQByteArray(size));
-	return waitResponse();
+    return waitResponse(command("boardsize "+intToQByteArray(size)));
 }
 
 
@@ -339,8 +681,7 @@ QGtp::setBoardsize (int size)
 int
 QGtp::queryBoardsize()
 {
-    fflush ("query_boardsize");
-	return waitResponse();
+    return waitResponse(command("query_boardsize"));
 }
 
 /***********************
@@ -356,8 +697,7 @@ QGtp::queryBoardsize()
 int
 QGtp::clearBoard ()
 {
-    fflush ("clear_board");
-	return waitResponse();
+    return waitResponse(command("clear_board"));
 }
 
 /***************************
@@ -372,8 +712,7 @@ QGtp::clearBoard ()
 int
 QGtp::setKomi(float f)
 {
-    fflush (QString("komi %1").arg(f,0,'f',2).toLatin1());
-    return waitResponse();
+    return waitResponse(command(QString("komi %1").arg(f,0,'f',2).toLatin1()));
 }
 
 /* Function:  Set the playing level.
@@ -384,8 +723,7 @@ QGtp::setKomi(float f)
 int
 QGtp::setLevel (int level)
 {
-    fflush ("level "+intToQByteArray(level));
-	return waitResponse();
+    return waitResponse(command("level "+intToQByteArray(level)));
 }
 /******************
 * Playing moves. *
@@ -399,8 +737,7 @@ QGtp::setLevel (int level)
 int
 QGtp::playblack (int x, int y)
 {
-    fflush (QByteArray("play black ")+encodeCoors(x,y));
-	return waitResponse();
+    return waitResponse(command(QByteArray("play black ")+encodeCoors(x,y)));
 }
 
 /* Function:  Black pass.
@@ -411,8 +748,7 @@ QGtp::playblack (int x, int y)
 int
 QGtp::playblackPass ()
 {
-    fflush ("play black pass");
-    return waitResponse();
+    return waitResponse(command("play black pass"));
 }
 
 /* Function:  Play a white stone at the given vertex.
@@ -423,8 +759,7 @@ QGtp::playblackPass ()
 int
 QGtp::playwhite (int x, int y)
 {
-    fflush ("play white "+encodeCoors(x,y));
-    return waitResponse();
+    return waitResponse(command("play white "+encodeCoors(x,y)));
 }
 
 /* Function:  White pass.
@@ -435,8 +770,7 @@ QGtp::playwhite (int x, int y)
 int
 QGtp::playwhitePass ()
 {
-    fflush ("play white pass");
-    return waitResponse();
+    return waitResponse(command("play white pass"));
 }
 
 /* Function:  Set up fixed placement handicap stones.
@@ -450,11 +784,15 @@ QGtp::fixedHandicap (int handicap)
 	if (handicap < 2) 
 		return OK;
 
-    fflush ("fixed_handicap "+intToQByteArray(handicap));
-    return waitResponse();
+    return waitResponse(command("fixed_handicap "+intToQByteArray(handicap)));
 }
 
-int QGtp::set_free_handicap(QList<Point> handicap_stones)
+/* Function:  Place handicap stones, asynchronously
+* Arguments: the stones, see command()
+* Fails:     never
+* Returns:   the command's id
+*/
+int QGtp::set_free_handicap(QList<Point> handicap_stones, QObject *receiver, const char *member)
 {
     QByteArray message("set_free_handicap");
     for ( int i=0; i<handicap_stones.length(); ++i )
@@ -462,8 +800,7 @@ int QGtp::set_free_handicap(QList<Point> handicap_stones)
         message.append(" ").append(encodeCoors(handicap_stones[i].x,handicap_stones[i].y));
     }
 
-    fflush (message);
-    return waitResponse();
+    return command(message, receiver, member);
 }
 
 /* Function:  Load an sgf file, possibly up to a move number or the first
@@ -474,8 +811,7 @@ int QGtp::set_free_handicap(QList<Point> handicap_stones)
 */
 int QGtp::loadsgf (QString filename,int /*movNumber*/,char /*c*/,int /*i*/)
 {
-    fflush (QString("loadsgf %1").arg(filename).toLatin1());
-	return waitResponse();
+    return waitResponse(command(QString("loadsgf %1").arg(filename).toLatin1()));
 }
 
 /*****************
@@ -490,8 +826,7 @@ int QGtp::loadsgf (QString filename,int /*movNumber*/,char /*c*/,int /*i*/)
 int
 QGtp::whatColor (char c, int i)
 {
-    fflush ("color "+c+intToQByteArray(i));
-	return waitResponse();
+    return waitResponse(command("color "+c+intToQByteArray(i)));
 }
 
 /* Function:  Count number of liberties for the string at a vertex.
@@ -502,8 +837,7 @@ QGtp::whatColor (char c, int i)
 int
 QGtp::countlib (char c, int i)
 {
-    fflush ("countlib "+c+intToQByteArray(i));
-	return waitResponse();
+    return waitResponse(command("countlib "+c+intToQByteArray(i)));
 }
 
 /* Function:  Return the positions of the liberties for the string at a vertex.
@@ -514,8 +848,7 @@ QGtp::countlib (char c, int i)
 int
 QGtp::findlib (char c, int i)
 {
-    fflush ("findlib "+c+intToQByteArray(i));
-	return waitResponse();
+    return waitResponse(command("findlib "+c+intToQByteArray(i)));
 }
 
 /* Function:  Tell whether a move is legal.
@@ -526,8 +859,7 @@ QGtp::findlib (char c, int i)
 int
 QGtp::isLegal (QString color, char c, int i)
 {
-    fflush (QString("is_legal %1 ").arg(color).toLatin1()+c+intToQByteArray(i));
-	return waitResponse();
+    return waitResponse(command(QString("is_legal %1 ").arg(color).toLatin1()+c+intToQByteArray(i)));
 }
 
 /* Function:  List all legal moves for either color.
@@ -538,8 +870,7 @@ QGtp::isLegal (QString color, char c, int i)
 int
 QGtp::allLegal (QString color)
 {
-    fflush (QByteArray("all_legal ")+color.toLatin1());
-	return waitResponse();
+    return waitResponse(command(QByteArray("all_legal ")+color.toLatin1()));
 }
 
 /* Function:  List the number of captures taken by either color.
@@ -550,8 +881,7 @@ QGtp::allLegal (QString color)
 int
 QGtp::captures (QString color)
 {
-    fflush (QByteArray("captures")+color.toLatin1());
-	return waitResponse();
+    return waitResponse(command(QByteArray("captures")+color.toLatin1()));
 }
 
 /**********************
@@ -566,8 +896,7 @@ QGtp::captures (QString color)
 int
 QGtp::trymove (QString color, char c, int i)
 {
-    fflush (QByteArray("trymove ")+color.toLatin1()+" "+c+intToQByteArray(i));
-	return waitResponse();
+    return waitResponse(command(QByteArray("trymove ")+color.toLatin1()+" "+c+intToQByteArray(i)));
 }
 
 /* Function:  Undo a trymove.
@@ -578,8 +907,7 @@ QGtp::trymove (QString color, char c, int i)
 int
 QGtp::popgo ()
 {
-    fflush ("popgo");
-	return waitResponse();
+    return waitResponse(command("popgo"));
 }
 
 /*********************
@@ -594,8 +922,7 @@ QGtp::popgo ()
 int
 QGtp::attack (char c, int i)
 {
-    fflush ("attack "+c+intToQByteArray(i));
-	return waitResponse();
+    return waitResponse(command("attack "+c+intToQByteArray(i)));
 }
 
 /* Function:  Try to defend a string.
@@ -606,8 +933,7 @@ QGtp::attack (char c, int i)
 int
 QGtp::defend (char c, int i)
 {
-    fflush ("defend "+c+intToQByteArray(i));
-	return waitResponse();
+    return waitResponse(command("defend "+c+intToQByteArray(i)));
 }
 
 /* Function:  Increase depth values by one.
@@ -618,8 +944,7 @@ QGtp::defend (char c, int i)
 int
 QGtp::increaseDepths ()
 {
-    fflush("increase_depths");
-	return waitResponse();
+    return waitResponse(command("increase_depths"));
 }
 
 /* Function:  Decrease depth values by one.
@@ -630,8 +955,7 @@ QGtp::increaseDepths ()
 int
 QGtp::decreaseDepths ()
 {
-    fflush("decrease_depths");
-	return waitResponse();
+    return waitResponse(command("decrease_depths"));
 }
 
 /******************
@@ -646,8 +970,7 @@ QGtp::decreaseDepths ()
 int
 QGtp::owlAttack (char c, int i)
 {
-    fflush("owl_attack "+c+intToQByteArray(i));
-	return waitResponse();
+    return waitResponse(command("owl_attack "+c+intToQByteArray(i)));
 }
 
 /* Function:  Try to defend a dragon.
@@ -658,8 +981,7 @@ QGtp::owlAttack (char c, int i)
 int
 QGtp::owlDefend (char c, int i)
 {
-    fflush("owl_defend "+c+intToQByteArray(i));
-	return waitResponse();
+    return waitResponse(command("owl_defend "+c+intToQByteArray(i)));
 }
 
 /********
@@ -678,8 +1000,7 @@ QGtp::owlDefend (char c, int i)
 int
 QGtp::evalEye (char c, int i)
 {
-    fflush("eval_eye "+c+intToQByteArray(i));
-	return waitResponse();
+    return waitResponse(command("eval_eye "+c+intToQByteArray(i)));
 }
 
 /*****************
@@ -701,8 +1022,7 @@ QGtp::evalEye (char c, int i)
 int
 QGtp::dragonStatus (char c, int i)
 {
-    fflush(QString("dragon_status %1%2").arg(c).arg(i).toLatin1());
-	return waitResponse();
+    return waitResponse(command(QString("dragon_status %1%2").arg(c).arg(i).toLatin1()));
 }
 
 /* Function:  Determine whether two stones belong to the same dragon.
@@ -714,8 +1034,7 @@ QGtp::dragonStatus (char c, int i)
 int
 QGtp::sameDragon (char c1, int i1, char c2, int i2)
 {
-    fflush(QString("same_dragon %1%2 %3%4").arg(c1).arg(i1).arg(c2).arg(i2).toLatin1());
-	return waitResponse();
+    return waitResponse(command(QString("same_dragon %1%2 %3%4").arg(c1).arg(i1).arg(c2).arg(i2).toLatin1()));
 }
 
 /* Function:  Return the information in the dragon data structure.
@@ -726,8 +1045,7 @@ QGtp::sameDragon (char c1, int i1, char c2, int i2)
 int
 QGtp::dragonData ()
 {
-    fflush("dragon_data");
-	return waitResponse();
+    return waitResponse(command("dragon_data"));
 }
 
 /* Function:  Return the information in the dragon data structure.
@@ -738,8 +1056,7 @@ QGtp::dragonData ()
 int
 QGtp::dragonData (char c,int i)
 {
-    fflush("dragon_data "+c+intToQByteArray(i));
-	return waitResponse();
+    return waitResponse(command("dragon_data "+c+intToQByteArray(i)));
 }
 
 /***********************
@@ -756,8 +1073,7 @@ QGtp::dragonData (char c,int i)
 int
 QGtp::combinationAttack (QString color)
 {
-    fflush(QByteArray("combination_attack ")+color.toLatin1());
-	return waitResponse();
+    return waitResponse(command(QByteArray("combination_attack ")+color.toLatin1()));
 }
 
 /********************
@@ -775,9 +1091,8 @@ QGtp::genmoveBlack ()
     if (busy)
         return FAIL; // Ignore multiple requests while the engine is busy
 
-    moveRequests.append(_cpt);
     busy=true;
-    fflush("genmove black");
+    moveRequests.append(command("genmove black"));
     return OK;
 }
 
@@ -792,9 +1107,8 @@ QGtp::genmoveWhite ()
     if (busy)
         return FAIL;
 
-    moveRequests.append(_cpt);
     busy=true;
-    fflush("genmove white");
+    moveRequests.append(command("genmove white"));
     return OK;
 }
 
@@ -806,8 +1120,7 @@ QGtp::genmoveWhite ()
 int
 QGtp::genmove (QString color,int seed)
 {
-    fflush(QByteArray("gg_genmove ") +color.toLatin1()+" "+intToQByteArray(seed));
-	return waitResponse();
+    return waitResponse(command(QByteArray("gg_genmove ") +color.toLatin1()+" "+intToQByteArray(seed)));
 }
 
 /* Function : Generate a list of the best moves for White with weights
@@ -819,8 +1132,7 @@ QGtp::genmove (QString color,int seed)
 int
 QGtp::topMovesWhite ()
 {
-    fflush("top_moves_white");
-	return waitResponse();
+    return waitResponse(command("top_moves_white"));
 }
 
 /* Function : Generate a list of the best moves for Black with weights
@@ -832,8 +1144,7 @@ QGtp::topMovesWhite ()
 int
 QGtp::topMovesBlack ()
 {
-    fflush("top_moves_black");
-	return waitResponse();
+    return waitResponse(command("top_moves_black"));
 }
 
 /* Function:  Undo last move
@@ -844,8 +1155,7 @@ QGtp::topMovesBlack ()
 int
 QGtp::undo (int i)
 {
-    fflush("undo "+intToQByteArray(i));
-	return waitResponse();
+    return waitResponse(command("undo "+intToQByteArray(i)));
 }
 
 /* Function:  Report the final status of a vertex in a finished game.
@@ -857,8 +1167,7 @@ QGtp::undo (int i)
 int
 QGtp::finalStatus (char c, int i, int seed)
 {
-    fflush("final_status "+c+intToQByteArray(i)+" "+intToQByteArray(seed));
-	return waitResponse();
+    return waitResponse(command("final_status "+c+intToQByteArray(i)+" "+intToQByteArray(seed)));
 }
 
 /* Function:  Report vertices with a specific final status in a finished game.
@@ -873,8 +1182,7 @@ QGtp::finalStatus (char c, int i, int seed)
 int
 QGtp::finalStatusList (QString status, int seed)
 {
-    fflush(QByteArray("final_status_list ")+status.toLatin1()+" "+intToQByteArray(seed));
-	return waitResponse();
+    return waitResponse(command(QByteArray("final_status_list ")+status.toLatin1()+" "+intToQByteArray(seed)));
 }
 
 /**************
@@ -889,22 +1197,19 @@ QGtp::finalStatusList (QString status, int seed)
 int
 QGtp::finalScore (int seed)
 {
-    fflush("final_score "+intToQByteArray(seed));
-	return waitResponse();
+    return waitResponse(command("final_score "+intToQByteArray(seed)));
 }
 
 int
 QGtp::estimateScore ()
 {
-    fflush("estimate_score");
-	return waitResponse();
+    return waitResponse(command("estimate_score"));
 }
 
 int
 QGtp::newScore ()
 {
-    fflush("new_score");
-	return waitResponse();
+    return waitResponse(command("new_score"));
 }
 
 /**************
@@ -919,8 +1224,7 @@ QGtp::newScore ()
 int
 QGtp::resetLifeNodeCounter ()
 {
-    fflush("reset_life_node_counter");
-	return waitResponse();
+    return waitResponse(command("reset_life_node_counter"));
 }
 
 /* Function:  Retrieve the count of life nodes.
@@ -931,8 +1235,7 @@ QGtp::resetLifeNodeCounter ()
 int
 QGtp::getLifeNodeCounter ()
 {
-    fflush("get_life_node_counter");
-	return waitResponse();
+    return waitResponse(command("get_life_node_counter"));
 }
 
 /* Function:  Reset the count of owl nodes.
@@ -943,8 +1246,7 @@ QGtp::getLifeNodeCounter ()
 int
 QGtp::resetOwlNodeCounter ()
 {
-    fflush("reset_owl_node_counter");
-	return waitResponse();
+    return waitResponse(command("reset_owl_node_counter"));
 }
 
 /* Function:  Retrieve the count of owl nodes.
@@ -955,8 +1257,7 @@ QGtp::resetOwlNodeCounter ()
 int
 QGtp::getOwlNodeCounter ()
 {
-    fflush("get_owl_node_counter");
-	return waitResponse();
+    return waitResponse(command("get_owl_node_counter"));
 }
 
 /* Function:  Reset the count of reading nodes.
@@ -967,8 +1268,7 @@ QGtp::getOwlNodeCounter ()
 int
 QGtp::resetReadingNodeCounter ()
 {
-    fflush("reset_reading_node_counter");
-	return waitResponse();
+    return waitResponse(command("reset_reading_node_counter"));
 }
 
 /* Function:  Retrieve the count of reading nodes.
@@ -979,8 +1279,7 @@ QGtp::resetReadingNodeCounter ()
 int
 QGtp::getReadingNodeCounter ()
 {
-    fflush("get_reading_node_counter");
-	return waitResponse();
+    return waitResponse(command("get_reading_node_counter"));
 }
 
 /* Function:  Reset the count of trymoves/trykos.
@@ -991,8 +1290,7 @@ QGtp::getReadingNodeCounter ()
 int
 QGtp::resetTrymoveCounter ()
 {
-    fflush("reset_trymove_counter");
-	return waitResponse();
+    return waitResponse(command("reset_trymove_counter"));
 }
 
 /* Function:  Retrieve the count of trymoves/trykos.
@@ -1003,8 +1301,7 @@ QGtp::resetTrymoveCounter ()
 int
 QGtp::getTrymoveCounter ()
 {
-    fflush("get_trymove_counter");
-	return waitResponse();
+    return waitResponse(command("get_trymove_counter"));
 }
 
 /*********
@@ -1019,8 +1316,7 @@ QGtp::getTrymoveCounter ()
 int
 QGtp::showboard ()
 {
-    fflush("showboard");
-	return waitResponse();
+    return waitResponse(command("showboard"));
 }
 
 /* Function:  Dump stack to stderr.
@@ -1031,8 +1327,7 @@ QGtp::showboard ()
 int
 QGtp::dumpStack ()
 {
-    fflush("dump_stack");
-	return waitResponse();
+    return waitResponse(command("dump_stack"));
 }
 
 /* Function:  Write information about the influence function to stderr.
@@ -1043,8 +1338,7 @@ QGtp::dumpStack ()
 int
 QGtp::debugInfluence (QString color,QString list)
 {
-    fflush(QByteArray("debug_influence ")+color.toLatin1()+" "+list.toLatin1());
-	return waitResponse();
+    return waitResponse(command(QByteArray("debug_influence ")+color.toLatin1()+" "+list.toLatin1()));
 }
 
 /* Function:  Write information about the influence function after making
@@ -1056,9 +1350,8 @@ QGtp::debugInfluence (QString color,QString list)
 int
 QGtp::debugMoveInfluence (QString color, char c, int i,QString list)
 {
-    fflush(QByteArray("debug_move_influence ")+color.toLatin1()+
-           " "+c+intToQByteArray(i)+" "+list.toLatin1());
-	return waitResponse();
+    return waitResponse(command(QByteArray("debug_move_influence ")+color.toLatin1()+
+           " "+c+intToQByteArray(i)+" "+list.toLatin1()));
 }
 
 /* Function:  Return information about the influence function.
@@ -1069,8 +1362,7 @@ QGtp::debugMoveInfluence (QString color, char c, int i,QString list)
 int
 QGtp::influence (QString color)
 {
-    fflush(QByteArray("influence ")+color.toLatin1());
-	return waitResponse();
+    return waitResponse(command(QByteArray("influence ")+color.toLatin1()));
 }
 
 /* Function:  Return information about the influence function after a move
@@ -1081,8 +1373,7 @@ QGtp::influence (QString color)
 int
 QGtp::moveInfluence (QString color, char c, int i)
 {
-    fflush(QByteArray("move_influence ")+color.toLatin1()+" "+c+intToQByteArray(i));
-	return waitResponse();
+    return waitResponse(command(QByteArray("move_influence ")+color.toLatin1()+" "+c+intToQByteArray(i)));
 }
 
 /* Function:  Return the information in the worm data structure.
@@ -1093,8 +1384,7 @@ QGtp::moveInfluence (QString color, char c, int i)
 int
 QGtp::wormData ()
 {
-    fflush("worm_data");
-	return waitResponse();
+    return waitResponse(command("worm_data"));
 }
 
 /* Function:  Return the information in the worm data structure.
@@ -1105,8 +1395,7 @@ QGtp::wormData ()
 int
 QGtp::wormData (char c, int i)
 {
-    fflush("worm_data "+c+intToQByteArray(i));
-	return waitResponse();
+    return waitResponse(command("worm_data "+c+intToQByteArray(i)));
 }
 
 /* Function:  Return the cutstone field in the worm data structure.
@@ -1117,8 +1406,7 @@ QGtp::wormData (char c, int i)
 int
 QGtp::wormCutstone (char c, int i)
 {
-    fflush("worm_cutstone "+c+intToQByteArray(i));
-	return waitResponse();
+    return waitResponse(command("worm_cutstone "+c+intToQByteArray(i)));
 }
 
 /* Function:  Tune the parameters for the move ordering in the tactical
@@ -1130,8 +1418,7 @@ QGtp::wormCutstone (char c, int i)
 int
 QGtp::tuneMoveOrdering (int MOVE_ORDERING_PARAMETERS)
 {
-    fflush("tune_move_ordering "+intToQByteArray(MOVE_ORDERING_PARAMETERS));
-	return waitResponse();
+    return waitResponse(command("tune_move_ordering "+intToQByteArray(MOVE_ORDERING_PARAMETERS)));
 }
 
 /* Function:  Echo the parameter
@@ -1142,8 +1429,7 @@ QGtp::tuneMoveOrdering (int MOVE_ORDERING_PARAMETERS)
 int
 QGtp::echo (QString param)
 {
-    fflush(QByteArray("echo ")+param.toLatin1());
-	return waitResponse();
+    return waitResponse(command(QByteArray("echo ")+param.toLatin1()));
 }
 
 /* Function:  List all known commands
@@ -1154,8 +1440,7 @@ QGtp::echo (QString param)
 int
 QGtp::help ()
 {
-    fflush("help");
-	return waitResponse();
+    return waitResponse(command("help"));
 }
 
 /* Function:  evaluate wether a command is known
@@ -1166,8 +1451,7 @@ QGtp::help ()
 int
 QGtp::knownCommand (QString s)
 {
-    fflush(QByteArray("known_command ")+s.toLatin1());
-    return waitResponse();
+    return waitResponse(command(QByteArray("known_command ")+s.toLatin1()));
 }
 
 QByteArray QGtp::encodeCoors(int x, int y)
@@ -1195,8 +1479,7 @@ QByteArray QGtp::intToQByteArray(int i)
 int
 QGtp::reportUncertainty (QString s)
 {
-    fflush(QByteArray("report_uncertainty ")+s.toLatin1());
-	return waitResponse();
+    return waitResponse(command(QByteArray("report_uncertainty ")+s.toLatin1()));
 }
 
 /* Function:  List the stones of a worm
@@ -1207,14 +1490,12 @@ QGtp::reportUncertainty (QString s)
 int
 QGtp::wormStones()
 {
-    fflush("worm_stones");
-	return waitResponse();
+    return waitResponse(command("worm_stones"));
 }
 
 int
 QGtp::shell(QString s)
 {
-    fflush(s.toLatin1());
-	return waitResponse();
+    return waitResponse(command(s.toLatin1()));
 }
 
@@ -20,6 +20,10 @@
 
 #include <QProcess>
 #include <QList>
+#include <QPointer>
+#include <QVector>
+
+#include "defines.h"
 
 #define IGTP_BUFSIZE 2048    /* Size of the response buffer */
 #define OK 0
@@ -36,6 +40,34 @@ struct Point
     char x,y;
 };
 
+/* A command sent to the program and not yet dispatched */
+struct GtpCommand
+{
+    int id;
+    QByteArray text;
+    QPointer<QObject> receiver;
+    QByteArray member;
+    bool ok;
+    QString response;
+};
+
+/* One candidate move of an lz-analyze or kata-analyze info line */
+struct AnalysisCandidate
+{
+    int x, y;		//PASS_XY for a pass
+    int visits;
+    int order;
+    float winrate;	//0 to 1, for the player on turn
+    float scoreLead;	//kata-analyze only
+};
+
+/* Commands are numbered and written to the program as soon as they're
+ * given, however many are still waiting for an answer, and responses
+ * are read as the program's output comes in.  command() and play()
+ * return at once; the answer goes to signal_response and, if one was
+ * given, to the receiver's slot.  The older int-returning commands wait
+ * for their own answer with waitResponse(), which runs the event loop
+ * without user input and gives up after GTP_TIMEOUT. */
 class QGtp : public QObject{
 	Q_OBJECT
 
@@ -43,24 +75,43 @@ signals:
     void signal_computerPlayed( int, int );
     void computerResigned();
     void computerPassed();
+    void signal_response(int id, bool ok, QString response);
+    void signal_analysisUpdated();
+    void signal_sessionReady(bool ok);
 
 public slots:
 	void slot_readFromStdout();
 	void slot_processExited(int , QProcess::ExitStatus );
 
+private slots:
+	void slot_dispatchResponses();
+	void slot_setupAnswered(int id, bool ok, QString response);
+
 public:
 	QGtp();
 	~QGtp();
 
     bool isBusy() { return busy; }
+    void discardMoves();
+	bool supportsUndo() const { return undoSupported; }
+	bool supportsAnalysis() const { return !analyzeCommand.isEmpty(); }
+
+	int command(const QByteArray &cmd, QObject *receiver = 0, const char *member = 0);
+	int play(StoneColor c, int x, int y, QObject *receiver = 0, const char *member = 0);
+	int pendingCommands() const { return inFlight.size(); }
+	int waitResponse(int id);
+	int analyze(StoneColor c, int interval);
+	const QVector<AnalysisCandidate> &getAnalysis() const { return analysis; }
+	static bool decodeCoors(const QString &vertex, int &x, int &y);
 
 	/****************************
  	*                          *
  	****************************/
 	QString getLastMessage();
 	int openGtpSession(QString path, QString args, int size, float komi, int handicap);
+	int startGtpSession(QString path, QString args, int size, float komi);
 	QProcess  * programProcess ;
-    void fflush(QByteArray s);
+    void fflush(QByteArray s, int id);
 
 	/****************************
  	* Administrative commands. *
@@ -99,7 +150,7 @@ public:
     int playwhite (int x, int y);
 	int playwhitePass ();
 	int fixedHandicap (int handicap);
-    int set_free_handicap (QList<Point> handicap_stones);
+    int set_free_handicap (QList<Point> handicap_stones, QObject *receiver = 0, const char *member = 0);
 	int loadsgf (QString filename,int movNumber=0,char c='A',int i=0);
 
 	/*****************
@@ -209,12 +260,27 @@ public:
 	char *_outFile;
 	char *outFile;
 	FILE *_inFile;
-    QString _response, answer;
+    QString _response;
     QList<int> moveRequests;
-
-    int waitResponse();
-
-	bool responseReceived,issueCmdNb ;
+    QList<int> discardedMoves;
+    QList<GtpCommand> inFlight, answered;
+    QStringList responseLines;
+
+    int launchProgram(QString path, QString args);
+    void parseLine(QByteArray line);
+    void parseAnalysis(char *s, int len);
+    void moveReceived(QString move);
+
+    QByteArray readBuffer;
+    QByteArray analyzeCommand;
+    QVector<AnalysisCandidate> analysis, analysisScratch;
+    int analyzeId;
+    int waitingId;	/* command waitResponse() is waiting for, 0 if none */
+    QList<int> setupIds;	/* startGtpSession() commands not yet answered */
+    bool sessionOk;
+
+	bool inResponse, responseOk, dispatchPending, issueCmdNb, undoSupported ;
+	bool analysisChanged;
 	
     bool busy;
 };
@@ -99,6 +99,8 @@ QVariant PlayerListModel::data(const QModelIndex & index, int role) const
     {
         if(item->name == account_name)
             return QColor(Qt::blue);
+        else if(item->stale)
+            return QColor(Qt::gray);
         else
             return QVariant();
     }
@@ -159,13 +161,15 @@ PlayerListing * PlayerListModel::playerListingFromIndex(const QModelIndex & inde
 }
 
 
+/* Ids only mean something on the server that gave them out, so
+ * listings left over from before a reconnect never match */
 PlayerListing * PlayerListModel::getEntry(unsigned int id)
 {
     PlayerListing * result;
     for (int i=0; i < items.count(); i++)
     {
         result = static_cast<PlayerListing*>(items[i]);
-        if (result->id == id)
+        if (result->id == id && !result->stale)
         {
             return result;
         }
@@ -214,6 +218,14 @@ PlayerListing * PlayerListModel::updateEntry(PlayerListing * listing)
     return NULL;
 }
 
+/* One dataChanged for every row, rather than a search per listing */
+void PlayerListModel::updateAll(void)
+{
+    if (items.isEmpty())
+        return;
+    emit dataChanged(createIndex(0, 0), createIndex(items.count() - 1, columnCount() - 1));
+}
+
 void PlayerListModel::insertListing(PlayerListing *item)
 {
     beginInsertRows(QModelIndex(), items.count(), items.count());
@@ -221,6 +233,16 @@ void PlayerListModel::insertListing(PlayerListing *item)
     endInsertRows();
 }
 
+/* One insert for a whole list, for the listing cache */
+void PlayerListModel::insertListings(const QList<PlayerListing *> & list)
+{
+    if (list.isEmpty())
+        return;
+    beginInsertRows(QModelIndex(), items.count(), items.count() + list.count() - 1);
+    items.append(list);
+    endInsertRows();
+}
+
 int PlayerListModel::rowCount(const QModelIndex &) const
 {
     return items.count();
@@ -238,6 +260,78 @@ Qt::ItemFlags PlayerListModel::flags(const QModelIndex & index) const
     return Qt::ItemIsEnabled | Qt::ItemIsSelectable;
 }
 
+/* A row is the number of observers who joined before and are still
+ * there, which a Fenwick tree over the join numbers counts in log time.
+ * A leave then doesn't renumber every row after it. */
+void ObserverListModel::insertListing(PlayerListing * item)
+{
+    if(seqs.contains(item))
+        return;
+    if(next_seq >= joined.size() - 1)
+        renumber();
+    seqs.insert(item, next_seq);
+    count(next_seq++, 1);
+    PlayerListModel::insertListing(item);
+}
+
+void ObserverListModel::removeListing(PlayerListing * const l)
+{
+    QHash<const PlayerListing *, int>::iterator s = seqs.find(l);
+    if(s == seqs.end())
+        return;
+    int seq = *s;
+    seqs.erase(s);
+    int i = rowOf(seq);
+    count(seq, -1);
+    beginRemoveRows(QModelIndex(), i, i);
+    items.removeAt(i);
+    endRemoveRows();
+}
+
+void ObserverListModel::clearList(void)
+{
+    seqs.clear();
+    joined.clear();
+    next_seq = 0;
+    PlayerListModel::clearList();
+}
+
+/* Observers still there who joined before 'seq' */
+int ObserverListModel::rowOf(int seq) const
+{
+    int n = 0;
+    for(int k = seq; k > 0; k -= k & -k)
+        n += joined[k];
+    return n;
+}
+
+void ObserverListModel::count(int seq, int delta)
+{
+    for(int k = seq + 1; k < joined.size(); k += k & -k)
+        joined[k] += delta;
+}
+
+/* Out of join numbers : those here are numbered again from 0, in row
+ * order, with room for as many more */
+void ObserverListModel::renumber(void)
+{
+    int n = items.count();
+    int size = qMax(16, 2 * n) + 1;
+    joined.fill(0, size);
+    for(int i = 0; i < n; i++)
+    {
+        seqs[items[i]] = i;
+        joined[i + 1] = 1;
+    }
+    for(int k = 1; k < size; k++)
+    {
+        int up = k + (k & -k);
+        if(up < size)
+            joined[up] += joined[k];
+    }
+    next_seq = n;
+}
+
 int ObserverListModel::columnCount(const QModelIndex &) const
 {
     return O_TOTALCOLUMNS;
@@ -403,6 +497,7 @@ void GamesListModel::clearList(void)
     beginRemoveRows(QModelIndex(), 0, items.count() - 1);
     items.clear();
     endRemoveRows();
+    emit countChanged(0);
 }
 
 QVariant GamesListModel::data(const QModelIndex & index, int role) const
@@ -411,7 +506,13 @@ QVariant GamesListModel::data(const QModelIndex & index, int role) const
         return QVariant();
 
     GameListing * item = static_cast<GameListing*>(index.internalPointer());
-    if ((role == Qt::DisplayRole) || (role == LIST_SORT_ROLE))
+    if (role == Qt::ForegroundRole)
+    {
+        if(item->stale)
+            return QColor(Qt::gray);
+        return QVariant();
+    }
+    else if ((role == Qt::DisplayRole) || (role == LIST_SORT_ROLE))
     {
         switch(index.column())
         {
@@ -461,6 +562,13 @@ GameListing * GamesListModel::gameListingFromIndex(const QModelIndex & index)
     return static_cast<GameListing*>(index.internalPointer());
 }
 
+void GamesListModel::updateAll(void)
+{
+    if (items.isEmpty())
+        return;
+    emit dataChanged(createIndex(0, 0), createIndex(items.count() - 1, columnCount() - 1));
+}
+
 void GamesListModel::insertListing(GameListing *item)
 {
     beginInsertRows(QModelIndex(), items.count(), items.count());
@@ -469,6 +577,16 @@ void GamesListModel::insertListing(GameListing *item)
     emit countChanged(items.count());
 }
 
+void GamesListModel::insertListings(const QList<GameListing *> & list)
+{
+    if (list.isEmpty())
+        return;
+    beginInsertRows(QModelIndex(), items.count(), items.count() + list.count() - 1);
+    items.append(list);
+    endInsertRows();
+    emit countChanged(items.count());
+}
+
 int GamesListModel::rowCount(const QModelIndex &) const
 {
     return items.count();
@@ -23,6 +23,8 @@
 #define LISTVIEWS_H
 #include <QAbstractTableModel>
 #include <QSortFilterProxyModel>
+#include <QHash>
+#include <QVector>
 class GameListing;
 class PlayerListing;
 
@@ -88,14 +90,16 @@ public:
     virtual QVariant headerData(int section, Qt::Orientation orientation, int role) const;
     virtual int columnCount(const QModelIndex & parent = QModelIndex()) const;
 
-    void insertListing(PlayerListing * item);
-    void removeListing(PlayerListing * const l);
-    void clearList(void);
+    virtual void insertListing(PlayerListing * item);
+    void insertListings(const QList<PlayerListing *> & list);
+    virtual void removeListing(PlayerListing * const l);
+    virtual void clearList(void);
     PlayerListing * playerListingFromIndex(const QModelIndex &);
     void setAccountName(const QString & name) { account_name = name; }
     PlayerListing * getEntry(const QString & name);
     PlayerListing * getEntry(unsigned int id);
     PlayerListing * getPlayerFromNotNickName(const QString & notnickname);
+    void updateAll(void);
 public slots:
     PlayerListing * updateEntry(PlayerListing * listing);
 protected:
@@ -105,12 +109,27 @@ protected:
     QString account_name;
 };
 
+/* Observers come and go one at a time, and a listing may be sent again
+ * for a player already on the board, so rows are looked up by listing
+ * rather than searched for.  Rows stay in the order players joined. */
 class ObserverListModel : public PlayerListModel
 {
     public:
+        ObserverListModel() : next_seq(0) {}
         QVariant headerData(int section, Qt::Orientation orientation, int role) const;
         virtual int columnCount(const QModelIndex & parent = QModelIndex()) const;
         virtual QVariant data(const QModelIndex & index, int role) const;
+        virtual void insertListing(PlayerListing * item);
+        virtual void removeListing(PlayerListing * const l);
+        virtual void clearList(void);
+    private:
+        int rowOf(int seq) const;
+        void count(int seq, int delta);
+        void renumber(void);
+
+        QHash<const PlayerListing *, int> seqs;	//join number of each listing
+        QVector<int> joined;	//Fenwick tree over join numbers, of those still here
+        int next_seq;
 };
 
 class SimplePlayerListModel: public PlayerListModel
@@ -134,10 +153,12 @@ public:
     virtual int columnCount(const QModelIndex & parent = QModelIndex()) const;
     GameListing * getEntry(unsigned int id);
     void updateListing(GameListing *listing);
+    void updateAll(void);
     void clearList(void);
     virtual QVariant data(const QModelIndex & index, int role) const;
     GameListing * gameListingFromIndex(const QModelIndex &);
     void insertListing(GameListing *item);
+    void insertListings(const QList<GameListing *> & list);
     virtual int rowCount(const QModelIndex & parent = QModelIndex()) const;
     QModelIndex index ( int row, int column, const QModelIndex & parent = QModelIndex() ) const;
 signals:
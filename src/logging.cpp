@@ -0,0 +1,97 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#include "logging.h"
+#include "defines.h"
+
+Q_LOGGING_CATEGORY(logProtocol, "qgo.protocol", QtInfoMsg)
+Q_LOGGING_CATEGORY(logGtp, "qgo.gtp", QtInfoMsg)
+Q_LOGGING_CATEGORY(logTree, "qgo.tree", QtInfoMsg)
+Q_LOGGING_CATEGORY(logRender, "qgo.render", QtInfoMsg)
+
+QtMessageHandler Log::previous = 0;
+QVector<QString> Log::ring;
+int Log::next = 0;
+QMutex Log::mutex;
+
+void Log::install(void)
+{
+	ring.resize(LOG_RING_SIZE);
+	previous = qInstallMessageHandler(handler);
+}
+
+/* Same syntax as QT_LOGGING_RULES, but ',' can separate rules since
+ * ';' is awkward on a command line */
+void Log::setRules(const QString & rules)
+{
+	QString r = rules;
+	QLoggingCategory::setFilterRules(r.replace(',', '\n').replace(';', '\n'));
+}
+
+/* Messages come from the engine and sound threads as well */
+void Log::handler(QtMsgType type, const QMessageLogContext & context, const QString & msg)
+{
+	static const char * levels[] = { "debug", "warning", "critical", "fatal", "info" };
+	QString line = QTime::currentTime().toString("hh:mm:ss.zzz") + ' ' +
+		(context.category ? context.category : "default") + ' ' +
+		(type >= 0 && type <= QtInfoMsg ? levels[type] : "?") + ": " + msg;
+	mutex.lock();
+	ring[next] = line;
+	next = (next + 1) % ring.size();
+	mutex.unlock();
+	if(previous)
+		previous(type, context, msg);
+	else
+		fprintf(stderr, "%s\n", msg.toLocal8Bit().constData());
+}
+
+QStringList Log::recent(void)
+{
+	QStringList lines;
+	QMutexLocker locker(&mutex);
+	for(int i = 0; i < ring.size(); i++)
+	{
+		const QString & line = ring[(next + i) % ring.size()];
+		if(!line.isNull())
+			lines << line;
+	}
+	return lines;
+}
+
+bool Log::dump(const QString & filename)
+{
+	QFile file(filename);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+		return false;
+	QTextStream out(&file);
+	QStringList lines = recent();
+	for(int i = 0; i < lines.size(); i++)
+		out << lines[i] << '\n';
+	return true;
+}
+
+/* For packet dumps, only called inside qCDebug/qTrace arguments so it
+ * costs nothing when they're off */
+QByteArray Log::hex(const unsigned char * p, int size)
+{
+	return QByteArray::fromRawData((const char *)p, size).toHex();
+}
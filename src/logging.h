@@ -0,0 +1,66 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#ifndef LOGGING_H
+#define LOGGING_H
+
+#include <QtCore>
+
+/* Debug output goes through these categories so it can be switched on
+ * per area at runtime, --log "qgo.protocol.debug=true" or the usual
+ * QT_LOGGING_RULES.  Debug level is off by default and a disabled
+ * qCDebug doesn't even format its arguments.  Warnings stay on. */
+Q_DECLARE_LOGGING_CATEGORY(logProtocol)
+Q_DECLARE_LOGGING_CATEGORY(logGtp)
+Q_DECLARE_LOGGING_CATEGORY(logTree)
+Q_DECLARE_LOGGING_CATEGORY(logRender)
+
+/* Per move and per packet detail.  Only built in with CONFIG+=trace,
+ * otherwise the call and its arguments disappear entirely */
+#ifdef QGO_TRACE
+#define qTrace(category, ...) qCDebug(category, __VA_ARGS__)
+#else
+#define qTrace(category, ...) do {} while(0)
+#endif //QGO_TRACE
+
+/* Keeps the last LOG_RING_SIZE lines of whatever got through the
+ * filters so they can be saved after something went wrong, without
+ * having had a console open. */
+class Log
+{
+public:
+	static void install(void);
+	static void setRules(const QString & rules);
+	static QStringList recent(void);
+	static bool dump(const QString & filename);
+	static QByteArray hex(const unsigned char * p, int size);
+
+private:
+	static void handler(QtMsgType type, const QMessageLogContext & context, const QString & msg);
+
+	static QtMessageHandler previous;
+	static QVector<QString> ring;
+	static int next;
+	static QMutex mutex;
+};
+
+#endif //LOGGING_H
@@ -21,9 +21,16 @@
 
 
 #include <QApplication>
+#include <QThread>
 
 #include "mainwindow.h"
 #include "defines.h"
+#include "logging.h"
+#include "networkconnection.h"
+#include "protocolreplay.h"
+#include "gamearchiver.h"
+#include "diagramexporter.h"
+#include "enginematch.h"
 
 
 struct _preferences preferences;
@@ -104,6 +111,7 @@ void startqGo(void)
 int main(int argc, char *argv[])
 {
 	Q_INIT_RESOURCE(application);
+    Log::install();
     QApplication * app = new QApplication(argc, argv);
 	QTranslator translator;
 
@@ -111,13 +119,128 @@ int main(int argc, char *argv[])
     app->setApplicationName("qGo");
 
     QCommandLineParser parser;
+    QCommandLineOption captureOption("capture", "Record network traffic to <file>.", "file");
+    QCommandLineOption replayOption("replay", "Play a captured connection back from <file> instead of connecting.", "file");
+    QCommandLineOption replaySpeedOption("replay-speed", "Replay at <factor> times the captured speed, 0 for as fast as possible.", "factor", "1");
+    parser.addOption(captureOption);
+    parser.addOption(replayOption);
+    QCommandLineOption archiveOption("archive", "Follow observed games without opening boards and save them as SGF in <dir>.", "dir");
+    QCommandLineOption archiveAllOption("archive-all", "With --archive, observe every game on the server.");
+    QCommandLineOption archiveMaxOption("archive-max", "Follow at most <count> games at once.", "count", "500");
+    QCommandLineOption logOption("log", "Logging rules, e.g. qgo.protocol.debug=true,qgo.gtp.debug=true. Categories are qgo.protocol, qgo.gtp, qgo.tree and qgo.render.", "rules");
+    parser.addOption(logOption);
+    parser.addOption(replaySpeedOption);
+    parser.addOption(archiveOption);
+    parser.addOption(archiveAllOption);
+    parser.addOption(archiveMaxOption);
+    QCommandLineOption exportOption("export-diagrams", "Write diagrams of the given SGF files to <dir> and exit.", "dir");
+    QCommandLineOption exportMovesOption("diagram-moves", "Draw the positions after these comma separated move numbers.", "list");
+    QCommandLineOption exportEveryOption("diagram-every", "Draw the position every <n> moves.", "n", "0");
+    QCommandLineOption exportCommentsOption("diagram-comments", "Draw every commented position.");
+    QCommandLineOption exportFormatOption("diagram-format", "png or svg.", "format", "png");
+    QCommandLineOption exportSizeOption("diagram-size", "Diagram width and height in pixels.", "pixels", "600");
+    QCommandLineOption exportNumbersOption("diagram-numbers", "Number the stones played since the previous diagram.");
+    QCommandLineOption exportNoMarksOption("diagram-no-marks", "Leave out SGF marks and the last move mark.");
+    QCommandLineOption exportNoCoordsOption("diagram-no-coords", "Leave out the coordinates.");
+    parser.addOption(exportOption);
+    parser.addOption(exportMovesOption);
+    parser.addOption(exportEveryOption);
+    parser.addOption(exportCommentsOption);
+    parser.addOption(exportFormatOption);
+    parser.addOption(exportSizeOption);
+    parser.addOption(exportNumbersOption);
+    parser.addOption(exportNoMarksOption);
+    parser.addOption(exportNoCoordsOption);
+    QCommandLineOption matchOption("match", "Play two engines against each other and save the games and results in <dir>, then exit.", "dir");
+    QCommandLineOption matchFirstOption("match-first", "First engine: its number in the engine list or its command line. The default engine if not given.", "engine");
+    QCommandLineOption matchSecondOption("match-second", "Second engine, as --match-first.", "engine");
+    QCommandLineOption matchGamesOption("match-games", "Play <n> games.", "n", "10");
+    QCommandLineOption matchSizeOption("match-size", "Board size.", "size", "19");
+    QCommandLineOption matchKomiOption("match-komi", "Komi.", "komi", "6.5");
+    QCommandLineOption matchHandicapOption("match-handicap", "Handicap stones.", "stones", "0");
+    QCommandLineOption matchTimeOption("match-time", "Time per move given to the engines.", "seconds", "5");
+    QCommandLineOption matchParallelOption("match-parallel", "Play <n> games at once, by default one per two cores.", "n");
+    QCommandLineOption matchMaxMovesOption("match-max-moves", "Count the game after <n> moves.", "n", "0");
+    QCommandLineOption matchNoSwapOption("match-no-swap", "The first engine always takes black.");
+    parser.addOption(matchOption);
+    parser.addOption(matchFirstOption);
+    parser.addOption(matchSecondOption);
+    parser.addOption(matchGamesOption);
+    parser.addOption(matchSizeOption);
+    parser.addOption(matchKomiOption);
+    parser.addOption(matchHandicapOption);
+    parser.addOption(matchTimeOption);
+    parser.addOption(matchParallelOption);
+    parser.addOption(matchMaxMovesOption);
+    parser.addOption(matchNoSwapOption);
     parser.process(*app);
     const QStringList args = parser.positionalArguments();
     translatorPtr = &translator;
+
+    if(parser.isSet(logOption))
+        Log::setRules(parser.value(logOption));
+
+    if(parser.isSet(exportOption))
+    {
+        DiagramExporter::Options options;
+        QStringList moves = parser.value(exportMovesOption).split(',', QString::SkipEmptyParts);
+        for (int i = 0; i < moves.size(); i++)
+            options.moves.append(moves[i].toInt());
+        options.every = parser.value(exportEveryOption).toInt();
+        options.comments = parser.isSet(exportCommentsOption);
+        options.svg = (parser.value(exportFormatOption).toLower() == "svg");
+        options.size = qMax(50, parser.value(exportSizeOption).toInt());
+        options.numbers = parser.isSet(exportNumbersOption);
+        options.marks = !parser.isSet(exportNoMarksOption);
+        options.coords = !parser.isSet(exportNoCoordsOption);
+        srand(time(NULL));
+        DiagramExporter exporter(parser.value(exportOption), options);
+        return exporter.exportFiles(args) > 0 ? 0 : 1;
+    }
+
+    if(parser.isSet(matchOption))
+    {
+        EngineMatch::Options options;
+        for (int e = 0; e < 2; e++)
+        {
+            QString spec = parser.value(e == 0 ? matchFirstOption : matchSecondOption);
+            if (!EngineMatch::engineFromSpec(spec, options.path[e], options.args[e]))
+            {
+                qWarning("No engine %s in the engine list", spec.toLatin1().constData());
+                return 1;
+            }
+        }
+        options.games = qMax(1, parser.value(matchGamesOption).toInt());
+        options.board_size = qBound(2, parser.value(matchSizeOption).toInt(), 25);
+        options.komi = parser.value(matchKomiOption).toFloat();
+        options.handicap = qBound(0, parser.value(matchHandicapOption).toInt(), 9);
+        options.move_secs = qMax(1, parser.value(matchTimeOption).toInt());
+        options.parallel = (parser.isSet(matchParallelOption) ? parser.value(matchParallelOption).toInt()
+                                                              : QThread::idealThreadCount() / 2);
+        options.parallel = qMax(1, options.parallel);
+        options.max_moves = parser.value(matchMaxMovesOption).toInt();
+        options.swap = !parser.isSet(matchNoSwapOption);
+        EngineMatch match(parser.value(matchOption), options);
+        QObject::connect(&match, SIGNAL(signal_finished()), app, SLOT(quit()));
+        match.start();
+        app->exec();
+        return match.failures() > 0 ? 1 : 0;
+    }
+
+    if(parser.isSet(captureOption))
+        NetworkConnection::setCaptureFilename(parser.value(captureOption));
+    if(parser.isSet(archiveOption))
+        NetworkConnection::setArchiver(new GameArchiver(parser.value(archiveOption), parser.isSet(archiveAllOption), parser.value(archiveMaxOption).toInt()));
 	
 	startqGo();
     mainwindow->show();
 
+    if(parser.isSet(replayOption))
+    {
+        ProtocolReplay * replay = new ProtocolReplay(parser.value(replayOption), parser.value(replaySpeedOption).toDouble());
+        QTimer::singleShot(0, replay, SLOT(start()));
+    }
+
     QStringList::const_iterator filename;
     for ( filename = args.begin(); filename != args.end(); ++filename )
 	{
@@ -29,6 +29,7 @@
 #include "audio.h"
 #include "sgfparser.h"
 #include "newgamedialog.h"
+#include "archivesearchdialog.h"
 #include "ui_mainwindow.h"
 
 MainWindow::MainWindow(QWidget * parent, Qt::WindowFlags flags )
@@ -48,6 +49,8 @@ MainWindow::MainWindow(QWidget * parent, Qt::WindowFlags flags )
 
 	// connecting the new game button
     connect( ui->actionOpen, SIGNAL(triggered()), SLOT(slot_fileOpen()) );
+    connect( ui->actionSearchFiles, SIGNAL(triggered()), SLOT(slot_searchFiles()) );
+    archiveSearchDialog = NULL;
     connect(ui->actionNew,SIGNAL(triggered()),SLOT(slot_fileNew()));
 
     connect(ui->cancelButtonPrefs,SIGNAL(pressed()),SLOT(slot_cancelPressed()));
@@ -125,6 +128,28 @@ void MainWindow::openSGF(QString path)
     this->addBoardWindow(new BoardWindow(GameLoaded, true, true));
 }
 
+void MainWindow::slot_searchFiles()
+{
+    if (archiveSearchDialog == NULL)
+    {
+        archiveSearchDialog = new ArchiveSearchDialog(this);
+        connect(archiveSearchDialog, SIGNAL(signal_open(const QString &, const QString &, int)),
+                SLOT(slot_openSearchResult(const QString &, const QString &, int)));
+    }
+    archiveSearchDialog->show();
+    archiveSearchDialog->raise();
+    archiveSearchDialog->activateWindow();
+}
+
+/* The board's own search finds the same match again in the loaded tree */
+void MainWindow::slot_openSearchResult(const QString &path, const QString &query, int match)
+{
+    int boards = boardWindowList.size();
+    openSGF(path);
+    if (boardWindowList.size() > boards)
+        boardWindowList.last()->showSearch(query, match);
+}
+
 /*
  * The 'New Game' button in 'Go Engine' tab has been pressed.
  */
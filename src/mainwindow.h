@@ -90,6 +90,8 @@ public slots:
     void slot_fileNew();
     void slot_fileOpen();
     void openSGF(QString path);
+    void slot_searchFiles();
+    void slot_openSearchResult(const QString &path, const QString &query, int match);
 
     //preferences tabs slots
 	void slot_cancelPressed();
@@ -116,6 +118,7 @@ private:
 	QString currentWorkingDir;
 
     LoginDialog * logindialog;
+    class ArchiveSearchDialog * archiveSearchDialog;
     EngineTableModel * engineTableModel;
 };
 
@@ -30,7 +30,11 @@
 #include "networkconnection.h"
 #include "qgoboard.h"
 #include "clockdisplay.h"
+#include "clockservice.h"
 #include "tree.h"
+#include "move.h"
+#include "matrix.h"
+#include "gamearchiver.h"
 
 /* It would be difficult to create a board without a connection,
  * but we need to either be certain and not test at all, or assign
@@ -43,12 +47,14 @@ BoardDispatch::BoardDispatch(NetworkConnection * conn, GameListing * l)
 {
 	connection = conn;
 	boardwindow = 0;
+	tree = 0;
 	resultdialog = 0;
 	countdialog = 0;
 	observerListModel = 0;
 	
 	clockStopped = false;
 	reviewInVariation = false;
+	moveSentAt = 0;
 	/* New rules.  The boarddispatch creates the game data or
 	 * whatever loads the game data before passing it to the
 	 * boardwindow creates it.  The boardwindow deletes it.
@@ -97,6 +103,12 @@ BoardDispatch::~BoardDispatch()
 		delete resultdialog;
 	if(countdialog)
 		delete countdialog;
+	/* No boardwindow to delete the game data */
+	if(tree)
+	{
+		delete tree;
+		delete gameData;
+	}
 }
 
 bool BoardDispatch::canClose(void)
@@ -178,6 +190,11 @@ void BoardDispatch::moveControl(QString & player)
 
 void BoardDispatch::recvMove(MoveRecord * m)
 {
+	if(tree)
+	{
+		recvMoveIntoTree(m);
+		return;
+	}
 	if(!boardwindow)
 	{
 		qDebug("Board dispatch has no board window\n");
@@ -191,9 +208,29 @@ void BoardDispatch::recvMove(MoveRecord * m)
 	{
 		gameData->gameMode = modeReview;
 	}
+	if(moveSentAt && connection &&
+		(m->flags == MoveRecord::NONE || m->flags == MoveRecord::PASS))
+	{
+		connection->recordRoundTrip(ClockService::now() - moveSentAt);
+		moveSentAt = 0;
+	}
 	boardwindow->qgoboard->handleMove(m);
 }
 
+/* Moves received until endMoveBatch are applied without redrawing,
+ * the connection ends any open batch when it runs out of data */
+void BoardDispatch::beginMoveBatch(void)
+{
+	if(boardwindow)
+		boardwindow->qgoboard->beginMoveBatch();
+}
+
+void BoardDispatch::endMoveBatch(void)
+{
+	if(boardwindow)
+		boardwindow->qgoboard->endMoveBatch();
+}
+
 //FIXME should be another way to set the game moves
 //related directly to the board... then again, I don't
 //really want to access the tree from here
@@ -203,7 +240,11 @@ void BoardDispatch::sendMove(MoveRecord * m)
 		gameData->moves = m->number;
 	//qDebug("setting game moves: %d", gameData->moves);
 	if(connection)
+	{
+		if(m->flags == MoveRecord::NONE || m->flags == MoveRecord::PASS)
+			moveSentAt = ClockService::now();
 		connection->sendMove(gameData->number, m);
+	}
 }
 
 /* FIXME
@@ -268,6 +309,8 @@ void BoardDispatch::gameDataChanged(void)
 
 void BoardDispatch::openBoard(void)
 {
+    if(tree)
+        return;
     if(boardwindow)
     {
         qDebug("BoardDispatch::openBoard() : window already open\n");
@@ -297,6 +340,13 @@ void BoardDispatch::openBoard(void)
 		}
 		//else, something else has set it ahead of time
 		
+		if(gameData->gameMode == modeObserve && NetworkConnection::getArchiver())
+		{
+			tree = new Tree(gameData->board_size, gameData->komi);
+			if(gameData->record_sgf != QString())	//for ORO
+				tree->importSGFString(gameData->record_sgf);
+			return;
+		}
 		boardwindow = new BoardWindow(gameData, imBlack, imWhite, this);
 		if(!observerListModel)
 		{
@@ -311,6 +361,66 @@ void BoardDispatch::openBoard(void)
             boardwindow->getTree()->slotNavLast();
 }
 
+/* Just enough of qGoBoardNetworkInterface::handleMove to follow the
+ * main line of an observed game without a board */
+void BoardDispatch::recvMoveIntoTree(MoveRecord * m)
+{
+	Move * last = tree->findLastMoveInMainBranch();
+	int move_counter = last->getMoveNumber() + 1;
+	int move_number = (m->number == NOMOVENUMBER ? move_counter : m->number);
+	StoneColor color = m->color;
+	if(color == stoneNone)
+		color = (last->getColor() == stoneBlack ? stoneWhite : stoneBlack);
+
+	tree->setCurrent(last);
+	switch(m->flags)
+	{
+		case MoveRecord::HANDICAP:
+			last->setMoveNumber(0);
+			if(last->getMatrix()->addHandicapStones(m->x))
+			{
+				last->setHandicapMove(true);
+				last->setX(-1);
+				last->setY(-1);
+				last->setColor(stoneBlack);
+				gameData->handicap = m->x;
+			}
+			return;
+		case MoveRecord::UNDO:
+			if(supportsMultipleUndo())
+			{
+				while(move_counter > move_number + 1 && tree->getCurrent()->parent)
+				{
+					tree->undoMove();
+					move_counter--;
+				}
+			}
+			else
+				tree->undoMove();
+			tree->lastMoveInMainBranch = tree->getCurrent();
+			return;
+		case MoveRecord::PASS:
+			last = last->makeMove(color, PASS_XY, PASS_XY, true);
+			break;
+		case MoveRecord::NONE:
+			if(move_number != move_counter)
+				return;
+			if(!last->checkMoveIsValid(color, m->x, m->y))
+			{
+				qDebug("Game %d: invalid move %d %d", gameData->number, m->x, m->y);
+				return;
+			}
+			last = last->makeMove(color, m->x, m->y, true);
+			break;
+		default:
+			//review and scoring moves don't go in the record
+			return;
+	}
+	tree->lastMoveInMainBranch = last;
+	tree->setCurrent(last);
+	gameData->moves = last->getMoveNumber();
+}
+
 void BoardDispatch::recvTime(const TimeRecord & wt, const TimeRecord & bt)
 {
 	/* I don't think I care if its not ongoing.  That's a minor issue
@@ -318,10 +428,12 @@ void BoardDispatch::recvTime(const TimeRecord & wt, const TimeRecord & bt)
 	if(!boardwindow /*|| boardwindow->getGamePhase() != phaseOngoing*/)
 		return;
 
+	/* The times were read about half a round trip ago */
 	boardwindow->getClockDisplay()->setTimeInfo(bt.time,
 						bt.stones_periods,
 						wt.time,
-						wt.stones_periods);
+						wt.stones_periods,
+						connection ? connection->getRoundTrip() / 2 : 0);
 }
 
 void BoardDispatch::recvAddTime(int minutes, QString player_name)
@@ -347,11 +459,11 @@ void BoardDispatch::recvResult(GameResult * r)
 {
 	/* FIXME there's still some issues here with this being called from certain services
 	 * at the wrong time, etc. */
-	if(!boardwindow)
+	if(!boardwindow && !tree)
 		return;
 	if(!r)
 	{
-        GameResult res = boardwindow->getTree()->retrieveScore();
+        GameResult res = (tree ? tree : boardwindow->getTree())->retrieveScore();
 		r = &res;
 	}
 	// also set on GameData of boardwindow ???
@@ -374,6 +486,18 @@ void BoardDispatch::recvResult(GameResult * r)
 			r->winner_color = stoneWhite;
 		}
 	}
+	if(tree)
+	{
+		/* IGS can send the result twice */
+		if(gameData->fullresult)
+			return;
+		gameData->result = r->shortMessage();
+		gameData->fullresult = new GameResult(*r);
+		NetworkConnection::getArchiver()->saveGame(gameData, tree);
+		if(connection)
+			NetworkConnection::getArchiver()->closeLater(connection, gameData->number);
+		return;
+	}
 	boardwindow->qgoboard->setResult(*r);
 	
 	//saveRecordToGameData();
@@ -428,6 +552,12 @@ void BoardDispatch::clearObservers(void)
 
 void BoardDispatch::recvKibitz(QString name, QString text)
 {
+	if(tree)
+	{
+		Move * last = tree->findLastMoveInMainBranch();
+		last->setComment(last->getComment() + (name == QString() ? text : name + ":" + text) + "\n");
+		return;
+	}
 	if(!boardwindow)
 		return;
 	if(name == QString())
@@ -614,6 +744,8 @@ void BoardDispatch::adjournGame(void)
 	// in case we get this after we've closed window
 	if(boardwindow)
 		boardwindow->qgoboard->adjournGame();
+	else if(tree)
+		NetworkConnection::getArchiver()->saveGame(gameData, tree);	//keep what we have
 	//wrong, sometimes there is a dispatch if we want to talk, etc.
 	//let the close and the connection delete things
 	//delete this;		//if the game is adjourned, there's no dispatch
@@ -787,6 +919,8 @@ void BoardDispatch::requestGameInfo(void)
 
 int BoardDispatch::getMoveNumber(void)
 {
+	if(tree)
+		return tree->findLastMoveInMainBranch()->getMoveNumber();
 	return boardwindow->qgoboard->getMoveNumber();
 }
 
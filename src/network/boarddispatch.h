@@ -20,6 +20,8 @@
  ***************************************************************************/
 
 
+#include <QtGlobal>
+
 class NetworkConnection;
 class QString;
 
@@ -32,6 +34,8 @@ class BoardDispatch
 		void closeBoard(void);
         void setConnection(NetworkConnection * conn);
 		void recvMove(class MoveRecord * m);
+		void beginMoveBatch(void);
+		void endMoveBatch(void);
 		void sendMove(class MoveRecord * m);
 		void sendRequestMatchMode();
 		bool isClockStopped(void) { return clockStopped; };
@@ -124,7 +128,9 @@ class BoardDispatch
 		bool cantMarkOppStonesDead(void);
 	private:
 		void mergeListingIntoRecord(class GameData * r, class GameListing * l);
+		void recvMoveIntoTree(class MoveRecord * m);
         class BoardWindow * boardwindow;
+		class Tree * tree;		//instead of a boardwindow when archiving
 		NetworkConnection * connection;
 		class GameData * gameData;
 		class GameListing * gameListing;
@@ -134,4 +140,5 @@ class BoardDispatch
 		
 		bool clockStopped;
 		bool reviewInVariation;
+		qint64 moveSentAt;	//ClockService::now() of our unechoed move, or 0
 };
@@ -0,0 +1,210 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#include <algorithm>
+#include "connectionmetrics.h"
+#include "protocolcapture.h"
+
+ConnectionMetrics::Handler::Handler(ConnectionMetrics & m, unsigned int t, unsigned int s) :
+metrics(m), type(t), size(s)
+{
+	start = ProtocolCapture::threadCpuNsecs();
+}
+
+/* Looked up again here since the handler may have sent something
+ * of a new type and grown the hash */
+ConnectionMetrics::Handler::~Handler()
+{
+	qint64 nsecs = ProtocolCapture::threadCpuNsecs() - start;
+	MessageStats & stats = metrics.stats[type];
+	stats.in++;
+	stats.bytes_in += size;
+	stats.nsecs += nsecs;
+	if(nsecs > stats.max_nsecs)
+		stats.max_nsecs = nsecs;
+	metrics.batch++;
+}
+
+ConnectionMetrics::ConnectionMetrics() : hex_types(false)
+{
+	reset();
+}
+
+void ConnectionMetrics::reset(void)
+{
+	stats.clear();
+	since.start();
+	rtt_samples = 0;
+	rtt_total = 0;
+	rtt_last = 0;
+	rtt_min = 0;
+	rtt_max = 0;
+	backlog_last = 0;
+	backlog_max = 0;
+	write_backlog_max = 0;
+	batch = 0;
+	batch_last = 0;
+	batch_max = 0;
+}
+
+void ConnectionMetrics::recordOut(unsigned int type, unsigned int size)
+{
+	MessageStats & s = stats[type];
+	s.out++;
+	s.bytes_out += size;
+}
+
+void ConnectionMetrics::recordRoundTrip(int ms)
+{
+	if(!rtt_samples || ms < rtt_min)
+		rtt_min = ms;
+	if(ms > rtt_max)
+		rtt_max = ms;
+	rtt_last = ms;
+	rtt_total += ms;
+	rtt_samples++;
+}
+
+/* What the socket already had queued when we got around to reading
+ * it, a growing backlog means we're not keeping up */
+void ConnectionMetrics::beginRead(qint64 bytes_waiting, qint64 bytes_to_write)
+{
+	backlog_last = bytes_waiting;
+	if(bytes_waiting > backlog_max)
+		backlog_max = bytes_waiting;
+	if(bytes_to_write > write_backlog_max)
+		write_backlog_max = bytes_to_write;
+	batch = 0;
+}
+
+void ConnectionMetrics::endRead(void)
+{
+	batch_last = batch;
+	if(batch > batch_max)
+		batch_max = batch;
+}
+
+/* 0 is whatever doesn't have a type, console text, login, etc. */
+QString ConnectionMetrics::typeName(unsigned int type) const
+{
+	if(!type)
+		return "other";
+	if(hex_types)
+		return QString("0x%1").arg(type, 4, 16, QChar('0'));
+	return QString::number(type);
+}
+
+QList<unsigned int> ConnectionMetrics::getTypes(void) const
+{
+	QList<unsigned int> types = stats.keys();
+	std::sort(types.begin(), types.end());
+	return types;
+}
+
+const ConnectionMetrics::MessageStats ConnectionMetrics::getTotals(void) const
+{
+	MessageStats total;
+	QHash<unsigned int, MessageStats>::const_iterator i;
+	for(i = stats.constBegin(); i != stats.constEnd(); ++i)
+	{
+		total.in += i.value().in;
+		total.bytes_in += i.value().bytes_in;
+		total.out += i.value().out;
+		total.bytes_out += i.value().bytes_out;
+		total.nsecs += i.value().nsecs;
+		if(i.value().max_nsecs > total.max_nsecs)
+			total.max_nsecs = i.value().max_nsecs;
+	}
+	return total;
+}
+
+QByteArray ConnectionMetrics::toJson(void) const
+{
+	QJsonObject root;
+	root["elapsed_ms"] = getElapsed();
+
+	QJsonObject rtt;
+	rtt["samples"] = (qint64)rtt_samples;
+	rtt["last_ms"] = rtt_last;
+	rtt["min_ms"] = rtt_min;
+	rtt["max_ms"] = rtt_max;
+	rtt["average_ms"] = getRoundTripAverage();
+	root["move_round_trip"] = rtt;
+
+	QJsonObject backlog;
+	backlog["read_bytes_last"] = backlog_last;
+	backlog["read_bytes_max"] = backlog_max;
+	backlog["write_bytes_max"] = write_backlog_max;
+	backlog["messages_per_read_last"] = (int)batch_last;
+	backlog["messages_per_read_max"] = (int)batch_max;
+	root["queue"] = backlog;
+
+	QJsonArray messages;
+	QList<unsigned int> types = getTypes();
+	for(int i = 0; i < types.size(); i++)
+	{
+		const MessageStats & s = stats[types[i]];
+		QJsonObject m;
+		m["type"] = typeName(types[i]);
+		m["in"] = (qint64)s.in;
+		m["bytes_in"] = (qint64)s.bytes_in;
+		m["out"] = (qint64)s.out;
+		m["bytes_out"] = (qint64)s.bytes_out;
+		m["handler_us"] = s.nsecs / 1000;
+		m["handler_max_us"] = s.max_nsecs / 1000;
+		messages.append(m);
+	}
+	root["messages"] = messages;
+	return QJsonDocument(root).toJson();
+}
+
+/* Just the per type table, the rest fits the json better */
+QByteArray ConnectionMetrics::toCsv(void) const
+{
+	QByteArray csv("type,in,bytes_in,out,bytes_out,handler_us,handler_max_us\n");
+	QList<unsigned int> types = getTypes();
+	for(int i = 0; i < types.size(); i++)
+	{
+		const MessageStats & s = stats[types[i]];
+		csv += typeName(types[i]).toLatin1() + ',' +
+			QByteArray::number(s.in) + ',' + QByteArray::number(s.bytes_in) + ',' +
+			QByteArray::number(s.out) + ',' + QByteArray::number(s.bytes_out) + ',' +
+			QByteArray::number(s.nsecs / 1000) + ',' + QByteArray::number(s.max_nsecs / 1000) + '\n';
+	}
+	return csv;
+}
+
+/* Format goes by the extension, json unless it's .csv */
+bool ConnectionMetrics::dump(const QString & filename) const
+{
+	QFile file(filename);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		qDebug("Can't open %s for metrics", filename.toLatin1().constData());
+		return false;
+	}
+	if(filename.endsWith(".csv", Qt::CaseInsensitive))
+		file.write(toCsv());
+	else
+		file.write(toJson());
+	return true;
+}
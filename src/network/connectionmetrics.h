@@ -0,0 +1,96 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#ifndef CONNECTIONMETRICS_H
+#define CONNECTIONMETRICS_H
+
+#include <QtCore>
+
+/* Always on counters for one connection: traffic and handler cpu time
+ * per message type, the move echo round trip and how much was waiting
+ * on the socket when we got to it.  Kept cheap enough to leave running,
+ * a hash lookup and two clock reads per message.  Together they tell
+ * a slow server apart from us being slow to handle what it sends. */
+class ConnectionMetrics
+{
+public:
+	struct MessageStats
+	{
+		MessageStats() : in(0), bytes_in(0), out(0), bytes_out(0), nsecs(0), max_nsecs(0) {}
+		quint64 in, bytes_in;
+		quint64 out, bytes_out;
+		qint64 nsecs, max_nsecs;	//handler cpu time
+	};
+
+	/* Times the handler for one incoming message, handlers return
+	 * from all over the place so this goes on the stack */
+	class Handler
+	{
+	public:
+		Handler(ConnectionMetrics & m, unsigned int type, unsigned int size);
+		~Handler();
+	private:
+		ConnectionMetrics & metrics;
+		unsigned int type, size;
+		qint64 start;
+	};
+
+	ConnectionMetrics();
+	void setHexTypes(bool hex) { hex_types = hex; }
+	void recordOut(unsigned int type, unsigned int size);
+	void recordRoundTrip(int ms);
+	void beginRead(qint64 bytes_waiting, qint64 bytes_to_write);
+	void endRead(void);
+	void reset(void);
+
+	QString typeName(unsigned int type) const;
+	QList<unsigned int> getTypes(void) const;
+	const MessageStats getStats(unsigned int type) const { return stats.value(type); }
+	const MessageStats getTotals(void) const;
+	quint64 getRoundTripSamples(void) const { return rtt_samples; }
+	int getRoundTripLast(void) const { return rtt_last; }
+	int getRoundTripMin(void) const { return rtt_min; }
+	int getRoundTripMax(void) const { return rtt_max; }
+	int getRoundTripAverage(void) const { return rtt_samples ? rtt_total / rtt_samples : 0; }
+	qint64 getBacklogLast(void) const { return backlog_last; }
+	qint64 getBacklogMax(void) const { return backlog_max; }
+	qint64 getWriteBacklogMax(void) const { return write_backlog_max; }
+	unsigned int getBatchLast(void) const { return batch_last; }
+	unsigned int getBatchMax(void) const { return batch_max; }
+	qint64 getElapsed(void) const { return since.elapsed(); }
+
+	QByteArray toJson(void) const;
+	QByteArray toCsv(void) const;
+	bool dump(const QString & filename) const;
+
+private:
+	QHash<unsigned int, MessageStats> stats;
+	bool hex_types;
+	QElapsedTimer since;
+	quint64 rtt_samples;
+	qint64 rtt_total;
+	int rtt_last, rtt_min, rtt_max;
+	qint64 backlog_last, backlog_max, write_backlog_max;
+	unsigned int batch, batch_last, batch_max;	//messages per read
+};
+
+#endif //CONNECTIONMETRICS_H
@@ -22,6 +22,7 @@
 
 #include <string.h>
 #include <math.h>
+#include <algorithm>
 #include "cyberoroconnection.h"
 #include "cyberoroprotocol.h"
 #include "consoledispatch.h"
@@ -40,6 +41,8 @@
 #include "playergamelistings.h"
 #include "quickconnection.h"
 #include "matchnegotiationstate.h"
+#include "stringpool.h"
+#include "logging.h"
 #include <QMessageBox>
 
 #ifdef NEWPROTOCOL
@@ -63,8 +66,10 @@ const char * JapaneseCodec = "Shift-JIS";
 const char * LatinCodec = "ISO-8859-1";
 
 CyberOroConnection::CyberOroConnection(const ConnectionCredentials credentials)
-    : NetworkConnection(credentials)
+    : NetworkConnection(credentials), packetFramer(PacketFramer::LittleEndian16At2)
 {
+	metrics.setHexTypes(true);
+	encoded_type = -1;
     //Note that this is not world.cyberoro.com
 	//which right now is 91.91.
 	//This is gateway server which is sent login
@@ -254,7 +259,6 @@ void CyberOroConnection::acceptMatchOffer(const PlayerListing * /*opponent*/, Ma
 void CyberOroConnection::handlePendingData()
 {
     unsigned char * c;
-    unsigned char header[4];
 	unsigned int packet_size;
 	int bytes;
 
@@ -289,20 +293,21 @@ void CyberOroConnection::handlePendingData()
         }
         break;
     case CONNECTED:
-        while((bytes = qsocket->bytesAvailable()) > 0)
+        /* A handler's modal dialog can bring us back here, the inner
+         * call dispatches what comes in meanwhile.  Handlers can also
+         * close or change the connection under us. */
+        packetFramer.hold();
+        do
         {
-            qsocket->peek((char *)header, 4);
+            while(connectionState == CONNECTED && packetFramer.nextPacket(&c, &packet_size))
+            {
 #ifdef RE_DEBUG
-            printf("%02x%02x%02x%02x\n", header[0], header[1], header[2], header[3]);
+                printf("%02x%02x%02x%02x\n", c[0], c[1], c[2], c[3]);
 #endif //RE_DEBUG
-            packet_size = header[2] + (header[3] << 8);
-            if((unsigned)bytes < packet_size)
-                break;
-            c = new unsigned char[packet_size];
-            qsocket->read((char*)c, packet_size);
-            handleMessage(c, packet_size);
-            delete[] c;
-        }
+                handleMessage(c, packet_size);
+            }
+        } while(qsocket && connectionState == CONNECTED && packetFramer.fill(qsocket) > 0);
+        packetFramer.release();
         break;
     case CANCELED:
     case RECONNECTING:
@@ -329,8 +334,7 @@ void CyberOroConnection::handleServerList(unsigned char * msg)
 	
 	if(p[0] != 0x24 || p[1] != 0x27)
 	{
-		qDebug("Non standard server list msg header");		//unnecessary check FIXME
-		printf("%02x %02x", p[0], p[1]);
+		qCWarning(logProtocol, "Non standard server list msg header %02x %02x", p[0], p[1]);		//unnecessary check FIXME
 	}
 	p += 4;
 	challenge_response = new unsigned char[106];
@@ -387,7 +391,6 @@ void CyberOroConnection::handleServerList(unsigned char * msg)
 		}
 		
 		p += (16 - server_name_length);	
-		printf("\n");
 		serverList.push_back(si);
 #ifdef RE_DEBUG
 		printf("Language byte: %02x\n", p[0]);
@@ -484,7 +487,8 @@ int CyberOroConnection::reconnectToServer(void)
 	qDebug("Reconnecting to %s: %s...", serverList[server_i]->name.toLatin1().constData(), serverList[server_i]->ipaddress);
 	
 	if(connectionState == CONNECTED)
-		closeConnection(false);
+		closeConnection(false, true);
+	packetFramer.clear();
 	/* Though connection isn't really negotiated yet,
 	 * we can get here without a playerListingIDRegistry as soon
 	 * as the connection is opened, so we're going to do this
@@ -1198,7 +1202,7 @@ void CyberOroConnection::sendMatchOffer(const MatchRequest & mr, bool offercount
 			packet[12] = 0x04;
 			break;
 		default:
-			printf("Bad board size: %d\n", mr.board_size);
+			qCWarning(logProtocol, "Bad board size: %d", mr.board_size);
 			return;
 			break;
 	}
@@ -2644,21 +2648,24 @@ void CyberOroConnection::sendChallengeResponse(void)
  * do wonder if its partly for obfuscation still.*/
 void CyberOroConnection::encode(unsigned char * h, unsigned int cycle_size)
 {
-	int i;
+	int i, n;
 	unsigned char a = 0xff;
 	int IV3 = cycle_size;	//maybe we're passed this?
 	
+	encoded_type = h[1] + (h[0] << 8);
 	IV3 -= 3;
 	/* sub edx, eax jl */
 	IV3++;
-	for(i = 0; i < IV3; i++)
-	{
-		h[i] = h[i] ^ codetable[codetable_IV];	
-		a = h[i] ^ a;
-		codetable_IV++;
-		codetable_IV %= 1000;	//double check!!! could be /!!
-		if(codetable_IV == 0)	//should probably be % 1000 ==, not %=!!!
+	/* xor against the table a run at a time, up to where
+	 * the table wraps */
+	for(i = 0; i < IV3; i += n)
+	{
+		n = std::min(IV3 - i, (int)(1000 - codetable_IV));
+		a ^= PacketFramer::xorBytes(h + i, codetable + codetable_IV, n);
+		codetable_IV += n;
+		if(codetable_IV == 1000)	//double check!!! could be /!!
 		{
+			codetable_IV = 0;
 			codetable_IV2++;
 			qDebug("incrementing codetable_IV2: %d", codetable_IV2);
 		}
@@ -2682,12 +2689,26 @@ void CyberOroConnection::handleMessage(QString)
 {
 }
 
+/* Same header as what we get, type in the first two bytes */
+/* encode() scrambles the header in place, so it notes the type first */
+unsigned int CyberOroConnection::outgoingMessageType(const char * packet, unsigned int size)
+{
+	int type = encoded_type;
+	encoded_type = -1;
+	if(type >= 0)
+		return type;
+	if(size < 2)
+		return 0;
+	return (unsigned char)packet[1] + ((unsigned char)packet[0] << 8);
+}
+
 /* We may convert everything here to unsigned char *s, delete the old...
  * we're still sort of hung up on all the things we were doing
  * to work with the IGS code. */
 void CyberOroConnection::handleMessage(unsigned char * msg, unsigned int size)
 {
 	unsigned short message_type = msg[1] + (msg[0] << 8);
+	ConnectionMetrics::Handler timed(metrics, message_type, size);
 	//message_type = msg[0];
 	//message_type >>= 8;
 	//message_type += msg[1];
@@ -2717,7 +2738,7 @@ void CyberOroConnection::handleMessage(unsigned char * msg, unsigned int size)
 			handlePlayerList(msg, size);
 			break;
 		/*case 0xfa00:
-			printf("likely game message\n");
+			qCDebug(logProtocol, "likely game message");
 			break;*/
 		case 0x2c56:
 #ifdef RE_DEBUG
@@ -3271,7 +3292,8 @@ void CyberOroConnection::handlePlayerList(unsigned char * msg, unsigned int size
 #endif //RE_DEBUG
 		p += 10;
 		id = p[0] + (p[1] << 8);
-		aPlayer = room->getPlayerListing(id);
+		QString decodedName = serverCodec->toUnicode((const char *)name, strlen((const char *)name));
+		aPlayer = room->getPlayerListing(id, decodedName);
 		if(!aPlayer)
 		{
 			aPlayer = newPlayer;
@@ -3283,7 +3305,7 @@ void CyberOroConnection::handlePlayerList(unsigned char * msg, unsigned int size
 		else
 			aPlayer->hidden = false;
 		//aPlayer->name = QString((char*)name);
-		aPlayer->name = serverCodec->toUnicode((const char *)name, strlen((const char *)name));
+		aPlayer->name = decodedName;
 		
 		p += 2;
 		//a byte here seems to be a send msg byte, or something
@@ -3311,14 +3333,14 @@ void CyberOroConnection::handlePlayerList(unsigned char * msg, unsigned int size
 		aPlayer->country = getCountryFromCode(p[3]);
 		//fifth byte is their open status
 		invitebyte = p[4];
-		aPlayer->nmatch_settings = QString::number(p[0]) + QString(" ") + QString::number((p[1])) + QString(" ") + QString::number(p[2]) + QString(" ") + QString::number(p[3]);
+		aPlayer->nmatch_settings = StringPool::intern(QString::number(p[0]) + QString(" ") + QString::number((p[1])) + QString(" ") + QString::number(p[2]) + QString(" ") + QString::number(p[3]));
 		p += 6;
 		aPlayer->rank_score = p[0] + (p[1] << 8); 
 		if(aPlayer->pro)
-			aPlayer->rank = QString::number(rankbyte & 0x1f) + QString("dp");
+			aPlayer->rank = StringPool::intern(QString::number(rankbyte & 0x1f) + QString("dp"));
 		else
 			aPlayer->rank = rating_pointsToRank(aPlayer->rank_score);
-		aPlayer->info = getStatusFromCode(invitebyte, aPlayer->rank);
+		aPlayer->info = StringPool::intern(getStatusFromCode(invitebyte, aPlayer->rank));
 		aPlayer->wins = p[2] + (p[3] << 8);
 		aPlayer->losses = p[4] + (p[5] << 8);
 		p += 6;
@@ -3370,7 +3392,7 @@ void CyberOroConnection::handlePlayerList(unsigned char * msg, unsigned int size
 				/* add room to player, ORO is one room per player */
 				backPlayer->observing = playerlist_roomnumber;
 				/* add player to room */
-				gamelisting->observer_list.push_back(backPlayer);
+				gamelisting->observer_list.insert(backPlayer);
 #ifdef RE_DEBUG
 				printf("Adding player %s %d to game %d\n", backPlayer->name.toLatin1().constData(), backPlayer->id, playerlist_roomnumber);
 #endif //RE_DEBUG
@@ -3416,12 +3438,13 @@ void CyberOroConnection::handlePlayerList(unsigned char * msg, unsigned int size
         name[10] = 0x00;
 		p += 10;
 		id = p[0] + (p[1] << 8);
-		aPlayer = room->getPlayerListing(id);
+		QString decodedName = serverCodec->toUnicode((const char *)name, strlen((const char *)name));
+		aPlayer = room->getPlayerListing(id, decodedName);
 		if(strncmp((char *)name, "jguest", 6) == 0 || strncmp((char *)name, "jpguest", 7) == 0)
 			aPlayer->hidden = true;
 		else
 			aPlayer->hidden = false;
-        aPlayer->name = serverCodec->toUnicode((const char *)name, strlen((const char *)name));
+        aPlayer->name = decodedName;
 		
 		p += 2;
 		//a byte here seems to be a send msg byte, or something
@@ -3439,14 +3462,14 @@ void CyberOroConnection::handlePlayerList(unsigned char * msg, unsigned int size
 		aPlayer->country = getCountryFromCode(p[3]);
 		//fifth byte is their open status
 		invitebyte = p[4];
-		aPlayer->nmatch_settings = QString::number(p[0]) + QString(" ") + QString::number((p[1])) + QString(" ") + QString::number(p[2]) + QString(" ") + QString::number(p[3]);
+		aPlayer->nmatch_settings = StringPool::intern(QString::number(p[0]) + QString(" ") + QString::number((p[1])) + QString(" ") + QString::number(p[2]) + QString(" ") + QString::number(p[3]));
 		p += 6;
 		aPlayer->rank_score = p[0] + (p[1] << 8); 
 		if(aPlayer->pro)
-			aPlayer->rank = QString::number(rankbyte & 0x1f) + QString("dp");
+			aPlayer->rank = StringPool::intern(QString::number(rankbyte & 0x1f) + QString("dp"));
 		else
 			aPlayer->rank = rating_pointsToRank(aPlayer->rank_score);
-		aPlayer->info = getStatusFromCode(invitebyte, aPlayer->rank);
+		aPlayer->info = StringPool::intern(getStatusFromCode(invitebyte, aPlayer->rank));
 		aPlayer->wins = p[2] + (p[3] << 8);
 		aPlayer->losses = p[4] + (p[5] << 8);
 		p += 6;
@@ -3456,22 +3479,22 @@ void CyberOroConnection::handlePlayerList(unsigned char * msg, unsigned int size
     }
 }
 
+/* Every listing of a rank shares one pooled string */
 QString CyberOroConnection::rating_pointsToRank(unsigned int rp)
 {
+	static QVector<QString> ranks;
 	int rem = rp % 1000;
 	rp -= rem;
 	rp /= 1000;
+	if(rp < (unsigned int)ranks.size() && !ranks[rp].isNull())
+		return ranks[rp];
+	if(rp >= (unsigned int)ranks.size())
+		ranks.resize(rp + 1);
 	if(rp < 26)
-	{
-		rp = 26 - rp;
-		return QString::number(rp) + QString("k");
-	}
+		ranks[rp] = StringPool::intern(QString::number(26 - rp) + QString("k"));
 	else
-	{
-		rp -= 25;
-		return QString::number(rp) + QString("d");
-	}
-	return QString("?");
+		ranks[rp] = StringPool::intern(QString::number(rp - 25) + QString("d"));
+	return ranks[rp];
 }
 
 unsigned int CyberOroConnection::rankToScore(QString rank)
@@ -3497,7 +3520,15 @@ unsigned int CyberOroConnection::rankToScore(QString rank)
 /* FIXME What are the other bits for ?!?!?!*/
 QString CyberOroConnection::getCountryFromCode(unsigned char code)
 {
+	static QString countries[16];		//pooled, built on first use
 	code &= 0x0f;
+	if(countries[code].isNull())
+		countries[code] = StringPool::intern(countryName(code));
+	return countries[code];
+}
+
+QString CyberOroConnection::countryName(unsigned char code)
+{
 	switch(code)
 	{
 		case 1:
@@ -3693,7 +3724,7 @@ void CyberOroConnection::handleRoomList(unsigned char * msg, unsigned int size)
 						/* add room to player, ORO is one room per player */
 						player->observing = number;
 						/* add player to room */
-						aGameListing->observer_list.push_back(player);
+						aGameListing->observer_list.insert(player);
 #ifdef RE_DEBUG
 						printf("Adding player %s %d to game %d\n", player->name.toLatin1().constData(), player->id, number);
 #endif //RE_DEBUG
@@ -3975,7 +4006,7 @@ void CyberOroConnection::handleGamesList(unsigned char * msg, unsigned int size)
 		setAttachedGame(white, aGameListing->number);
 	}
     if(p != (msg + size))
-        printf("gameslist3 error: %d %ld\n", size, p - msg);
+        qCWarning(logProtocol, "gameslist3 error: %d %ld", size, p - msg);
 }
 
 //0456
@@ -4010,14 +4041,15 @@ void CyberOroConnection::handlePlayerConnect(unsigned char * msg, unsigned int s
 	printf("id: %02x%02x\n", p[0], p[1]);
 #endif //RE_DEBUG
 	id = p[0] + (p[1] << 8);
-    aPlayer = room->getPlayerListing(id);
+	QString decodedName = serverCodec->toUnicode((const char *)name2, strlen((const char *)name2));
+    aPlayer = room->getPlayerListing(id, decodedName);
 	aPlayer->id = id;
 	//aPlayer->name = (char *)name;
 	if(strncmp((char *)name, "jguest", 6) == 0 || strncmp((char *)name, "jpguest", 7) == 0)
 		aPlayer->hidden = true;
 	else
 		aPlayer->hidden = false;
-	aPlayer->name = serverCodec->toUnicode((const char *)name2, strlen((const char *)name2));
+	aPlayer->name = decodedName;
 	aPlayer->notnickname = serverCodec->toUnicode((const char *)name, strlen((const char *)name));
 	/* It actually looks like this catches more unicode foreign names, then the
 	* second name.  But I get the feeling that one is the text username or
@@ -4047,7 +4079,7 @@ void CyberOroConnection::handlePlayerConnect(unsigned char * msg, unsigned int s
 	p += 4;
 	aPlayer->rank_score = p[0] + (p[1] << 8);
 	if(aPlayer->pro)
-		aPlayer->rank = QString::number(rankbyte & 0x1f) + QString("dp");
+		aPlayer->rank = StringPool::intern(QString::number(rankbyte & 0x1f) + QString("dp"));
 	else
 		aPlayer->rank = rating_pointsToRank(aPlayer->rank_score);
 #ifdef RE_DEBUG
@@ -4060,7 +4092,7 @@ void CyberOroConnection::handlePlayerConnect(unsigned char * msg, unsigned int s
 	printf("\n");
 #endif //RE_DEBUG
 	aPlayer->country = getCountryFromCode(p[2]);
-	aPlayer->info = getStatusFromCode(p[3], aPlayer->rank);
+	aPlayer->info = StringPool::intern(getStatusFromCode(p[3], aPlayer->rank));
 	aPlayer->nmatch_settings = QString("-") + QString::number(msg[23]) + " " + QString::number(p[0]) + QString(" ") + QString::number((p[1])) + QString(" ") + QString::number(p[2]) + QString(" ") + QString::number(p[3]) + QString::number(p[4]) + QString(" ") + QString::number((p[5])) + QString(" ") + QString::number(p[6]) + QString(" ") + QString::number(p[7]);
 	p += 8;	//other data;
 	aPlayer->observing = 0;		//necessary?
@@ -4105,7 +4137,7 @@ void CyberOroConnection::setAttachedGame(PlayerListing * const player, unsigned
             {
                 if(game->observer_list.size())
                 {
-                    game->white = game->observer_list[0];
+                    game->white = game->observer_list.first();
                     /* FIXME actually a game should never have no name, so I think when black leaves, black's name
                          * is replaced by white, but in our case, since we have white than black, we'd the opposite
                          * and then we have to pull up observernames, either alphabetical or in the order they joined
@@ -4146,7 +4178,7 @@ void CyberOroConnection::setAttachedGame(PlayerListing * const player, unsigned
 	{
 		game = getDefaultRoom()->getGameListing(game_id);
         //game->observers++;
-        game->observer_list.push_back(player);
+        game->observer_list.insert(player);
     }
 
 	if(player->observing && player->observing != game_id)
@@ -4272,13 +4304,13 @@ void CyberOroConnection::handleServerAnnouncementwithLink(unsigned char * msg, u
 	unsigned int len = 0;
 	while((msg[8 + len] || msg[9 + len])&& len + 8 < 260)
 		len += 2;
-	printf("Server anon len %d\n", len);
+	qCDebug(logProtocol, "Server anon len %d", len);
 	u = serverCodec->toUnicode((const char *)&(msg[8]), len);
 			//u = codec->toUnicode(b, size - 4);
 	len = 0;
 	while(msg[264 + len] && len + 264 < size)
 		len++;
-	printf("Server anon len2 %d\n", len);
+	qCDebug(logProtocol, "Server anon len2 %d", len);
 	link = QString((const char *)&(msg[264]));	//not unicode
 	if(console_dispatch)
 		console_dispatch->recvText("*** " + u + ": " + link);
@@ -4372,7 +4404,7 @@ void CyberOroConnection::handleRoomChat(unsigned char * msg, unsigned int size)
 		}
 	}
 	else
-		printf("unknown player says something");
+		qCWarning(logProtocol, "unknown player says something");
 	delete[] text;	
 }
 
@@ -4411,7 +4443,7 @@ void CyberOroConnection::handlePersonalChat(unsigned char * msg, unsigned int si
 		//	console_dispatch->recvText(player->name + "-> " + QString((char *)text));
 	}
 	else
-		printf("unknown player says something");
+		qCWarning(logProtocol, "unknown player says something");
 	delete[] text;
 }
 
@@ -4467,7 +4499,7 @@ void CyberOroConnection::handlePlayerRoomJoin(unsigned char * msg, unsigned int
 	{
 		game = room->getGameListing(room_number);
         game->observers++;
-        game->observer_list.push_back(aPlayer);
+        game->observer_list.insert(aPlayer);
         if(id == our_player_id)
 		{
 			if(game->gameData)		//only used on finished games where we won't receive info from server
@@ -4501,15 +4533,7 @@ void CyberOroConnection::removeObserverFromGameListing(const PlayerListing * p)
 		return;
 	}
 	game->observers--; 
-	for(std::vector<PlayerListing *>::iterator oblistit = game->observer_list.begin();
-		   oblistit != game->observer_list.end(); oblistit++)
-	{
-		if(*oblistit == p)
-		{
-			game->observer_list.erase(oblistit);
-			break;
-		}
-	}
+	game->observer_list.remove(p);
 	if(game->observers == 0 && !game->isBroadcast)
 	{
 		/* We should probably increment an observer count here, and
@@ -4770,14 +4794,14 @@ void CyberOroConnection::handleNewRoom(unsigned char * msg, unsigned int size)
     if(aGameListing->owner_id == our_player_id)
         setRoomNumber(aGameListing->number);
     aGameListing->observers++;
-    aGameListing->observer_list.push_back(white);
+    aGameListing->observer_list.insert(white);
 
 	p += 2;
 	id = p[0] + (p[1] << 8);
 	black = room->getPlayerListing(id);
 	if(!black)
 	{
-		printf("can't get black player: %02x%02x\n", p[0], p[1]);
+		qCWarning(logProtocol, "can't get black player: %02x%02x", p[0], p[1]);
 		//return;		//not an issue
 	}
 	else
@@ -4787,7 +4811,7 @@ void CyberOroConnection::handleNewRoom(unsigned char * msg, unsigned int size)
 		if(id == our_player_id)
 			setRoomNumber(aGameListing->number);
 		aGameListing->observers++;
-		aGameListing->observer_list.push_back(black);
+		aGameListing->observer_list.insert(black);
 	}
 	/* FIXME, no recv, no game yet, maybe there should be. */
 	aGameListing->white = white;
@@ -4852,7 +4876,7 @@ void CyberOroConnection::handleGameMsg(unsigned char * msg, unsigned int size)
 #endif //RE_DEBUG
 	if(!black || !white)
 	{
-		printf("%d gamecode game is missing black or white\n", game_code);
+		qCDebug(logProtocol, "%d gamecode game is missing black or white", game_code);
 		return;
 	}
 	/* If there's a rematch, we might be able to just use
@@ -4897,7 +4921,7 @@ void CyberOroConnection::handleGameMsg(unsigned char * msg, unsigned int size)
 	
 	if(!aGameListing)
 	{
-		printf("No 0a7d for this game\n");
+		qCWarning(logProtocol, "No 0a7d for this game");
 		return;
 		/* FIXME, if there's no room, we can't add the game. */
 	}
@@ -5587,7 +5611,7 @@ void CyberOroConnection::handleMsg2(unsigned char * msg, unsigned int size)
 		p += 18;
 	}
 	if(p != (msg + size))
-		printf("Weird msg length: %d at line %d\n", size, __LINE__);
+		qCWarning(logProtocol, "Weird msg length: %d at line %d", size, __LINE__);
 }
 
 //0x69c3:
@@ -5801,7 +5825,7 @@ void CyberOroConnection::handleResign(unsigned char * msg, unsigned int size)
 		gr = boarddispatch->getGameData();
 		if(!gr)
 		{
-			printf("Can't get game record for resign msg\n");
+			qCWarning(logProtocol, "Can't get game record for resign msg");
 			return;
 		}
 		aGameResult.result = GameResult::RESIGN;
@@ -5919,7 +5943,7 @@ void CyberOroConnection::handleRemoveStones(unsigned char * msg, unsigned int si
 	boarddispatch = getIfBoardDispatch(game_number);
 	if(!boarddispatch)
 	{
-		printf("Can't get board dispatch for remove stones for %02x%02x\n", p[0], p[1]);
+		qCWarning(logProtocol, "Can't get board dispatch for remove stones for %02x%02x", p[0], p[1]);
 		return;
 	}
 	p += 2;
@@ -6018,7 +6042,7 @@ void CyberOroConnection::handleStonesDone(unsigned char * msg, unsigned int /*si
 	boarddispatch = getIfBoardDispatch(game_number);
 	if(!boarddispatch)
 	{
-		printf("Can't get board dispatch for remove stones for %02x%02x\n", p[0], p[1]);
+		qCWarning(logProtocol, "Can't get board dispatch for remove stones for %02x%02x", p[0], p[1]);
 		return;
 	}
 	p += 2;
@@ -6101,7 +6125,7 @@ void CyberOroConnection::handleScore(unsigned char * msg, unsigned int /*size*/)
 	boarddispatch = getIfBoardDispatch(game_id);
 	if(!boarddispatch)
 	{
-		printf("Can't get board dispatch for remove stones for %02x%02x\n", p[0], p[1]);
+		qCWarning(logProtocol, "Can't get board dispatch for remove stones for %02x%02x", p[0], p[1]);
 		return;
 	}
 	p += 2;
@@ -6124,7 +6148,7 @@ void CyberOroConnection::handleScore(unsigned char * msg, unsigned int /*size*/)
 	{
 		if(!match_negotiation_state->doneCounting())
 		{
-			printf("Not done counting and e7b3\n");
+			qCDebug(logProtocol, "Not done counting and e7b3");
 			return;
 		}
 	}
@@ -6646,6 +6670,7 @@ void CyberOroConnection::handleMoveList(unsigned char * msg, unsigned int size)
 		aMove->color = stoneWhite;
 	else
 		aMove->color = stoneBlack;
+	boarddispatch->beginMoveBatch();
 	for(i = 1; i < number_of_moves + 1; i++)
 	{
 		//aMove->color = stoneNone;	//keep resetting this
@@ -6680,7 +6705,7 @@ void CyberOroConnection::handleMoveList(unsigned char * msg, unsigned int size)
 	 * we crash during score mode, we get a separate message to enter score mode */
 	if(enterScore && !match_negotiation_state->isOurGame(game_number))
 	{
-		printf("Enter score mode, not our game\n");
+		qCDebug(logProtocol, "Enter score mode, not our game");
 		boarddispatch->recvEnterScoreMode();
 		match_negotiation_state->enterScoreMode();
 	}
@@ -6727,6 +6752,7 @@ void CyberOroConnection::handleMoveList2(unsigned char * msg, unsigned int size)
 	//player = room->getPlayerListing(p[0] + (p[1] << 8));
 	aMove->flags = MoveRecord::NONE;
 	//for(i = (aGameData->handicap ? 1 : 0) ; i < number_of_moves + (aGameData->handicap ? 1 : 0); i++)
+	boarddispatch->beginMoveBatch();
 	for(i = 1; i < number_of_moves + 1; i++)
 	{
 		
@@ -6771,7 +6797,7 @@ void CyberOroConnection::handleInvitationSettings(unsigned char * msg, unsigned
 #endif //RE_DEBUG
 	p += 2;
 	//3rd byte after name is invitation settings
-	player->info = getStatusFromCode(p[2], player->rank);
+	player->info = StringPool::intern(getStatusFromCode(p[2], player->rank));
 	
 }
 
@@ -6914,7 +6940,7 @@ void CyberOroConnection::handleMatchOpened(unsigned char * msg, unsigned int siz
 	game_id = msg[2] + (msg[3] << 8);
 	game_number = game_code_to_number[game_id];
 	if(!game_number)
-		printf("No game number for %02x%02x\n", msg[2], msg[3]);
+		qCWarning(logProtocol, "No game number for %02x%02x", msg[2], msg[3]);
 	/* FIXME, its apparently possible to get this on a match we're
 	 * already observing for some reason... if we haven't set a connecting
 	 * to number, this causes us to create an unnecessary board */
@@ -6931,7 +6957,7 @@ void CyberOroConnection::handleMatchOpened(unsigned char * msg, unsigned int siz
 	{
 		if(connecting_to_game_number != game_number)
 		{
-			printf("Received unexpected d2af\n");
+			qCDebug(logProtocol, "Received unexpected d2af");
 		}
 		else
 			connecting_to_game_number = 0;
@@ -6998,7 +7024,7 @@ void CyberOroConnection::handleMatchOpened(unsigned char * msg, unsigned int siz
 					GameListing * listing = room->getGameListing(game_number);
 					delete listing->gameData;
 					listing->gameData = 0;
-					printf("our rematch\n");
+					qCDebug(logProtocol, "our rematch");
 					NetworkConnection::closeBoardDispatch(game_number);
 					aGameData = 0;
 				}
@@ -7038,7 +7064,7 @@ void CyberOroConnection::handleMatchOpened(unsigned char * msg, unsigned int siz
 				GameListing * listing = room->getGameListing(game_number);
 				delete listing->gameData;
 				listing->gameData = 0;
-				printf("observer rematch\n");
+				qCDebug(logProtocol, "observer rematch");
 				NetworkConnection::closeBoardDispatch(game_number);
 				aGameData = 0;
 			}
@@ -7108,7 +7134,7 @@ void CyberOroConnection::handleMatchOpened(unsigned char * msg, unsigned int siz
 			board_size = 5;
 			break;
 		default:
-			printf("Strange boardsize indicator: %02x\n", p[0]);
+			qCWarning(logProtocol, "Strange boardsize indicator: %02x", p[0]);
 			board_size = 19;
 			break;
 	}
@@ -7259,7 +7285,7 @@ void CyberOroConnection::addObserverListToBoard(BoardDispatch * boarddispatch)
 	if(game->observers != game->observer_list.size())
 		qDebug("Observers and observer list size mismatch on game %d!! (%d != %d)", boarddispatch->getGameData()->number, game->observers, game->observer_list.size());
 #endif //RE_DEBUG
-	for(std::vector<PlayerListing *>::iterator oblistit = game->observer_list.begin();
+	for(ObserverSet::const_iterator oblistit = game->observer_list.begin();
 		oblistit != game->observer_list.end(); oblistit++)
 		boarddispatch->recvObserver(*oblistit, true);
 }
@@ -7292,7 +7318,7 @@ void CyberOroConnection::handleObserveAfterJoining(unsigned char * msg, unsigned
 	bool send_handicap_move = false;
 	bool white_in_byoyomi, black_in_byoyomi;*/
 	
-	printf("FIXME handleObserveAfterJoining size: %d\n", size);
+	qCWarning(logProtocol, "FIXME handleObserveAfterJoining size: %d", size);
 	
 	player = room->getPlayerListing(p[0] + (p[1] << 8));
 #ifdef FIXME
@@ -7403,7 +7429,7 @@ void CyberOroConnection::handleMatchOffer(unsigned char * msg, unsigned int size
 			mr.board_size = 5;
 			break;
 		default:
-			printf("Strange boardsize indicator: %02x\n", p[0]);
+			qCWarning(logProtocol, "Strange boardsize indicator: %02x", p[0]);
 			break;
 	}
 #ifdef RE_DEBUG
@@ -7450,7 +7476,7 @@ void CyberOroConnection::handleMatchOffer(unsigned char * msg, unsigned int size
 			mr.timeSystem = tvasia;
 			break;
 		default:
-			printf("Unknown time style indicator %02x\n", p[1]);
+			qCWarning(logProtocol, "Unknown time style indicator %02x", p[1]);
 			break;
 	}
 	mr.stones_periods = periods;
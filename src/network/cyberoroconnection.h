@@ -23,6 +23,7 @@
 #include <QtNetwork>
 #include "networkconnection.h"
 #include "messages.h"
+#include "packetframer.h"
 #include <vector>
 
 class BoardDispatch;
@@ -155,11 +156,13 @@ class CyberOroConnection : public NetworkConnection
 		void encode(unsigned char * h, unsigned int cycle_size);
 		void handleMessage(QString msg);
 		void handleMessage(unsigned char * msg, unsigned int size);
+		virtual unsigned int outgoingMessageType(const char * packet, unsigned int size);
 		void handleCodeTable(unsigned char * msg, unsigned int size);
 		void handleConnected(unsigned char * msg, unsigned int size);
 		void handlePlayerList(unsigned char * msg, unsigned int size);
 		QString rating_pointsToRank(unsigned int rp);
 		QString getCountryFromCode(unsigned char code);
+		QString countryName(unsigned char code);
 		void handleRoomList(unsigned char * msg, unsigned int size);
 		void handleBroadcastGamesList(unsigned char * msg, unsigned int size);
 		int getPhase(unsigned char byte);
@@ -241,6 +244,8 @@ class CyberOroConnection : public NetworkConnection
 		unsigned char * challenge_response;
 		unsigned char * codetable;
 		unsigned int codetable_IV, codetable_IV2;
+		int encoded_type;		//type of the packet last encoded, -1 once written
+		PacketFramer packetFramer;
 		
 		QuickConnection * metaserverQC;
 		
@@ -0,0 +1,157 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#include <QtWidgets>
+#include "diagnosticsdialog.h"
+#include "networkconnection.h"
+#include "logging.h"
+#include "../defines.h"
+
+DiagnosticsDialog::DiagnosticsDialog(NetworkConnection * c, QWidget * parent) : QDialog(parent), connection(c)
+{
+	summaryLabel = new QLabel();
+	summaryLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+
+	messageTable = new QTableWidget(0, 7);
+	messageTable->setHorizontalHeaderLabels(QStringList() << tr("Type") << tr("In") << tr("Bytes in")
+			<< tr("Out") << tr("Bytes out") << tr("Handler ms") << tr("Max us"));
+	messageTable->verticalHeader()->hide();
+	messageTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+	messageTable->setSelectionMode(QAbstractItemView::NoSelection);
+	messageTable->setShowGrid(false);
+
+	resetButton = new QPushButton(tr("Reset"));
+	saveButton = new QPushButton(tr("Save..."));
+	saveLogButton = new QPushButton(tr("Save Log..."));
+	saveLogButton->setToolTip(tr("Save the last %1 log lines").arg(LOG_RING_SIZE));
+	closeButton = new QPushButton(tr("Close"));
+	closeButton->setDefault(true);
+	connect(resetButton, SIGNAL(clicked()), this, SLOT(slot_reset()));
+	connect(saveButton, SIGNAL(clicked()), this, SLOT(slot_save()));
+	connect(saveLogButton, SIGNAL(clicked()), this, SLOT(slot_saveLog()));
+	connect(closeButton, SIGNAL(clicked()), this, SLOT(accept()));
+
+	QHBoxLayout * buttonLayout = new QHBoxLayout;
+	buttonLayout->addWidget(resetButton);
+	buttonLayout->addWidget(saveButton);
+	buttonLayout->addWidget(saveLogButton);
+	buttonLayout->addStretch();
+	buttonLayout->addWidget(closeButton);
+
+	QVBoxLayout * mainLayout = new QVBoxLayout;
+	mainLayout->addWidget(summaryLabel);
+	mainLayout->addWidget(messageTable);
+	mainLayout->addLayout(buttonLayout);
+	setLayout(mainLayout);
+
+	setWindowTitle(tr("Connection Diagnostics"));
+	resize(560, 480);
+	refresh();
+	refreshTimerId = startTimer(DIAGNOSTICS_REFRESH);
+}
+
+DiagnosticsDialog::~DiagnosticsDialog()
+{
+	killTimer(refreshTimerId);
+}
+
+void DiagnosticsDialog::timerEvent(QTimerEvent *)
+{
+	refresh();
+}
+
+/* Round trip is server plus wire, handler time is ours, if the first
+ * is fine and the second is large the lag is on this end */
+void DiagnosticsDialog::refresh(void)
+{
+	if(!connection)
+	{
+		summaryLabel->setText(tr("Connection closed"));
+		resetButton->setEnabled(false);
+		saveButton->setEnabled(false);
+		return;
+	}
+	const ConnectionMetrics & m = connection->getMetrics();
+	ConnectionMetrics::MessageStats total = m.getTotals();
+	summaryLabel->setText(tr("Move round trip: %1 ms last, %2 ms average, %3-%4 ms over %5 moves\n"
+				"Handler time: %6 ms for %7 messages in %8 s\n"
+				"Waiting on socket: %9 bytes, %10 at most, %11 messages per read at most")
+			.arg(m.getRoundTripLast()).arg(m.getRoundTripAverage())
+			.arg(m.getRoundTripMin()).arg(m.getRoundTripMax()).arg(m.getRoundTripSamples())
+			.arg(total.nsecs / 1000000.0, 0, 'f', 1).arg(total.in).arg(m.getElapsed() / 1000)
+			.arg(m.getBacklogLast()).arg(m.getBacklogMax()).arg(m.getBatchMax()));
+
+	QList<unsigned int> types = m.getTypes();
+	messageTable->setRowCount(types.size());
+	for(int i = 0; i < types.size(); i++)
+	{
+		ConnectionMetrics::MessageStats s = m.getStats(types[i]);
+		QStringList row;
+		row << m.typeName(types[i]) << QString::number(s.in) << QString::number(s.bytes_in)
+			<< QString::number(s.out) << QString::number(s.bytes_out)
+			<< QString::number(s.nsecs / 1000000.0, 'f', 2) << QString::number(s.max_nsecs / 1000);
+		for(int j = 0; j < row.size(); j++)
+		{
+			QTableWidgetItem * item = messageTable->item(i, j);
+			if(!item)
+			{
+				item = new QTableWidgetItem();
+				if(j)
+					item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+				messageTable->setItem(i, j, item);
+			}
+			item->setText(row[j]);
+		}
+	}
+}
+
+void DiagnosticsDialog::slot_reset(void)
+{
+	if(connection)
+		connection->getMetrics().reset();
+	refresh();
+}
+
+void DiagnosticsDialog::slot_save(void)
+{
+	if(!connection)
+		return;
+	QString csvFilter = tr("CSV (*.csv)");
+	QString filter;
+	QString filename = QFileDialog::getSaveFileName(this, tr("Save Diagnostics"), QString(),
+					tr("JSON (*.json)") + ";;" + csvFilter, &filter);
+	if(filename.isEmpty())
+		return;
+	if(QFileInfo(filename).suffix().isEmpty())
+		filename += (filter == csvFilter ? ".csv" : ".json");
+	if(!connection || !connection->getMetrics().dump(filename))
+		QMessageBox::warning(this, tr("Save Diagnostics"), tr("Can't write %1").arg(filename));
+}
+
+void DiagnosticsDialog::slot_saveLog(void)
+{
+	QString filename = QFileDialog::getSaveFileName(this, tr("Save Log"), "qgo.log");
+	if(filename.isEmpty())
+		return;
+	if(!Log::dump(filename))
+		QMessageBox::warning(this, tr("Save Log"), tr("Can't write %1").arg(filename));
+}
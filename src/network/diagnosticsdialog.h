@@ -0,0 +1,60 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#ifndef DIAGNOSTICSDIALOG_H
+#define DIAGNOSTICSDIALOG_H
+
+#include <QDialog>
+#include <QPointer>
+
+class NetworkConnection;
+class QLabel;
+class QTableWidget;
+class QPushButton;
+
+/* Live view of a connection's ConnectionMetrics, refreshed while open */
+class DiagnosticsDialog : public QDialog
+{
+	Q_OBJECT
+	public:
+		DiagnosticsDialog(NetworkConnection * c, QWidget * parent = 0);
+		~DiagnosticsDialog();
+	protected:
+		virtual void timerEvent(QTimerEvent *);
+	private slots:
+		void slot_reset(void);
+		void slot_save(void);
+		void slot_saveLog(void);
+	private:
+		void refresh(void);
+
+		QPointer<NetworkConnection> connection;
+		QLabel * summaryLabel;
+		QTableWidget * messageTable;
+		QPushButton * resetButton;
+		QPushButton * saveButton;
+		QPushButton * saveLogButton;
+		QPushButton * closeButton;
+		int refreshTimerId;
+};
+
+#endif //DIAGNOSTICSDIALOG_H
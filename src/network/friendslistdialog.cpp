@@ -92,11 +92,11 @@ void FriendsListDialog::populateLists(void)
 	  * the friends lists are a lower priority than getting
 	  * games playing on all three services */ 
 	
-	std::vector<FriendWatchListing *> & friends = connection->getFriendsList();
-	std::vector<FriendWatchListing *> & watches = connection->getWatchesList();
-	std::vector<FriendWatchListing *> & blocked = connection->getBlockedList();
+	FriendWatchList & friends = connection->getFriendsList();
+	FriendWatchList & watches = connection->getWatchesList();
+	FriendWatchList & blocked = connection->getBlockedList();
 	
-	std::vector<FriendWatchListing *>::iterator i;
+	FriendWatchList::iterator i;
 	PlayerListing * p;
 	for(i = friends.begin(); i != friends.end(); i++)
 	{
@@ -0,0 +1,116 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#include "gamearchiver.h"
+#include "gamedata.h"
+#include "playergamelistings.h"
+#include "room.h"
+#include "tree.h"
+
+/* one observe request per tick and a fresh games list every minute */
+#define ARCHIVE_TICK_MSECS		500
+#define ARCHIVE_REFRESH_TICKS		120
+
+GameArchiver::GameArchiver(const QString & d, bool all, int max) :
+	directory(d), observe_all(all), max_games(max), ticks(0), saved(0)
+{
+	if(!QDir().mkpath(directory))
+		qWarning("Can't create archive directory %s", directory.toLatin1().constData());
+	timer = new QTimer(this);
+	connect(timer, SIGNAL(timeout()), SLOT(slot_timeout()));
+	timer->start(ARCHIVE_TICK_MSECS);
+}
+
+/* Called for every new connection, but we only observe on the main one */
+void GameArchiver::watch(NetworkConnection * c)
+{
+	if(!observe_all || connection)
+		return;
+	connection = c;
+	connect(c, SIGNAL(gameListingReceived(GameListing *)), SLOT(slot_gameListingReceived(GameListing *)));
+}
+
+bool GameArchiver::saveGame(GameData * gameData, Tree * tree)
+{
+	QString base = directory + "/" + QDate::currentDate().toString("yyyy-MM-dd") + "-" +
+			gameData->white_name + "-" + gameData->black_name + "-" + QString::number(gameData->number);
+	QString fileName = base + ".sgf";
+	int i = 1;
+	while(QFile(fileName).exists())
+		fileName = base + "-" + QString::number(i++) + ".sgf";
+	gameData->fileName = fileName;
+
+	QString SGF = tree->exportSGFString(gameData);
+	QFile file(fileName);
+	if(!file.open(QIODevice::WriteOnly))
+	{
+		qWarning("Could not open file: %s", fileName.toLatin1().constData());
+		return false;
+	}
+	file.write(SGF.toLatin1());
+	file.close();
+	saved++;
+	qDebug("Archived game %d as %s, %d so far", gameData->number, fileName.toLatin1().constData(), saved);
+	return true;
+}
+
+/* The protocol code still uses the dispatch after passing it the result,
+ * so it can't be closed from recvResult */
+void GameArchiver::closeLater(NetworkConnection * c, unsigned int game_id)
+{
+	pending_closes.append(qMakePair(QPointer<NetworkConnection>(c), game_id));
+	QTimer::singleShot(0, this, SLOT(slot_timeout()));
+}
+
+void GameArchiver::slot_gameListingReceived(GameListing * l)
+{
+	if(!l->running || l->isRoomOnly || pending_observes.contains(l->number))
+		return;
+	if(connection->getIfBoardDispatch(l->number))
+		return;
+	pending_observes.enqueue(l->number);
+}
+
+void GameArchiver::slot_timeout(void)
+{
+	while(!pending_closes.isEmpty())
+	{
+		QPair<QPointer<NetworkConnection>, unsigned int> p = pending_closes.takeFirst();
+		if(p.first)
+			p.first->closeBoardDispatch(p.second);
+	}
+	if(!connection || connection->getConnectionState() != CONNECTED)
+		return;
+	if(sender() != timer)
+		return;
+	if(ticks++ % ARCHIVE_REFRESH_TICKS == 0)
+		connection->sendGamesRequest();
+	while(!pending_observes.isEmpty() && connection->getBoardDispatches() < max_games)
+	{
+		/* Gone from the list if the room was rebuilt meanwhile */
+		GameListing * l = connection->getDefaultRoom()->getIfGameListing(pending_observes.dequeue());
+		if(!l || !l->running || connection->getIfBoardDispatch(l->number))
+			continue;
+		connection->sendObserve(l);
+		break;
+	}
+}
@@ -0,0 +1,59 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#ifndef GAMEARCHIVER_H
+#define GAMEARCHIVER_H
+#include <QtCore>
+#include "networkconnection.h"
+
+class GameData;
+class Tree;
+
+/* With --archive, observed games don't get a BoardWindow.  Their
+ * BoardDispatch feeds the moves into a bare Tree instead and hands it
+ * here to be written out as SGF when the result comes in.  With
+ * --archive-all we also observe every running game on the server, a
+ * few at a time since IGS doesn't number its observe replies. */
+class GameArchiver : public QObject
+{
+	Q_OBJECT
+
+	public:
+		GameArchiver(const QString & d, bool all, int max);
+		void watch(NetworkConnection * c);
+		bool saveGame(GameData * gameData, Tree * tree);
+		void closeLater(NetworkConnection * c, unsigned int game_id);
+	private slots:
+		void slot_gameListingReceived(GameListing * l);
+		void slot_timeout(void);
+	private:
+		QString directory;
+		bool observe_all;
+		int max_games;
+		QPointer<NetworkConnection> connection;
+		QQueue<unsigned int> pending_observes;
+		QList<QPair<QPointer<NetworkConnection>, unsigned int> > pending_closes;
+		QTimer * timer;
+		int ticks;
+		int saved;
+};
+#endif //GAMEARCHIVER_H
@@ -31,6 +31,8 @@
 #include "gamedialogflags.h"
 #include "playergamelistings.h"
 #include "matchnegotiationstate.h"
+#include "stringpool.h"
+#include "logging.h"
 
 #define PLAYERSLISTREFRESH_SECONDS		300
 #define GAMESLISTREFRESH_SECONDS		180
@@ -84,7 +86,7 @@ void IGSConnection::sendText(QString text)
 	// FIXME We're getting some nonsense on the end of this sometimes for
 	// some reason
 	//text += "\r\n";
-	qDebug("sendText: %s", text.toLatin1().constData());
+	qCDebug(logProtocol, "sendText: %s", text.toLatin1().constData());
 	QByteArray raw = textCodec->fromUnicode(text);
 	if(write(raw.data(), raw.size()) < 0)
 		qWarning("*** failed sending to host: %s", raw.data());
@@ -608,7 +610,7 @@ void IGSConnection::handleLogin(QString msg)
  * be called earlier */
 void IGSConnection::handlePassword(QString msg)
 {
-	qDebug(":%d %s\n", msg.size(), msg.toLatin1().constData());
+	qCDebug(logProtocol, ":%d %s", msg.size(), msg.toLatin1().constData());
 	if(msg.contains("Password:") > 0 || msg.contains("1 1") > 0)
 	{
 		qDebug("Password prompt or 1 1 found");
@@ -912,6 +914,7 @@ void IGSConnection::handleMessage(QString msg)
 		type *= 10;
 		type += (int)msg[1].toLatin1() - '0';
 	}
+	ConnectionMetrics::Handler timed(metrics, type, msg.size());
 	
 	if(needToSendClientToggle)
 		onAuthenticationNegotiated();
@@ -1525,7 +1528,7 @@ void IGSConnection::handle_games(QString line)
 //	case 8:
 void IGSConnection::handle_file(QString line)
 {
-	qDebug("%s", line.toLatin1().constData());
+	qCDebug(logProtocol, "%s", line.toLatin1().constData());
 #ifdef FIXME
 	if (!memory_str.isEmpty() && memory_str.contains("File"))
 	{
@@ -1970,7 +1973,7 @@ void IGSConnection::handle_info(QString line)
 			//9 yfh2test declines undo
 	else if (line.contains("declines undo"))
 	{
-		qDebug("%s", line.toLatin1().constData());	//FIXME
+		qCDebug(logProtocol, "%s", line.toLatin1().constData());	//FIXME
 				// not the cleanest way : we should send this to a message box
 		//emit signal_kibitz(0, element(line, 0, " "), line);
 		return;
@@ -2559,9 +2562,7 @@ void IGSConnection::handle_info(QString line)
 				
 	else if (line.contains("Rating:"))
 	{
-		statsPlayer->rank = element(line, 1, " ");
-		fixRankString(&(statsPlayer->rank));
-		statsPlayer->rank_score = rankToScore(statsPlayer->rank);
+		setPlayerRank(statsPlayer, element(line, 1, " "));
 		return;
 	}
 			
@@ -2636,9 +2637,7 @@ void IGSConnection::handle_info(QString line)
 				
 	else if (line.left(5) == "19x19")     //LGS syntax
 	{
-		statsPlayer->rank = element(line, 4, " ");
-		fixRankString(&(statsPlayer->rank));
-		statsPlayer->rank_score = rankToScore(statsPlayer->rank);
+		setPlayerRank(statsPlayer, element(line, 4, " "));
 		statsPlayer->rated_games = element(line, 7, " ").toInt();
 		return;
 	}
@@ -2717,7 +2716,7 @@ void IGSConnection::handle_kibitz(QString line)
 		// 14 File
 void IGSConnection::handle_messages(QString line)
 {
-	qDebug("%s", line.toLatin1().constData());
+	qCDebug(logProtocol, "%s", line.toLatin1().constData());
 #ifdef FIXME	
 		//case 14:
 	if (!memory_str.isEmpty() && memory_str.contains("File"))
@@ -2746,7 +2745,7 @@ void IGSConnection::handle_move(QString line)
 {
 	BoardDispatch * boarddispatch;
 		//case 15:
-    qDebug("%s", line.toLatin1().constData());
+    qTrace(logProtocol, "%s", line.toLatin1().constData());
 	line = line.remove(0, 2).trimmed();	
 	static bool need_time = false;	
 	int number;
@@ -3011,7 +3010,11 @@ void IGSConnection::handle_move(QString line)
 		aMove->number = element(line, 0, "(").toInt();
 		QString point = element(line, 0, " ", "EOL");
 		if(aMove->number == 0)
+		{
 			r->move_list_received = true;
+			/* the rest of the list is likely already buffered */
+			boarddispatch->beginMoveBatch();
+		}
 		else if(!r->move_list_received)
 		{
 			delete aMove;
@@ -3167,9 +3170,7 @@ void IGSConnection::handle_shout(QString line)
 				//line.replace(QRegExp(" "), "");
 		QString name = element(line, 0, "{", " ");
         PlayerListing * aPlayer = room->getPlayerListing(name);
-		aPlayer->rank = element(line, 0, "[", "]", true);
-		fixRankString(&(aPlayer->rank));
-		aPlayer->rank_score = rankToScore(aPlayer->rank);
+		setPlayerRank(aPlayer, element(line, 0, "[", "]", true));
 		aPlayer->info = "??";
 		aPlayer->playing = 0;
 		aPlayer->observing = 0;
@@ -3425,7 +3426,7 @@ void IGSConnection::handle_shout(QString line)
 
 void IGSConnection::handle_status(QString line)
 {
-	qDebug("%s", line.toLatin1().constData());
+	qCDebug(logProtocol, "%s", line.toLatin1().constData());
 	line = line.remove(0, 2).trimmed();
 		// CURRENT GAME STATUS
 		// 22 Pinkie  3d* 21 218 9 T 5.5 0
@@ -3558,7 +3559,7 @@ void IGSConnection::handle_status(QString line)
 
 void IGSConnection::handle_stored(QString line)
 {
-	qDebug("%s", line.toLatin1().constData());
+	qCDebug(logProtocol, "%s", line.toLatin1().constData());
 		// STORED
 		// 9 Stored games for frosla:
 		// 23           frosla-physician
@@ -3579,7 +3580,7 @@ void IGSConnection::handle_tell(QString line)
 		//  24 --> frosla  Hallo
 		//case 24:
 		//{
-	qDebug("24: %s", line.toLatin1().constData());
+	qCDebug(logProtocol, "24: %s", line.toLatin1().constData());
 	int pos;
 	BoardDispatch * boarddispatch;
 #ifdef FIXME
@@ -3641,7 +3642,7 @@ void IGSConnection::handle_tell(QString line)
 			boarddispatch = getBoardDispatch(protocol_save_int);
 			if(!boarddispatch)
 			{
-				printf("No boarddispatch for undo message");
+				qCWarning(logProtocol, "No boarddispatch for undo message");
 				return;
 			}
 			MoveRecord * aMove = new MoveRecord();
@@ -3694,7 +3695,7 @@ void IGSConnection::handle_thist(QString line)
 {
 	//FIXME if this is something that happens then
 	// we should be picking it up
-	qDebug("%s", line.toLatin1().constData());
+	qCDebug(logProtocol, "%s", line.toLatin1().constData());
 }
 		// who
 		// 27  Info Name Idle Rank | Info Name Idle Rank
@@ -3750,29 +3751,18 @@ void IGSConnection::handle_who(QString line)
 			QString name = line.mid(15,11).trimmed();
             aPlayer = room->getPlayerListing(name);
 			aPlayer->online = true;
-			aPlayer->info = info;
+			aPlayer->info = StringPool::intern(info);
 			aPlayer->observing = observing;
 			aPlayer->playing = playing;
-			aPlayer->idletime = line.mid(26,3);
-			aPlayer->seconds_idle = idleTimeToSeconds(aPlayer->idletime);
+			setPlayerIdle(aPlayer, line.mid(26,3));
 					//aPlayer->nmatch = false;
 			if (line[33] == ' ')
 			{
-				if (line[36] == ' ')
-					aPlayer->rank = line.mid(34,2);
-				else
-					aPlayer->rank = line.mid(34,3);
-				fixRankString(&(aPlayer->rank));
-				aPlayer->rank_score = rankToScore(aPlayer->rank);
+				setPlayerRank(aPlayer, line.mid(34, line[36] == ' ' ? 2 : 3));
 			}
 			else
 			{
-				if (line[36] == ' ')
-					aPlayer->rank = line.mid(33,3);
-				else
-					aPlayer->rank = line.mid(33,4);
-				fixRankString(&(aPlayer->rank));
-				aPlayer->rank_score = rankToScore(aPlayer->rank);
+				setPlayerRank(aPlayer, line.mid(33, line[36] == ' ' ? 3 : 4));
 			}
 					
 					// check if line ok, true -> cmd "players" preceded
@@ -3795,29 +3785,18 @@ void IGSConnection::handle_who(QString line)
 			QString name = line.mid(52,11).trimmed();
             aPlayer = room->getPlayerListing(name);
 			aPlayer->online = true;
-			aPlayer->info = info;
+			aPlayer->info = StringPool::intern(info);
 			aPlayer->observing = observing;
 			aPlayer->playing = playing;
-			aPlayer->idletime = line.mid(63,3);
-			aPlayer->seconds_idle = idleTimeToSeconds(aPlayer->idletime);
+			setPlayerIdle(aPlayer, line.mid(63,3));
 					//aPlayer->nmatch = false;
 			if (line[70] == ' ')
 			{
-				if (line[73] == ' ')
-					aPlayer->rank = line.mid(71,2);
-				else
-					aPlayer->rank = line.mid(71,3);
-				fixRankString(&(aPlayer->rank));
-				aPlayer->rank_score = rankToScore(aPlayer->rank);
+				setPlayerRank(aPlayer, line.mid(71, line[73] == ' ' ? 2 : 3));
 			}
 			else
 			{
-				if (line[73] == ' ')
-					aPlayer->rank = line.mid(70,3);
-				else
-					aPlayer->rank = line.mid(70,4);
-				fixRankString(&(aPlayer->rank));
-				aPlayer->rank_score = rankToScore(aPlayer->rank);
+				setPlayerRank(aPlayer, line.mid(70, line[73] == ' ' ? 3 : 4));
 			}
 
 					// true -> cmd "players" preceded
@@ -3838,7 +3817,7 @@ void IGSConnection::handle_undo(QString line)
 		//case 28:
 {
 	BoardDispatch * boarddispatch;
-	qDebug("*** %s", line.toLatin1().constData());
+	qCDebug(logProtocol, "*** %s", line.toLatin1().constData());
 	line = line.remove(0, 2).trimmed();
 	if (line.contains("undid the last "))
 	{
@@ -3916,7 +3895,7 @@ void IGSConnection::handle_yell(QString line)
 	 * never hooked up to anything.  The talk should be
 	 * hooked up to something, but this is a FIXME*/
 	QString e1,e2;
-	qDebug("%s\n", line.toLatin1().constData());
+	qCDebug(logProtocol, "%s", line.toLatin1().constData());
 	line = line.remove(0, 2).trimmed();
 	if (line.contains("Changing into channel"))
 	{
@@ -4129,12 +4108,10 @@ void IGSConnection::handle_userlist(QString line)
 	if(aPlayer->extInfo == "")
 		aPlayer->extInfo = "<None>";
 
-	aPlayer->country = re3.cap(1).trimmed();
+	aPlayer->country = StringPool::intern(re3.cap(1).trimmed());
 	if(aPlayer->country == "--")
 		aPlayer->country = "";
-	aPlayer->rank = re3.cap(2).trimmed();
-	fixRankString(&(aPlayer->rank));
-	aPlayer->rank_score = rankToScore(aPlayer->rank);
+	setPlayerRank(aPlayer, re3.cap(2).trimmed());
 	aPlayer->wins = re3.cap(3).trimmed().toInt();
 	aPlayer->losses = re3.cap(4).trimmed().toInt();
 	aPlayer->observing = re3.cap(5).trimmed().toInt();
@@ -4590,6 +4567,31 @@ void IGSConnection::fixRankString(QString * rank)
 #endif //IGS_OLDRATING
 }
 
+/* Ranks come from a small set, so the fixed string and its score are
+ * worked out once per rank seen and shared by every listing */
+void IGSConnection::setPlayerRank(PlayerListing * player, const QString & rank)
+{
+	QHash<QString, QPair<QString, unsigned int> >::const_iterator i = rankCache.constFind(rank);
+	if(i == rankCache.constEnd())
+	{
+		QString fixed = rank;
+		fixRankString(&fixed);
+		i = rankCache.insert(rank, qMakePair(StringPool::intern(fixed), rankToScore(fixed)));
+	}
+	player->rank = i->first;
+	player->rank_score = i->second;
+}
+
+/* Same for idle times */
+void IGSConnection::setPlayerIdle(PlayerListing * player, const QString & idle)
+{
+	QHash<QString, QPair<QString, unsigned int> >::const_iterator i = idleCache.constFind(idle);
+	if(i == idleCache.constEnd())
+		i = idleCache.insert(idle, qMakePair(StringPool::intern(idle), idleTimeToSeconds(idle)));
+	player->idletime = i->first;
+	player->seconds_idle = i->second;
+}
+
 PlayerListing * IGSConnection::getPlayerListingNeverFail(QString & name)
 {
     return getDefaultRoom()->getPlayerListing(name);
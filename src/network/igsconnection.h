@@ -86,6 +86,7 @@ class IGSConnection : public NetworkConnection
         virtual bool supportsAddTime(void) { return true; }
         virtual bool undoResetsScore(void) { return true; }
         virtual bool supportsSeek(void) { return true; }
+        virtual bool playerNamesCaseSensitive(void) { return false; }
         virtual unsigned long getPlayerListColumns(void) { return PL_NOWINSLOSSES; }
         virtual bool supportsChannels(void) { return true; }
         virtual bool supportsRefreshListsButtons(void) { return true; }
@@ -138,6 +139,8 @@ class IGSConnection : public NetworkConnection
 		QString element(const QString &line, int index, const QString &del1, const QString &del2="", bool killblanks=false);
 		unsigned int idleTimeToSeconds(QString time);
 		void fixRankString(QString * rank);
+		void setPlayerRank(PlayerListing * player, const QString & rank);
+		void setPlayerIdle(PlayerListing * player, const QString & idle);
 		PlayerListing * getPlayerListingNeverFail(QString & name);
 
 		int keepAliveTimer;
@@ -155,6 +158,8 @@ class IGSConnection : public NetworkConnection
 		int time_to_seconds(const QString & time);
 		
 		QTextCodec * textCodec;
+		/* server string -> pooled display string and sort value */
+		QHash<QString, QPair<QString, unsigned int> > rankCache, idleCache;
 		
 		virtual void timerEvent(QTimerEvent*);
 	private:
@@ -915,9 +915,7 @@ void LGSConnection::handle_info(QString line)
 				
 	else if (line.contains("Rating:"))
 	{
-		statsPlayer->rank = element(line, 1, " ");
-		fixRankString(&(statsPlayer->rank));
-		statsPlayer->rank_score = rankToScore(statsPlayer->rank);
+		setPlayerRank(statsPlayer, element(line, 1, " "));
 		return;
 	}
 			
@@ -975,9 +973,7 @@ void LGSConnection::handle_info(QString line)
 	}*/	
 	else if (line.left(5) == "19x19")     //LGS syntax
 	{
-		statsPlayer->rank = element(line, 4, " ");
-		fixRankString(&(statsPlayer->rank));
-		statsPlayer->rank_score = rankToScore(statsPlayer->rank);
+		setPlayerRank(statsPlayer, element(line, 4, " "));
 		statsPlayer->rated_games = element(line, 7, " ").toInt();
 		return;
 	}
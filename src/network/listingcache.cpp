@@ -0,0 +1,158 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#include <QSaveFile>
+#include <QStandardPaths>
+#include "listingcache.h"
+#include "playergamelistings.h"
+#include "stringpool.h"
+
+#define LISTINGCACHE_MAGIC		0x71476f4c	//"qGoL"
+#define LISTINGCACHE_VERSION	1
+
+QString ListingCache::fileName(ConnectionType type, const QString & host)
+{
+	QString h = host;
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+		QString("/listings-%1/%2-%3.bin").arg(LISTINGCACHE_VERSION).arg((int)type)
+		.arg(h.replace(QRegExp("[^A-Za-z0-9.-]"), "_"));
+}
+
+/* Only what's actually online and running, and nothing at all if we
+ * never got a list, so a short session doesn't wipe out a good cache */
+bool ListingCache::save(ConnectionType type, const QString & host,
+			const QList<PlayerListing *> & players, const QList<GameListing *> & games)
+{
+	quint32 player_count = 0, game_count = 0;
+	int i;
+
+	for(i = 0; i < players.size(); i++)
+	{
+		if(players[i]->online && !players[i]->stale && !players[i]->name.isEmpty())
+			player_count++;
+	}
+	for(i = 0; i < games.size(); i++)
+	{
+		if(games[i]->running && !games[i]->stale && !games[i]->isRoomOnly)
+			game_count++;
+	}
+	if(!player_count)
+		return false;
+
+	QString name = fileName(type, host);
+	QDir().mkpath(QFileInfo(name).path());
+	QSaveFile file(name);
+	if(!file.open(QIODevice::WriteOnly))
+		return false;
+	QDataStream data(&file);
+	data.setVersion(QDataStream::Qt_5_0);
+	data << (quint32)LISTINGCACHE_MAGIC << (quint16)LISTINGCACHE_VERSION;
+	data << (qint64)QDateTime::currentMSecsSinceEpoch() << player_count << game_count;
+	for(i = 0; i < players.size(); i++)
+	{
+		const PlayerListing * p = players[i];
+		if(!p->online || p->stale || p->name.isEmpty())
+			continue;
+		data << p->name << p->notnickname << p->rank << p->country << p->info << p->idletime;
+		data << (quint32)p->rank_score << (quint32)p->seconds_idle << (quint32)p->wins << (quint32)p->losses;
+		data << (quint32)p->playing << (quint32)p->observing;
+	}
+	for(i = 0; i < games.size(); i++)
+	{
+		const GameListing * g = games[i];
+		if(!g->running || g->stale || g->isRoomOnly)
+			continue;
+		data << (quint32)g->number << g->white_name() << g->white_rank() << g->black_name() << g->black_rank();
+		data << (quint32)g->white_rank_score() << (quint32)g->black_rank_score();
+		data << (quint32)g->moves << (quint32)g->board_size << (quint32)g->handicap << g->komi;
+		data << g->By << g->FR << (quint32)g->observers;
+	}
+	if(data.status() != QDataStream::Ok)
+	{
+		file.cancelWriting();
+		return false;
+	}
+	return file.commit();
+}
+
+/* Strings are still copied out, but the file itself isn't, the stream
+ * reads straight from the mapping */
+bool ListingCache::load(ConnectionType type, const QString & host,
+			QList<PlayerListing *> & players, QList<GameListing *> & games)
+{
+	quint32 magic, player_count, game_count;
+	quint16 version;
+	qint64 written;
+	quint32 i;
+
+	QFile file(fileName(type, host));
+	if(!file.open(QIODevice::ReadOnly) || file.size() == 0)
+		return false;
+	uchar * mapped = file.map(0, file.size());
+	if(!mapped)
+		return false;
+	QByteArray bytes = QByteArray::fromRawData((const char *)mapped, file.size());
+	QDataStream data(bytes);
+	data.setVersion(QDataStream::Qt_5_0);
+	data >> magic >> version >> written >> player_count >> game_count;
+	if(data.status() != QDataStream::Ok || magic != LISTINGCACHE_MAGIC || version != LISTINGCACHE_VERSION)
+		return false;
+	if(QDateTime::currentMSecsSinceEpoch() - written > (qint64)LISTINGCACHE_MAX_AGE * 3600000)
+		return false;
+
+	for(i = 0; i < player_count && data.status() == QDataStream::Ok; i++)
+	{
+		PlayerListing * p = new PlayerListing();
+		data >> p->name >> p->notnickname >> p->rank >> p->country >> p->info >> p->idletime;
+		data >> p->rank_score >> p->seconds_idle >> p->wins >> p->losses;
+		data >> p->playing >> p->observing;
+		p->rank = StringPool::intern(p->rank);
+		p->country = StringPool::intern(p->country);
+		p->info = StringPool::intern(p->info);
+		p->online = true;
+		p->stale = true;
+		players.append(p);
+	}
+	for(i = 0; i < game_count && data.status() == QDataStream::Ok; i++)
+	{
+		GameListing * g = new GameListing();
+		data >> g->number;
+		data >> g->_white_name >> g->_white_rank >> g->_black_name >> g->_black_rank;
+		g->_white_rank = StringPool::intern(g->_white_rank);
+		g->_black_rank = StringPool::intern(g->_black_rank);
+		data >> g->_white_rank_score >> g->_black_rank_score;
+		data >> g->moves >> g->board_size >> g->handicap >> g->komi;
+		data >> g->By >> g->FR >> g->observers;
+		g->running = true;
+		g->stale = true;
+		games.append(g);
+	}
+	if(data.status() != QDataStream::Ok)
+	{
+		while(!players.isEmpty())
+			delete players.takeLast();
+		while(!games.isEmpty())
+			delete games.takeLast();
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,49 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#ifndef LISTINGCACHE_H
+#define LISTINGCACHE_H
+
+#include <QtCore>
+#include "defines.h"
+
+class PlayerListing;
+class GameListing;
+
+/* The last player and game lists we had from a server, kept on disk so
+ * a new room can show them straight away instead of starting empty.
+ * Everything loaded is marked stale until the server lists it again.
+ * The file is a QDataStream, read through a memory mapping: a header
+ * with the time it was written, then the players, then the games. */
+class ListingCache
+{
+public:
+	static bool save(ConnectionType type, const QString & host,
+			 const QList<PlayerListing *> & players, const QList<GameListing *> & games);
+	static bool load(ConnectionType type, const QString & host,
+			 QList<PlayerListing *> & players, QList<GameListing *> & games);
+
+private:
+	static QString fileName(ConnectionType type, const QString & host);
+};
+
+#endif //LISTINGCACHE_H
@@ -87,6 +87,7 @@ class LoginDialog : public QDialog, Ui::LoginDialog
 	public:
         LoginDialog(QWidget *parent = 0);
         ~LoginDialog();
+        static NetworkConnection * newConnection(ConnectionCredentials cred);
 	private slots:		//or can these be private?
 		void slot_cancel(void);
         void slot_connect(QModelIndex);
@@ -97,7 +98,6 @@ class LoginDialog : public QDialog, Ui::LoginDialog
         void slot_toggleEditable(void);
     private:
 		ConnectionType serverStringToConnectionType(const QString & s);
-        NetworkConnection * newConnection(ConnectionCredentials cred);
         Ui::LoginDialog ui;
         NetworkConnection * connection;
         CredentialTableModel * credModel;
@@ -20,9 +20,6 @@
  ***************************************************************************/
 
 
-#ifdef LATENCY
-#include <sys/time.h>
-#endif //LATENCY
 #include "defines.h"
 #include "networkconnection.h"
 #include "consoledispatch.h"
@@ -33,9 +30,18 @@
 #include "playergamelistings.h"
 #include "connectionwidget.h"			//don't like so much
 #include "matchnegotiationstate.h"
+#include "protocolcapture.h"
+#include "protocolreplay.h"
+#include "gamearchiver.h"
+#include <algorithm>
 
 #define FRIENDWATCH_NOTIFY_DEFAULT	1
 
+QString NetworkConnection::capture_filename;
+int NetworkConnection::captures = 0;
+ProtocolReplay * NetworkConnection::replay = 0;
+GameArchiver * NetworkConnection::archiver = 0;
+
 NetworkConnection::NetworkConnection(ConnectionCredentials credentials) :
 default_room(0), console_dispatch(0), qsocket(0)
 {
@@ -53,11 +59,33 @@ default_room(0), console_dispatch(0), qsocket(0)
     password = credentials.password;
 
     ourListing = NULL;
+
+    roundTrip = 0;
+    handler_depth = 0;
+    handler_calls = 0;
+    handler_nsecs = 0;
+    capture = 0;
+    if(!capture_filename.isEmpty() && !replay)
+    {
+        /* one file per connection, later ones get numbered */
+        QString filename = capture_filename;
+        if(captures)
+            filename += "." + QString::number(captures);
+        captures++;
+        capture = new ProtocolCapture();
+        if(!capture->openForWriting(filename, credentials))
+        {
+            delete capture;
+            capture = 0;
+        }
+    }
+    if(archiver)
+        archiver->watch(this);
 }
 
 bool NetworkConnection::openConnection(const QString & host, const unsigned short port, bool not_main_connection)
 {	
-	qsocket = new QTcpSocket();	//try with no parent passed for now
+	qsocket = createSocket();
 	if(!qsocket)
 		return 0;
 	//connect signals
@@ -95,8 +123,22 @@ bool NetworkConnection::openConnection(const QString & host, const unsigned shor
 	return (qsocket->state() != QTcpSocket::UnconnectedState);
 }
 
+/* Anything that talks to a server on our behalf, like the oro
+ * QuickConnections to the metaserver, gets its socket here so it's
+ * captured and replayed along with the rest of the session */
+QTcpSocket * NetworkConnection::createSocket(void)
+{
+	if(replay)
+		return replay->createSocket();
+	else if(capture)
+		return new CaptureSocket(capture);
+	return new QTcpSocket();	//try with no parent passed for now
+}
+
 int NetworkConnection::write(const char * packet, unsigned int size)
 {
+    unsigned int type = outgoingMessageType(packet, size);	//always asked, it may keep state
+    metrics.recordOut(connectionState == CONNECTED ? type : 0, size);
     return qsocket->write(packet, size);
 }
 
@@ -110,6 +152,14 @@ void NetworkConnection::writeZeroPaddedString(char * dst, const QString & src, i
 		dst[i] = 0x00;
 }
 
+/* For a password the capture can't find by its value, because the
+ * packet is encoded before it's written */
+void NetworkConnection::maskNextWrite(int offset, int length)
+{
+	if(capture)
+		capture->maskNextOutbound(offset, length);
+}
+
 int NetworkConnection::checkForOpenBoards(void)
 {
 	BoardDispatch * boarddispatch;
@@ -123,7 +173,11 @@ int NetworkConnection::checkForOpenBoards(void)
 	return 0;
 }
 
-void NetworkConnection::closeConnection(bool send_disconnect)
+/* With keep_room the room, console and friends lists stay up for the
+ * reconnect that follows, and the room marks its players stale until the
+ * next server lists them again.  Boards and games are per server either
+ * way, so the boards are let go of as on any close. */
+void NetworkConnection::closeConnection(bool send_disconnect, bool keep_room)
 {
 	if(!qsocket)		//when can this happen?  this function shouldn't be
 				//called if we get here!!!
@@ -164,7 +218,13 @@ void NetworkConnection::closeConnection(bool send_disconnect)
 	//delete qsocket;
 	qsocket->deleteLater();		//for safety
 	qsocket = 0;
-	onClose();
+	if(keep_room && mainwindowroom)
+	{
+		detachBoardDispatches();
+		mainwindowroom->markListingsStale();
+	}
+	else
+		onClose();
 	
 	return;
 }
@@ -194,6 +254,7 @@ NetworkConnection::~NetworkConnection()
 	//In case these still exist
 	//probably unnecessary?
 	delete match_negotiation_state;
+	delete capture;
 }
 
 void NetworkConnection::setConsoleDispatch(class ConsoleDispatch * c)
@@ -255,22 +316,15 @@ void NetworkConnection::addFriend(PlayerListing * player)
 	//FIXME presumably they're not already on the list because
 	//the popup checked that in constructing the popup menu but...
     friendedList.push_back(new FriendWatchListing(player->name, friendwatch_notify_default));
+    player->friendWatch = friendedList.find(player->name);
     emit playerListingReceived(player);
 }
 
 void NetworkConnection::removeFriend(PlayerListing * player)
 {
     player->friendWatchType = PlayerListing::none;
-	std::vector<FriendWatchListing * >::iterator i;
-	for(i = friendedList.begin(); i != friendedList.end(); i++)
-	{
-        if((*i)->name == player->name)
-		{
-			delete *i;
-			friendedList.erase(i);
-			break;
-		}
-	}
+    player->friendWatch = 0;
+    friendedList.remove(player->name);
     emit playerListingReceived(player);
 }
 
@@ -282,22 +336,15 @@ void NetworkConnection::addWatch(PlayerListing * player)
 		removeBlock(player);
     player->friendWatchType = PlayerListing::watched;
     watchedList.push_back(new FriendWatchListing(player->name, friendwatch_notify_default));
+    player->friendWatch = watchedList.find(player->name);
     emit playerListingReceived(player);
 }
 
 void NetworkConnection::removeWatch(PlayerListing * player)
 {
     player->friendWatchType = PlayerListing::none;
-	std::vector<FriendWatchListing * >::iterator i;
-	for(i = watchedList.begin(); i != watchedList.end(); i++)
-	{
-        if((*i)->name == player->name)
-		{
-			delete *i;
-			watchedList.erase(i);
-			break;
-		}
-	}
+    player->friendWatch = 0;
+    watchedList.remove(player->name);
     emit playerListingReceived(player);
 }
 
@@ -309,21 +356,14 @@ void NetworkConnection::addBlock(PlayerListing * player)
 		removeWatch(player);
     player->friendWatchType = PlayerListing::blocked;
     blockedList.push_back(new FriendWatchListing(player->name));
+    player->friendWatch = blockedList.find(player->name);
 }
 
 void NetworkConnection::removeBlock(PlayerListing * player)
 {
     player->friendWatchType = PlayerListing::none;
-	std::vector<FriendWatchListing * >::iterator i;
-	for(i = blockedList.begin(); i != blockedList.end(); i++)
-	{
-        if((*i)->name == player->name)
-		{
-			delete *i;
-			blockedList.erase(i);
-			break;
-		}
-	}
+    player->friendWatch = 0;
+    blockedList.remove(player->name);
 }
 
 /* This function checks the local lists for a name and sets
@@ -338,71 +378,99 @@ void NetworkConnection::removeBlock(PlayerListing * player)
  * that.  So we probably need to have an online flag
  * on the friends listing to see if we've already flagged
  * them FIXME */
+/* Once a player has been found on a list the listing keeps a link to
+ * the entry and later updates don't look the name up again */
 void NetworkConnection::getAndSetFriendWatchType(PlayerListing * player)
 {
-	std::vector<FriendWatchListing * >::iterator i;
-	
-	for(i = friendedList.begin(); i != friendedList.end(); i++)
+	FriendWatchListing * f = player->friendWatch;
+	if(!f)
 	{
-        if((*i)->name == player->name)
+		if((f = friendedList.find(player->name)))
+			player->friendWatchType = PlayerListing::friended;
+		else if((f = watchedList.find(player->name)))
+			player->friendWatchType = PlayerListing::watched;
+		else if((f = blockedList.find(player->name)))
+			player->friendWatchType = PlayerListing::blocked;
+		else
 		{
-			if(!(*i)->online)
-			{
-				(*i)->online = true;
-                player->friendWatchType = PlayerListing::friended;
-				/* We may want to put this somewhere else or have it be dialog
-				 * with options, like talk or match.  We might also want
-			 	 * to block all notifies while one is in a game FIXME 
-			 	 * Also, these messages should be nonblocking !?!?!!!!! FIXME*/
-			 	/* And actually, its a big enough deal, i.e., we might want console
-			 	 * messages, game blocks, etc., that it makes sense to have some separate
-			 	 * class for it that handles the notifications... a notification class... */
-#ifdef FIXME
-				if((*i)->notify)
-					QMessageBox::information(0, tr("Signed on"), tr("%1 has signed on").arg(player.name));
-#endif //FIXME
-			}
-            else if(!player->online)
-			{
-				(*i)->online = false;
-				//they are disconnecting
-			}
+			player->friendWatchType = PlayerListing::none;
 			return;
 		}
+		player->friendWatch = f;
 	}
-	for(i = watchedList.begin(); i != watchedList.end(); i++)
+	if(player->friendWatchType != PlayerListing::friended)
+		return;
+	
+	if(!f->online)
 	{
-        if((*i)->name == player->name)
-		{
-            player->friendWatchType = PlayerListing::watched;
-			return;
-		}
+		f->online = true;
+		/* We may want to put this somewhere else or have it be dialog
+		 * with options, like talk or match.  We might also want
+	 	 * to block all notifies while one is in a game FIXME 
+	 	 * Also, these messages should be nonblocking !?!?!!!!! FIXME*/
+	 	/* And actually, its a big enough deal, i.e., we might want console
+	 	 * messages, game blocks, etc., that it makes sense to have some separate
+	 	 * class for it that handles the notifications... a notification class... */
+#ifdef FIXME
+		if(f->notify)
+			QMessageBox::information(0, tr("Signed on"), tr("%1 has signed on").arg(player.name));
+#endif //FIXME
 	}
-	for(i = blockedList.begin(); i != blockedList.end(); i++)
+    else if(!player->online)
 	{
-        if((*i)->name == player->name)
-		{
-            player->friendWatchType = PlayerListing::blocked;
-			return;
-		}
+		f->online = false;
+		//they are disconnecting
 	}
-    player->friendWatchType = PlayerListing::none;
-	return;
 }
 
 void NetworkConnection::checkGameWatched(const GameListing *game)
 {
-	std::vector<FriendWatchListing * >::iterator i;
-	for(i = watchedList.begin(); i != watchedList.end(); i++)
+	FriendWatchListing * f = watchedList.find(game->white_name());
+	if(!f)
+		f = watchedList.find(game->black_name());
+	//notifies too often!!! FIXME
+	if(f && f->notify)
+        QMessageBox::information(0, tr("Match Started!"), tr("Match has started between %1 and %2").arg(game->white_name()).arg(game->black_name()));
+}
+
+/* Servers that don't care about case in names get a case folded index,
+ * the names themselves are kept as given */
+void FriendWatchList::setCaseSensitive(bool b)
+{
+	if(b == caseSensitive)
+		return;
+	caseSensitive = b;
+	index.clear();
+	for(iterator i = list.begin(); i != list.end(); i++)
+		index.insert(key((*i)->name), *i);
+}
+
+/* The list owns the listing, a second one for the same name is dropped */
+void FriendWatchList::push_back(FriendWatchListing * f)
+{
+	QString k = key(f->name);
+	if(index.contains(k))
 	{
-        if((*i)->name == game->white_name() || (*i)->name == game->black_name())
-		{
-			//notifies too often!!! FIXME
-			if((*i)->notify)
-                QMessageBox::information(0, tr("Match Started!"), tr("Match has started between %1 and %2").arg(game->white_name()).arg(game->black_name()));
-			return;
-		}
+		delete f;
+		return;
 	}
+	list.push_back(f);
+	index.insert(k, f);
+}
+
+void FriendWatchList::remove(const QString & name)
+{
+	FriendWatchListing * f = index.take(key(name));
+	if(!f)
+		return;
+	list.erase(std::find(list.begin(), list.end(), f));
+	delete f;
+}
+
+void FriendWatchList::clear(void)
+{
+	list.clear();
+	index.clear();
 }
 
 void NetworkConnection::drawPleaseWait(void)
@@ -442,9 +510,31 @@ void NetworkConnection::onReady(void)
     emit ready();
 }
 
+/* Handlers can spin the event loop and end up back in here, we
+ * only time the outermost call so nothing is counted twice */
 void NetworkConnection::OnReadyRead()
 {
+    if(handler_depth++)
+    {
+        handlePendingData();
+        handler_depth--;
+        return;
+    }
+    metrics.beginRead(qsocket->bytesAvailable(), qsocket->bytesToWrite());
+    qint64 start = ProtocolCapture::threadCpuNsecs();
     handlePendingData();
+    handler_nsecs += ProtocolCapture::threadCpuNsecs() - start;
+    handler_calls++;
+    handler_depth--;
+    metrics.endRead();
+    endMoveBatches();
+}
+
+void NetworkConnection::endMoveBatches(void)
+{
+    QMap <unsigned int, BoardDispatch *>::iterator i;
+    for(i = boardDispatchMap.begin(); i != boardDispatchMap.end(); ++i)
+        i.value()->endMoveBatch();
 }
 
 void NetworkConnection::OnConnectionClosed() 
@@ -535,6 +625,8 @@ void NetworkConnection::OnError(QAbstractSocket::SocketError i)
 
 void NetworkConnection::setupRoomAndConsole(void)
 {
+    if(mainwindowroom)
+        return;		//kept over a reconnect
     mainwindowroom = new Room(this);
     mainwindowroom->setConnection(this);
     /* Two calls are needed beacause Room has a two step
@@ -551,13 +643,7 @@ void NetworkConnection::setupRoomAndConsole(void)
 void NetworkConnection::tearDownRoomAndConsole(void)
 {
     savefriendswatches();
-    QMap<unsigned int, class BoardDispatch *>::iterator i;
-    for(i = boardDispatchMap.begin(); i != boardDispatchMap.end(); i++)
-    {
-        (i.value())->setConnection(NULL);
-    }
-    boardDispatchMap.clear();
-    gameDialogMap.clear(); // FIXME probably unnecessary
+    detachBoardDispatches();
 	
 	if(mainwindowroom)
 	{
@@ -571,6 +657,17 @@ void NetworkConnection::tearDownRoomAndConsole(void)
 	}
 }
 
+void NetworkConnection::detachBoardDispatches(void)
+{
+    QMap<unsigned int, class BoardDispatch *>::iterator i;
+    for(i = boardDispatchMap.begin(); i != boardDispatchMap.end(); i++)
+    {
+        (i.value())->setConnection(NULL);
+    }
+    boardDispatchMap.clear();
+    gameDialogMap.clear(); // FIXME probably unnecessary
+}
+
 /* Edit friends/watches list window is created when needed.
  * but we might consider having it always existing and then
  * show hide it?  That's ugly though.  But like these functions
@@ -580,6 +677,9 @@ void NetworkConnection::loadfriendswatches(void)
 {
 	QSettings settings;
 	int size, i;
+	friendedList.setCaseSensitive(playerNamesCaseSensitive());
+	watchedList.setCaseSensitive(playerNamesCaseSensitive());
+	blockedList.setCaseSensitive(playerNamesCaseSensitive());
 	if(!supportsFriendList())
 	{
 		size = settings.beginReadArray("FRIENDEDLIST");
@@ -624,7 +724,7 @@ void NetworkConnection::savefriendswatches(void)
 	if(!supportsFriendList())
 	{
 		settings.beginWriteArray("FRIENDEDLIST");
-		std::vector<FriendWatchListing * >::iterator i;
+		FriendWatchList::iterator i;
 		index = 0;
 		for (i = friendedList.begin(); i != friendedList.end(); i++) 
 		{
@@ -635,11 +735,12 @@ void NetworkConnection::savefriendswatches(void)
 			index++;
 		}
 		settings.endArray();
+		friendedList.clear();
 	}
 	if(!supportsWatchList())
 	{
 		settings.beginWriteArray("WATCHEDLIST");
-		std::vector<FriendWatchListing * >::iterator i;
+		FriendWatchList::iterator i;
 		index = 0;
 		for (i = watchedList.begin(); i != watchedList.end(); i++) 
 		{
@@ -650,11 +751,12 @@ void NetworkConnection::savefriendswatches(void)
 			index++;
 		}
 		settings.endArray();	
+		watchedList.clear();
 	}
 	if(!supportsBlockList())
 	{
 		settings.beginWriteArray("BLOCKEDLIST");
-		std::vector<FriendWatchListing * >::iterator i;
+		FriendWatchList::iterator i;
 		index = 0;
 		for (i = blockedList.begin(); i != blockedList.end(); i++) 
 		{
@@ -664,28 +766,22 @@ void NetworkConnection::savefriendswatches(void)
 			index++;
 		}
 		settings.endArray();
+		blockedList.clear();
 	}
 }
 
-/* Problem if messages come out of order */
-void NetworkConnection::latencyOnSend(void)
+/* A sample is the time between sending one of our moves and the server
+ * echoing it back.  Smoothed like TCP does, so one slow echo doesn't
+ * throw the clocks off. */
+void NetworkConnection::recordRoundTrip(int ms)
 {
-#ifdef LATENCY
-	gettimeofday(&latencyLast, NULL);
-#endif //LATENCY
-}
-
-void NetworkConnection::latencyOnRecv(void)
-{
-#ifdef LATENCY
-	unsigned long ms;
-	struct timeval tv;
-	gettimeofday(&tv, NULL);
-	ms = (tv.tv_sec - latencyLast.tv_sec) * 1000;
-	ms += (tv.tv_usec - latencyLast.tv_usec);
-	latencyAverage += ms;
-	latencyAverage /= 2;
-#endif //LATENCY
+	if(ms < 0)
+		return;
+	metrics.recordRoundTrip(ms);
+	if(!roundTrip)
+		roundTrip = ms;
+	else
+		roundTrip += (ms - roundTrip) / 8;
 }
 
 void NetworkConnection::sendConsoleText(const char * text)
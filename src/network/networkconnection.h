@@ -26,6 +26,7 @@
 #include <QtCore>
 #include <QtNetwork>
 #include "messages.h"
+#include "connectionmetrics.h"
 
 class GameListing;
 class PlayerListing;
@@ -39,8 +40,44 @@ class NetworkConnection;
 
 class MatchNegotiationState;
 
+class FriendWatchListing
+{
+public:
+    FriendWatchListing(QString n, bool b = false) : name(n), id(0), notify(b), online(false) {}
+	QString name;
+	unsigned short id;		//if necessary
+	bool notify;
+	bool online;
+};
+
+/* A friends, watches or blocked list.  Names stay in the order they were
+ * added, for the dialog and the settings, and are indexed so that looking
+ * up a player doesn't depend on how long the list is. */
+class FriendWatchList
+{
+public:
+	typedef std::vector<FriendWatchListing *>::iterator iterator;
+	FriendWatchList() : caseSensitive(true) {}
+	iterator begin(void) { return list.begin(); }
+	iterator end(void) { return list.end(); }
+	unsigned int size(void) const { return list.size(); }
+	void setCaseSensitive(bool b);
+	void push_back(FriendWatchListing * f);
+	FriendWatchListing * find(const QString & name) const { return index.value(key(name)); }
+	void remove(const QString & name);
+	void clear(void);		//doesn't delete the listings
+private:
+	QString key(const QString & name) const { return caseSensitive ? name : name.toCaseFolded(); }
+	std::vector<FriendWatchListing *> list;
+	QHash<QString, FriendWatchListing *> index;
+	bool caseSensitive;
+};
+
 class Room;
 class QMessageBox;
+class ProtocolCapture;
+class ProtocolReplay;
+class GameArchiver;
 
 enum ConnectionState {
     LOGIN,
@@ -149,6 +186,7 @@ public:
         void setDefaultRoom(Room * r) { default_room = r; }
         ConsoleDispatch * getConsoleDispatch(void) { return console_dispatch; }
         Room * getDefaultRoom(void) { return default_room; }
+        ConnectionState getConnectionState(void) const { return connectionState; }
 		class PlayerListing * getPlayerListingFromFriendWatchListing(class FriendWatchListing & f);
         virtual void handlePendingData() = 0;
         virtual void changeServer(void) {}
@@ -173,9 +211,9 @@ public:
         virtual char * sendAddBlock(int *, void *) { return NULL; }
         virtual char * sendRemoveBlock(int *, void *) { return NULL; }
 		
-        std::vector<class FriendWatchListing *> & getFriendsList(void) { return friendedList; }
-        std::vector<class FriendWatchListing *> & getWatchesList(void) { return watchedList; }
-        std::vector<class FriendWatchListing *> & getBlockedList(void) { return blockedList; }
+        FriendWatchList & getFriendsList(void) { return friendedList; }
+        FriendWatchList & getWatchesList(void) { return watchedList; }
+        FriendWatchList & getBlockedList(void) { return blockedList; }
 		
 		// FIXME Not certain but maybe this chunk below should be protected:??
 		BoardDispatch * getBoardDispatch(unsigned int game_id);
@@ -188,6 +226,8 @@ public:
         class MatchRequest * getAndCloseGameDialog(const PlayerListing *opponent);
 		
         const QString & getUsername(void) const { return username; }
+        const QString & getHostname(void) const { return hostname; }
+        ConnectionType getConnectionType(void) const { return connectionType; }
         virtual const PlayerListing * getOurListing(void);
         virtual unsigned short getRoomNumber(void) { return 0; }
         virtual void requestGameInfo(unsigned int) {}		//for IGS on board open
@@ -224,9 +264,12 @@ public:
         virtual bool supportsFriendList(void) { return false; }
         virtual bool supportsWatchList(void) { return false; }
         virtual bool supportsBlockList(void) { return false; }
+        virtual bool playerNamesCaseSensitive(void) { return true; }
         virtual bool supportsSeek(void) { return false; }
         virtual const char * getCodecString(void) { return ""; }
         virtual QString getPlaceString(void) { return ""; }
+        void recordRoundTrip(int ms);
+        int getRoundTrip(void) const { return roundTrip; }	//ms, smoothed
         virtual void saveIfDoesntSave(GameData *) {}
         virtual unsigned long getPlayerListColumns(void) { return 0; }
 		#define PL_NOWINSLOSSES		0x01
@@ -251,6 +294,18 @@ public:
         virtual void sendSeek(class SeekCondition *) {}
         virtual void sendSeekCancel(void) {}
 
+        /* Capture writes everything that goes over the wire to a file,
+         * replay feeds a capture back in instead of opening a socket.
+         * Both apply to connections created after they're set. */
+        static void setCaptureFilename(const QString & filename) { capture_filename = filename; }
+        static void setReplay(ProtocolReplay * r) { replay = r; }
+        QTcpSocket * createSocket(void);
+        static void setArchiver(GameArchiver * a) { archiver = a; }
+        static GameArchiver * getArchiver(void) { return archiver; }
+        ConnectionMetrics & getMetrics(void) { return metrics; }
+        quint64 getHandlerCalls(void) const { return handler_calls; }
+        qint64 getHandlerNsecs(void) const { return handler_nsecs; }
+
     signals:
         void ready(void);
         void playerListingReceived(PlayerListing *);
@@ -258,14 +313,14 @@ public:
         void stateChanged(ConnectionState);
 		
 	protected:
-		void closeConnection(bool send_disconnect = true);
+		void closeConnection(bool send_disconnect = true, bool keep_room = false);
         virtual void onAuthenticationNegotiated(void);
 		virtual void onReady(void);
         QTcpSocket * getQSocket(void) { return qsocket; }
         void writeZeroPaddedString(char * dst, const QString & src, int size);
+        void maskNextWrite(int offset, int length);
         bool openConnection(const QString & host, const unsigned short port, bool not_main_connection = false);
-		void latencyOnSend(void);
-		void latencyOnRecv(void);
+        virtual unsigned int outgoingMessageType(const char *, unsigned int) { return 0; }
 		void changeChannel(const QString & s);
         void setState(ConnectionState newState);
 
@@ -283,18 +338,21 @@ public:
 		
 		bool friendwatch_notify_default;
 		
-		std::vector<FriendWatchListing *> friendedList;
-		std::vector<FriendWatchListing *> watchedList;
-		std::vector<FriendWatchListing *> blockedList;
+		FriendWatchList friendedList;
+		FriendWatchList watchedList;
+		FriendWatchList blockedList;
 
 		MatchNegotiationState * match_negotiation_state;
 		int lastMainTimeChecked, lastPeriodTimeChecked, lastPeriodsChecked;
 
         QTcpSocket * qsocket;
+        ConnectionMetrics metrics;
 
 	private:
 		void setupRoomAndConsole(void);
+		void endMoveBatches(void);
 		void tearDownRoomAndConsole(void);
+		void detachBoardDispatches(void);
 		void loadfriendswatches(void);
 		void savefriendswatches(void);
 
@@ -303,10 +361,16 @@ public:
 		Room * mainwindowroom;
 
         QMessageBox * connectingDialog;
-#ifdef LATENCY
-		struct timeval latencyLast;
-		unsigned long latencyAverage;
-#endif //LATENCY
+
+        ProtocolCapture * capture;
+        static QString capture_filename;
+        static int captures;
+        static ProtocolReplay * replay;
+        static GameArchiver * archiver;
+        int roundTrip;
+        int handler_depth;
+        quint64 handler_calls;
+        qint64 handler_nsecs;
 
 protected:
         QMap <unsigned int, BoardDispatch *> boardDispatchMap;
@@ -328,13 +392,4 @@ private:
 		void slot_cancelConnecting(void);
 };
 
-class FriendWatchListing
-{
-public:
-    FriendWatchListing(QString n, bool b = false) : name(n), id(0), notify(b), online(false) {}
-	QString name;
-	unsigned short id;		//if necessary
-	bool notify;
-	bool online;
-};
 #endif //NETWORKCONNECTION_H
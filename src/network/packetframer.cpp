@@ -0,0 +1,204 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#include <string.h>
+#include <QtCore>
+#include "packetframer.h"
+
+PacketFramer::PacketFramer(enum LengthField field, unsigned int initial_capacity) :
+lengthField(field), capacity(initial_capacity), head(0), tail(0), holds(0)
+{
+	buffer = new unsigned char[capacity];
+}
+
+PacketFramer::~PacketFramer()
+{
+	delete[] buffer;
+	holds = 0;
+	release();
+}
+
+void PacketFramer::release(void)
+{
+	if(holds && --holds)
+		return;
+	while(!retired.isEmpty())
+		delete[] retired.takeLast();
+}
+
+/* Appends whatever the device has ready.  Returns the number of
+ * bytes read, 0 if there was nothing, -1 on error */
+int PacketFramer::fill(QIODevice * device)
+{
+	qint64 available, bytes;
+
+	if(!device)
+		return 0;
+	available = device->bytesAvailable();
+	if(available <= 0)
+		return 0;
+	reserve(available);
+	bytes = device->read((char *)buffer + tail, available);
+	if(bytes < 0)
+		return -1;
+	tail += bytes;
+	return bytes;
+}
+
+/* Hands out the next complete packet, header included, if we have one.
+ * The pointer is into our buffer, it's good until the next fill() */
+bool PacketFramer::nextPacket(unsigned char ** packet, unsigned int * size)
+{
+	unsigned int length;
+
+	if(tail - head < 4)
+		return false;
+	length = packetLength(buffer + head);
+	if(length < 4)
+	{
+		/* we'd never get past this, so there's no point in
+		 * holding onto anything after it */
+		qWarning("Bad packet length %d, dropping %d bytes", length, tail - head);
+		clear();
+		return false;
+	}
+	if(tail - head < length)
+		return false;
+	*packet = buffer + head;
+	*size = length;
+	head += length;
+	if(head == tail && !holds)
+		head = tail = 0;
+	return true;
+}
+
+/* Doesn't release the buffer, we're likely to need it again
+ * right away for the next server. */
+void PacketFramer::clear(void)
+{
+	if(holds)
+		head = tail;
+	else
+		head = tail = 0;
+}
+
+unsigned int PacketFramer::packetLength(const unsigned char * header) const
+{
+	switch(lengthField)
+	{
+		case BigEndian16At0:
+			return header[1] + (header[0] << 8);
+		case LittleEndian16At2:
+			return header[2] + (header[3] << 8);
+	}
+	return 0;
+}
+
+/* Makes room for length more bytes at the tail, first by moving the
+ * partial packet at the head back to the front and only if that's not
+ * enough, by growing.  While held, packets before head may still be in
+ * use: nothing moves and the old buffer lives on until release(). */
+void PacketFramer::reserve(unsigned int length)
+{
+	unsigned char * b;
+	unsigned int new_capacity;
+
+	if(capacity - tail >= length)
+		return;
+	if(head && !holds)
+	{
+		memmove(buffer, buffer + head, tail - head);
+		tail -= head;
+		head = 0;
+		if(capacity - tail >= length)
+			return;
+	}
+	new_capacity = capacity;
+	while(new_capacity - tail < length)
+		new_capacity <<= 1;
+	b = new unsigned char[new_capacity];
+	memcpy(b, buffer, tail);
+	if(holds)
+		retired.append(buffer);
+	else
+		delete[] buffer;
+	buffer = b;
+	capacity = new_capacity;
+}
+
+/* memcpy here is just an unaligned load/store, the compiler turns it
+ * into a single mov.  The key is the same in both halves so byte
+ * order doesn't matter, and folding the two halves of the sum gives
+ * the same thing as xoring the 32 bit words one by one. */
+uint32_t PacketFramer::xorWords32(unsigned char * p, unsigned int words, uint32_t key)
+{
+	uint64_t w, sum = 0;
+	uint64_t key64 = ((uint64_t)key << 32) | key;
+	uint32_t w32, sum32;
+
+	while(words >= 2)
+	{
+		memcpy(&w, p, 8);
+		sum ^= w;
+		w ^= key64;
+		memcpy(p, &w, 8);
+		p += 8;
+		words -= 2;
+	}
+	sum32 = (uint32_t)sum ^ (uint32_t)(sum >> 32);
+	if(words)
+	{
+		memcpy(&w32, p, 4);
+		sum32 ^= w32;
+		w32 ^= key;
+		memcpy(p, &w32, 4);
+	}
+	return sum32;
+}
+
+unsigned char PacketFramer::xorBytes(unsigned char * p, const unsigned char * key, unsigned int length)
+{
+	uint64_t w, k, sum = 0;
+	unsigned char fold;
+
+	while(length >= 8)
+	{
+		memcpy(&w, p, 8);
+		memcpy(&k, key, 8);
+		w ^= k;
+		sum ^= w;
+		memcpy(p, &w, 8);
+		p += 8;
+		key += 8;
+		length -= 8;
+	}
+	sum ^= sum >> 32;
+	sum ^= sum >> 16;
+	sum ^= sum >> 8;
+	fold = sum & 0xff;
+	while(length--)
+	{
+		*p ^= *key++;
+		fold ^= *p++;
+	}
+	return fold;
+}
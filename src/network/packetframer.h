@@ -0,0 +1,85 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#ifndef PACKETFRAMER_H
+#define PACKETFRAMER_H
+#include <stdint.h>
+#include <QList>
+
+class QIODevice;
+
+/* Tygem, TOM, eWeiqi and CyberORO all send binary packets with a
+ * 4 byte header carrying the packet length.  We used to peek the header,
+ * allocate the packet, read it, dispatch and delete it for every single
+ * packet which was a lot of churn on the big player list bursts.
+ * The framer keeps one buffer per connection that is reused for the
+ * life of the connection.  Bytes are appended at the tail and complete
+ * packets are handed out from the head as pointers into the buffer, so
+ * nothing is copied or allocated per packet.  When the tail hits the end
+ * the partial packet left at the head is moved back to the front, which
+ * is the only time anything moves.  A packet handed out by nextPacket()
+ * stays valid until the next fill() that isn't inside a hold().
+ * The handlers are free to modify the packet in place. */
+class PacketFramer
+{
+	public:
+		/* Where the length lives in the header */
+		enum LengthField {
+			BigEndian16At0,		//tygem and friends
+			LittleEndian16At2	//cyberoro
+		};
+		PacketFramer(enum LengthField field, unsigned int initial_capacity = 0x4000);
+		~PacketFramer();
+
+		int fill(QIODevice * device);
+		bool nextPacket(unsigned char ** packet, unsigned int * size);
+		void clear(void);
+		unsigned int buffered(void) const { return tail - head; }
+
+		/* Handlers can pop up modal dialogs that spin the event loop
+		 * and call back into handlePendingData, which fills and
+		 * dispatches in turn.  The outer call holds the framer while
+		 * its packet is out: nothing is moved, and a buffer that has
+		 * to grow keeps the old one around, until the last release. */
+		void hold(void) { holds++; }
+		void release(void);
+
+		/* In place ciphers, word at a time.  xorWords32 xors "words"
+		 * 32 bit words with key and returns the xor of the plain words,
+		 * which is the tygem checksum.  xorBytes xors against a key
+		 * stream and returns the xor of the resulting bytes, as ORO
+		 * wants. */
+		static uint32_t xorWords32(unsigned char * p, unsigned int words, uint32_t key);
+		static unsigned char xorBytes(unsigned char * p, const unsigned char * key, unsigned int length);
+	private:
+		unsigned int packetLength(const unsigned char * header) const;
+		void reserve(unsigned int length);
+
+		enum LengthField lengthField;
+		unsigned char * buffer;
+		unsigned int capacity;
+		unsigned int head, tail;
+		int holds;
+		QList<unsigned char *> retired;	//outgrown while held, freed on release
+
+};
+#endif //PACKETFRAMER_H
@@ -24,6 +24,8 @@
 #define PLAYERGAMELISTING_H
 
 #include <QString>
+#include <QHash>
+#include <QMap>
 
 class GameData;
 
@@ -58,10 +60,13 @@ private:
     dialog_opened(false),
     game_dialog_opened(false),
     friendWatchType(none),
+    friendWatch(0),
     notify(false),
-    hidden(false) {}
+    hidden(false),
+    stale(false) {}
     ~PlayerListing() {}
     friend class Room;
+    friend class ListingCache;
 public:
 	unsigned short id;
 	bool online;
@@ -98,8 +103,46 @@ public:
 	bool dialog_opened;
 	bool game_dialog_opened;
 	enum FriendWatchType { none, friended, watched, blocked } friendWatchType;
+	class FriendWatchListing * friendWatch;	//entry on the list of friendWatchType
 	bool notify;
     bool hidden;
+    bool stale;			//cached or from before a reconnect, not yet listed again
+};
+
+/* The players in a game or room.  Joins and leaves are looked up by
+ * listing, iterating goes in the order they joined. */
+class ObserverSet
+{
+public:
+	typedef QMap<quint32, PlayerListing *>::const_iterator const_iterator;
+	ObserverSet() : next(0) {}
+	bool insert(PlayerListing * p)
+	{
+		if(seq.contains(p))
+			return false;
+		seq.insert(p, next);
+		order.insert(next++, p);
+		return true;
+	}
+	bool remove(const PlayerListing * p)
+	{
+		QHash<const PlayerListing *, quint32>::iterator i = seq.find(p);
+		if(i == seq.end())
+			return false;
+		order.remove(*i);
+		seq.erase(i);
+		return true;
+	}
+	bool contains(const PlayerListing * p) const { return seq.contains(p); }
+	unsigned int size(void) const { return seq.size(); }
+	void clear(void) { seq.clear(); order.clear(); }
+	PlayerListing * first(void) const { return order.isEmpty() ? 0 : order.first(); }
+	const_iterator begin(void) const { return order.constBegin(); }
+	const_iterator end(void) const { return order.constEnd(); }
+private:
+	QHash<const PlayerListing *, quint32> seq;
+	QMap<quint32, PlayerListing *> order;
+	quint32 next;
 };
 
 /* We need to alter copy constructor to have and respect a bit field.
@@ -131,9 +174,11 @@ private:
     isBroadcast(false),
     isBetting(false),
     isLocked(false),
+    stale(false),
     gameData(NULL) {}
     ~GameListing() {}
     friend class Room;
+    friend class ListingCache;
 public:
     bool running;
 	unsigned int number;
@@ -208,8 +253,9 @@ public:
 	bool isBroadcast;
 	bool isBetting;
 	bool isLocked;
+	bool stale;			//from the listing cache, not yet seen this session
 	bool white_first_flag;
-	std::vector <PlayerListing *> observer_list;
+	ObserverSet observer_list;
 	GameData * gameData;
 	/* Also need byomi time, one color go, running, private, flags, ranked, etc.*/
 };
@@ -0,0 +1,419 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#include <string.h>
+#ifdef Q_OS_UNIX
+#include <time.h>
+#endif //Q_OS_UNIX
+#include "protocolcapture.h"
+#include "networkconnection.h"
+
+#define CAPTURE_MAGIC		0x71476f43	//"qGoC"
+#define CAPTURE_VERSION		1
+
+ProtocolCapture::ProtocolCapture() :
+type(TypeUNKNOWN), port(0), mask_offset(0), mask_length(0), streams(0)
+{
+}
+
+ProtocolCapture::~ProtocolCapture()
+{
+	std::vector<Record *>::iterator i;
+	for(i = records.begin(); i != records.end(); i++)
+		delete *i;
+	if(file.isOpen())
+		file.close();
+}
+
+bool ProtocolCapture::openForWriting(const QString & filename, const ConnectionCredentials & credentials)
+{
+	file.setFileName(filename);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		qWarning("Can't open capture file %s", filename.toLatin1().constData());
+		return false;
+	}
+	data.setDevice(&file);
+	data.setVersion(QDataStream::Qt_5_0);
+	type = credentials.type;
+	hostname = credentials.hostName;
+	port = credentials.port;
+	username = credentials.userName;
+	password = credentials.password.toLatin1();
+	data << (quint32)CAPTURE_MAGIC << (quint16)CAPTURE_VERSION;
+	data << (qint32)type << hostname << port << username;
+	clock.start();
+	qDebug("Capturing connection to %s", filename.toLatin1().constData());
+	return true;
+}
+
+/* Reads the whole thing in, captures are never that big */
+bool ProtocolCapture::openForReading(const QString & filename)
+{
+	quint32 magic;
+	quint16 version, stream;
+	qint32 t;
+	quint8 kind;
+	qint64 usecs;
+	QByteArray d;
+
+	file.setFileName(filename);
+	if(!file.open(QIODevice::ReadOnly))
+	{
+		qWarning("Can't open capture file %s", filename.toLatin1().constData());
+		return false;
+	}
+	data.setDevice(&file);
+	data.setVersion(QDataStream::Qt_5_0);
+	data >> magic >> version;
+	if(magic != CAPTURE_MAGIC || version != CAPTURE_VERSION)
+	{
+		qWarning("%s is not a qGo capture", filename.toLatin1().constData());
+		file.close();
+		return false;
+	}
+	data >> t >> hostname >> port >> username;
+	type = (ConnectionType)t;
+	while(!data.atEnd())
+	{
+		data >> kind >> stream >> usecs >> d;
+		if(data.status() != QDataStream::Ok)
+		{
+			//probably we crashed while capturing, keep what we have
+			qWarning("Capture truncated after %d records", (int)records.size());
+			break;
+		}
+		records.push_back(new Record((enum RecordKind)kind, stream, usecs, d));
+		if(stream >= streams)
+			streams = stream + 1;
+	}
+	file.close();
+	return true;
+}
+
+quint16 ProtocolCapture::newStream(const QString & host, quint16 p)
+{
+	quint16 s = streams++;
+	record(Open, s, QString("%1:%2").arg(host).arg(p).toLatin1());
+	return s;
+}
+
+/* We flush every record, the point of these is often to find out
+ * what was happening right before something went wrong */
+void ProtocolCapture::record(enum RecordKind kind, quint16 stream, const QByteArray & d)
+{
+	if(!file.isOpen())
+		return;
+	data << (quint8)kind << stream << (qint64)(clock.nsecsElapsed() / 1000);
+	if(kind == Outbound && (mask_length || (!password.isEmpty() && d.contains(password))))
+	{
+		QByteArray masked(d);
+		if(!password.isEmpty())
+			masked.replace(password, QByteArray(password.size(), '*'));
+		for(int i = mask_offset; i < mask_offset + mask_length && i < masked.size(); i++)
+			masked[i] = '*';
+		mask_length = 0;
+		data << masked;
+	}
+	else
+		data << d;
+	file.flush();
+}
+
+/* The bytes at offset in the next thing we send are blanked out */
+void ProtocolCapture::maskNextOutbound(int offset, int length)
+{
+	mask_offset = offset;
+	mask_length = length;
+}
+
+std::vector<const ProtocolCapture::Record *> ProtocolCapture::getStreamRecords(quint16 stream) const
+{
+	std::vector<const Record *> r;
+	std::vector<Record *>::const_iterator i;
+	for(i = records.begin(); i != records.end(); i++)
+	{
+		if((*i)->stream == stream)
+			r.push_back(*i);
+	}
+	return r;
+}
+
+/* CPU time of the calling thread, so that time we spend waiting
+ * on the event loop doesn't count against the handlers.  Falls
+ * back to wall clock where we don't have that. */
+qint64 ProtocolCapture::threadCpuNsecs(void)
+{
+#if defined(Q_OS_UNIX) && defined(CLOCK_THREAD_CPUTIME_ID)
+	struct timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return (qint64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+	static QElapsedTimer wallclock;
+	if(!wallclock.isValid())
+		wallclock.start();
+	return wallclock.nsecsElapsed();
+#endif
+}
+
+PipeSocket::PipeSocket(QObject * parent) : QTcpSocket(parent), pendingPos(0)
+{
+}
+
+qint64 PipeSocket::bytesAvailable() const
+{
+	return (pending.size() - pendingPos) + QIODevice::bytesAvailable();
+}
+
+bool PipeSocket::canReadLine() const
+{
+	return (pending.indexOf('\n', pendingPos) != -1) || QIODevice::canReadLine();
+}
+
+void PipeSocket::append(const QByteArray & d)
+{
+	if(pendingPos == pending.size())
+	{
+		pending.resize(0);
+		pendingPos = 0;
+	}
+	pending.append(d);
+	emit readyRead();
+}
+
+void PipeSocket::setConnected(const QString & host, quint16 p)
+{
+	setPeerName(host);
+	setPeerPort(p);
+	setSocketState(QAbstractSocket::ConnectedState);
+	QIODevice::open(QIODevice::ReadWrite | QIODevice::Unbuffered);
+}
+
+void PipeSocket::setUnconnected(void)
+{
+	bool was_connected = (state() == QAbstractSocket::ConnectedState);
+	QIODevice::close();
+	setSocketState(QAbstractSocket::UnconnectedState);
+	if(was_connected)
+		emit disconnected();
+}
+
+qint64 PipeSocket::readData(char * d, qint64 maxSize)
+{
+	qint64 n = qMin(maxSize, (qint64)(pending.size() - pendingPos));
+	memcpy(d, pending.constData() + pendingPos, n);
+	pendingPos += n;
+	return n;
+}
+
+qint64 PipeSocket::readLineData(char * d, qint64 maxSize)
+{
+	const char * start = pending.constData() + pendingPos;
+	qint64 n = qMin(maxSize, (qint64)(pending.size() - pendingPos));
+	const char * newline = (const char *)memchr(start, '\n', n);
+	if(newline)
+		n = newline - start + 1;
+	memcpy(d, start, n);
+	pendingPos += n;
+	return n;
+}
+
+CaptureSocket::CaptureSocket(ProtocolCapture * c) : capture(c), stream(0)
+{
+	wire = new QTcpSocket(this);
+	connect(wire, SIGNAL(connected()), SLOT(slot_wireConnected()));
+	connect(wire, SIGNAL(readyRead()), SLOT(slot_wireReadyRead()));
+	connect(wire, SIGNAL(disconnected()), SLOT(slot_wireDisconnected()));
+	connect(wire, SIGNAL(error(QAbstractSocket::SocketError)), SLOT(slot_wireError(QAbstractSocket::SocketError)));
+}
+
+CaptureSocket::~CaptureSocket()
+{
+	wire->disconnect(this);
+}
+
+void CaptureSocket::connectToHost(const QString & hostName, quint16 p, OpenMode mode, NetworkLayerProtocol protocol)
+{
+	stream = capture->newStream(hostName, p);
+	setSocketState(QAbstractSocket::ConnectingState);
+	wire->connectToHost(hostName, p, mode, protocol);
+}
+
+void CaptureSocket::disconnectFromHost(void)
+{
+	wire->disconnectFromHost();
+}
+
+void CaptureSocket::close(void)
+{
+	wire->close();
+	if(state() != QAbstractSocket::UnconnectedState)
+	{
+		capture->record(ProtocolCapture::Close, stream, QByteArray());
+		setUnconnected();
+	}
+}
+
+qint64 CaptureSocket::writeData(const char * d, qint64 size)
+{
+	capture->record(ProtocolCapture::Outbound, stream, QByteArray(d, size));
+	return wire->write(d, size);
+}
+
+void CaptureSocket::slot_wireConnected(void)
+{
+	setConnected(wire->peerName(), wire->peerPort());
+	emit connected();
+}
+
+void CaptureSocket::slot_wireReadyRead(void)
+{
+	QByteArray d = wire->readAll();
+	capture->record(ProtocolCapture::Inbound, stream, d);
+	append(d);
+}
+
+void CaptureSocket::slot_wireDisconnected(void)
+{
+	if(state() == QAbstractSocket::UnconnectedState)
+		return;
+	capture->record(ProtocolCapture::Close, stream, QByteArray());
+	setUnconnected();
+}
+
+void CaptureSocket::slot_wireError(QAbstractSocket::SocketError e)
+{
+	setSocketError(e);
+	setErrorString(wire->errorString());
+	emit error(e);
+}
+
+ReplaySocket::ReplaySocket(const ProtocolCapture * c, quint16 s, double sp) :
+stream(s), speed(sp), next(0), openUsecs(0), bytesIn(0), bytesOut(0), done(false)
+{
+	std::vector<const ProtocolCapture::Record *> r = c->getStreamRecords(s);
+	std::vector<const ProtocolCapture::Record *>::iterator i;
+	/* we only play back what the server sent, what we sent
+	 * is only there to look at */
+	for(i = r.begin(); i != r.end(); i++)
+	{
+		if((*i)->kind == ProtocolCapture::Open)
+			openUsecs = (*i)->usecs;
+		else if((*i)->kind != ProtocolCapture::Outbound)
+			records.push_back(*i);
+	}
+	timer = new QTimer(this);
+	timer->setSingleShot(true);
+	connect(timer, SIGNAL(timeout()), SLOT(slot_deliver()));
+}
+
+void ReplaySocket::connectToHost(const QString & hostName, quint16 p, OpenMode, NetworkLayerProtocol)
+{
+	setPeerName(hostName);
+	setPeerPort(p);
+	setSocketState(QAbstractSocket::ConnectingState);
+	/* the connection checks our state right after this returns
+	 * and only then expects to hear that we're connected */
+	QTimer::singleShot(0, this, SLOT(slot_connected()));
+}
+
+void ReplaySocket::disconnectFromHost(void)
+{
+	close();
+}
+
+void ReplaySocket::close(void)
+{
+	timer->stop();
+	setUnconnected();
+	finish();
+}
+
+qint64 ReplaySocket::writeData(const char *, qint64 size)
+{
+	bytesOut += size;
+	return size;
+}
+
+void ReplaySocket::slot_connected(void)
+{
+	if(state() != QAbstractSocket::ConnectingState)
+		return;
+	setConnected(peerName(), peerPort());
+	clock.start();
+	emit connected();
+	scheduleNext();
+}
+
+/* Anything we hand over can end up closing us, so we check our
+ * state after every append */
+void ReplaySocket::slot_deliver(void)
+{
+	const ProtocolCapture::Record * r;
+
+	while(next < records.size() && state() == QAbstractSocket::ConnectedState)
+	{
+		r = records[next];
+		if(speed > 0 && (r->usecs - openUsecs) / speed / 1000 > clock.elapsed())
+			break;
+		next++;
+		if(r->kind == ProtocolCapture::Close)
+		{
+			setUnconnected();
+			break;
+		}
+		bytesIn += r->data.size();
+		append(r->data);
+		if(speed <= 0)
+			break;
+	}
+	if(state() == QAbstractSocket::ConnectedState)
+		scheduleNext();
+	else
+		finish();
+}
+
+void ReplaySocket::scheduleNext(void)
+{
+	qint64 due;
+
+	if(next >= records.size())
+	{
+		finish();
+		return;
+	}
+	if(speed <= 0)
+		timer->start(0);
+	else
+	{
+		due = (qint64)((records[next]->usecs - openUsecs) / speed / 1000) - clock.elapsed();
+		timer->start(due > 0 ? due : 0);
+	}
+}
+
+void ReplaySocket::finish(void)
+{
+	if(done)
+		return;
+	done = true;
+	emit finished();
+}
@@ -0,0 +1,170 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#ifndef PROTOCOLCAPTURE_H
+#define PROTOCOLCAPTURE_H
+#include <vector>
+#include <QtCore>
+#include <QtNetwork>
+#include "defines.h"
+
+class ConnectionCredentials;
+
+/* A capture is everything that went over the wire for one
+ * NetworkConnection, both directions, with microsecond timestamps
+ * from when the capture was opened.  Every openConnection starts a new
+ * stream, since tygem and oro will hop between servers and the replay
+ * has to hand them out in the same order.
+ * The file is a QDataStream: a header with the connection type, host,
+ * port and user name and then records until the end.  The password is
+ * masked out of anything we send, where it's sent as is or where the
+ * connection marks it with maskNextOutbound, along with anything that
+ * could be worked back to it like tygem's checksum, but captures still have
+ * the whole session in them so be careful who they're given to. */
+class ProtocolCapture
+{
+	public:
+		enum RecordKind { Open, Inbound, Outbound, Close };
+		class Record
+		{
+		public:
+			Record(enum RecordKind k, quint16 s, qint64 u, const QByteArray & d) :
+				kind(k), stream(s), usecs(u), data(d) {}
+			enum RecordKind kind;
+			quint16 stream;
+			qint64 usecs;
+			QByteArray data;
+		};
+		ProtocolCapture();
+		~ProtocolCapture();
+		bool openForWriting(const QString & filename, const ConnectionCredentials & credentials);
+		bool openForReading(const QString & filename);
+		quint16 newStream(const QString & host, quint16 port);
+		void record(enum RecordKind kind, quint16 stream, const QByteArray & data);
+		void maskNextOutbound(int offset, int length);
+
+		ConnectionType getType(void) const { return type; }
+		const QString & getHostname(void) const { return hostname; }
+		quint16 getPort(void) const { return port; }
+		const QString & getUsername(void) const { return username; }
+		quint16 getStreams(void) const { return streams; }
+		std::vector<const Record *> getStreamRecords(quint16 stream) const;
+
+		static qint64 threadCpuNsecs(void);
+	private:
+		QFile file;
+		QDataStream data;
+		QElapsedTimer clock;
+		ConnectionType type;
+		QString hostname;
+		quint16 port;
+		QString username;
+		QByteArray password;
+		int mask_offset, mask_length;	//of the next Outbound record
+		quint16 streams;
+		std::vector<Record *> records;
+};
+
+/* Stands in for the QTcpSocket a NetworkConnection reads from.  Reads
+ * come out of our own buffer, which the subclasses fill, so the
+ * connections can't tell the difference. */
+class PipeSocket : public QTcpSocket
+{
+	Q_OBJECT
+
+	public:
+		PipeSocket(QObject * parent = 0);
+		virtual qint64 bytesAvailable() const;
+		virtual bool canReadLine() const;
+	protected:
+		void append(const QByteArray & data);
+		void setConnected(const QString & host, quint16 port);
+		void setUnconnected(void);
+		virtual qint64 readData(char * data, qint64 maxSize);
+		virtual qint64 readLineData(char * data, qint64 maxSize);
+	private:
+		QByteArray pending;
+		int pendingPos;
+};
+
+/* Sits in front of a real socket and records what goes through it */
+class CaptureSocket : public PipeSocket
+{
+	Q_OBJECT
+
+	public:
+		CaptureSocket(ProtocolCapture * c);
+		~CaptureSocket();
+		virtual void connectToHost(const QString & hostName, quint16 port, OpenMode mode = ReadWrite, NetworkLayerProtocol protocol = AnyIPProtocol);
+		virtual void disconnectFromHost(void);
+		virtual void close(void);
+	protected:
+		virtual qint64 writeData(const char * data, qint64 size);
+	private slots:
+		void slot_wireConnected(void);
+		void slot_wireReadyRead(void);
+		void slot_wireDisconnected(void);
+		void slot_wireError(QAbstractSocket::SocketError e);
+	private:
+		ProtocolCapture * capture;
+		quint16 stream;
+		QTcpSocket * wire;
+};
+
+/* Plays one stream of a capture back.  With a speed of 0 it hands over
+ * one recorded read per pass of the event loop, as fast as we can take
+ * them, otherwise it keeps the recorded timing divided by speed.  What
+ * we write is counted and dropped. */
+class ReplaySocket : public PipeSocket
+{
+	Q_OBJECT
+
+	public:
+		ReplaySocket(const ProtocolCapture * c, quint16 s, double sp);
+		virtual void connectToHost(const QString & hostName, quint16 port, OpenMode mode = ReadWrite, NetworkLayerProtocol protocol = AnyIPProtocol);
+		virtual void disconnectFromHost(void);
+		virtual void close(void);
+		quint16 getStream(void) const { return stream; }
+		qint64 getBytesIn(void) const { return bytesIn; }
+		qint64 getBytesOut(void) const { return bytesOut; }
+	signals:
+		void finished(void);
+	protected:
+		virtual qint64 writeData(const char * data, qint64 size);
+	private slots:
+		void slot_connected(void);
+		void slot_deliver(void);
+	private:
+		void scheduleNext(void);
+		void finish(void);
+
+		quint16 stream;
+		double speed;
+		std::vector<const ProtocolCapture::Record *> records;
+		unsigned int next;
+		qint64 openUsecs;
+		QElapsedTimer clock;
+		QTimer * timer;
+		qint64 bytesIn, bytesOut;
+		bool done;
+};
+#endif //PROTOCOLCAPTURE_H
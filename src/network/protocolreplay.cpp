@@ -0,0 +1,183 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
+#include "protocolreplay.h"
+#include "protocolcapture.h"
+#include "login.h"
+#include "connectionwidget.h"
+
+#ifdef COUNT_ALLOCATIONS
+static QAtomicInteger<quint64> allocation_count;
+
+void * operator new(size_t size)
+{
+	allocation_count.fetchAndAddRelaxed(1);
+	void * p = malloc(size ? size : 1);
+	if(!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void * operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void * p) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void * p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void * p, size_t) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void * p, size_t) noexcept
+{
+	free(p);
+}
+#endif //COUNT_ALLOCATIONS
+
+ProtocolReplay::ProtocolReplay(const QString & f, double s) :
+filename(f), speed(s), capture(0), next_stream(0),
+players(0), games(0), states(0), bytes_in(0), bytes_out(0),
+start_allocations(0), reported(false)
+{
+}
+
+ProtocolReplay::~ProtocolReplay()
+{
+	NetworkConnection::setReplay(0);
+	delete capture;
+}
+
+quint64 ProtocolReplay::allocations(void)
+{
+#ifdef COUNT_ALLOCATIONS
+	return allocation_count.load();
+#else
+	return 0;
+#endif //COUNT_ALLOCATIONS
+}
+
+void ProtocolReplay::start(void)
+{
+	capture = new ProtocolCapture();
+	if(!capture->openForReading(filename))
+		return;
+	qDebug("Replaying %d streams from %s", capture->getStreams(), filename.toLatin1().constData());
+	NetworkConnection::setReplay(this);
+	ConnectionCredentials credentials(capture->getType(), capture->getHostname(), capture->getPort(), capture->getUsername(), QString());
+	connection = LoginDialog::newConnection(credentials);
+	if(!connection)
+		return;
+	connect(connection, SIGNAL(playerListingReceived(PlayerListing *)), SLOT(slot_playerListingReceived(PlayerListing *)));
+	connect(connection, SIGNAL(gameListingReceived(GameListing *)), SLOT(slot_gameListingReceived(GameListing *)));
+	connect(connection, SIGNAL(stateChanged(ConnectionState)), SLOT(slot_stateChanged(ConnectionState)));
+	connectionWidget->setNetworkConnection(connection);
+	start_allocations = allocations();
+	wallclock.start();
+}
+
+/* Called from openConnection in place of new QTcpSocket */
+QTcpSocket * ProtocolReplay::createSocket(void)
+{
+	if(next_stream >= capture->getStreams())
+		qWarning("Connection opened more sockets than were captured");
+	ReplaySocket * s = new ReplaySocket(capture, next_stream++, speed);
+	connect(s, SIGNAL(finished()), SLOT(slot_socketFinished()));
+	return s;
+}
+
+void ProtocolReplay::slot_socketFinished(void)
+{
+	ReplaySocket * s = qobject_cast<ReplaySocket *>(sender());
+	if(!s)
+		return;
+	bytes_in += s->getBytesIn();
+	bytes_out += s->getBytesOut();
+	if(s->getStream() + 1 >= capture->getStreams())
+		QTimer::singleShot(0, this, SLOT(slot_report()));
+}
+
+void ProtocolReplay::slot_playerListingReceived(PlayerListing *)
+{
+	players++;
+}
+
+void ProtocolReplay::slot_gameListingReceived(GameListing *)
+{
+	games++;
+}
+
+void ProtocolReplay::slot_stateChanged(ConnectionState state)
+{
+	states++;
+	if(state == CONNECTED)
+	{
+		connectionWidget->setupButtons();
+		connectionWidget->setEnabled(true);
+	}
+}
+
+void ProtocolReplay::slot_report(void)
+{
+	quint64 calls = 0;
+	qint64 nsecs = 0;
+	int boards = 0;
+
+	if(reported)
+		return;
+	reported = true;
+	if(connection)
+	{
+		calls = connection->getHandlerCalls();
+		nsecs = connection->getHandlerNsecs();
+		boards = connection->getBoardDispatches();
+	}
+	printf("Replay of %s, %d streams at %s\n", filename.toLatin1().constData(), capture->getStreams(),
+	       speed > 0 ? QString("%1x").arg(speed).toLatin1().constData() : "full speed");
+	printf("  wall time          %lld ms\n", (long long)wallclock.elapsed());
+	printf("  handler calls      %llu\n", (unsigned long long)calls);
+	printf("  handler cpu time   %.3f ms (%.1f us per call)\n", nsecs / 1000000.0,
+	       calls ? nsecs / 1000.0 / calls : 0.0);
+#ifdef COUNT_ALLOCATIONS
+	printf("  allocations        %llu\n", (unsigned long long)(allocations() - start_allocations));
+#else
+	printf("  allocations        not counted, build with CONFIG+=count_allocations\n");
+#endif //COUNT_ALLOCATIONS
+	printf("  bytes in/out       %lld/%lld\n", (long long)bytes_in, (long long)bytes_out);
+	printf("  player listings    %llu\n", (unsigned long long)players);
+	printf("  game listings      %llu\n", (unsigned long long)games);
+	printf("  state changes      %llu\n", (unsigned long long)states);
+	printf("  open boards        %d\n", boards);
+	fflush(stdout);
+}
@@ -0,0 +1,66 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#ifndef PROTOCOLREPLAY_H
+#define PROTOCOLREPLAY_H
+#include <QtCore>
+#include "networkconnection.h"
+
+class ProtocolCapture;
+class QTcpSocket;
+
+/* Drives a connection from a capture file instead of a server, see
+ * --replay.  The connection is created and hooked up to the UI just as
+ * the login dialog would, and when the last captured stream has been
+ * played we print what the handlers cost.  Allocations are only counted
+ * in builds with CONFIG+=count_allocations since it means replacing
+ * operator new for the whole program. */
+class ProtocolReplay : public QObject
+{
+	Q_OBJECT
+
+	public:
+		ProtocolReplay(const QString & f, double s);
+		~ProtocolReplay();
+		QTcpSocket * createSocket(void);
+		static quint64 allocations(void);
+	public slots:
+		void start(void);
+	private slots:
+		void slot_socketFinished(void);
+		void slot_playerListingReceived(PlayerListing *);
+		void slot_gameListingReceived(GameListing *);
+		void slot_stateChanged(ConnectionState state);
+		void slot_report(void);
+	private:
+		QString filename;
+		double speed;
+		ProtocolCapture * capture;
+		QPointer<NetworkConnection> connection;
+		quint16 next_stream;
+		quint64 players, games, states;
+		qint64 bytes_in, bytes_out;
+		quint64 start_allocations;
+		QElapsedTimer wallclock;
+		bool reported;
+};
+#endif //PROTOCOLREPLAY_H
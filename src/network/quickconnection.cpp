@@ -26,7 +26,7 @@
 QuickConnection::QuickConnection(QString hostname, qint16 port, void * m, NetworkConnection * c, QuickConnectionType t) :
 msginfo(m), connection(c), type(t)
 {
-	qsocket = new QTcpSocket();	//try with no parent passed for now
+	qsocket = connection->createSocket();
 	if(!qsocket)
 	{
 		success = 0;
@@ -20,6 +20,7 @@
  ***************************************************************************/
 
 #include <QDebug>
+#include <QTimer>
 #include "room.h"
 #include "listviews.h"
 #include "talk.h"
@@ -29,6 +30,7 @@
 #include "playergamelistings.h"
 #include "boarddispatch.h"	//so we can remove observers
 #include "networkconnection.h"
+#include "listingcache.h"
 
 #include "ui_connectionwidget.h" // Contains declaration of Ui::ConnectionWidget, needed in Room::Room, FIXME
 
@@ -96,6 +98,13 @@ Room::Room(NetworkConnection * c)
 
     joinObserveAct = new QAction(tr("Join and Observe"), 0);
     observeOutsideAct = new QAction(tr("Observe Outside"), 0);
+
+    staleTimer = new QTimer(this);
+    staleTimer->setSingleShot(true);
+    staleTimer->setInterval(LISTINGCACHE_GRACE);
+    connect(staleTimer, SIGNAL(timeout()), SLOT(slot_dropStaleListings()));
+
+    loadListingCache();
 }
 
 Room::~Room()
@@ -107,15 +116,109 @@ Room::~Room()
     connectionWidget->playerListProxyModel->setSourceModel(NULL);
     connectionWidget->gamesListProxyModel->setSourceModel(NULL);
     connectionWidget->room = NULL;
+    saveListingCache();
     while (! playerListModel->items.isEmpty())
         delete playerListModel->items.takeLast();
     while (! gamesListModel->items.isEmpty())
         delete gamesListModel->items.takeLast();
+    qDeleteAll(retiredGames);
 	delete playerListModel;
 	delete gamesListModel;
     talkMap.clear();
 }
 
+/* The lists from last time go up right away, greyed out.  The server's
+ * lists then update them in place as they come in, since listings are
+ * looked up by name and number, and whatever it doesn't mention again
+ * is taken down after LISTINGCACHE_GRACE. */
+void Room::loadListingCache(void)
+{
+    QList<PlayerListing *> cachedPlayers;
+    QList<GameListing *> cachedGames;
+    if(!ListingCache::load(connection->getConnectionType(), connection->getHostname(), cachedPlayers, cachedGames))
+        return;
+    for(int i = 0; i < cachedPlayers.size(); i++)
+    {
+        if(stalePlayers.contains(cachedPlayers[i]->name))
+        {
+            delete cachedPlayers.takeAt(i--);
+            continue;
+        }
+        stalePlayers.insert(cachedPlayers[i]->name, cachedPlayers[i]);
+    }
+    for(int i = 0; i < cachedGames.size(); i++)
+    {
+        if(staleGames.contains(cachedGames[i]->number))
+        {
+            delete cachedGames.takeAt(i--);
+            continue;
+        }
+        staleGames.insert(cachedGames[i]->number, cachedGames[i]);
+    }
+    playerListModel->insertListings(cachedPlayers);
+    gamesListModel->insertListings(cachedGames);
+    staleTimer->start();
+}
+
+/* Reconnecting keeps the room and the player listings, so whatever
+ * points at them stays good.  Players are stale until the new server
+ * lists them again by name, and anyone it doesn't is taken down once
+ * staleTimer runs out.  Game numbers only mean something on the server
+ * that gave them out, so the games come off the list instead.  They
+ * aren't deleted, the boards that were let go of may still point at them. */
+void Room::markListingsStale(void)
+{
+    for(int i = 0; i < playerListModel->items.count(); i++)
+    {
+        PlayerListing * p = playerListModel->items[i];
+        p->playing = 0;
+        p->observing = 0;
+        p->room_list.clear();
+        if(!p->online || p->stale)
+            continue;
+        p->stale = true;
+        stalePlayers.insert(p->name, p);
+    }
+    staleGames.clear();
+    if(!gamesListModel->items.isEmpty())
+    {
+        retiredGames += gamesListModel->items;
+        gamesListModel->clearList();
+    }
+    playerListModel->updateAll();
+    staleTimer->start();
+}
+
+void Room::saveListingCache(void)
+{
+    if(connection)
+        ListingCache::save(connection->getConnectionType(), connection->getHostname(),
+                           playerListModel->items, gamesListModel->items);
+}
+
+/* Listings are never deleted while the room is up, leftovers just go
+ * offline like anyone else who left */
+void Room::slot_dropStaleListings(void)
+{
+    QHash<QString, PlayerListing *>::iterator p;
+    for(p = stalePlayers.begin(); p != stalePlayers.end(); ++p)
+    {
+        p.value()->stale = false;
+        p.value()->online = false;
+        p.value()->id = 0;
+        playerListModel->updateEntry(p.value());
+    }
+    stalePlayers.clear();
+    QHash<unsigned int, GameListing *>::iterator g;
+    for(g = staleGames.begin(); g != staleGames.end(); ++g)
+    {
+        g.value()->stale = false;
+        g.value()->running = false;
+        gamesListModel->updateListing(g.value());
+    }
+    staleGames.clear();
+}
+
 void Room::onError(void)
 {
 	/* We're going to call this straight from the network dispatch
@@ -278,6 +381,23 @@ PlayerListing * Room::getPlayerListing(const unsigned int id)
     return result;
 }
 
+/* For servers that look players up by id.  Ids don't last past a
+ * reconnect, so a player from before one is found by name instead and
+ * keeps their old listing under the new id. */
+PlayerListing * Room::getPlayerListing(const unsigned int id, const QString & name)
+{
+    PlayerListing * result = playerListModel->getEntry(id);
+    if (result != NULL)
+        return result;
+    result = stalePlayers.take(name);
+    if (result == NULL)
+        return getPlayerListing(id);
+    result->stale = false;
+    result->id = id;
+    playerListModel->updateEntry(result);
+    return result;
+}
+
 // The reason to have this function seems to date from performance issues around 2011.
 /* Here's the deal with this.  Tygem has a username and a nickname.
  * the nickname is displayed and generally present, but not always.  The username
@@ -321,6 +441,11 @@ GameListing * Room::getGameListing(unsigned int key)
     return result;
 }
 
+GameListing * Room::getIfGameListing(unsigned int key)
+{
+    return gamesListModel->getEntry(key);
+}
+
 /* Called from getNewEntry in BoardDispatchRegistry in networkconnection.cpp */
 class BoardDispatch * Room::getNewBoardDispatch(unsigned int key)
 {
@@ -340,6 +465,29 @@ class BoardDispatch * Room::getNewBoardDispatch(unsigned int key)
 
 void Room::recvPlayerListing(PlayerListing *player)
 {
+    if(!stalePlayers.isEmpty())
+    {
+        /* A player looked up by id before their listing came in
+         * has a new listing, the old one with the same name then goes */
+        PlayerListing * cached = stalePlayers.take(player->name);
+        if(cached && cached != player)
+        {
+            cached->stale = false;
+            cached->online = false;
+            cached->id = 0;
+            if(cached->dialog_opened)
+            {
+                Talk * t = talkMap.take(cached);
+                if(t)
+                {
+                    talkMap.insert(player, t);
+                    t->setPlayerListing(player);
+                }
+            }
+            playerListModel->updateEntry(cached);
+        }
+        player->stale = false;
+    }
     playerListModel->updateEntry(player);
 
     if(!player->online)
@@ -373,15 +521,16 @@ void Room::recvPlayerListing(PlayerListing *player)
 			if(player->dialog_opened)
                 closeTalk(player);
 		}
-		std::vector<unsigned short>::iterator room_listit = player->room_list.begin();
-		while(room_listit != player->room_list.end())
+		/* recvObserver takes the game off the list, from the back
+		 * that doesn't move the others */
+		while(!player->room_list.empty())
 		{
-			BoardDispatch * boarddispatch = connection->getIfBoardDispatch(*room_listit);
+			unsigned short game_id = player->room_list.back();
+			BoardDispatch * boarddispatch = connection->getIfBoardDispatch(game_id);
 			if(boarddispatch)
 				boarddispatch->recvObserver(player, false);
-			else
-				player->room_list.erase(room_listit);
-			room_listit = player->room_list.begin();
+			if(!player->room_list.empty() && player->room_list.back() == game_id)
+				player->room_list.pop_back();
 		}
 		if(player->friendWatchType != PlayerListing::none)
             connection->getAndSetFriendWatchType(player);  //removes
@@ -402,6 +551,11 @@ void Room::recvPlayerListing(PlayerListing *player)
 
 void Room::recvGameListing(GameListing * game)
 {
+    if(game->stale)
+    {
+        game->stale = false;
+        staleGames.remove(game->number);
+    }
     gamesListModel->updateListing(game);
 	/* This WAS iffy, we WERE using the other ID registry's
 	 * existence to indicate an ORO connection in order
@@ -25,6 +25,7 @@
 
 #include <QObject>
 #include <QString>
+#include <QHash>
 #include <QTableView>
 
 class NetworkConnection;
@@ -35,6 +36,7 @@ class FilteredView;
 class PlayerListModel;
 class GamesListModel;
 class Talk;
+class QTimer;
 
 /* The main purpose of this class is to manage player and game listings.
  * Listings must be created and retrieved using get...() methods of this class.
@@ -57,8 +59,11 @@ class Room : public QObject
         // These functions create a listing if it does not exist
 		PlayerListing * getPlayerListing(const QString & name);
         PlayerListing * getPlayerListing(const unsigned int id);
+        PlayerListing * getPlayerListing(const unsigned int id, const QString & name);
         PlayerListing * getPlayerListingByNotNickname(const QString & notnickname);
 		GameListing * getGameListing(unsigned int key);
+        // This function returns NULL if no listing exists
+        GameListing * getIfGameListing(unsigned int key);
 
 		BoardDispatch * getNewBoardDispatch(unsigned int key);
 
@@ -67,11 +72,13 @@ class Room : public QObject
         // This function returns NULL if no Talk exists
         Talk * getIfTalk(const PlayerListing *opponent);
         void closeTalk(const PlayerListing *opponent);
+        void markListingsStale(void);
 public slots:
         void slot_refreshGames(void);
         void slot_refreshPlayers(void);
         void recvPlayerListing(PlayerListing *g);
         void recvGameListing(GameListing *g);
+        void slot_dropStaleListings(void);
     protected:
 		unsigned int players;
 		unsigned int games;
@@ -90,6 +97,10 @@ public slots:
         QAction *joinObserveAct, *observeOutsideAct;
 
         QMap <const PlayerListing *, Talk *> talkMap;
+        QHash <QString, PlayerListing *> stalePlayers;
+        QHash <unsigned int, GameListing *> staleGames;
+        QList <GameListing *> retiredGames;
+        QTimer * staleTimer;
 	private slots:
         // These slots expect QModelIndex from the proxy models
         void slot_playerOpenTalk(const QModelIndex &);
@@ -98,6 +109,8 @@ public slots:
 		void slot_showGamesPopup(const QPoint & iPoint);
 private:
         void openTalk(PlayerListing * listing);
+        void loadListingCache(void);
+        void saveListingCache(void);
 };
 
 #endif //ROOM_H
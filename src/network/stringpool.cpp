@@ -0,0 +1,57 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#include "stringpool.h"
+#include "defines.h"
+
+QSet<QString> StringPool::strings;
+QHash<QTextCodec *, QHash<QByteArray, QString> > StringPool::decoded;
+
+QString StringPool::intern(const QString & s)
+{
+	QSet<QString>::const_iterator i = strings.constFind(s);
+	if(i != strings.constEnd())
+		return *i;
+	if(strings.size() >= STRINGPOOL_MAX)
+	{
+		/* Listings already holding strings keep them, they just
+		 * aren't shared with later ones */
+		qDebug("String pool full, starting over");
+		strings.clear();
+	}
+	strings.insert(s);
+	return s;
+}
+
+QString StringPool::decode(QTextCodec * codec, const char * bytes, int len)
+{
+	QHash<QByteArray, QString> & d = decoded[codec];
+	QByteArray key = QByteArray::fromRawData(bytes, len);
+	QHash<QByteArray, QString>::const_iterator i = d.constFind(key);
+	if(i != d.constEnd())
+		return *i;
+	if(d.size() >= STRINGPOOL_MAX)
+		d.clear();
+	QString s = intern(codec ? codec->toUnicode(bytes, len) : QString::fromLatin1(bytes, len));
+	d.insert(QByteArray(bytes, len), s);
+	return s;
+}
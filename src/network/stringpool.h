@@ -0,0 +1,45 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <QtCore>
+
+/* Ranks, countries, idle times, open flags and the like come from a
+ * small set of values but arrive with every player listing.  Interned
+ * here, every listing holding one shares a single copy, so a QString
+ * member costs about what a small code would.  Names and other strings
+ * in server bytes can be decoded through here as well, which only runs
+ * the codec the first time a given byte string is seen. */
+class StringPool
+{
+public:
+	static QString intern(const QString & s);
+	static QString decode(QTextCodec * codec, const char * bytes, int len);
+
+private:
+	static QSet<QString> strings;
+	static QHash<QTextCodec *, QHash<QByteArray, QString> > decoded;
+};
+
+#endif //STRINGPOOL_H
@@ -97,6 +97,15 @@ void Talk::recvTalk(QString text)
     ui.MultiLineEdit1->append(opponent->name + ": " + text);
 }
 
+/* The player came back under a new listing, after a reconnect */
+void Talk::setPlayerListing(PlayerListing * player)
+{
+    opponent->dialog_opened = false;
+    opponent = player;
+    opponent->dialog_opened = true;
+    updatePlayerListing();
+}
+
 void Talk::updatePlayerListing(void)
 {
     if (opponent == NULL)
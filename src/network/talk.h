@@ -41,6 +41,7 @@ public:
     bool getConversationOpened(void) const { return conversationOpened; }
     void setConversationOpened(bool c) { conversationOpened = c; }
     void recvTalk(QString text);
+    void setPlayerListing(PlayerListing * player);
 public slots:
 	void slot_returnPressed();
 	void slot_pbRelTab();
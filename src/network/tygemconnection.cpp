@@ -42,6 +42,8 @@
 #include "gamedata.h"
 #include "playergamelistings.h"
 #include "matchnegotiationstate.h"
+#include "stringpool.h"
+#include "logging.h"
 #include <QMessageBox>
 
 //#define RE_DEBUG
@@ -120,8 +122,9 @@ unsigned char zodiac_byte;
 		FIXME */
 
 TygemConnection::TygemConnection(const ConnectionCredentials credentials)
-    : NetworkConnection(credentials)
+    : NetworkConnection(credentials), packetFramer(PacketFramer::BigEndian16At0)
 {
+	metrics.setHexTypes(true);
 	textCodec = QTextCodec::codecForLocale();
 	serverCodec = QTextCodec::codecForLocale();
 	//FIXME check for validity of codecs ??? 
@@ -432,7 +435,7 @@ QTime TygemConnection::gd_checkMainTime(TimeSystem s, const QTime & t)
 	int seconds = (t.hour() * 3600) + (t.minute() * 60) + t.second();
 	bool increase;
 	int i, hours, minutes;
-	printf("maintime: %d %d", seconds, lastMainTimeChecked);
+	qCDebug(logProtocol, "maintime: %d %d", seconds, lastMainTimeChecked);
 	if(lastMainTimeChecked == seconds)
 		return t;
 	if(seconds < lastMainTimeChecked)
@@ -487,7 +490,7 @@ QTime TygemConnection::gd_checkPeriodTime(TimeSystem s, const QTime & t)
 	int seconds = (t.minute() * 60) + t.second();
 	bool increase;
 	int i, minutes;
-	printf("periodtime: %d %d", seconds, lastPeriodTimeChecked);
+	qCDebug(logProtocol, "periodtime: %d %d", seconds, lastPeriodTimeChecked);
 	if(lastPeriodTimeChecked == seconds)
 		return t;
 	if(seconds < lastPeriodTimeChecked)
@@ -612,7 +615,6 @@ void TygemConnection::acceptMatchOffer(const PlayerListing * opponent, MatchRequ
 void TygemConnection::handlePendingData()
 {
 	unsigned char * c;
-	unsigned char header[4];
 	unsigned int packet_size;
 	int bytes;
 	
@@ -715,7 +717,6 @@ void TygemConnection::handlePendingData()
 						//we can't continue
 						//special response
 						qDebug("Already logged in? Too recent?");
-						fflush(stdout);
 						//00080698ff010072
 						retryLoginTimerID = startTimer(2000);
 						/* FIXME its real ugly if this happens
@@ -746,22 +747,25 @@ void TygemConnection::handlePendingData()
 			break;
 		case SETUP:
 		case CONNECTED:
-            while((bytes = qsocket->bytesAvailable()))
+			/* A handler's modal dialog can bring us back here, the inner
+			 * call dispatches what comes in meanwhile.  Handlers can also
+			 * close or change the connection under us. */
+			packetFramer.hold();
+			do
 			{
-                qsocket->peek((char *)header, 4);
+				while((connectionState == SETUP || connectionState == CONNECTED) &&
+				      packetFramer.nextPacket(&c, &packet_size))
+				{
 #ifdef RE_DEBUG
 #ifdef NOISY_DEBUG
-				printf("%02x%02x%02x%02x\n", header[0], header[1], header[2], header[3]);
+					printf("%02x%02x%02x%02x\n", c[0], c[1], c[2], c[3]);
 #endif //NOISY_DEBUG
 #endif //RE_DEBUG
-				packet_size = header[1] + (header[0] << 8);
-				if((unsigned)bytes < packet_size)
-					break;
-				c = new unsigned char[packet_size + 1];
-                qsocket->read((char *)c, packet_size);
-				handleMessage(c, packet_size);
-				delete[] c;
-			}
+					handleMessage(c, packet_size);
+				}
+			} while(qsocket && (connectionState == SETUP || connectionState == CONNECTED) &&
+			        packetFramer.fill(qsocket) > 0);
+			packetFramer.release();
 			break;
 		case CANCELED:
 		case RECONNECTING:
@@ -921,6 +925,9 @@ void TygemConnection::sendLogin(bool response_bit, bool change_server)
 	printf("\n");
 #endif //RE_DEBUG
 
+	/* encoded, the capture can't find it, and the checksum at the end
+	 * would give it away as well */
+	maskNextWrite(24, length - 24);
 	if(write((const char *)packet, length) < 0)
 		qWarning("*** failed sending login");
 	delete[] packet;
@@ -1255,7 +1262,7 @@ int TygemConnection::reconnectToServer(void)
 	if(connectionState == CONNECTED)
 	{
 		sendDisconnectMsg();
-		closeConnection(false);
+		closeConnection(false, true);
 		reconnecting = true;
 	}
 	else if(connectionState == LOGIN)
@@ -1265,14 +1272,13 @@ int TygemConnection::reconnectToServer(void)
 	}
 	else
 		reconnecting = false;
+	packetFramer.clear();
 	if(openConnection(serverList[server_i]->ipaddress, 12320))
 	{
 		qDebug("Reconnected %d", reconnecting);
         setState(LOGIN);
 		sendLogin(false, false);
 		//sendLogin(reconnecting, reconnecting);
-		fflush(stdout);
-		fflush(stderr);
 		onAuthenticationNegotiated();
 	}
 	else
@@ -1368,17 +1374,11 @@ void TygemConnection::sendPersonalChat(const PlayerListing * , const char * )
 	packet[i + 2] = 0x00;
 	packet[i + 3] = 0x00;
 	
-	printf("personal chat before encode\n");
-	for(i = 0; i < length; i++)
-		printf("%02x", packet[i]);
-	printf("\n");
+	qCDebug(logProtocol, "personal chat before encode %s", Log::hex(packet, length).constData());
 	
 	encode(packet, (length / 4) - 2);
 	
-	printf("personal chat after encode\n");
-	for(i = 0; i < length; i++)
-		printf("%02x", packet[i]);
-	printf("\n");
+	qCDebug(logProtocol, "personal chat after encode %s", Log::hex(packet, length).constData());
 	if(write((const char *)packet, length) < 0)
 		qWarning("*** failed sending personal chat");
 	delete[] packet;*/
@@ -4010,31 +4010,32 @@ void TygemConnection::sendDisconnectMsg(void)
 
 void TygemConnection::encode(unsigned char * p, unsigned int cycles)
 {
-	uint32_t b, c = 0;
-	uint32_t header = *(uint32_t *)p;
+	uint32_t header, checksum;
+	memcpy(&header, p, 4);
 	header ^= encode_offset;
-	p += 4;
-	while(cycles--)
-	{
-		b = *(uint32_t *)p;
-		c ^= b;
-		b ^= header;
-		*(uint32_t *)p = b;
-		p += 4;
-	}
-	*(uint32_t *)p = c;
+	checksum = PacketFramer::xorWords32(p + 4, cycles, header);
+	memcpy(p + 4 + (cycles * 4), &checksum, 4);
 }
 
 void TygemConnection::handleMessage(QString)
 {
 }
 
+/* Length then type, encode() leaves the header alone */
+unsigned int TygemConnection::outgoingMessageType(const char * packet, unsigned int size)
+{
+	if(size < 4)
+		return 0;
+	return (unsigned char)packet[3] + ((unsigned char)packet[2] << 8);
+}
+
 /* We may convert everything here to unsigned char *s, delete the old...
  * we're still sort of hung up on all the things we were doing
  * to work with the IGS code. */
 void TygemConnection::handleMessage(unsigned char * msg, unsigned int size)
 {
 	unsigned short message_type = msg[3] + (msg[2] << 8);
+	ConnectionMetrics::Handler timed(metrics, message_type, size);
 	int i;
 	//message_type = msg[0];
 	//message_type >>= 8;
@@ -4134,7 +4135,7 @@ void TygemConnection::handleMessage(unsigned char * msg, unsigned int size)
 			else if(msg[43] == 0x03)	//double check
 				handleMatchOffer(msg, size, decline);
 			else
-				printf("*** 0645 match offer has strange type: %02x!!!\n", msg[43]);
+				qCWarning(logProtocol, "*** 0645 match offer has strange type: %02x!!!", msg[43]);
 			//type 0x1e could be rematch, or something else
 			break;
 		case TPC(TYGEM_MATCHOFFERRESPONSE):
@@ -4208,10 +4209,7 @@ void TygemConnection::handleMessage(unsigned char * msg, unsigned int size)
 			//who sends it... we get it if we request the count
 			//from them and they agree FIXME
 			//game number two bytes for colors sender something, also seen CSP nearby
-			printf("0x0674: ");
-			for(i = 0; i < (int)size; i++)
-				printf("%02x", msg[i]);
-			printf("\n");
+			qCDebug(logProtocol, "0x0674: %s", Log::hex(msg, size).constData());
 			//I think this starts the review, maybe not
 			break;
 			//an REM -1 -1 likely proceeds these as meaning done?
@@ -4449,20 +4447,15 @@ void TygemConnection::handlePlayerList(unsigned char * msg, unsigned int size)
 		else
 			special_account = false;
 		strncpy((char *)name, (char *)p, 14);
-		encoded_name = serverCodec->toUnicode((char *)name, strlen((char *)name));
+		encoded_name = StringPool::decode(serverCodec, (char *)name, strlen((char *)name));
 		if(p[14])
-			printf("FIXME player 14 char:\n\n");
+			qCDebug(logProtocol, "FIXME player 14 char:");
 		p += 15;
 		//rank byte
-		if(p[0] < 0x12)
-			rank = QString::number(0x12 - p[0]) + 'k';
-		else if(p[0] > 0x1a)
-			rank = QString::number(p[0] - 0x1a) + 'p';
-		else
-			rank = QString::number(p[0] - 0x11) + 'd';
+		rank = rankFromByte(p[0]);
 		p++;
 		strncpy((char *)name, (char *)p, 11);
-		encoded_name2 = serverCodec->toUnicode((char *)name, strlen((char *)name));
+		encoded_name2 = StringPool::decode(serverCodec, (char *)name, strlen((char *)name));
 		//another name
 		aPlayer = room->getPlayerListing(encoded_name2);
         aPlayer->notnickname = encoded_name;
@@ -4485,7 +4478,7 @@ void TygemConnection::handlePlayerList(unsigned char * msg, unsigned int size)
 		if(p[0])
 		{
 			//FIXME
-			printf("player uses username, not nickname?!?\n");
+			qCDebug(logProtocol, "player uses username, not nickname?!?");
 			/* If this occurs often, ... well its one thing to store
 			 * the player on the username, but if it affects the game
 			 * listing displays, we have to check the byte on the player...
@@ -4510,9 +4503,9 @@ void TygemConnection::handlePlayerList(unsigned char * msg, unsigned int size)
 		p += 2;
 		//p[0] probably means keyi, can contact with game
 		if(p[0])
-			aPlayer->info = "X";
+			aPlayer->info = StringPool::intern("X");
 		else
-			aPlayer->info = "O";
+			aPlayer->info = StringPool::intern("O");
 		//p[1]
 		//00  
 		//01  might mean observing
@@ -4539,6 +4532,22 @@ void TygemConnection::handlePlayerList(unsigned char * msg, unsigned int size)
 		promptResumeMatch();
 }
 
+/* Player list rank byte, each rank built and pooled once */
+QString TygemConnection::rankFromByte(unsigned char byte)
+{
+	static QString ranks[256];
+	if(ranks[byte].isNull())
+	{
+		if(byte < 0x12)
+			ranks[byte] = StringPool::intern(QString::number(0x12 - byte) + 'k');
+		else if(byte > 0x1a)
+			ranks[byte] = StringPool::intern(QString::number(byte - 0x1a) + 'p');
+		else
+			ranks[byte] = StringPool::intern(QString::number(byte - 0x11) + 'd');
+	}
+	return ranks[byte];
+}
+
 QString TygemConnection::rating_pointsToRank(unsigned int rp)
 {
 	int rem = rp % 1000;
@@ -4690,7 +4699,7 @@ void TygemConnection::handleFriendsBlocksList(unsigned char * msg, unsigned int
 		else if(msg[i] == 0xff)
 			blockedList.push_back(new FriendWatchListing(encoded_name, friendwatch_notify_default));
 		else
-			printf("unknown indicator: %02x\n", msg[i]);
+			qCWarning(logProtocol, "unknown indicator: %02x", msg[i]);
 #ifdef RE_DEBUG
 		printf("%02x %s %s\n", msg[i], encoded_name.toLatin1().constData(), name);
 #endif //RE_DEBUG
@@ -5477,7 +5486,7 @@ void TygemConnection::handlePersonalChat(unsigned char * msg, unsigned int size)
 	p++;
 	subject_size = p[0];
 	p++;
-	printf("Subjectsize: %d\n", subject_size);
+	qCDebug(logProtocol, "Subjectsize: %d", subject_size);
 	if(subject_size > (size - 47))
 	{
 		qDebug("Bad message subject size: %d", subject_size);
@@ -5489,7 +5498,7 @@ void TygemConnection::handlePersonalChat(unsigned char * msg, unsigned int size)
 	p += subject_size;
 	msg_size = (p[0] << 8) + p[1];		//tygem caps at 1024
 	p += 2;
-	printf("msg_size: %d\n", msg_size);
+	qCDebug(logProtocol, "msg_size: %d", msg_size);
 	if(msg_size > (size - (47 + subject_size + 2)))
 	{
 		qDebug("Bad message msg size: %d", msg_size);
@@ -5608,12 +5617,12 @@ void TygemConnection::handleObserverList(unsigned char * msg, unsigned int size)
 		if(p[1] == 0x39)
 		{
 			p += 4;
-			printf("observer, what the hell is this\n");
+			qCDebug(logProtocol, "observer, what the hell is this");
 			continue;
 		}
 		else if(p[1] != 0x02)
 		{
-			printf("%02x%02x\n", p[0], p[1]);
+			qCDebug(logProtocol, "%02x%02x", p[0], p[1]);
 		}
 #ifdef RE_DEBUG
 		for(int i = 0; i < 0x34; i++)
@@ -5624,7 +5633,7 @@ void TygemConnection::handleObserverList(unsigned char * msg, unsigned int size)
 		p++;
 		if(!p[0])
 		{
-			printf("Observer Guest\n");
+			qCDebug(logProtocol, "Observer Guest");
 			//0002 0000 5b47 3337 3039 5d32 3000 0000
 			//0000 0000 5b47 3337 3039 5d32 3000 0000
 			//0000 0100 0000 0000 0000 0000 0000 0000
@@ -5704,7 +5713,7 @@ void TygemConnection::handleObserverList(unsigned char * msg, unsigned int size)
 		strncpy((char *)name, (char *)p, country_size);
 		name[country_size] = '\0';
 		p += country_size;
-		aPlayer->country = QString((char *)name);
+		aPlayer->country = StringPool::intern(QString((char *)name));
 		/*recvObserver does not make a copy at any point.
 		 *its supposed that the player listing comes from
 		 *the full listing and will be handled with that.*/
@@ -5936,7 +5945,7 @@ void TygemConnection::handleGameResult(unsigned char * msg, unsigned int size)
 	p += 2;
     // moves = (msg[24] << 8) + msg[25];
 	p += 2;
-	printf("%02x%02x is in 0672 after margin and moves\n", p[0], p[1]);		//p[0] may need to be xored with wff
+	qTrace(logProtocol, "%02x%02x is in 0672 after margin and moves", p[0], p[1]);		//p[0] may need to be xored with wff
 	p += 2;
 	//times
 	
@@ -7248,7 +7257,7 @@ void TygemConnection::handleMove(unsigned char * msg, unsigned int size)
 		delete aMove;
 	}
 	else
-		printf("Unknown: %s\n", (char *)p);
+		qCWarning(logProtocol, "Unknown: %s", (char *)p);
 }
 
 void TygemConnection::handlePass(unsigned char * msg, unsigned int size, int /* FIXME */)
@@ -7598,7 +7607,7 @@ void TygemConnection::handleMatchOpened(unsigned char * msg, unsigned int size)
 			aGameData->timeSystem = byoyomi;
 			break;
 		default:
-			printf("Time system: %02x!!!\n", p[0]);
+			qCDebug(logProtocol, "Time system: %02x!!!", p[0]);
 			break;
 	}*/
 	// TIME is wrong FIXME
@@ -7895,7 +7904,7 @@ void TygemConnection::handleMatchOffer(unsigned char * msg, unsigned int size, M
 			tempmr->color_request = MatchRequest::NIGIRI;
 			break;
 		default:
-			printf("Strange byte in match offer: %02x", p[6]);
+			qCWarning(logProtocol, "Strange byte in match offer: %02x", p[6]);
 			break;
 	}
 	p += 7;
@@ -7914,7 +7923,7 @@ void TygemConnection::handleMatchOffer(unsigned char * msg, unsigned int size, M
 	else if(p[1] == 0x00)
 		tempmr->free_rated = RATED;
 	else
-		printf("match offer with friendly/rated %02x %02x", p[0], p[1]);
+		qCDebug(logProtocol, "match offer with friendly/rated %02x %02x", p[0], p[1]);
 	p += 2;
 	//message version byte
 	p++;
@@ -8044,10 +8053,7 @@ void TygemConnection::handleResumeMatch(unsigned char * msg, unsigned int size)
 	//a game they disconnected from
 	//the last byte msg[35] is 0x01
 	//made a mistake, that was from us.. 
-	printf("***0x068e: ");
-	for(i = 0; i < (int)size; i++)
-		printf("%02x", msg[i]);
-	printf("\n");
+	qCDebug(logProtocol, "***0x068e: %s", Log::hex(msg, size).constData());
 	
 	if(encoded_name == getUsername() && msg[35] == 0x01)
 	{
@@ -8270,7 +8276,7 @@ void TygemConnection::handleCreateRoomResponse(unsigned char * msg, unsigned int
 	 * so we'll just send the join message and pray for rain */
 	if(msg[2] != 0x01 || msg[3] != 0xff)
 	{
-		printf("roomcreate: %02x %02x\n", msg[2], msg[3]);
+		qCDebug(logProtocol, "roomcreate: %02x %02x", msg[2], msg[3]);
 	}
 	//0x0637 room create?: 0129 01ff 0000 0000 0000 0000
 #ifdef RE_DEBUG
@@ -8369,5 +8375,5 @@ void TygemConnection::secondsToDate(unsigned short & year, unsigned char & month
 		}
 	}
 	
-	printf("Todays date is: %d %d %d - %d %d %d\n", year, month, day, hour, minute, second);
+	qCDebug(logProtocol, "Todays date is: %d %d %d - %d %d %d", year, month, day, hour, minute, second);
 }
@@ -25,6 +25,7 @@
 #include <QtNetwork>
 #include "networkconnection.h"
 #include "messages.h"
+#include "packetframer.h"
 #include <vector>
 #include <stdint.h>
 
@@ -189,10 +190,12 @@ class TygemConnection : public NetworkConnection
 		void encode(unsigned char * h, unsigned int cycle_size);
 		void handleMessage(QString msg);
 		void handleMessage(unsigned char * msg, unsigned int size);
+		virtual unsigned int outgoingMessageType(const char * packet, unsigned int size);
 		void handleConnected(unsigned char * msg, unsigned int size);
 		void handlePlayerList(unsigned char * msg, unsigned int size);
 		void handleFriendsBlocksList(unsigned char * msg, unsigned int size);
 		void handleServerPlayerCounts(unsigned char * msg, unsigned int size);
+		QString rankFromByte(unsigned char byte);
 		QString rating_pointsToRank(unsigned int rp);
 		QString getCountryFromCode(unsigned char code);
 		int getPhase(unsigned char byte);
@@ -246,6 +249,7 @@ class TygemConnection : public NetworkConnection
 		std::vector<PlayerListing *> decline_all_invitations;
 		QTextCodec * textCodec;
 		unsigned long encode_offset;
+		PacketFramer packetFramer;
 		
 		std::map <PlayerListing *, QString> pendingConversationMsg;
 		
@@ -1037,9 +1037,7 @@ void WingConnection::handle_info(QString line)
 				
 	else if (line.contains("Rating:"))
 	{
-		statsPlayer->rank = element(line, 1, " ");
-		fixRankString(&(statsPlayer->rank));
-		statsPlayer->rank_score = rankToScore(statsPlayer->rank);
+		setPlayerRank(statsPlayer, element(line, 1, " "));
 		return;
 	}
 			
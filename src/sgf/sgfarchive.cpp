@@ -0,0 +1,132 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#include "sgfarchive.h"
+#include "sgfparser.h"
+
+#include <QDirIterator>
+
+SGFArchive::SGFArchive()
+{
+}
+
+void SGFArchive::clear(void)
+{
+	index.clear();
+	files.clear();
+	entryFiles.clear();
+	entryTexts.clear();
+}
+
+/* Only node boundaries and C and N values matter here.  Escapes are
+ * undone, anything else in the values is left as it is. */
+static void scanNodes(const QString & sgf, QStringList & texts)
+{
+	QString text, ident;
+	bool inNode = false, inIdent = false;
+	int n = sgf.size();
+	for(int i = 0; i < n; i++)
+	{
+		QChar c = sgf.at(i);
+		if(c == '[')
+		{
+			QString value;
+			for(i++; i < n && sgf.at(i) != ']'; i++)
+			{
+				if(sgf.at(i) == '\\' && i + 1 < n)
+					i++;
+				value += sgf.at(i);
+			}
+			if(ident == "C" || ident == "N")
+				text += value + "\n";
+			inIdent = false;
+		}
+		else if(c == ';' || c == '(' || c == ')')
+		{
+			if(inNode && !text.trimmed().isEmpty())
+				texts << text;
+			text.clear();
+			ident.clear();
+			inNode = (c == ';');
+			inIdent = false;
+		}
+		else if(c.isUpper())
+		{
+			if(!inIdent)
+				ident.clear();
+			ident += c;
+			inIdent = true;
+		}
+		else if(!c.isLower())		//old files have lower case in identifiers
+			inIdent = false;
+	}
+	if(inNode && !text.trimmed().isEmpty())
+		texts << text;
+}
+
+bool SGFArchive::addFile(const QString & path)
+{
+	SGFParser parser(NULL);
+	QString sgf = parser.loadFile(path);
+	if(sgf.isNull())
+		return false;
+	QStringList texts;
+	scanNodes(sgf, texts);
+	for(int i = 0; i < texts.size(); i++)
+	{
+		index.addEntry(texts[i]);
+		entryFiles.append(files.size());
+		entryTexts << texts[i];
+	}
+	files << path;
+	return true;
+}
+
+/* Entries go in file by file, so a file's matches come together */
+QList<SGFArchive::Match> SGFArchive::find(const QString & query) const
+{
+	QList<Match> result;
+	QVector<int> entries = index.find(query);
+	int file = -1, ordinal = 0;
+	for(int i = 0; i < entries.size(); i++)
+	{
+		int f = entryFiles[entries[i]];
+		ordinal = (f == file) ? ordinal + 1 : 0;
+		file = f;
+		Match m;
+		m.path = files[f];
+		m.ordinal = ordinal;
+		m.text = SearchIndex::snippet(entryTexts[entries[i]], query);
+		result << m;
+	}
+	return result;
+}
+
+QStringList SGFArchive::listFiles(const QString & folder)
+{
+	QStringList result;
+	QDirIterator i(folder, QStringList() << "*.sgf" << "*.SGF", QDir::Files, QDirIterator::Subdirectories);
+	while(i.hasNext())
+		result << i.next();
+	result.sort();
+	return result;
+}
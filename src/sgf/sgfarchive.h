@@ -0,0 +1,56 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#ifndef SGFARCHIVE_H
+#define SGFARCHIVE_H
+
+#include "searchindex.h"
+
+/* Search across a folder of SGF files, for finding a position in a
+ * whole collection.  Files are only scanned for C[] and N[] text, not
+ * loaded into trees.  A match is given as its file and which match in
+ * that file it is, counting in file order.  The file's own TreeIndex
+ * counts the same way, so a board window can find it again. */
+class SGFArchive
+{
+	public:
+		struct Match
+		{
+			QString path;
+			int ordinal;
+			QString text;
+		};
+		SGFArchive();
+		void clear(void);
+		bool addFile(const QString & path);
+		int fileCount(void) const { return files.size(); }
+		QList<Match> find(const QString & query) const;
+
+		static QStringList listFiles(const QString & folder);
+	private:
+		SearchIndex index;
+		QStringList files;
+		QVector<int> entryFiles;
+		QStringList entryTexts;
+};
+
+#endif //SGFARCHIVE_H
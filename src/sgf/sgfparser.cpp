@@ -156,6 +156,8 @@ public:
 };
 
 
+bool SGFParser::interactive = true;
+
 SGFParser::SGFParser(Tree * _tree)
 //: boardHandler(bh)
 {
@@ -1183,9 +1185,12 @@ bool SGFParser::doParse(const QString &toParseStr)
 
 bool SGFParser::corruptSgf(int where, QString reason)
 {
-	QMessageBox::warning(0, PACKAGE, QObject::tr("Corrupt SGF file at position") + " " +
-			     QString::number(where) + "\n\n" +
-			     (reason.isNull() || reason.isEmpty() ? QString("") : reason));
+	if (interactive)
+		QMessageBox::warning(0, PACKAGE, QObject::tr("Corrupt SGF file at position") + " " +
+				     QString::number(where) + "\n\n" +
+				     (reason.isNull() || reason.isEmpty() ? QString("") : reason));
+	else
+		qWarning("Corrupt SGF file at position %d %s", where, reason.toLatin1().constData());
 	tree->setLoadingSGF(false);
 	return false;
 }
@@ -43,6 +43,7 @@ public:
 	bool doParse(const QString &toParseStr);
 	bool doWrite(const QString &fileName, Tree *tree, GameData *gameData);
 	bool exportSGFtoClipB(QString *str, Tree *tree, GameData *gameData);
+	static void setInteractive(bool b) { interactive = b; }
 
 protected:
 	int minPos(int n1, int n2, int n3);
@@ -62,6 +63,7 @@ private:
     bool isRoot;
 	Tree *tree;
 	bool loadedfromfile;
+	static bool interactive;	//false to only log corrupt files, when running headless
 };
 
 #endif
@@ -3,13 +3,21 @@
 #message($${CONFIG})
 RESOURCES = application.qrc  \
 	    board/board.qrc
-QT += core gui widgets network multimedia
+QT += core gui widgets network multimedia concurrent svg
 DESTDIR = ../build
 TARGET = qgo
 OBJECTS_DIR = $${DESTDIR}/objects
 MOC_DIR = $${DESTDIR}/moc
 RCC_DIR = $${DESTDIR}/rcc
 UI_DIR = $${DESTDIR}/ui
+#Counts every allocation for the --replay report, qmake CONFIG+=count_allocations
+count_allocations {
+    DEFINES += COUNT_ALLOCATIONS
+}
+#qTrace() per packet and per move logging, only in debug builds or with qmake CONFIG+=trace
+CONFIG(debug, debug|release)|trace {
+    DEFINES += QGO_TRACE
+}
 #Because I can't figureout how to turn console and exceptions off:
 win32 {
     RC_FILE = qgo.rc
@@ -49,21 +57,32 @@ FORMS += mainwindow.ui \
     newgamedialog.ui
 
 HEADERS += defines.h \
+archivesearchdialog.h \
 displayboard.h \
 gamedata.h \
 listviews.h \
+logging.h \
 mainwindow.h \
 audio/audio.h \
+audio/audioengine.h \
 game_tree/group.h \
 game_tree/matrix.h \
 game_tree/move.h \
+game_tree/searchindex.h \
 game_tree/tree.h \
+game_tree/treeindex.h \
 board/board.h \
 board/boardwindow.h \
+board/searchdialog.h \
 board/clockdisplay.h \
+board/clockservice.h \
 board/gameinfo.h \
 board/gatter.h \
+board/boarditem.h \
+board/analysisoverlay.h \
+board/diagramexporter.h \
 board/imagehandler.h \
+board/stoneatlas.h \
 board/mark.h \
 board/stone.h \
 game_interfaces/countdialog.h \
@@ -71,23 +90,32 @@ game_interfaces/qgoboard.h \
 game_interfaces/resultdialog.h \
 game_interfaces/undoprompt.h \
 gtp/qgtp.h \
+gtp/engineanalysis.h \
+gtp/enginematch.h \
 network/boarddispatch.h \
 network/codecwarndialog.h \
+network/connectionmetrics.h \
 network/consoledispatch.h \
 network/createroomdialog.h \
 network/cyberoroconnection.h \
 network/cyberoroprotocol.h \
+network/diagnosticsdialog.h \
 network/eweiqiconnection.h \
 network/friendslistdialog.h \
 network/gamedialog.h \
 network/gamedialogflags.h \
 network/igsconnection.h \
 network/lgs.h \
+network/listingcache.h \
 network/login.h \
 network/matchinvitedialog.h \
 network/matchnegotiationstate.h \
 network/messages.h \
 network/networkconnection.h \
+network/packetframer.h \
+network/protocolcapture.h \
+network/protocolreplay.h \
+network/gamearchiver.h \
 network/orosetphrasechat.h \
 network/playergamelistings.h \
 network/protocol.h \
@@ -95,11 +123,13 @@ network/quickconnection.h \
 network/room.h \
 network/serverlistdialog.h \
 network/setphrasepalette.h \
+network/stringpool.h \
 network/talk.h \
 network/tomconnection.h \
 network/tygemconnection.h \
 network/tygemprotocol.h \
 network/wing.h \
+sgf/sgfarchive.h \
 sgf/sgfparser.h \
     connectionwidget.h \
     host.h \
@@ -107,18 +137,27 @@ sgf/sgfparser.h \
     game_interfaces/qgoboardlocalinterface.h \
     newgamedialog.h
 
-SOURCES += displayboard.cpp \
+SOURCES += archivesearchdialog.cpp \
+           displayboard.cpp \
            listviews.cpp \
+           logging.cpp \
  	   main.cpp \
            mainwindow.cpp \
            mainwindow_settings.cpp \
            audio/audio.cpp \
+           audio/audioengine.cpp \
            board/board.cpp \
            board/boardwindow.cpp \
+           board/searchdialog.cpp \
            board/clockdisplay.cpp \
+           board/clockservice.cpp \
            board/gameinfo.cpp \
            board/gatter.cpp \
+           board/boarditem.cpp \
+           board/analysisoverlay.cpp \
+           board/diagramexporter.cpp \
            board/imagehandler.cpp \
+           board/stoneatlas.cpp \
            board/mark.cpp \
            board/stone.cpp \
 	   game_interfaces/countdialog.cpp \
@@ -131,32 +170,45 @@ SOURCES += displayboard.cpp \
            game_interfaces/undoprompt.cpp \
            game_tree/matrix.cpp \
            game_tree/move.cpp \
+           game_tree/searchindex.cpp \
            game_tree/tree.cpp \
+           game_tree/treeindex.cpp \
            game_tree/group.cpp \
            gtp/qgtp.cpp \
+           gtp/engineanalysis.cpp \
+           gtp/enginematch.cpp \
        	   network/boarddispatch.cpp \
 	   network/codecwarndialog.cpp \
+	   network/connectionmetrics.cpp \
 	   network/consoledispatch.cpp \
 	   network/createroomdialog.cpp \
 	   network/cyberoroconnection.cpp \
+	   network/diagnosticsdialog.cpp \
 	   network/eweiqiconnection.cpp \
 	   network/friendslistdialog.cpp \
            network/gamedialog.cpp \
 	   network/igsconnection.cpp \
 	   network/lgs.cpp \
+	   network/listingcache.cpp \
  	   network/login.cpp \
 	   network/matchinvitedialog.cpp \
 	   network/matchnegotiationstate.cpp \
 	   network/networkconnection.cpp \
+	   network/packetframer.cpp \
+	   network/protocolcapture.cpp \
+	   network/protocolreplay.cpp \
+	   network/gamearchiver.cpp \
 	   network/orosetphrasechat.cpp \
  	   network/quickconnection.cpp \
  	   network/room.cpp \
            network/serverlistdialog.cpp \
 	   network/setphrasepalette.cpp \
+	   network/stringpool.cpp \
  	   network/talk.cpp \
 	   network/tomconnection.cpp \
 	   network/tygemconnection.cpp \
 	   network/wing.cpp \
+	   sgf/sgfarchive.cpp \
 	   sgf/sgfparser.cpp \
     connectionwidget.cpp \
     host.cpp \
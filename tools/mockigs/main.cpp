@@ -0,0 +1,68 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#include <QtCore>
+#include "mockigsserver.h"
+
+int main(int argc, char ** argv)
+{
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName("mockigs");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Local IGS stand-in for loading qGo with large rooms.");
+	parser.addHelpOption();
+	QCommandLineOption portOption("port", "Listen on <port>.", "port", "6969");
+	QCommandLineOption playersOption("players", "Simulate <count> players.", "count", "3000");
+	QCommandLineOption gamesOption("games", "Keep <count> games running.", "count", "300");
+	QCommandLineOption moveRateOption("moves-per-second", "Play <rate> moves per second across all games.", "rate", "50");
+	QCommandLineOption kibitzRateOption("kibitzes-per-second", "Send <rate> kibitzes per second to observed games.", "rate", "0.5");
+	QCommandLineOption replyOption("reply-delay", "Answer moves in matches against the client after <msecs>.", "msecs", "1000");
+	QCommandLineOption lengthOption("game-length", "Score games after <min>-<max> moves.", "min-max", "150-300");
+	QCommandLineOption seedOption("seed", "Random <seed>, for repeatable runs.", "seed", "1");
+	parser.addOption(portOption);
+	parser.addOption(playersOption);
+	parser.addOption(gamesOption);
+	parser.addOption(moveRateOption);
+	parser.addOption(kibitzRateOption);
+	parser.addOption(replyOption);
+	parser.addOption(lengthOption);
+	parser.addOption(seedOption);
+	parser.process(app);
+
+	MockIGSServer::Settings settings;
+	settings.port = parser.value(portOption).toUShort();
+	settings.players = qMax(2, parser.value(playersOption).toInt());
+	/* Every game needs two players */
+	settings.games = qBound(0, parser.value(gamesOption).toInt(), settings.players / 2);
+	settings.moves_per_second = parser.value(moveRateOption).toDouble();
+	settings.kibitzes_per_second = parser.value(kibitzRateOption).toDouble();
+	settings.bot_reply_msecs = parser.value(replyOption).toInt();
+	settings.min_game_length = qMax(1, parser.value(lengthOption).section('-', 0, 0).toInt());
+	settings.max_game_length = qMax(settings.min_game_length, parser.value(lengthOption).section('-', 1, 1).toInt());
+	settings.seed = parser.value(seedOption).toUInt();
+
+	MockIGSServer server(settings);
+	if(!server.listen())
+		return 1;
+	return app.exec();
+}
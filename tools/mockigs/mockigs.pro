@@ -0,0 +1,16 @@
+#qmake file
+#Local IGS stand-in for load testing, qmake CONFIG+=mockigs from the top level
+
+QT += core network
+QT -= gui
+CONFIG += console
+CONFIG -= app_bundle
+DESTDIR = ../../build
+TARGET = mockigs
+OBJECTS_DIR = $${DESTDIR}/objects/mockigs
+MOC_DIR = $${DESTDIR}/moc/mockigs
+TEMPLATE = app
+
+HEADERS += mockigsserver.h
+SOURCES += main.cpp \
+	mockigsserver.cpp
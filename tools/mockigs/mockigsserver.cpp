@@ -0,0 +1,622 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#include "mockigsserver.h"
+
+/* Client mode prompts, 5 waiting and 6 playing, see IGSConnection::handle_prompt */
+#define PROMPT_WAITING		"1 5\r\n"
+#define PROMPT_PLAYING		"1 6\r\n"
+
+static const char columns[] = "ABCDEFGHJKLMNOPQRST";
+static const char * countries[] = { "Japan", "Korea", "China", "USA", "France", "Germany", "--" };
+static const char * kibitzes[] = { "nice move", "hane is better", "black is thick", "what about the ladder?",
+				"white is ahead", "that group is dead", "tesuji!", "hmm" };
+
+static QString randomRank(void)
+{
+	int r = qrand() % 39;
+	QString rank = (r < 30 ? QString::number(30 - r) + "k" : QString::number(r - 29) + "d");
+	return rank + "*";
+}
+
+/* IGS right aligns the number so that the kyu/dan letter stays in a column */
+static QString alignedRank(const QString & rank)
+{
+	return (rank.size() > 1 && !rank[1].isDigit() ? " " + rank : rank);
+}
+
+MockIGSServer::MockIGSServer(const Settings & s) : settings(s)
+{
+	server = new QTcpServer(this);
+	connect(server, SIGNAL(newConnection()), SLOT(slot_newConnection()));
+	tickTimer = new QTimer(this);
+	connect(tickTimer, SIGNAL(timeout()), SLOT(slot_tick()));
+	next_game_number = 1;
+	move_budget = 0;
+	kibitz_budget = 0;
+
+	qsrand(settings.seed);
+	players.resize(settings.players);
+	for(int i = 0; i < players.size(); i++)
+	{
+		players[i].name = QString("mock%1").arg(i, 5, 10, QChar('0'));
+		players[i].rank = randomRank();
+		players[i].country = countries[qrand() % (sizeof(countries) / sizeof(countries[0]))];
+		players[i].wins = qrand() % 500;
+		players[i].losses = qrand() % 500;
+		players[i].playing = 0;
+	}
+}
+
+MockIGSServer::~MockIGSServer()
+{
+	qDeleteAll(games);
+	qDeleteAll(sessions);
+}
+
+bool MockIGSServer::listen(void)
+{
+	if(!server->listen(QHostAddress::Any, settings.port))
+	{
+		qWarning("Can't listen on port %d: %s", settings.port, server->errorString().toLatin1().constData());
+		return false;
+	}
+	/* Fill the room before anyone logs in so that the first listings
+	 * are the full size */
+	while(games.size() < settings.games)
+	{
+		int white = randomIdlePlayer();
+		int black = randomIdlePlayer();
+		if(white < 0 || black < 0 || white == black)
+			break;
+		Game * game = startGame(white, black);
+		int premoves = qrand() % game->length;
+		for(int i = 0; i < premoves; i++)
+			playMove(game, randomMove(game));
+	}
+	clock.start();
+	tickTimer->start(100);
+	qDebug("mockigs listening on port %d with %d players and %d games", settings.port, players.size(), games.size());
+	return true;
+}
+
+void MockIGSServer::slot_newConnection(void)
+{
+	QTcpSocket * socket;
+	while((socket = server->nextPendingConnection()))
+	{
+		Session * session = new Session();
+		session->state = Session::LOGIN;
+		session->socket = socket;
+		session->playing = 0;
+		sessions.insert(socket, session);
+		connect(socket, SIGNAL(readyRead()), SLOT(slot_readyRead()));
+		connect(socket, SIGNAL(disconnected()), SLOT(slot_disconnected()));
+		socket->write("Login: ");
+	}
+}
+
+void MockIGSServer::slot_readyRead(void)
+{
+	QTcpSocket * socket = qobject_cast<QTcpSocket *>(sender());
+	Session * session = sessions.value(socket);
+	if(!session)
+		return;
+	while(socket->canReadLine())
+	{
+		QString line = QString::fromLatin1(socket->readLine()).trimmed();
+		switch(session->state)
+		{
+			case Session::LOGIN:
+				if(line.isEmpty())
+				{
+					socket->write("Login: ");
+					break;
+				}
+				session->name = line;
+				session->state = Session::PASSWORD;
+				socket->write("1 1\r\n");
+				break;
+			case Session::PASSWORD:
+				/* Any password will do */
+				session->state = Session::ONLINE;
+				session->rank = randomRank();
+				sendToAll(QString("21 {%1 [%2] has connected.}\r\n").arg(session->name).arg(session->rank).toLatin1());
+				socket->write(QString("9 Welcome to mockigs, %1.\r\n").arg(session->name).toLatin1());
+				sendPrompt(session);
+				break;
+			case Session::ONLINE:
+				if(!line.isEmpty())
+					handleCommand(session, line);
+				break;
+		}
+	}
+}
+
+void MockIGSServer::slot_disconnected(void)
+{
+	QTcpSocket * socket = qobject_cast<QTcpSocket *>(sender());
+	Session * session = sessions.take(socket);
+	if(!session)
+		return;
+	foreach(int number, session->observing)
+	{
+		Game * game = games.value(number);
+		if(game)
+			game->observers.remove(session);
+	}
+	Game * game = games.value(session->playing);
+	if(game)
+		endGame(game, " has adjourned.");
+	if(session->state == Session::ONLINE)
+		sendToAll(QString("21 {%1 has disconnected}\r\n").arg(session->name).toLatin1());
+	socket->deleteLater();
+	delete session;
+}
+
+void MockIGSServer::handleCommand(Session * session, const QString & line)
+{
+	QStringList args = line.split(QChar(' '), QString::SkipEmptyParts);
+	QString command = args[0].toLower();
+
+	if(command == "userlist")
+		sendUserList(session);
+	else if(command == "who")
+		sendWho(session);
+	else if(command == "games")
+		sendGames(session);
+	else if(command == "observe" && args.size() > 1)
+		sendObserve(session, args[1].toInt());
+	else if(command == "unobserve" && args.size() > 1)
+		sendUnobserve(session, args[1].toInt());
+	else if(command == "moves" && args.size() > 1)
+	{
+		Game * game = games.value(args[1].toInt());
+		if(game)
+			sendMoves(session, game);
+	}
+	else if(command == "kibitz" && args.size() > 2)
+	{
+		Game * game = games.value(args[1].toInt());
+		if(game)
+			sendKibitz(game, session->name, session->rank, line.section(' ', 2, -1, QString::SectionSkipEmpty));
+	}
+	else if((command == "match" || command == "nmatch") && args.size() > 3)
+	{
+		sendMatch(session, args);
+		return;
+	}
+	else if(command == "pass" || command == "resign" ||
+		QRegExp("[A-HJ-Ta-hj-t][0-9]{1,2}").exactMatch(command))
+	{
+		sendClientMove(session, command);
+		return;
+	}
+	else if(command == "exit" || command == "quit")
+	{
+		session->socket->disconnectFromHost();
+		return;
+	}
+	/* Everything else, toggles, id, seek, room, channels, ayt, etc., is
+	 * simply acknowledged */
+	sendPrompt(session);
+}
+
+void MockIGSServer::sendUserList(Session * session)
+{
+	QByteArray out;
+	out += QString("42 %1  %2  %3  %4 %5  Obs Pl  Idle Flags Language\r\n")
+			.arg("Name", 10).arg("Info", -14).arg("Country", -7).arg("Rank", -4).arg("Won/Lost").toLatin1();
+	for(int i = 0; i < players.size(); i++)
+	{
+		const Player & p = players[i];
+		out += QString("42 %1  %2  %3  %4 %5/%6  %7 %8 %9    -X default  T BWN 0-9 19-19 60-60 60-3600 25-25 0-0 0-0 0-0\r\n")
+				.arg(p.name, 10).arg("<None>", -14).arg(p.country, -7).arg(alignedRank(p.rank), -4)
+				.arg(p.wins, 4).arg(p.losses, 4)
+				.arg("-", 3).arg(p.playing ? QString::number(p.playing) : QString("-"), 3)
+				.arg(QString::number(qrand() % 60) + "s", 4).toLatin1();
+	}
+	foreach(Session * s, sessions)
+	{
+		if(s->state != Session::ONLINE)
+			continue;
+		out += QString("42 %1  %2  %3  %4 %5/%6  %7 %8 %9    -X default  T BWN 0-9 19-19 60-60 60-3600 25-25 0-0 0-0 0-0\r\n")
+				.arg(s->name, 10).arg("<None>", -14).arg("--", -7).arg(alignedRank(s->rank), -4)
+				.arg(0, 4).arg(0, 4)
+				.arg("-", 3).arg(s->playing ? QString::number(s->playing) : QString("-"), 3)
+				.arg("0s", 4).toLatin1();
+	}
+	session->socket->write(out);
+	sendPrompt(session);
+}
+
+void MockIGSServer::sendWho(Session * session)
+{
+	QByteArray out;
+	out += "27  Info Obs  Pl   Name     Idle   Rank |  Info Obs  Pl   Name     Idle   Rank\r\n";
+	QString line;
+	for(int i = 0; i < players.size(); i++)
+	{
+		const Player & p = players[i];
+		/* Fixed columns, see IGSConnection::handle_who */
+		QString half = QString("%1%2  %3 %4%5    %6")
+				.arg("  ")
+				.arg(" --")
+				.arg(p.playing ? QString::number(p.playing) : QString("--"), 3)
+				.arg(p.name, -11)
+				.arg(QString::number(qrand() % 60) + "s", 3)
+				.arg(alignedRank(p.rank), 4);
+		if(line.isEmpty())
+			line = "27  " + half;
+		else
+		{
+			out += (line + " |  " + half + "\r\n").toLatin1();
+			line = QString();
+		}
+	}
+	if(!line.isEmpty())
+		out += (line + "\r\n").toLatin1();
+	session->socket->write(out);
+	sendPrompt(session);
+}
+
+void MockIGSServer::sendGames(Session * session)
+{
+	QByteArray out;
+	out += "7 [##]  white name [ rk ]      black name [ rk ] (Move size H Komi BY FR) (###)\r\n";
+	foreach(Game * game, games)
+	{
+		out += QString("7 [%1] %2 [%3] vs. %4 [%5] (%6 %7  0 %8 10  I) (%9)\r\n")
+				.arg(game->number, 3)
+				.arg(whiteName(game), 11).arg(alignedRank(whiteRank(game)), 4)
+				.arg(blackName(game), 11).arg(alignedRank(blackRank(game)), 4)
+				.arg(game->moves.size(), 3).arg(game->size, 4).arg(game->komi, 4, 'f', 1)
+				.arg(game->observers.size(), 3).toLatin1();
+	}
+	session->socket->write(out);
+	sendPrompt(session);
+}
+
+void MockIGSServer::sendMoves(Session * session, const Game * game)
+{
+	QByteArray out = gameHeader(game).toLatin1();
+	for(int i = 0; i < game->moves.size(); i++)
+		out += QString("15 %1(%2): %3\r\n").arg(i, 3).arg(i % 2 ? 'W' : 'B').arg(game->moves[i]).toLatin1();
+	session->socket->write(out);
+}
+
+void MockIGSServer::sendObserve(Session * session, int number)
+{
+	Game * game = games.value(number);
+	if(!game)
+	{
+		session->socket->write("5 There is no such game.\r\n");
+		sendPrompt(session);
+		return;
+	}
+	if(!game->observers.contains(session))
+	{
+		game->observers.insert(session);
+		session->observing.insert(number);
+		session->socket->write("9 Adding game to observation list.\r\n");
+	}
+	sendMoves(session, game);
+	sendPrompt(session);
+}
+
+void MockIGSServer::sendUnobserve(Session * session, int number)
+{
+	Game * game = games.value(number);
+	if(game)
+		game->observers.remove(session);
+	session->observing.remove(number);
+	session->socket->write(QString("9 Removing game %1 from observation list.\r\n").arg(number).toLatin1());
+	sendPrompt(session);
+}
+
+void MockIGSServer::sendKibitz(Game * game, const QString & name, const QString & rank, const QString & text)
+{
+	QByteArray out = QString("11 Kibitz %1 [%2]: Game %3 [%4]\r\n11    %5\r\n")
+			.arg(name).arg(rank).arg(blackName(game)).arg(game->number).arg(text).toLatin1();
+	foreach(Session * s, game->observers)
+		s->socket->write(out);
+	if(game->human)
+		game->human->socket->write(out);
+}
+
+/* match <opponent> <B|W|N> <size> <main minutes> <byoyomi minutes>
+ * nmatch <opponent> <B|W|N> <handicap> <size> <main> <period> <stones> 0 0 0
+ * Simulated players take every offer as long as they're not already playing */
+void MockIGSServer::sendMatch(Session * session, const QStringList & args)
+{
+	int opponent = findPlayer(args[1]);
+	if(opponent < 0 || players[opponent].playing || session->playing)
+	{
+		session->socket->write(QString("9 %1 declines your request for a match.\r\n").arg(args[1]).toLatin1());
+		sendPrompt(session);
+		return;
+	}
+	QString color = args[2].toUpper();
+	if(color == "N")
+		color = (qrand() % 2 ? "B" : "W");
+	int size = (args[0].toLower() == "nmatch" && args.size() > 4 ? args[4] : args[3]).toInt();
+	if(size < 2 || size > 19)
+		size = 19;
+
+	Game * game = (color == "B" ? startGame(opponent, -1, session) : startGame(-1, opponent, session));
+	game->size = size;
+	game->occupied.fill(false, size * size);
+	game->length = 10000;		//until the client resigns or leaves
+	session->playing = game->number;
+
+	QByteArray out;
+	out += QString("9 Match [%1] with %2 in 10 accepted.\r\n").arg(game->number).arg(players[opponent].name).toLatin1();
+	out += QString("9 Creating match [%1] with %2.\r\n").arg(game->number).arg(players[opponent].name).toLatin1();
+	out += gameHeader(game).toLatin1();
+	session->socket->write(out);
+	sendPrompt(session);
+	if(color == "W")
+		game->bot_move_due = clock.elapsed() + settings.bot_reply_msecs;
+}
+
+void MockIGSServer::sendClientMove(Session * session, const QString & move)
+{
+	Game * game = games.value(session->playing);
+	if(!game)
+	{
+		sendPrompt(session);
+		return;
+	}
+	bool clientIsBlack = (game->black == -1);
+	if(move == "resign")
+	{
+		endGame(game, QString(" : %1 lost by Resign").arg(clientIsBlack ? "Black" : "White"));
+		sendPrompt(session);
+		return;
+	}
+	if((game->moves.size() % 2 == 0) != clientIsBlack)
+	{
+		session->socket->write("5 Please wait for your opponent's move.\r\n");
+		sendPrompt(session);
+		return;
+	}
+	QString point = move.toUpper();
+	if(point == "PASS")
+		point = "Pass";
+	else
+	{
+		int x = QString(columns).indexOf(point[0]);
+		int y = point.mid(1).toInt() - 1;
+		if(x < 0 || x >= game->size || y < 0 || y >= game->size || game->occupied.testBit(y * game->size + x))
+		{
+			session->socket->write("5 Illegal move.\r\n");
+			sendPrompt(session);
+			return;
+		}
+	}
+	playMove(game, point);
+	game->bot_move_due = clock.elapsed() + settings.bot_reply_msecs;
+	sendPrompt(session);
+}
+
+void MockIGSServer::sendPrompt(Session * session)
+{
+	session->socket->write(session->playing ? PROMPT_PLAYING : PROMPT_WAITING);
+}
+
+void MockIGSServer::sendToAll(const QByteArray & data)
+{
+	foreach(Session * s, sessions)
+	{
+		if(s->state == Session::ONLINE)
+			s->socket->write(data);
+	}
+}
+
+void MockIGSServer::slot_tick(void)
+{
+	static qint64 last = 0;
+	qint64 now = clock.elapsed();
+	double seconds = (now - last) / 1000.0;
+	last = now;
+
+	QList<Game *> simulated, kibitzed;
+	foreach(Game * game, games)
+	{
+		if(game->human)
+		{
+			if(game->bot_move_due && game->bot_move_due <= now)
+			{
+				game->bot_move_due = 0;
+				playMove(game, randomMove(game));
+				sendPrompt(game->human);
+			}
+		}
+		else
+			simulated.append(game);
+		if(!game->observers.isEmpty())
+			kibitzed.append(game);
+	}
+
+	move_budget += settings.moves_per_second * seconds;
+	while(move_budget >= 1 && !simulated.isEmpty())
+	{
+		move_budget--;
+		int i = qrand() % simulated.size();
+		Game * game = simulated[i];
+		playMove(game, randomMove(game));
+		if(game->moves.size() >= game->length)
+		{
+			float black = 50 + qrand() % 60;
+			float white = black + (qrand() % 40) - 19.5;
+			simulated.removeAt(i);
+			kibitzed.removeOne(game);
+			endGame(game, QString(" : W %1 B %2").arg(white, 0, 'f', 1).arg(black, 0, 'f', 1));
+		}
+	}
+	if(simulated.isEmpty())
+		move_budget = 0;
+
+	kibitz_budget += settings.kibitzes_per_second * seconds;
+	while(kibitz_budget >= 1)
+	{
+		kibitz_budget--;
+		if(kibitzed.isEmpty())
+			continue;
+		Game * game = kibitzed[qrand() % kibitzed.size()];
+		const Player & p = players[qrand() % players.size()];
+		sendKibitz(game, p.name, p.rank, kibitzes[qrand() % (sizeof(kibitzes) / sizeof(kibitzes[0]))]);
+	}
+
+	int missing = settings.games - simulated.size();
+	while(missing-- > 0)
+	{
+		int white = randomIdlePlayer();
+		int black = randomIdlePlayer();
+		if(white < 0 || black < 0 || white == black)
+			break;
+		startGame(white, black);
+	}
+}
+
+MockIGSServer::Game * MockIGSServer::startGame(int white, int black, Session * human)
+{
+	Game * game = new Game();
+	game->number = next_game_number++;
+	game->white = white;
+	game->black = black;
+	game->size = 19;
+	game->komi = 6.5;
+	game->occupied.fill(false, game->size * game->size);
+	game->length = settings.min_game_length +
+			qrand() % qMax(1, settings.max_game_length - settings.min_game_length + 1);
+	game->human = human;
+	game->bot_move_due = 0;
+	if(white >= 0)
+		players[white].playing = game->number;
+	if(black >= 0)
+		players[black].playing = game->number;
+	games.insert(game->number, game);
+	sendToAll(QString("21 {Match %1: %2 [%3] vs. %4 [%5] }\r\n")
+			.arg(game->number).arg(whiteName(game)).arg(whiteRank(game))
+			.arg(blackName(game)).arg(blackRank(game)).toLatin1());
+	return game;
+}
+
+/* Announced to everyone, the same way IGS shouts results */
+void MockIGSServer::endGame(Game * game, const QString & result)
+{
+	sendToAll(QString("21 {Game %1: %2 vs %3%4}\r\n")
+			.arg(game->number).arg(whiteName(game)).arg(blackName(game)).arg(result).toLatin1());
+	if(game->white >= 0)
+		players[game->white].playing = 0;
+	if(game->black >= 0)
+		players[game->black].playing = 0;
+	foreach(Session * s, game->observers)
+		s->observing.remove(game->number);
+	if(game->human)
+		game->human->playing = 0;
+	games.remove(game->number);
+	delete game;
+}
+
+void MockIGSServer::playMove(Game * game, const QString & move)
+{
+	int number = game->moves.size();
+	if(move != "Pass")
+	{
+		int x = QString(columns).indexOf(move[0]);
+		int y = move.mid(1).toInt() - 1;
+		game->occupied.setBit(y * game->size + x);
+	}
+	game->moves.append(move);
+	if(game->observers.isEmpty() && !game->human)
+		return;
+
+	/* IGS resends the game header ahead of every move */
+	QByteArray out = gameHeader(game).toLatin1();
+	out += QString("15 %1(%2): %3\r\n").arg(number, 3).arg(number % 2 ? 'W' : 'B').arg(move).toLatin1();
+	foreach(Session * s, game->observers)
+		s->socket->write(out);
+	if(game->human)
+		game->human->socket->write(out);
+}
+
+QString MockIGSServer::randomMove(Game * game)
+{
+	int points = game->size * game->size;
+	int start = qrand() % points;
+	for(int i = 0; i < points; i++)
+	{
+		int p = (start + i) % points;
+		if(!game->occupied.testBit(p))
+			return columns[p % game->size] + QString::number(p / game->size + 1);
+	}
+	return "Pass";
+}
+
+QString MockIGSServer::gameHeader(const Game * game) const
+{
+	return QString("15 Game %1 I: %2 (0 600 -1) vs %3 (0 600 -1)\r\n")
+			.arg(game->number).arg(whiteName(game)).arg(blackName(game));
+}
+
+QString MockIGSServer::whiteName(const Game * game) const
+{
+	return (game->white >= 0 ? players[game->white].name : game->human->name);
+}
+
+QString MockIGSServer::blackName(const Game * game) const
+{
+	return (game->black >= 0 ? players[game->black].name : game->human->name);
+}
+
+QString MockIGSServer::whiteRank(const Game * game) const
+{
+	return (game->white >= 0 ? players[game->white].rank : game->human->rank);
+}
+
+QString MockIGSServer::blackRank(const Game * game) const
+{
+	return (game->black >= 0 ? players[game->black].rank : game->human->rank);
+}
+
+int MockIGSServer::findPlayer(const QString & name) const
+{
+	for(int i = 0; i < players.size(); i++)
+	{
+		if(players[i].name == name)
+			return i;
+	}
+	return -1;
+}
+
+int MockIGSServer::randomIdlePlayer(void)
+{
+	for(int tries = 0; tries < 64; tries++)
+	{
+		int i = qrand() % players.size();
+		if(!players[i].playing)
+			return i;
+	}
+	return -1;
+}
@@ -0,0 +1,131 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#ifndef MOCKIGSSERVER_H
+#define MOCKIGSSERVER_H
+
+#include <QtCore>
+#include <QtNetwork>
+
+/* A stand-in for the IGS server, speaking just enough of the client
+ * mode protocol (login, who, userlist, games, observe, moves, kibitz,
+ * match) to load qGo with thousands of players and hundreds of running
+ * games without hammering a real server.  Games are random walks over
+ * the empty points, nothing is captured and nothing is scored. */
+
+class MockIGSServer : public QObject
+{
+	Q_OBJECT
+	public:
+		struct Settings
+		{
+			quint16 port;
+			int players;
+			int games;
+			double moves_per_second;	//across all simulated games
+			double kibitzes_per_second;
+			int bot_reply_msecs;		//delay before answering a client's move
+			int min_game_length;
+			int max_game_length;
+			unsigned int seed;
+		};
+		MockIGSServer(const Settings & s);
+		~MockIGSServer();
+		bool listen(void);
+	private slots:
+		void slot_newConnection(void);
+		void slot_readyRead(void);
+		void slot_disconnected(void);
+		void slot_tick(void);
+	private:
+		struct Player
+		{
+			QString name;
+			QString rank;
+			QString country;
+			int wins;
+			int losses;
+			int playing;		//game number or 0
+		};
+		struct Session;
+		struct Game
+		{
+			int number;
+			int white;		//index into players, -1 for the session
+			int black;
+			int size;
+			float komi;
+			QStringList moves;
+			QBitArray occupied;
+			int length;		//moves until the game is scored
+			QSet<Session *> observers;
+			Session * human;
+			qint64 bot_move_due;	//msecs, 0 if not the bot's turn
+		};
+		struct Session
+		{
+			enum State { LOGIN, PASSWORD, ONLINE } state;
+			QTcpSocket * socket;
+			QString name;
+			QString rank;
+			QSet<int> observing;
+			int playing;
+		};
+
+		void handleCommand(Session * session, const QString & line);
+		void sendUserList(Session * session);
+		void sendWho(Session * session);
+		void sendGames(Session * session);
+		void sendMoves(Session * session, const Game * game);
+		void sendObserve(Session * session, int number);
+		void sendUnobserve(Session * session, int number);
+		void sendKibitz(Game * game, const QString & name, const QString & rank, const QString & text);
+		void sendMatch(Session * session, const QStringList & args);
+		void sendClientMove(Session * session, const QString & move);
+		void sendPrompt(Session * session);
+		void sendToAll(const QByteArray & data);
+
+		Game * startGame(int white, int black, Session * human = 0);
+		void endGame(Game * game, const QString & result);
+		void playMove(Game * game, const QString & move);
+		QString randomMove(Game * game);
+		QString gameHeader(const Game * game) const;
+		QString whiteName(const Game * game) const;
+		QString blackName(const Game * game) const;
+		QString whiteRank(const Game * game) const;
+		QString blackRank(const Game * game) const;
+		int findPlayer(const QString & name) const;
+		int randomIdlePlayer(void);
+
+		Settings settings;
+		QTcpServer * server;
+		QTimer * tickTimer;
+		QElapsedTimer clock;
+		QVector<Player> players;
+		QMap<int, Game *> games;
+		QHash<QTcpSocket *, Session *> sessions;
+		int next_game_number;
+		double move_budget;
+		double kibitz_budget;
+};
+
+#endif //MOCKIGSSERVER_H
@@ -0,0 +1,60 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+
+
+#include <QtCore>
+#include "stubengine.h"
+
+int main(int argc, char ** argv)
+{
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName("stubengine");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Scripted GTP engine for trying out qGo's engine code.");
+	parser.addHelpOption();
+	QCommandLineOption thinkOption("think", "Answer genmove after <msecs>.", "msecs", "0");
+	QCommandLineOption candidatesOption("candidates", "Give <count> candidates per analysis line.", "count", "8");
+	QCommandLineOption resignOption("resign-after", "Resign after <moves>, 0 for never.", "moves", "0");
+	QCommandLineOption seedOption("seed", "Random <seed>, for repeatable runs.", "seed", "1");
+	parser.addOption(thinkOption);
+	parser.addOption(candidatesOption);
+	parser.addOption(resignOption);
+	parser.addOption(seedOption);
+	parser.process(app);
+
+	StubEngine::Settings settings;
+	settings.think_msecs = qMax(0, parser.value(thinkOption).toInt());
+	settings.candidates = qMax(1, parser.value(candidatesOption).toInt());
+	settings.resign_after = qMax(0, parser.value(resignOption).toInt());
+	settings.seed = parser.value(seedOption).toUInt();
+
+	StubEngine engine(settings);
+	StdinReader reader;
+	QObject::connect(&reader, SIGNAL(lineRead(QByteArray)), &engine, SLOT(slot_command(QByteArray)));
+	reader.start();
+	int result = app.exec();
+	reader.terminate();
+	reader.wait();
+	return result;
+}
@@ -0,0 +1,293 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+
+
+#include "stubengine.h"
+
+#include <stdio.h>
+#include <ctype.h>
+
+static const char * commands[] = {
+	"protocol_version", "name", "version", "known_command", "list_commands",
+	"quit", "boardsize", "clear_board", "komi", "play", "genmove",
+	"reg_genmove", "undo", "fixed_handicap", "set_free_handicap",
+	"final_score", "lz-analyze", "kata-analyze", 0 };
+
+void StdinReader::run()
+{
+	char buffer[4096];
+	while (fgets(buffer, sizeof(buffer), stdin))
+		emit lineRead(QByteArray(buffer));
+	emit lineRead(QByteArray("quit"));
+}
+
+StubEngine::StubEngine(const Settings & s) : settings(s), board_size(19), kata(false),
+	analysisColor(1), analysisVisits(0)
+{
+	qsrand(settings.seed);
+	board.fill(0, board_size * board_size);
+	analysisTimer = new QTimer(this);
+	connect(analysisTimer, SIGNAL(timeout()), SLOT(slot_analysisTick()));
+}
+
+void StubEngine::answer(bool ok, const QByteArray & text)
+{
+	QByteArray out = (ok ? "=" : "?") + pendingId;
+	if (!text.isEmpty())
+		out += " " + text;
+	out += "\n\n";
+	fwrite(out.constData(), 1, out.size(), stdout);
+	fflush(stdout);
+}
+
+/* Any command ends a running analysis */
+void StubEngine::stopAnalysis(void)
+{
+	if (!analysisTimer->isActive())
+		return;
+	analysisTimer->stop();
+	fputs("\n", stdout);
+	fflush(stdout);
+}
+
+QByteArray StubEngine::vertex(int x, int y) const
+{
+	if (x < 0)
+		return "pass";
+	// no 'I'
+	char c = 'A' + x - 1 + (x > 8 ? 1 : 0);
+	return QByteArray(1, c) + QByteArray::number(y);
+}
+
+bool StubEngine::parseVertex(const QByteArray & v, int & x, int & y) const
+{
+	if (v.toLower() == "pass")
+	{
+		x = y = -1;
+		return true;
+	}
+	if (v.size() < 2)
+		return false;
+	x = QChar(v[0]).toUpper().toLatin1() - 'A' + 1;
+	if (x > 8)
+		x--;
+	bool ok;
+	y = v.mid(1).toInt(&ok);
+	return ok && x >= 1 && x <= board_size && y >= 1 && y <= board_size;
+}
+
+QByteArray StubEngine::randomMove(void)
+{
+	if (settings.resign_after && history.size() >= settings.resign_after)
+		return "resign";
+	QList<int> empty;
+	for (int i = 0; i < board.size(); i++)
+		if (!board[i])
+			empty.append(i);
+	// Pass once a third of the board is full, or after a pass
+	if (empty.size() < board.size() * 2 / 3 || (!history.isEmpty() && history.last() < 0))
+		return "pass";
+	int p = empty[qrand() % empty.size()];
+	return vertex(p % board_size + 1, p / board_size + 1);
+}
+
+void StubEngine::slot_command(QByteArray line)
+{
+	stopAnalysis();
+
+	line = line.simplified();
+	pendingId.clear();
+	int i = 0;
+	while (i < line.size() && isdigit(line[i]))
+		i++;
+	pendingId = line.left(i);
+	line = line.mid(i).trimmed();
+	if (line.isEmpty())
+		return;
+	QList<QByteArray> args = line.split(' ');
+	QByteArray cmd = args.takeFirst();
+
+	if (cmd == "protocol_version")
+		answer(true, "2");
+	else if (cmd == "name")
+		answer(true, "stubengine");
+	else if (cmd == "version")
+		answer(true, "1.0");
+	else if (cmd == "known_command")
+	{
+		bool known = false;
+		for (int c = 0; commands[c]; c++)
+			known |= (!args.isEmpty() && args[0] == commands[c]);
+		answer(true, known ? "true" : "false");
+	}
+	else if (cmd == "list_commands")
+	{
+		QByteArray list;
+		for (int c = 0; commands[c]; c++)
+			list += QByteArray(c ? "\n" : "") + commands[c];
+		answer(true, list);
+	}
+	else if (cmd == "quit")
+	{
+		answer(true, QByteArray());
+		QCoreApplication::quit();
+	}
+	else if (cmd == "boardsize")
+	{
+		int size = args.isEmpty() ? 0 : args[0].toInt();
+		if (size < 2 || size > 25)
+		{
+			answer(false, "unacceptable size");
+			return;
+		}
+		board_size = size;
+		board.fill(0, board_size * board_size);
+		history.clear();
+		answer(true, QByteArray());
+	}
+	else if (cmd == "clear_board")
+	{
+		board.fill(0);
+		history.clear();
+		answer(true, QByteArray());
+	}
+	else if (cmd == "komi")
+		answer(true, QByteArray());
+	else if (cmd == "play" || cmd == "set_free_handicap")
+	{
+		// set_free_handicap is a list of black stones
+		int first = (cmd == "play" ? 1 : 0);
+		if (args.size() < first + 1)
+		{
+			answer(false, "syntax error");
+			return;
+		}
+		for (int a = first; a < args.size(); a++)
+		{
+			int x, y;
+			if (!parseVertex(args[a], x, y))
+			{
+				answer(false, "invalid coordinate");
+				return;
+			}
+			if (x < 0)
+			{
+				history.append(-1);
+				continue;
+			}
+			int p = (y - 1) * board_size + x - 1;
+			if (board[p])
+			{
+				answer(false, "illegal move");
+				return;
+			}
+			board[p] = 1;
+			history.append(p);
+		}
+		answer(true, QByteArray());
+	}
+	else if (cmd == "fixed_handicap")
+		answer(false, "not supported");
+	else if (cmd == "genmove" || cmd == "reg_genmove")
+	{
+		QByteArray move = randomMove();
+		if (settings.think_msecs)
+			QThread::msleep(settings.think_msecs);
+		int x, y;
+		if (cmd == "genmove" && parseVertex(move, x, y))
+		{
+			if (x < 0)
+				history.append(-1);
+			else
+			{
+				board[(y - 1) * board_size + x - 1] = 1;
+				history.append((y - 1) * board_size + x - 1);
+			}
+		}
+		answer(true, move);
+	}
+	else if (cmd == "undo")
+	{
+		if (history.isEmpty())
+		{
+			answer(false, "cannot undo");
+			return;
+		}
+		int p = history.takeLast();
+		if (p >= 0)
+			board[p] = 0;
+		answer(true, QByteArray());
+	}
+	else if (cmd == "final_score")
+		answer(true, "0");
+	else if (cmd == "lz-analyze" || cmd == "kata-analyze")
+	{
+		// [color] [interval in centiseconds]
+		kata = (cmd == "kata-analyze");
+		int interval = 100;
+		for (int a = 0; a < args.size(); a++)
+		{
+			bool ok;
+			int n = args[a].toInt(&ok);
+			if (ok)
+				interval = n;
+		}
+		analysisVisits = 0;
+		fputs(("=" + pendingId + "\n").constData(), stdout);
+		fflush(stdout);
+		analysisTimer->start(qMax(1, interval) * 10);
+	}
+	else
+		answer(false, "unknown command");
+}
+
+/* One info line : every candidate gets more visits each time */
+void StubEngine::slot_analysisTick(void)
+{
+	analysisVisits += 50 + qrand() % 50;
+	QByteArray out;
+	QList<int> empty;
+	for (int i = 0; i < board.size(); i++)
+		if (!board[i])
+			empty.append(i);
+	int n = qMin(settings.candidates, empty.size());
+	int visits = analysisVisits;
+	for (int c = 0; c < n; c++)
+	{
+		// The same points while the position stays the same
+		int p = empty[(c * 7919 + history.size()) % empty.size()];
+		QByteArray move = vertex(p % board_size + 1, p / board_size + 1);
+		double winrate = 0.5 + 0.3 * (n - c) / n - 0.15;
+		out += "info move " + move + " visits " + QByteArray::number(visits);
+		if (kata)
+			out += " winrate " + QByteArray::number(winrate, 'f', 6)
+				+ " scoreLead " + QByteArray::number((winrate - 0.5) * 20, 'f', 2);
+		else
+			out += " winrate " + QByteArray::number(int(winrate * 10000));
+		out += " prior 1000 order " + QByteArray::number(c) + " pv " + move + " ";
+		visits /= 2;
+	}
+	out += "\n";
+	fwrite(out.constData(), 1, out.size(), stdout);
+	fflush(stdout);
+}
@@ -0,0 +1,78 @@
+/***************************************************************************
+ *   Copyright (C) 2009 by The qGo Project                                 *
+ *                                                                         *
+ *   This file is part of qGo.   					   *
+ *                                                                         *
+ *   qGo is free software: you can redistribute it and/or modify           *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ *   or write to the Free Software Foundation, Inc.,                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+
+
+#ifndef STUBENGINE_H
+#define STUBENGINE_H
+
+#include <QtCore>
+
+/* Reads stdin on its own thread, so the engine can keep streaming
+ * analysis while it waits for the next command. */
+class StdinReader : public QThread
+{
+	Q_OBJECT
+	signals:
+		void lineRead(QByteArray line);
+	protected:
+		void run();
+};
+
+/* A GTP engine that plays random legal-looking moves (empty points,
+ * nothing is ever captured) and answers lz-analyze and kata-analyze
+ * with made up candidates, for trying qGo's engine code without a
+ * real engine. */
+class StubEngine : public QObject
+{
+	Q_OBJECT
+	public:
+		struct Settings
+		{
+			int think_msecs;	//delay before answering genmove
+			int candidates;		//per analysis info line
+			int resign_after;	//moves, 0 never resigns
+			unsigned int seed;
+		};
+		StubEngine(const Settings & s);
+	private slots:
+		void slot_command(QByteArray line);
+		void slot_analysisTick(void);
+	private:
+		void answer(bool ok, const QByteArray & text);
+		void stopAnalysis(void);
+		QByteArray vertex(int x, int y) const;
+		bool parseVertex(const QByteArray & v, int & x, int & y) const;
+		QByteArray randomMove(void);
+
+		Settings settings;
+		int board_size;
+		QVector<quint8> board;		//by (y-1)*board_size + x-1, 0 empty
+		QList<int> history;		//points played, -1 for passes
+		QByteArray pendingId;
+		QTimer * analysisTimer;
+		bool kata;
+		int analysisColor;
+		int analysisVisits;
+};
+
+#endif
@@ -0,0 +1,16 @@
+#qmake file
+#Scripted GTP engine for trying out the engine code, qmake CONFIG+=stubengine from the top level
+
+QT += core
+QT -= gui
+CONFIG += console
+CONFIG -= app_bundle
+DESTDIR = ../../build
+TARGET = stubengine
+OBJECTS_DIR = $${DESTDIR}/objects/stubengine
+MOC_DIR = $${DESTDIR}/moc/stubengine
+TEMPLATE = app
+
+HEADERS += stubengine.h
+SOURCES += main.cpp \
+	stubengine.cpp